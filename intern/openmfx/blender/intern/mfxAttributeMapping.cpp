@@ -0,0 +1,1452 @@
+/**
+ * OpenMfx modifier for Blender
+ * Copyright (C) 2019 - 2021 Elie Michel
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** \file
+ * \ingroup openmesheffect
+ */
+
+#include "mfxAttributeMapping.h"
+
+#include "ofxMeshEffect.h"
+#include "util/plugin_support.h"  // halfToFloat, floatToHalf
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_pointcloud_types.h"
+
+#include "BKE_customdata.h"
+#include "BKE_deform.h"  // BKE_defvert_find_weight
+
+#include "BLI_string.h"
+#include "BLI_task.hh"
+
+#include "bmesh.h"
+
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+using blender::Array;
+using blender::IndexRange;
+using blender::Span;
+using blender::StringRefNull;
+using blender::Vector;
+using blender::bke::ReadAttributePtr;
+
+// Grain size used when copying attributes in parallel
+constexpr int ATTRIBUTE_GRAIN_SIZE = 4096;
+
+// Number of legacy per-layer names, like uv0 or color0, that are recognized in outputs
+constexpr int MAX_LEGACY_LAYERS = 8;
+
+// ----------------------------------------------------------------------------
+// Type mapping
+
+enum class OfxScalarType {
+  Unknown,
+  UByte,
+  Int,
+  Float,
+  Half,
+  Short,
+  UShort,
+  Double,
+};
+
+static OfxScalarType ofx_scalar_type(const char *type)
+{
+  if (NULL == type) {
+    return OfxScalarType::Unknown;
+  }
+  if (0 == strcmp(type, kOfxMeshAttribTypeUByte)) {
+    return OfxScalarType::UByte;
+  }
+  if (0 == strcmp(type, kOfxMeshAttribTypeInt)) {
+    return OfxScalarType::Int;
+  }
+  if (0 == strcmp(type, kOfxMeshAttribTypeFloat)) {
+    return OfxScalarType::Float;
+  }
+  if (0 == strcmp(type, kOfxMeshAttribTypeHalf)) {
+    return OfxScalarType::Half;
+  }
+  if (0 == strcmp(type, kOfxMeshAttribTypeShort)) {
+    return OfxScalarType::Short;
+  }
+  if (0 == strcmp(type, kOfxMeshAttribTypeUShort)) {
+    return OfxScalarType::UShort;
+  }
+  if (0 == strcmp(type, kOfxMeshAttribTypeDouble)) {
+    return OfxScalarType::Double;
+  }
+  return OfxScalarType::Unknown;
+}
+
+static int ofx_scalar_size(OfxScalarType type)
+{
+  switch (type) {
+    case OfxScalarType::UByte:
+      return sizeof(unsigned char);
+    case OfxScalarType::Int:
+      return sizeof(int);
+    case OfxScalarType::Float:
+      return sizeof(float);
+    case OfxScalarType::Half:
+      return sizeof(unsigned short);
+    case OfxScalarType::Short:
+      return sizeof(short);
+    case OfxScalarType::UShort:
+      return sizeof(unsigned short);
+    case OfxScalarType::Double:
+      return sizeof(double);
+    default:
+      return 0;
+  }
+}
+
+/**
+ * Get the static type string matching a type, so that it can be stored in
+ * properties without ownership concerns.
+ */
+static const char *ofx_type_string(OfxScalarType type)
+{
+  switch (type) {
+    case OfxScalarType::UByte:
+      return kOfxMeshAttribTypeUByte;
+    case OfxScalarType::Int:
+      return kOfxMeshAttribTypeInt;
+    case OfxScalarType::Float:
+      return kOfxMeshAttribTypeFloat;
+    case OfxScalarType::Half:
+      return kOfxMeshAttribTypeHalf;
+    case OfxScalarType::Short:
+      return kOfxMeshAttribTypeShort;
+    case OfxScalarType::UShort:
+      return kOfxMeshAttribTypeUShort;
+    case OfxScalarType::Double:
+      return kOfxMeshAttribTypeDouble;
+    default:
+      return NULL;
+  }
+}
+
+template<typename T> static T clamp_component(double value)
+{
+  const double min = (double)std::numeric_limits<T>::lowest();
+  const double max = (double)std::numeric_limits<T>::max();
+  return (T)(value < min ? min : (value > max ? max : value));
+}
+
+static double load_component(OfxScalarType type, const char *component)
+{
+  switch (type) {
+    case OfxScalarType::UByte:
+      return (double)*(const unsigned char *)component;
+    case OfxScalarType::Int:
+      return (double)*(const int *)component;
+    case OfxScalarType::Float:
+      return (double)*(const float *)component;
+    case OfxScalarType::Half:
+      return (double)halfToFloat(*(const unsigned short *)component);
+    case OfxScalarType::Short:
+      return (double)*(const short *)component;
+    case OfxScalarType::UShort:
+      return (double)*(const unsigned short *)component;
+    case OfxScalarType::Double:
+      return *(const double *)component;
+    default:
+      return 0.0;
+  }
+}
+
+static void store_component(OfxScalarType type, char *component, double value)
+{
+  switch (type) {
+    case OfxScalarType::UByte:
+      *(unsigned char *)component = clamp_component<unsigned char>(value);
+      break;
+    case OfxScalarType::Int:
+      *(int *)component = clamp_component<int>(value);
+      break;
+    case OfxScalarType::Float:
+      *(float *)component = (float)value;
+      break;
+    case OfxScalarType::Half:
+      *(unsigned short *)component = floatToHalf((float)value);
+      break;
+    case OfxScalarType::Short:
+      *(short *)component = clamp_component<short>(value);
+      break;
+    case OfxScalarType::UShort:
+      *(unsigned short *)component = clamp_component<unsigned short>(value);
+      break;
+    case OfxScalarType::Double:
+      *(double *)component = value;
+      break;
+    default:
+      break;
+  }
+}
+
+static bool is_floating(OfxScalarType type)
+{
+  return OfxScalarType::Float == type || OfxScalarType::Half == type ||
+         OfxScalarType::Double == type;
+}
+
+static bool semantic_is(const char *semantic, const char *expected)
+{
+  return NULL != semantic && 0 == strcmp(semantic, expected);
+}
+
+/**
+ * Set the OpenMfx type of a binding from the Blender data type of the
+ * attribute. The OpenMfx element has exactly the same memory layout as the
+ * Blender element, so that values can be memcpy'd.
+ * \return false if the type cannot be represented in OpenMfx
+ */
+static bool set_ofx_type_from_data_type(MfxAttributeBinding &binding)
+{
+  switch (binding.data_type) {
+    case CD_PROP_FLOAT:
+      binding.type = kOfxMeshAttribTypeFloat;
+      binding.component_count = 1;
+      return true;
+    case CD_PROP_FLOAT2:
+      binding.type = kOfxMeshAttribTypeFloat;
+      binding.component_count = 2;
+      return true;
+    case CD_PROP_FLOAT3:
+      binding.type = kOfxMeshAttribTypeFloat;
+      binding.component_count = 3;
+      return true;
+    case CD_PROP_COLOR:
+      binding.type = kOfxMeshAttribTypeFloat;
+      binding.component_count = 4;
+      binding.semantic = kOfxMeshAttribSemanticColor;
+      return true;
+    case CD_PROP_INT32:
+      binding.type = kOfxMeshAttribTypeInt;
+      binding.component_count = 1;
+      return true;
+    case CD_PROP_BOOL:
+      binding.type = kOfxMeshAttribTypeUByte;
+      binding.component_count = 1;
+      return true;
+    default:
+      return false;
+  }
+}
+
+static const char *attachment_from_domain(AttributeDomain domain)
+{
+  switch (domain) {
+    case ATTR_DOMAIN_POINT:
+      return kOfxMeshAttribPoint;
+    case ATTR_DOMAIN_CORNER:
+    case ATTR_DOMAIN_EDGE:
+      // There is no edge attachment in OpenMfx, edge values are forwarded to
+      // the corners starting the edges.
+      return kOfxMeshAttribCorner;
+    case ATTR_DOMAIN_FACE:
+      return kOfxMeshAttribFace;
+    default:
+      return NULL;
+  }
+}
+
+static AttributeDomain domain_from_attachment(const char *attachment)
+{
+  if (0 == strcmp(attachment, kOfxMeshAttribPoint)) {
+    return ATTR_DOMAIN_POINT;
+  }
+  if (0 == strcmp(attachment, kOfxMeshAttribCorner)) {
+    return ATTR_DOMAIN_CORNER;
+  }
+  if (0 == strcmp(attachment, kOfxMeshAttribFace)) {
+    return ATTR_DOMAIN_FACE;
+  }
+  return ATTR_DOMAIN_NUM;
+}
+
+static const CustomData *domain_custom_data(const Mesh *mesh, AttributeDomain domain)
+{
+  switch (domain) {
+    case ATTR_DOMAIN_POINT:
+      return &mesh->vdata;
+    case ATTR_DOMAIN_EDGE:
+      return &mesh->edata;
+    case ATTR_DOMAIN_CORNER:
+      return &mesh->ldata;
+    case ATTR_DOMAIN_FACE:
+      return &mesh->pdata;
+    default:
+      return NULL;
+  }
+}
+
+// ----------------------------------------------------------------------------
+// Blender -> OpenMfx
+
+static const MfxAttributeRequest *find_request(Span<MfxAttributeRequest> requests,
+                                              StringRefNull name,
+                                              const char *attachment)
+{
+  for (const MfxAttributeRequest &request : requests) {
+    if (name == request.name && 0 == strcmp(attachment, request.attachment)) {
+      return &request;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Expose the attribute with the type requested by the effect, if any.
+ */
+static void apply_requested_type(MfxAttributeBinding &binding,
+                                 Span<MfxAttributeRequest> requests)
+{
+  binding.native_type = binding.type;
+  const MfxAttributeRequest *request = find_request(requests, binding.name, binding.attachment);
+  if (NULL == request) {
+    return;
+  }
+  const char *type = ofx_type_string(ofx_scalar_type(request->type));
+  if (NULL != type && 0 != strcmp(type, binding.type)) {
+    binding.type = type;
+  }
+}
+
+static void add_legacy_layer_bindings(const Mesh *mesh,
+                                      Span<MfxAttributeRequest> requests,
+                                      Vector<MfxAttributeBinding> &bindings)
+{
+  char name[MAX_CUSTOMDATA_LAYER_NAME];
+
+  // Corner colors, exposed as color0, color1, etc. (RGB only)
+  int vcolor_layers = CustomData_number_of_layers(&mesh->ldata, CD_MLOOPCOL);
+  for (int k = 0; k < vcolor_layers; ++k) {
+    MLoopCol *vcolor_data = (MLoopCol *)CustomData_get_layer_n(&mesh->ldata, CD_MLOOPCOL, k);
+    if (NULL == vcolor_data) {
+      printf("WARNING: missing color attribute!\n");
+      continue;
+    }
+    BLI_snprintf(name, sizeof(name), "color%d", k);
+    MfxAttributeBinding binding;
+    binding.name = name;
+    binding.domain = ATTR_DOMAIN_CORNER;
+    binding.data_type = CD_PROP_COLOR;
+    binding.attachment = kOfxMeshAttribCorner;
+    binding.type = kOfxMeshAttribTypeUByte;
+    binding.semantic = kOfxMeshAttribSemanticColor;
+    binding.component_count = 3;
+    binding.raw_data = (char *)&vcolor_data[0].r;
+    binding.raw_stride = sizeof(MLoopCol);
+    apply_requested_type(binding, requests);
+    bindings.append(binding);
+  }
+
+  // Corner UVs, exposed as uv0, uv1, etc.
+  int uv_layers = CustomData_number_of_layers(&mesh->ldata, CD_MLOOPUV);
+  for (int k = 0; k < uv_layers; ++k) {
+    MLoopUV *uv_data = (MLoopUV *)CustomData_get_layer_n(&mesh->ldata, CD_MLOOPUV, k);
+    if (NULL == uv_data) {
+      printf("WARNING: missing UV attribute!\n");
+      continue;
+    }
+    BLI_snprintf(name, sizeof(name), "uv%d", k);
+    MfxAttributeBinding binding;
+    binding.name = name;
+    binding.domain = ATTR_DOMAIN_CORNER;
+    binding.data_type = CD_PROP_FLOAT2;
+    binding.attachment = kOfxMeshAttribCorner;
+    binding.type = kOfxMeshAttribTypeFloat;
+    binding.semantic = kOfxMeshAttribSemanticTextureCoordinate;
+    binding.component_count = 2;
+    binding.raw_data = (char *)&uv_data[0].uv[0];
+    binding.raw_stride = sizeof(MLoopUV);
+    apply_requested_type(binding, requests);
+    bindings.append(binding);
+  }
+}
+
+static bool is_binding_name_used(const Vector<MfxAttributeBinding> &bindings, StringRefNull name)
+{
+  for (const MfxAttributeBinding &binding : bindings) {
+    if (name == binding.name) {
+      return true;
+    }
+  }
+  return false;
+}
+
+Span<float> MfxVertexWeightCache::get(const Mesh *mesh, int vertex_group_index)
+{
+  const std::pair<const void *, int> key(mesh, vertex_group_index);
+  const blender::Array<float> *cached = m_weights.lookup_ptr(key);
+  if (nullptr != cached) {
+    return *cached;
+  }
+
+  blender::Array<float> weights(mesh->totvert, 0.0f);
+  const MDeformVert *dvert = mesh->dvert;
+  if (nullptr != dvert) {
+    blender::parallel_for(
+        IndexRange(mesh->totvert), ATTRIBUTE_GRAIN_SIZE, [&](IndexRange range) {
+          for (int64_t i : range) {
+            const MDeformVert &dv = dvert[i];
+            for (int j = 0; j < dv.totweight; ++j) {
+              if (dv.dw[j].def_nr == vertex_group_index) {
+                weights[i] = dv.dw[j].weight;
+                break;
+              }
+            }
+          }
+        });
+  }
+
+  return m_weights.lookup_or_add(key, std::move(weights));
+}
+
+Span<float> MfxVertexWeightCache::get(BMesh *bm, int vertex_group_index)
+{
+  const std::pair<const void *, int> key(bm, vertex_group_index);
+  const blender::Array<float> *cached = m_weights.lookup_ptr(key);
+  if (nullptr != cached) {
+    return *cached;
+  }
+
+  blender::Array<float> weights(bm->totvert, 0.0f);
+  const int cd_dvert_offset = CustomData_get_offset(&bm->vdata, CD_MDEFORMVERT);
+  if (-1 != cd_dvert_offset) {
+    BM_mesh_elem_table_ensure(bm, BM_VERT);
+    BMVert **vtable = bm->vtable;
+    blender::parallel_for(
+        IndexRange(bm->totvert), ATTRIBUTE_GRAIN_SIZE, [&](IndexRange range) {
+          for (int64_t i : range) {
+            const MDeformVert *dv = (const MDeformVert *)BM_ELEM_CD_GET_VOID_P(vtable[i],
+                                                                              cd_dvert_offset);
+            weights[i] = BKE_defvert_find_weight(dv, vertex_group_index);
+          }
+        });
+  }
+
+  return m_weights.lookup_or_add(key, std::move(weights));
+}
+
+void MfxVertexWeightCache::clear()
+{
+  m_weights.clear();
+}
+
+// ----------------------------------------------------------------------------
+// Edit-mode BMesh
+
+bool MfxBMeshTopology::matches(const BMesh *other) const
+{
+  return other == bm && other->totvert == totvert && other->totedge == totedge &&
+         other->totloop == totloop && other->totface == totface;
+}
+
+void MfxBMeshTopology::update(BMesh *new_bm)
+{
+  BM_mesh_elem_index_ensure(new_bm, BM_VERT);
+  BM_mesh_elem_table_ensure(new_bm, BM_VERT | BM_FACE);
+
+  loose_edges.clear();
+  BMIter iter;
+  BMEdge *e;
+  BM_ITER_MESH (e, &iter, new_bm, BM_EDGES_OF_MESH) {
+    if (NULL == e->l) {
+      loose_edges.append(e);
+    }
+  }
+
+  // First corner of each face, so that faces can then be read in parallel
+  const int face_count = new_bm->totface;
+  const int loose_edge_count = (int)loose_edges.size();
+  BMFace **ftable = new_bm->ftable;
+  Array<int> face_offsets(face_count);
+  face_sizes.reinitialize(face_count + loose_edge_count);
+  int offset = 0;
+  for (int f = 0; f < face_count; ++f) {
+    face_offsets[f] = offset;
+    face_sizes[f] = ftable[f]->len;
+    offset += ftable[f]->len;
+  }
+
+  corner_loops.reinitialize(offset);
+  corner_points.reinitialize(offset + 2 * loose_edge_count);
+  blender::parallel_for(IndexRange(face_count), ATTRIBUTE_GRAIN_SIZE, [&](IndexRange range) {
+    for (int64_t f : range) {
+      int c = face_offsets[f];
+      BMLoop *l_first = BM_FACE_FIRST_LOOP(ftable[f]);
+      BMLoop *l = l_first;
+      do {
+        corner_loops[c] = l;
+        corner_points[c] = BM_elem_index_get(l->v);
+        ++c;
+      } while ((l = l->next) != l_first);
+    }
+  });
+
+  for (int k = 0; k < loose_edge_count; ++k) {
+    face_sizes[face_count + k] = 2;
+    corner_points[offset + 2 * k] = BM_elem_index_get(loose_edges[k]->v1);
+    corner_points[offset + 2 * k + 1] = BM_elem_index_get(loose_edges[k]->v2);
+  }
+
+  bm = new_bm;
+  totvert = new_bm->totvert;
+  totedge = new_bm->totedge;
+  totloop = new_bm->totloop;
+  totface = new_bm->totface;
+}
+
+void MfxBMeshTopology::clear()
+{
+  bm = nullptr;
+  totvert = totedge = totloop = totface = 0;
+  corner_loops = Array<BMLoop *>();
+  loose_edges.clear_and_make_inline();
+  corner_points = Array<int>();
+  face_sizes = Array<int>();
+}
+
+Vector<MfxAttributeBinding> mfx_list_mesh_attributes(
+    const MeshComponent &component,
+    Span<MfxAttributeRequest> requests,
+    MfxVertexWeightCache *weight_cache)
+{
+  Vector<MfxAttributeBinding> bindings;
+  const Mesh *mesh = component.get_for_read();
+  if (NULL == mesh) {
+    return bindings;
+  }
+
+  // Legacy names come first because existing plugins rely on them
+  add_legacy_layer_bindings(mesh, requests, bindings);
+
+  component.attribute_foreach([&](StringRefNull name, const AttributeMetaData &meta_data) {
+    // Mandatory attributes are handled separately, and normals are derived data
+    if (name == "position" || name == "normal") {
+      return true;
+    }
+    // Builtin crease is always present, but only meaningful when enabled
+    if (name == "crease" && 0 == (mesh->cd_flag & ME_CDFLAG_EDGE_CREASE)) {
+      return true;
+    }
+    if (is_binding_name_used(bindings, name)) {
+      printf("WARNING: attribute '%s' is shadowed by a legacy layer name\n", name.c_str());
+      return true;
+    }
+
+    MfxAttributeBinding binding;
+    binding.name = name;
+    binding.domain = meta_data.domain;
+    binding.data_type = meta_data.data_type;
+    binding.attachment = attachment_from_domain(meta_data.domain);
+    binding.semantic = NULL;
+    binding.raw_data = NULL;
+    binding.raw_stride = 0;
+
+    if (NULL == binding.attachment || !set_ofx_type_from_data_type(binding)) {
+      printf("WARNING: attribute '%s' cannot be forwarded to OpenMfx\n", name.c_str());
+      return true;
+    }
+
+    const CustomData *custom_data = domain_custom_data(mesh, meta_data.domain);
+    void *layer = NULL;
+
+    if (ATTR_DOMAIN_CORNER == meta_data.domain &&
+        NULL != (layer = CustomData_get_layer_named(&mesh->ldata, CD_MLOOPUV, name.c_str()))) {
+      // UV map, forwarded with the stride of MLoopUV
+      binding.semantic = kOfxMeshAttribSemanticTextureCoordinate;
+      binding.raw_data = (char *)&((MLoopUV *)layer)[0].uv[0];
+      binding.raw_stride = sizeof(MLoopUV);
+    }
+    else if (ATTR_DOMAIN_CORNER == meta_data.domain &&
+             NULL != (layer = CustomData_get_layer_named(
+                          &mesh->ldata, CD_MLOOPCOL, name.c_str()))) {
+      // Byte vertex colors, forwarded in place rather than as Color4f
+      binding.type = kOfxMeshAttribTypeUByte;
+      binding.semantic = kOfxMeshAttribSemanticColor;
+      binding.raw_data = (char *)&((MLoopCol *)layer)[0].r;
+      binding.raw_stride = sizeof(MLoopCol);
+    }
+    else if (NULL != custom_data &&
+             NULL != (layer = CustomData_get_layer_named(
+                          custom_data, meta_data.data_type, name.c_str()))) {
+      // Generic attribute layer, contiguous
+      binding.raw_data = (char *)layer;
+      binding.raw_stride = CustomData_sizeof(meta_data.data_type);
+    }
+    else if (component.vertex_group_names().contains_as(name)) {
+      // Vertex group, only densified when explicitely requested
+      if (NULL == find_request(requests, name, kOfxMeshAttribPoint)) {
+        return true;
+      }
+      binding.semantic = kOfxMeshAttribSemanticWeight;
+      if (NULL != weight_cache) {
+        Span<float> weights = weight_cache->get(
+            mesh, component.vertex_group_names().lookup_as(name));
+        binding.raw_data = (char *)weights.data();
+        binding.raw_stride = sizeof(float);
+      }
+    }
+    // Other builtin attributes (material index, crease, etc.) are converted on copy
+
+    apply_requested_type(binding, requests);
+    bindings.append(binding);
+    return true;
+  });
+
+  return bindings;
+}
+
+Vector<MfxAttributeBinding> mfx_list_point_cloud_attributes(
+    const PointCloudComponent &component, Span<MfxAttributeRequest> requests)
+{
+  Vector<MfxAttributeBinding> bindings;
+  const PointCloud *pointcloud = component.get_for_read();
+  if (NULL == pointcloud) {
+    return bindings;
+  }
+
+  component.attribute_foreach([&](StringRefNull name, const AttributeMetaData &meta_data) {
+    // Position is mandatory and handled separately
+    if (name == "position") {
+      return true;
+    }
+
+    MfxAttributeBinding binding;
+    binding.name = name;
+    binding.domain = meta_data.domain;
+    binding.data_type = meta_data.data_type;
+    binding.attachment = attachment_from_domain(meta_data.domain);
+    binding.semantic = NULL;
+    binding.raw_data = NULL;
+    binding.raw_stride = 0;
+
+    if (NULL == binding.attachment || !set_ofx_type_from_data_type(binding)) {
+      printf("WARNING: attribute '%s' cannot be forwarded to OpenMfx\n", name.c_str());
+      return true;
+    }
+
+    // All point cloud attributes, radius included, are contiguous layers
+    void *layer = CustomData_get_layer_named(
+        &pointcloud->pdata, meta_data.data_type, name.c_str());
+    if (NULL != layer) {
+      binding.raw_data = (char *)layer;
+      binding.raw_stride = CustomData_sizeof(meta_data.data_type);
+    }
+
+    apply_requested_type(binding, requests);
+    bindings.append(binding);
+    return true;
+  });
+
+  return bindings;
+}
+
+/**
+ * Binding of an attribute read from the elements of a BMesh, whose custom
+ * data layer starts at the given offset in element blocks (-1 for none).
+ */
+static MfxAttributeBinding bmesh_binding(const char *name,
+                                         AttributeDomain domain,
+                                         CustomDataType data_type,
+                                         int bmesh_offset)
+{
+  MfxAttributeBinding binding;
+  binding.name = name;
+  binding.domain = domain;
+  binding.data_type = data_type;
+  binding.attachment = attachment_from_domain(domain);
+  binding.semantic = NULL;
+  binding.raw_data = NULL;
+  binding.raw_stride = 0;
+  binding.bmesh_offset = bmesh_offset;
+  set_ofx_type_from_data_type(binding);
+  return binding;
+}
+
+static bool is_generic_data_type(int type)
+{
+  switch (type) {
+    case CD_PROP_FLOAT:
+    case CD_PROP_FLOAT2:
+    case CD_PROP_FLOAT3:
+    case CD_PROP_COLOR:
+    case CD_PROP_INT32:
+    case CD_PROP_BOOL:
+      return true;
+    default:
+      return false;
+  }
+}
+
+Vector<MfxAttributeBinding> mfx_list_bmesh_attributes(
+    BMesh *bm,
+    const blender::Map<std::string, int> &vertex_group_names,
+    Span<MfxAttributeRequest> requests,
+    MfxVertexWeightCache *weight_cache)
+{
+  Vector<MfxAttributeBinding> bindings;
+  char name[MAX_CUSTOMDATA_LAYER_NAME];
+
+  // Legacy names come first, as for meshes (MLoopCol and MLoopUV values are
+  // at the start of their structs)
+  int vcolor_layers = CustomData_number_of_layers(&bm->ldata, CD_MLOOPCOL);
+  for (int k = 0; k < vcolor_layers; ++k) {
+    BLI_snprintf(name, sizeof(name), "color%d", k);
+    MfxAttributeBinding binding = bmesh_binding(
+        name, ATTR_DOMAIN_CORNER, CD_PROP_COLOR, CustomData_get_n_offset(&bm->ldata, CD_MLOOPCOL, k));
+    binding.type = kOfxMeshAttribTypeUByte;
+    binding.component_count = 3;
+    apply_requested_type(binding, requests);
+    bindings.append(binding);
+  }
+
+  int uv_layers = CustomData_number_of_layers(&bm->ldata, CD_MLOOPUV);
+  for (int k = 0; k < uv_layers; ++k) {
+    BLI_snprintf(name, sizeof(name), "uv%d", k);
+    MfxAttributeBinding binding = bmesh_binding(
+        name, ATTR_DOMAIN_CORNER, CD_PROP_FLOAT2, CustomData_get_n_offset(&bm->ldata, CD_MLOOPUV, k));
+    binding.semantic = kOfxMeshAttribSemanticTextureCoordinate;
+    apply_requested_type(binding, requests);
+    bindings.append(binding);
+  }
+
+  // Then the same attributes as the attribute API lists for meshes, in the same order
+  Vector<MfxAttributeBinding> named_bindings;
+  named_bindings.append(bmesh_binding("material_index", ATTR_DOMAIN_FACE, CD_PROP_INT32, -1));
+  named_bindings.append(bmesh_binding("shade_smooth", ATTR_DOMAIN_FACE, CD_PROP_BOOL, -1));
+  const int cd_edge_crease_offset = CustomData_get_offset(&bm->edata, CD_CREASE);
+  if (-1 != cd_edge_crease_offset) {
+    named_bindings.append(
+        bmesh_binding("crease", ATTR_DOMAIN_EDGE, CD_PROP_FLOAT, cd_edge_crease_offset));
+  }
+
+  for (int i = 0; i < bm->ldata.totlayer; ++i) {
+    const CustomDataLayer &layer = bm->ldata.layers[i];
+    if (CD_MLOOPUV == layer.type) {
+      MfxAttributeBinding binding = bmesh_binding(
+          layer.name, ATTR_DOMAIN_CORNER, CD_PROP_FLOAT2, layer.offset);
+      binding.semantic = kOfxMeshAttribSemanticTextureCoordinate;
+      named_bindings.append(binding);
+    }
+  }
+  for (int i = 0; i < bm->ldata.totlayer; ++i) {
+    const CustomDataLayer &layer = bm->ldata.layers[i];
+    if (CD_MLOOPCOL == layer.type) {
+      // Byte vertex colors, read in place rather than as Color4f
+      MfxAttributeBinding binding = bmesh_binding(
+          layer.name, ATTR_DOMAIN_CORNER, CD_PROP_COLOR, layer.offset);
+      binding.type = kOfxMeshAttribTypeUByte;
+      named_bindings.append(binding);
+    }
+  }
+
+  const std::pair<AttributeDomain, const CustomData *> domains[] = {
+      {ATTR_DOMAIN_CORNER, &bm->ldata},
+      {ATTR_DOMAIN_POINT, &bm->vdata},
+      {ATTR_DOMAIN_EDGE, &bm->edata},
+      {ATTR_DOMAIN_FACE, &bm->pdata},
+  };
+  for (const std::pair<AttributeDomain, const CustomData *> &domain : domains) {
+    if (ATTR_DOMAIN_POINT == domain.first) {
+      // Vertex groups, only densified when explicitely requested
+      for (const auto item : vertex_group_names.items()) {
+        if (NULL == find_request(requests, item.key, kOfxMeshAttribPoint)) {
+          continue;
+        }
+        if (NULL == weight_cache) {
+          printf("WARNING: vertex group '%s' cannot be read without a weight cache\n",
+                 item.key.c_str());
+          continue;
+        }
+        Span<float> weights = weight_cache->get(bm, item.value);
+        MfxAttributeBinding binding = bmesh_binding(
+            item.key.c_str(), ATTR_DOMAIN_POINT, CD_PROP_FLOAT, -1);
+        binding.semantic = kOfxMeshAttribSemanticWeight;
+        binding.raw_data = (char *)weights.data();
+        binding.raw_stride = sizeof(float);
+        named_bindings.append(binding);
+      }
+    }
+
+    const CustomData &custom_data = *domain.second;
+    for (int i = 0; i < custom_data.totlayer; ++i) {
+      const CustomDataLayer &layer = custom_data.layers[i];
+      if (is_generic_data_type(layer.type)) {
+        named_bindings.append(bmesh_binding(
+            layer.name, domain.first, (CustomDataType)layer.type, layer.offset));
+      }
+    }
+  }
+
+  for (MfxAttributeBinding &binding : named_bindings) {
+    if (is_binding_name_used(bindings, binding.name)) {
+      printf("WARNING: attribute '%s' is shadowed by a legacy layer name\n",
+             binding.name.c_str());
+      continue;
+    }
+    apply_requested_type(binding, requests);
+    bindings.append(binding);
+  }
+
+  return bindings;
+}
+
+/**
+ * Copy elements from Blender into an OpenMfx buffer, gathering the Blender
+ * element at address `src_element(i)` into OpenMfx element i, or zeroing it
+ * if the address is null. Components are cast when types differ, and spread
+ * dst_component_stride bytes apart on the OpenMfx side.
+ */
+template<typename ElementFunc>
+static void gather_element_pointers(OfxScalarType src_type,
+                                    char *dst_data,
+                                    int dst_stride,
+                                    int dst_component_stride,
+                                    OfxScalarType dst_type,
+                                    int dst_count,
+                                    int component_count,
+                                    const ElementFunc &src_element)
+{
+  const int src_scalar_size = ofx_scalar_size(src_type);
+  const int dst_scalar_size = ofx_scalar_size(dst_type);
+  const int element_size = component_count * dst_scalar_size;
+  const bool interleaved = dst_component_stride == dst_scalar_size;
+  blender::parallel_for(IndexRange(dst_count), ATTRIBUTE_GRAIN_SIZE, [&](IndexRange range) {
+    for (int64_t i : range) {
+      char *dst = dst_data + i * dst_stride;
+      const char *src = src_element((int)i);
+      if (NULL == src) {
+        if (interleaved) {
+          memset(dst, 0, element_size);
+        }
+        else {
+          for (int c = 0; c < component_count; ++c) {
+            memset(dst + (int64_t)c * dst_component_stride, 0, dst_scalar_size);
+          }
+        }
+      }
+      else if (src_type == dst_type && interleaved) {
+        memcpy(dst, src, element_size);
+      }
+      else {
+        for (int c = 0; c < component_count; ++c) {
+          store_component(dst_type,
+                          dst + (int64_t)c * dst_component_stride,
+                          load_component(src_type, src + c * src_scalar_size));
+        }
+      }
+    }
+  });
+}
+
+/**
+ * Same as gather_element_pointers() for Blender elements stored src_stride
+ * bytes apart, gathering the element of index `src_index(i)`, or zeroing it if
+ * the index is negative.
+ */
+template<typename IndexFunc>
+static void gather_elements(const char *src_data,
+                            int src_stride,
+                            OfxScalarType src_type,
+                            char *dst_data,
+                            int dst_stride,
+                            int dst_component_stride,
+                            OfxScalarType dst_type,
+                            int dst_count,
+                            int component_count,
+                            const IndexFunc &src_index)
+{
+  gather_element_pointers(src_type,
+                          dst_data,
+                          dst_stride,
+                          dst_component_stride,
+                          dst_type,
+                          dst_count,
+                          component_count,
+                          [&](int i) -> const char * {
+                            int j = src_index(i);
+                            return j < 0 ? NULL : src_data + (int64_t)j * src_stride;
+                          });
+}
+
+void mfx_fill_attribute_buffer(const GeometryComponent &component,
+                               const MfxAttributeBinding &binding,
+                               Span<int> loose_edges,
+                               char *ofx_data,
+                               int ofx_stride,
+                               int ofx_component_stride,
+                               int ofx_count)
+{
+  const OfxScalarType src_type = ofx_scalar_type(binding.native_type);
+  const OfxScalarType dst_type = ofx_scalar_type(binding.type);
+  if (0 == ofx_component_stride) {
+    ofx_component_stride = ofx_scalar_size(dst_type);
+  }
+
+  const char *src_data = binding.raw_data;
+  int src_stride = binding.raw_stride;
+
+  // Keep the attribute alive while reading from its span, which may be a
+  // temporary buffer (e.g. for vertex groups).
+  ReadAttributePtr attribute;
+  if (NULL == src_data) {
+    attribute = component.attribute_try_get_for_read(
+        binding.name, binding.domain, binding.data_type);
+    if (!attribute) {
+      printf("WARNING: could not read attribute '%s'\n", binding.name.c_str());
+      gather_elements(NULL,
+                      0,
+                      src_type,
+                      ofx_data,
+                      ofx_stride,
+                      ofx_component_stride,
+                      dst_type,
+                      ofx_count,
+                      binding.component_count,
+                      [](int) { return -1; });
+      return;
+    }
+    blender::fn::GSpan span = attribute->get_span();
+    src_data = (const char *)span.data();
+    src_stride = (int)span.type().size();
+  }
+
+  if (ATTR_DOMAIN_EDGE == binding.domain) {
+    // Each corner gets the value of the edge that it starts. Corners added
+    // for loose edges get the value of their loose edge.
+    const Mesh *mesh = static_cast<const MeshComponent &>(component).get_for_read();
+    const MLoop *mloop = mesh->mloop;
+    const int totloop = mesh->totloop;
+    gather_elements(src_data,
+                    src_stride,
+                    src_type,
+                    ofx_data,
+                    ofx_stride,
+                    ofx_component_stride,
+                    dst_type,
+                    ofx_count,
+                    binding.component_count,
+                    [&](int i) {
+                      if (i < totloop) {
+                        return (int)mloop[i].e;
+                      }
+                      int k = (i - totloop) / 2;
+                      return k < loose_edges.size() ? loose_edges[k] : -1;
+                    });
+    return;
+  }
+
+  // Other domains match one to one, up to the loose edge elements appended
+  // at the end of corners and faces.
+  const int domain_size = component.attribute_domain_size(binding.domain);
+  gather_elements(src_data,
+                  src_stride,
+                  src_type,
+                  ofx_data,
+                  ofx_stride,
+                  ofx_component_stride,
+                  dst_type,
+                  ofx_count,
+                  binding.component_count,
+                  [&](int i) { return i < domain_size ? i : -1; });
+}
+
+void mfx_fill_bmesh_attribute_buffer(const BMesh *bm,
+                                     const MfxBMeshTopology &topology,
+                                     const MfxAttributeBinding &binding,
+                                     char *ofx_data,
+                                     int ofx_stride,
+                                     int ofx_component_stride,
+                                     int ofx_count)
+{
+  OfxScalarType src_type = ofx_scalar_type(binding.native_type);
+  const OfxScalarType dst_type = ofx_scalar_type(binding.type);
+  if (0 == ofx_component_stride) {
+    ofx_component_stride = ofx_scalar_size(dst_type);
+  }
+
+  auto gather = [&](const auto &src_element) {
+    gather_element_pointers(src_type,
+                            ofx_data,
+                            ofx_stride,
+                            ofx_component_stride,
+                            dst_type,
+                            ofx_count,
+                            binding.component_count,
+                            src_element);
+  };
+
+  // Densified values, i.e. vertex group weights
+  if (NULL != binding.raw_data) {
+    const int totvert = bm->totvert;
+    gather_elements(binding.raw_data,
+                    binding.raw_stride,
+                    src_type,
+                    ofx_data,
+                    ofx_stride,
+                    ofx_component_stride,
+                    dst_type,
+                    ofx_count,
+                    binding.component_count,
+                    [&](int i) { return i < totvert ? i : -1; });
+    return;
+  }
+
+  const int offset = binding.bmesh_offset;
+  const int totvert = bm->totvert;
+  const int totface = bm->totface;
+  const int totloop = (int)topology.corner_loops.size();
+  BMVert *const *vtable = bm->vtable;
+  BMFace *const *ftable = bm->ftable;
+  Span<BMLoop *> corner_loops = topology.corner_loops;
+  Span<BMEdge *> loose_edges = topology.loose_edges;
+
+  switch (binding.domain) {
+    case ATTR_DOMAIN_POINT:
+      gather([&](int i) -> const char * {
+        return i < totvert ? (const char *)BM_ELEM_CD_GET_VOID_P(vtable[i], offset) : NULL;
+      });
+      break;
+    case ATTR_DOMAIN_CORNER:
+      gather([&](int i) -> const char * {
+        return i < totloop ? (const char *)BM_ELEM_CD_GET_VOID_P(corner_loops[i], offset) : NULL;
+      });
+      break;
+    case ATTR_DOMAIN_EDGE:
+      // Each corner gets the value of the edge that it starts. Corners added
+      // for loose edges get the value of their loose edge.
+      gather([&](int i) -> const char * {
+        const BMEdge *e = NULL;
+        if (i < totloop) {
+          e = corner_loops[i]->e;
+        }
+        else if ((i - totloop) / 2 < loose_edges.size()) {
+          e = loose_edges[(i - totloop) / 2];
+        }
+        return NULL != e ? (const char *)BM_ELEM_CD_GET_VOID_P(e, offset) : NULL;
+      });
+      break;
+    case ATTR_DOMAIN_FACE:
+      if (-1 != offset) {
+        gather([&](int i) -> const char * {
+          return i < totface ? (const char *)BM_ELEM_CD_GET_VOID_P(ftable[i], offset) : NULL;
+        });
+      }
+      else if (binding.name == "material_index") {
+        src_type = OfxScalarType::Short;
+        gather([&](int i) -> const char * {
+          return i < totface ? (const char *)&ftable[i]->mat_nr : NULL;
+        });
+      }
+      else {
+        // Smooth flag, the only other attribute stored in faces
+        static const unsigned char flag_values[2] = {0, 1};
+        gather([&](int i) -> const char * {
+          if (i >= totface) {
+            return NULL;
+          }
+          return (const char *)&flag_values[BM_elem_flag_test(ftable[i], BM_ELEM_SMOOTH) ? 1 : 0];
+        });
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+// ----------------------------------------------------------------------------
+// OpenMfx -> Blender
+
+/**
+ * Read the first components of an OpenMfx element as floats. Missing
+ * components are left untouched.
+ */
+static void load_element_as_float(const MfxAttributeBuffer &buffer,
+                                  OfxScalarType type,
+                                  const char *element,
+                                  float *r_values,
+                                  int count)
+{
+  int n = count < buffer.component_count ? count : buffer.component_count;
+  float scale = 1.0f;
+  if (semantic_is(buffer.semantic, kOfxMeshAttribSemanticColor)) {
+    scale = OfxScalarType::UByte == type ? 1.0f / 255.0f :
+            OfxScalarType::UShort == type ? 1.0f / 65535.0f :
+                                            1.0f;
+  }
+  for (int c = 0; c < n; ++c) {
+    r_values[c] = (float)load_component(type, element + c * buffer.component_stride) * scale;
+  }
+}
+
+static int load_element_as_int(OfxScalarType type, const char *element)
+{
+  return clamp_component<int>(load_component(type, element));
+}
+
+/**
+ * Deduce the Blender data type of an output attribute that does not exist in
+ * the source mesh.
+ */
+static CustomDataType data_type_from_ofx(OfxScalarType type, int component_count)
+{
+  if (!is_floating(type) && 1 == component_count) {
+    return CD_PROP_INT32;
+  }
+  // Vectors of integers have no generic counterpart in Blender, they are stored as floats
+  switch (component_count) {
+    case 1:
+      return CD_PROP_FLOAT;
+    case 2:
+      return CD_PROP_FLOAT2;
+    case 3:
+      return CD_PROP_FLOAT3;
+    default:
+      return CD_PROP_COLOR;
+  }
+}
+
+/**
+ * Convert OpenMfx elements into a contiguous Blender buffer of the given data
+ * type, reading OpenMfx element `src_index(i)` for Blender element i.
+ */
+template<typename IndexFunc>
+static void scatter_converted(const MfxAttributeBuffer &buffer,
+                              CustomDataType data_type,
+                              char *dst_data,
+                              int dst_size,
+                              const IndexFunc &src_index)
+{
+  OfxScalarType type = ofx_scalar_type(buffer.type);
+  int dst_element_size = CustomData_sizeof(data_type);
+  int src_element_size = buffer.component_count * ofx_scalar_size(type);
+
+  // When layouts match, this is a strided copy
+  CustomDataType native_type = data_type_from_ofx(type, buffer.component_count);
+  bool same_layout = native_type == data_type && src_element_size == dst_element_size &&
+                     buffer.component_stride == ofx_scalar_size(type) &&
+                     (OfxScalarType::Float == type || CD_PROP_INT32 == data_type);
+
+  blender::parallel_for(IndexRange(dst_size), ATTRIBUTE_GRAIN_SIZE, [&](IndexRange range) {
+    for (int64_t i : range) {
+      const char *src = buffer.data + (int64_t)src_index((int)i) * buffer.stride;
+      char *dst = dst_data + i * dst_element_size;
+      if (same_layout) {
+        memcpy(dst, src, dst_element_size);
+        continue;
+      }
+      switch (data_type) {
+        case CD_PROP_INT32:
+          *(int *)dst = load_element_as_int(type, src);
+          break;
+        case CD_PROP_BOOL:
+          *(bool *)dst = 0 != load_element_as_int(type, src);
+          break;
+        case CD_PROP_COLOR: {
+          float values[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+          load_element_as_float(buffer, type, src, values, 4);
+          memcpy(dst, values, sizeof(values));
+          break;
+        }
+        default: {
+          float values[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+          int count = dst_element_size / (int)sizeof(float);
+          load_element_as_float(buffer, type, src, values, count);
+          memcpy(dst, values, count * sizeof(float));
+          break;
+        }
+      }
+    }
+  });
+}
+
+static int legacy_layer_index(const char *name, const char *prefix)
+{
+  size_t len = strlen(prefix);
+  if (0 != strncmp(name, prefix, len) || name[len] < '0' || name[len] > '9' ||
+      '\0' != name[len + 1]) {
+    return -1;
+  }
+  int k = name[len] - '0';
+  return k < MAX_LEGACY_LAYERS ? k : -1;
+}
+
+/**
+ * Get the k-th layer of the given legacy loop type, adding layers if needed.
+ */
+static void *ensure_loop_layer_n(Mesh *mesh, CustomDataType type, int k)
+{
+  while (CustomData_number_of_layers(&mesh->ldata, type) <= k) {
+    CustomData_add_layer(&mesh->ldata, type, CD_CALLOC, NULL, mesh->totloop);
+  }
+  return CustomData_duplicate_referenced_layer_n(&mesh->ldata, type, k, mesh->totloop);
+}
+
+/**
+ * Get the layer of the given legacy loop type with the given name, adding it
+ * if needed.
+ */
+static void *ensure_loop_layer_named(Mesh *mesh, CustomDataType type, const char *name)
+{
+  if (-1 == CustomData_get_named_layer_index(&mesh->ldata, type, name)) {
+    CustomData_add_layer_named(&mesh->ldata, type, CD_CALLOC, NULL, mesh->totloop, name);
+  }
+  return CustomData_duplicate_referenced_layer_named(&mesh->ldata, type, name, mesh->totloop);
+}
+
+static bool write_uv_layer(Mesh *mesh,
+                           MLoopUV *uv_data,
+                           const MfxAttributeBuffer &buffer,
+                           Span<int> loop_to_corner)
+{
+  if (NULL == uv_data) {
+    return false;
+  }
+  OfxScalarType type = ofx_scalar_type(buffer.type);
+  blender::parallel_for(IndexRange(mesh->totloop), ATTRIBUTE_GRAIN_SIZE, [&](IndexRange range) {
+    for (int64_t i : range) {
+      int corner = loop_to_corner.is_empty() ? (int)i : loop_to_corner[i];
+      const char *src = buffer.data + (int64_t)corner * buffer.stride;
+      load_element_as_float(buffer, type, src, uv_data[i].uv, 2);
+    }
+  });
+  mesh->runtime.cd_dirty_loop |= CD_MASK_MLOOPUV;
+  mesh->runtime.cd_dirty_poly |= CD_MASK_MTFACE;
+  return true;
+}
+
+static bool write_color_layer(Mesh *mesh,
+                              MLoopCol *vcolor_data,
+                              const MfxAttributeBuffer &buffer,
+                              Span<int> loop_to_corner)
+{
+  if (NULL == vcolor_data) {
+    return false;
+  }
+  OfxScalarType type = ofx_scalar_type(buffer.type);
+  blender::parallel_for(IndexRange(mesh->totloop), ATTRIBUTE_GRAIN_SIZE, [&](IndexRange range) {
+    for (int64_t i : range) {
+      int corner = loop_to_corner.is_empty() ? (int)i : loop_to_corner[i];
+      const char *src = buffer.data + (int64_t)corner * buffer.stride;
+      unsigned char *dst = &vcolor_data[i].r;
+      if (OfxScalarType::UByte == type && 1 == buffer.component_stride) {
+        int n = buffer.component_count < 4 ? buffer.component_count : 4;
+        memcpy(dst, src, n);
+        if (n < 4) {
+          dst[3] = 255;
+        }
+      }
+      else {
+        float values[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+        load_element_as_float(buffer, type, src, values, 4);
+        for (int c = 0; c < 4; ++c) {
+          float v = values[c] < 0.0f ? 0.0f : (values[c] > 1.0f ? 1.0f : values[c]);
+          dst[c] = (unsigned char)(v * 255.0f + 0.5f);
+        }
+      }
+    }
+  });
+  return true;
+}
+
+bool mfx_write_attribute_buffer(MeshComponent &component,
+                                const MeshComponent *source_component,
+                                const MfxAttributeBuffer &ofx_buffer,
+                                Span<int> loop_to_corner,
+                                Span<int> poly_to_face)
+{
+  Mesh *mesh = component.get_for_write();
+  const AttributeDomain ofx_domain = domain_from_attachment(ofx_buffer.attachment);
+  const OfxScalarType type = ofx_scalar_type(ofx_buffer.type);
+
+  // Buffers forwarded from inputs may not specify their component stride
+  MfxAttributeBuffer buffer = ofx_buffer;
+  if (0 == buffer.component_stride) {
+    buffer.component_stride = ofx_scalar_size(type);
+  }
+
+  if (NULL == mesh || NULL == buffer.data || ATTR_DOMAIN_NUM == ofx_domain ||
+      OfxScalarType::Unknown == type) {
+    return false;
+  }
+
+  // Legacy names used by plugins, mapping to the n-th UV map or color layer
+  if (ATTR_DOMAIN_CORNER == ofx_domain) {
+    int k = legacy_layer_index(buffer.name, "uv");
+    if (-1 != k) {
+      return write_uv_layer(
+          mesh, (MLoopUV *)ensure_loop_layer_n(mesh, CD_MLOOPUV, k), buffer, loop_to_corner);
+    }
+    k = legacy_layer_index(buffer.name, "color");
+    if (-1 != k) {
+      return write_color_layer(
+          mesh, (MLoopCol *)ensure_loop_layer_n(mesh, CD_MLOOPCOL, k), buffer, loop_to_corner);
+    }
+  }
+
+  // Figure out domain and type from the source mesh, if it has this attribute
+  AttributeDomain domain = ofx_domain;
+  CustomDataType data_type = data_type_from_ofx(type, buffer.component_count);
+  ReadAttributePtr source_attribute;
+  if (NULL != source_component) {
+    source_attribute = source_component->attribute_try_get_for_read(buffer.name);
+  }
+  const bool has_source_attribute = static_cast<bool>(source_attribute);
+  if (has_source_attribute) {
+    AttributeDomain source_domain = source_attribute->domain();
+    if (source_domain == ofx_domain ||
+        (ATTR_DOMAIN_EDGE == source_domain && ATTR_DOMAIN_CORNER == ofx_domain)) {
+      domain = source_domain;
+    }
+    data_type = source_attribute->custom_data_type();
+    source_attribute.reset();
+  }
+
+  if (ATTR_DOMAIN_CORNER == domain) {
+    // UV maps and byte colors keep their legacy storage
+    const Mesh *source_mesh = source_component ? source_component->get_for_read() : NULL;
+    bool is_uv, is_color;
+    if (has_source_attribute) {
+      is_uv = -1 != CustomData_get_named_layer_index(&source_mesh->ldata, CD_MLOOPUV, buffer.name);
+      is_color = -1 !=
+                 CustomData_get_named_layer_index(&source_mesh->ldata, CD_MLOOPCOL, buffer.name);
+    }
+    else {
+      is_uv = is_floating(type) && 2 == buffer.component_count &&
+              semantic_is(buffer.semantic, kOfxMeshAttribSemanticTextureCoordinate);
+      is_color = OfxScalarType::UByte == type && buffer.component_count >= 3 &&
+                 semantic_is(buffer.semantic, kOfxMeshAttribSemanticColor);
+    }
+    if (is_uv) {
+      return write_uv_layer(mesh,
+                            (MLoopUV *)ensure_loop_layer_named(mesh, CD_MLOOPUV, buffer.name),
+                            buffer,
+                            loop_to_corner);
+    }
+    if (is_color) {
+      return write_color_layer(mesh,
+                               (MLoopCol *)ensure_loop_layer_named(mesh, CD_MLOOPCOL, buffer.name),
+                               buffer,
+                               loop_to_corner);
+    }
+  }
+
+  OutputAttributePtr attribute = component.attribute_try_get_for_output(
+      buffer.name, domain, data_type);
+  if (!attribute) {
+    printf("WARNING: could not write attribute '%s' to Blender mesh\n", buffer.name);
+    return false;
+  }
+  blender::fn::GMutableSpan span = attribute->get_span_for_write_only();
+  char *dst_data = (char *)span.data();
+  int dst_size = (int)span.size();
+
+  switch (domain) {
+    case ATTR_DOMAIN_CORNER:
+      scatter_converted(buffer, data_type, dst_data, dst_size, [&](int i) {
+        return loop_to_corner.is_empty() ? i : loop_to_corner[i];
+      });
+      break;
+    case ATTR_DOMAIN_FACE:
+      scatter_converted(buffer, data_type, dst_data, dst_size, [&](int i) {
+        return poly_to_face.is_empty() ? i : poly_to_face[i];
+      });
+      break;
+    case ATTR_DOMAIN_EDGE: {
+      // Each edge gets the value of (one of) the corners starting it. Edges that
+      // are not used by any corner, like loose edges, keep a zero value.
+      Vector<int> edge_to_corner(dst_size, -1);
+      for (int l = 0; l < mesh->totloop; ++l) {
+        edge_to_corner[mesh->mloop[l].e] = loop_to_corner.is_empty() ? l : loop_to_corner[l];
+      }
+      int element_size = CustomData_sizeof(data_type);
+      memset(dst_data, 0, (size_t)dst_size * element_size);
+      Vector<int> used_edges;
+      for (int e = 0; e < dst_size; ++e) {
+        if (-1 != edge_to_corner[e]) {
+          used_edges.append(e);
+        }
+      }
+      Vector<char> values(used_edges.size() * element_size);
+      scatter_converted(buffer, data_type, values.data(), (int)used_edges.size(), [&](int i) {
+        return edge_to_corner[used_edges[i]];
+      });
+      for (int i = 0; i < used_edges.size(); ++i) {
+        memcpy(dst_data + (int64_t)used_edges[i] * element_size,
+               values.data() + (int64_t)i * element_size,
+               element_size);
+      }
+      if (STREQ(buffer.name, "crease")) {
+        mesh->cd_flag |= ME_CDFLAG_EDGE_CREASE;
+      }
+      break;
+    }
+    default:
+      scatter_converted(buffer, data_type, dst_data, dst_size, [&](int i) { return i; });
+      break;
+  }
+
+  attribute.apply_span_and_save();
+  return true;
+}
+
+bool mfx_write_point_cloud_attribute_buffer(PointCloudComponent &component,
+                                            const PointCloudComponent *source_component,
+                                            const MfxAttributeBuffer &ofx_buffer)
+{
+  const OfxScalarType type = ofx_scalar_type(ofx_buffer.type);
+
+  MfxAttributeBuffer buffer = ofx_buffer;
+  if (0 == buffer.component_stride) {
+    buffer.component_stride = ofx_scalar_size(type);
+  }
+
+  if (NULL == buffer.data || ATTR_DOMAIN_POINT != domain_from_attachment(buffer.attachment) ||
+      OfxScalarType::Unknown == type) {
+    return false;
+  }
+
+  CustomDataType data_type = data_type_from_ofx(type, buffer.component_count);
+  if (NULL != source_component) {
+    ReadAttributePtr source_attribute = source_component->attribute_try_get_for_read(
+        buffer.name);
+    if (source_attribute && ATTR_DOMAIN_POINT == source_attribute->domain()) {
+      data_type = source_attribute->custom_data_type();
+    }
+  }
+
+  OutputAttributePtr attribute = component.attribute_try_get_for_output(
+      buffer.name, ATTR_DOMAIN_POINT, data_type);
+  if (!attribute) {
+    printf("WARNING: could not write attribute '%s' to Blender point cloud\n", buffer.name);
+    return false;
+  }
+  blender::fn::GMutableSpan span = attribute->get_span_for_write_only();
+  scatter_converted(
+      buffer, data_type, (char *)span.data(), (int)span.size(), [](int i) { return i; });
+  attribute.apply_span_and_save();
+  return true;
+}
@@ -0,0 +1,265 @@
+/**
+ * OpenMfx modifier for Blender
+ * Copyright (C) 2019 - 2021 Elie Michel
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** \file
+ * \ingroup openmesheffect
+ * Mapping between Blender's generic attributes (as exposed by the attribute
+ * API of geometry components) and OpenMfx mesh attributes.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "BLI_array.hh"
+#include "BLI_map.hh"
+#include "BLI_span.hh"
+#include "BLI_vector.hh"
+
+#include "BKE_attribute.h"
+#include "BKE_geometry_set.hh"
+
+#include "DNA_customdata_types.h"
+
+struct BMEdge;
+struct BMLoop;
+struct BMesh;
+struct Mesh;
+
+/**
+ * Describes how a Blender attribute is exposed to an effect.
+ */
+struct MfxAttributeBinding {
+  std::string name;
+
+  // Blender side
+  AttributeDomain domain;
+  CustomDataType data_type;
+
+  // OpenMfx side (all strings are static)
+  const char *attachment;
+  const char *type;
+  const char *semantic;
+  int component_count;
+
+  /**
+   * OpenMfx type matching the layout of Blender data. It differs from type
+   * when the effect requested a different type, e.g. half floats.
+   */
+  const char *native_type;
+
+  /**
+   * When not null, attribute values can be read in place from this buffer,
+   * with one element every raw_stride bytes (in the Blender domain).
+   */
+  char *raw_data;
+  int raw_stride;
+
+  /**
+   * When read from a BMesh and raw_data is null, offset of the layer in the
+   * custom data blocks of its elements, or -1 for attributes stored in the
+   * elements themselves (material index and smooth flag).
+   */
+  int bmesh_offset = -1;
+
+  /**
+   * The Blender buffer can be forwarded as is if there is no extra OpenMfx
+   * element, which is the case when there is no loose edge, or for points,
+   * and if no type conversion is needed. Edge attributes are attached to
+   * corners, so they must always be gathered through the edges of loops.
+   */
+  bool can_share_buffer(bool has_loose_edges) const
+  {
+    return raw_data != nullptr && type == native_type && domain != ATTR_DOMAIN_EDGE &&
+           (!has_loose_edges || domain == ATTR_DOMAIN_POINT);
+  }
+};
+
+/**
+ * Attribute requested by an effect on one of its inputs.
+ */
+struct MfxAttributeRequest {
+  std::string name;
+  const char *attachment;
+  const char *type;
+  int component_count;
+};
+
+/**
+ * Dense vertex group weights, computed on demand and shared by all the inputs
+ * reading the same evaluated mesh during a cook.
+ */
+class MfxVertexWeightCache {
+ public:
+  /**
+   * Get the weight of each vertex in the given vertex group, densifying the
+   * sparse deform vertices on first call.
+   */
+  blender::Span<float> get(const Mesh *mesh, int vertex_group_index);
+
+  /**
+   * Same for the deform vertices stored in the custom data blocks of an
+   * edit-mode BMesh.
+   */
+  blender::Span<float> get(BMesh *bm, int vertex_group_index);
+
+  void clear();
+
+ private:
+  blender::Map<std::pair<const void *, int>, blender::Array<float>> m_weights;
+};
+
+/**
+ * Element tables of an edit-mode BMesh, giving the BMesh element behind each
+ * OpenMfx corner and loose edge face. They remain valid as long as the
+ * topology of the BMesh does not change, which is the case while transforming
+ * elements, so that they are kept from one cook to the next.
+ */
+struct MfxBMeshTopology {
+  const BMesh *bm = nullptr;
+  int totvert = 0;
+  int totedge = 0;
+  int totloop = 0;
+  int totface = 0;
+
+  // Loops of the BMesh faces, face after face, i.e. in the order of OpenMfx corners
+  blender::Array<BMLoop *> corner_loops;
+  // Wire edges, turned into 2-corner faces after the BMesh faces
+  blender::Vector<BMEdge *> loose_edges;
+
+  // Point of each corner and size of each face, loose edges included
+  blender::Array<int> corner_points;
+  blender::Array<int> face_sizes;
+
+  /**
+   * Whether the tables were built from this BMesh with its current element
+   * counts. It cannot tell whether the topology changed otherwise.
+   */
+  bool matches(const BMesh *bm) const;
+
+  /**
+   * Rebuild the tables, in parallel over faces. This also ensures the index
+   * and lookup tables of vertices and faces of the BMesh.
+   */
+  void update(BMesh *bm);
+
+  void clear();
+};
+
+/**
+ * List the attributes of a mesh that are forwarded to effects, besides the
+ * mandatory ones (point position, corner point and face size). The component
+ * must wrap the mesh and know about the vertex groups of its object.
+ *
+ * Vertex groups are only forwarded when the effect requested a point
+ * attribute with the same name, since densifying them is costly. When a
+ * weight cache is provided, their dense weights are shared from it.
+ *
+ * When a request matches an attribute with a different type, for instance
+ * half floats or doubles, the attribute is converted to the requested type.
+ */
+blender::Vector<MfxAttributeBinding> mfx_list_mesh_attributes(
+    const MeshComponent &component,
+    blender::Span<MfxAttributeRequest> requests,
+    MfxVertexWeightCache *weight_cache);
+
+/**
+ * List the attributes of an edit-mode BMesh that are forwarded to effects,
+ * with the same names and types as mfx_list_mesh_attributes() gives for the
+ * mesh that Blender would convert it into. Except for vertex groups, which are
+ * densified in the weight cache, none of them can share buffers.
+ */
+blender::Vector<MfxAttributeBinding> mfx_list_bmesh_attributes(
+    BMesh *bm,
+    const blender::Map<std::string, int> &vertex_group_names,
+    blender::Span<MfxAttributeRequest> requests,
+    MfxVertexWeightCache *weight_cache);
+
+/**
+ * List the attributes of a point cloud that are forwarded to effects, besides
+ * point position. Generic layers, including the radius, are read in place.
+ */
+blender::Vector<MfxAttributeBinding> mfx_list_point_cloud_attributes(
+    const PointCloudComponent &component, blender::Span<MfxAttributeRequest> requests);
+
+/**
+ * Fill an OpenMfx attribute buffer with values from Blender. OpenMfx elements
+ * that do not exist in Blender, namely the corners and faces added for loose
+ * edges, are zeroed except for edge attributes that exist on loose edges.
+ * \param loose_edges indices of the edges turned into 2-corner faces, in order.
+ * \param ofx_component_stride offset in bytes between two components of an
+ * element, which differs from the scalar size in planar layouts (0 for default).
+ */
+void mfx_fill_attribute_buffer(const GeometryComponent &component,
+                               const MfxAttributeBinding &binding,
+                               blender::Span<int> loose_edges,
+                               char *ofx_data,
+                               int ofx_stride,
+                               int ofx_component_stride,
+                               int ofx_count);
+
+/**
+ * Same as mfx_fill_attribute_buffer() for an attribute listed by
+ * mfx_list_bmesh_attributes(), reading elements in the order of the tables.
+ */
+void mfx_fill_bmesh_attribute_buffer(const BMesh *bm,
+                                     const MfxBMeshTopology &topology,
+                                     const MfxAttributeBinding &binding,
+                                     char *ofx_data,
+                                     int ofx_stride,
+                                     int ofx_component_stride,
+                                     int ofx_count);
+
+/**
+ * Description of an OpenMfx attribute buffer read back into Blender.
+ */
+struct MfxAttributeBuffer {
+  const char *name;
+  const char *attachment;
+  const char *type;
+  const char *semantic;
+  int component_count;
+  const char *data;
+  int stride;
+  int component_stride;
+};
+
+/**
+ * Write an attribute from an effect's output into a Blender mesh. The target
+ * domain and type are those of an attribute with the same name on the source
+ * mesh if any, otherwise they are deduced from the OpenMfx description.
+ * \param loop_to_corner for each Blender loop its OpenMfx corner, or empty
+ * when they match.
+ * \param poly_to_face for each Blender poly its OpenMfx face, or empty when
+ * they match.
+ * \return false if the attribute could not be stored in the mesh
+ */
+bool mfx_write_attribute_buffer(MeshComponent &component,
+                                const MeshComponent *source_component,
+                                const MfxAttributeBuffer &buffer,
+                                blender::Span<int> loop_to_corner,
+                                blender::Span<int> poly_to_face);
+
+/**
+ * Write a point attribute from an effect's output into a Blender point cloud,
+ * matching the type of the source attribute with the same name if any.
+ * \return false if the attribute could not be stored in the point cloud
+ */
+bool mfx_write_point_cloud_attribute_buffer(PointCloudComponent &component,
+                                            const PointCloudComponent *source_component,
+                                            const MfxAttributeBuffer &buffer);
@@ -0,0 +1,527 @@
+/**
+ * Open Mesh Effect modifier for Blender
+ * Copyright (C) 2019 - 2021 Elie Michel
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** \file
+ * \ingroup openmesheffect
+ */
+
+#include "mfxBakeCache.h"
+
+#include "DNA_customdata_types.h"
+#include "DNA_meshdata_types.h"
+
+#include "BKE_customdata.h"
+#include "BKE_main.h" // BKE_main_blendfile_path_from_global
+#include "BKE_mesh.h" // BKE_mesh_new_nomain
+
+#include "BLI_fileops.h"
+#include "BLI_math_base.h"
+#include "BLI_mmap.h"
+#include "BLI_path_util.h"
+#include "BLI_string.h"
+#include "BLI_task.hh" // parallel_for
+#include "BLI_vector.hh"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#ifndef WIN32
+#  include <unistd.h>
+#else
+#  include <io.h>
+#endif
+
+namespace {
+
+const char kCacheMagic[8] = {'M', 'F', 'X', 'C', 'A', 'C', 'H', 'E'};
+const int kCacheVersion = 1;
+
+/** CacheHeader::flag */
+enum {
+  /** Edges, loops and polygons are those of the reference frame */
+  CACHE_FLAG_SHARED_TOPOLOGY = (1 << 0),
+  /** Positions are stored as 16 bit deltas to the reference frame */
+  CACHE_FLAG_QUANTIZED_POSITIONS = (1 << 1),
+};
+
+/** Domain of a CacheLayer */
+enum {
+  CACHE_DOMAIN_VERT = 0,
+  CACHE_DOMAIN_EDGE = 1,
+  CACHE_DOMAIN_LOOP = 2,
+  CACHE_DOMAIN_POLY = 3,
+};
+
+/**
+ * Sections are stored after the header, aligned to kSectionAlignment bytes from the start of
+ * the file, which is itself page aligned once mapped.
+ */
+struct CacheHeader {
+  char magic[8];
+  int version;
+  int flag;
+  int totvert, totedge, totloop, totpoly;
+  int layer_count;
+  /** Quantization step of position deltas, when CACHE_FLAG_QUANTIZED_POSITIONS is set */
+  float position_step;
+  uint64_t positions_offset;
+  uint64_t edges_offset;
+  uint64_t loops_offset;
+  uint64_t polys_offset;
+  uint64_t layers_offset;
+};
+
+struct CacheLayer {
+  char name[MAX_CUSTOMDATA_LAYER_NAME];
+  int domain;
+  int type;
+  uint64_t offset;
+  uint64_t size;
+};
+
+const size_t kSectionAlignment = 16;
+
+/**
+ * Generic attribute layers that are plain arrays and can be stored as is. Other layers (e.g.
+ * deform weights) point to separate allocations and are not cached.
+ */
+bool is_cached_layer_type(int type)
+{
+  switch (type) {
+    case CD_PROP_FLOAT:
+    case CD_PROP_FLOAT2:
+    case CD_PROP_FLOAT3:
+    case CD_PROP_INT32:
+    case CD_PROP_COLOR:
+    case CD_PROP_BOOL:
+    case CD_MLOOPUV:
+    case CD_MLOOPCOL:
+      return true;
+    default:
+      return false;
+  }
+}
+
+/**
+ * A cache file mapped in memory for the lifetime of the object
+ */
+class MappedCacheFile {
+ public:
+  MappedCacheFile(const char *path)
+  {
+    if (NULL == path) {
+      return;
+    }
+    m_fd = BLI_open(path, O_BINARY | O_RDONLY, 0);
+    if (m_fd == -1) {
+      return;
+    }
+    m_size = BLI_file_descriptor_size(m_fd);
+    if (m_size < sizeof(CacheHeader) || m_size == (size_t)-1) {
+      return;
+    }
+    m_file = BLI_mmap_open(m_fd);
+    if (NULL == m_file) {
+      return;
+    }
+    m_data = (const char *)BLI_mmap_get_pointer(m_file);
+  }
+
+  ~MappedCacheFile()
+  {
+    if (NULL != m_file) {
+      BLI_mmap_free(m_file);
+    }
+    if (m_fd != -1) {
+      close(m_fd);
+    }
+  }
+
+  MappedCacheFile(const MappedCacheFile &) = delete;
+  MappedCacheFile &operator=(const MappedCacheFile &) = delete;
+
+  /**
+   * The file exists, has a valid header and all its sections are within bounds
+   */
+  bool is_valid() const
+  {
+    if (NULL == m_data) {
+      return false;
+    }
+    const CacheHeader &h = header();
+    if (0 != memcmp(h.magic, kCacheMagic, sizeof(kCacheMagic)) || h.version != kCacheVersion ||
+        h.totvert < 0 || h.totedge < 0 || h.totloop < 0 || h.totpoly < 0 || h.layer_count < 0) {
+      return false;
+    }
+    const size_t position_size = (h.flag & CACHE_FLAG_QUANTIZED_POSITIONS) ?
+                                     sizeof(int16_t[3]) :
+                                     sizeof(float[3]);
+    if (!contains(h.positions_offset, position_size * h.totvert) ||
+        !contains(h.layers_offset, sizeof(CacheLayer) * h.layer_count)) {
+      return false;
+    }
+    if (0 == (h.flag & CACHE_FLAG_SHARED_TOPOLOGY) &&
+        (!contains(h.edges_offset, sizeof(MEdge) * h.totedge) ||
+         !contains(h.loops_offset, sizeof(MLoop) * h.totloop) ||
+         !contains(h.polys_offset, sizeof(MPoly) * h.totpoly))) {
+      return false;
+    }
+    for (const CacheLayer &layer : layers()) {
+      if (!contains(layer.offset, layer.size)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  const CacheHeader &header() const
+  {
+    return *(const CacheHeader *)m_data;
+  }
+
+  blender::Span<CacheLayer> layers() const
+  {
+    return blender::Span<CacheLayer>((const CacheLayer *)(m_data + header().layers_offset),
+                                     header().layer_count);
+  }
+
+  template<typename T> const T *section(uint64_t offset) const
+  {
+    return (const T *)(m_data + offset);
+  }
+
+ private:
+  bool contains(uint64_t offset, uint64_t size) const
+  {
+    return offset <= m_size && size <= m_size - offset;
+  }
+
+  int m_fd = -1;
+  size_t m_size = 0;
+  BLI_mmap_file *m_file = NULL;
+  const char *m_data = NULL;
+};
+
+/**
+ * Build a cache file in memory, section by section
+ */
+class CacheWriter {
+ public:
+  CacheWriter()
+  {
+    m_buffer.resize(sizeof(CacheHeader), 0);
+  }
+
+  CacheHeader &header()
+  {
+    return *(CacheHeader *)m_buffer.data();
+  }
+
+  /**
+   * Append an aligned section and return its offset
+   */
+  uint64_t append(const void *data, size_t size)
+  {
+    const size_t offset = (m_buffer.size() + kSectionAlignment - 1) & ~(kSectionAlignment - 1);
+    m_buffer.resize(offset + size, 0);
+    if (size > 0) {
+      memcpy(m_buffer.data() + offset, data, size);
+    }
+    return offset;
+  }
+
+  bool write(const char *path) const
+  {
+    FILE *file = BLI_fopen(path, "wb");
+    if (NULL == file) {
+      return false;
+    }
+    const bool success = fwrite(m_buffer.data(), 1, m_buffer.size(), file) == m_buffer.size();
+    fclose(file);
+    return success;
+  }
+
+ private:
+  blender::Vector<char> m_buffer;
+};
+
+void append_layers(CacheWriter &writer,
+                   blender::Vector<CacheLayer> &layers,
+                   const CustomData &data,
+                   int domain,
+                   int count)
+{
+  for (int i = 0; i < data.totlayer; ++i) {
+    const CustomDataLayer &cd_layer = data.layers[i];
+    if (!is_cached_layer_type(cd_layer.type)) {
+      continue;
+    }
+    CacheLayer layer;
+    memset(&layer, 0, sizeof(CacheLayer));
+    BLI_strncpy(layer.name, cd_layer.name, sizeof(layer.name));
+    layer.domain = domain;
+    layer.type = cd_layer.type;
+    layer.size = (uint64_t)CustomData_sizeof(cd_layer.type) * count;
+    layer.offset = writer.append(cd_layer.data, layer.size);
+    layers.append(layer);
+  }
+}
+
+/**
+ * Quantize positions as deltas to the reference, if it is precise enough
+ */
+bool quantize_positions(const Mesh *mesh,
+                        const float (*reference)[3],
+                        blender::Vector<int16_t> &r_deltas,
+                        float &r_step)
+{
+  float max_delta = 0.0f;
+  for (int i = 0; i < mesh->totvert; ++i) {
+    for (int c = 0; c < 3; ++c) {
+      max_delta = max_ff(max_delta, fabsf(mesh->mvert[i].co[c] - reference[i][c]));
+    }
+  }
+  r_step = max_delta / INT16_MAX;
+  if (0.5f * r_step > MFX_BAKE_CACHE_MAX_ERROR) {
+    return false;
+  }
+
+  r_deltas.resize(3 * (int64_t)mesh->totvert);
+  const float inv_step = r_step > 0.0f ? 1.0f / r_step : 0.0f;
+  blender::parallel_for(blender::IndexRange(mesh->totvert), 4096, [&](blender::IndexRange range) {
+    for (int64_t i : range) {
+      for (int c = 0; c < 3; ++c) {
+        const float delta = mesh->mvert[i].co[c] - reference[i][c];
+        r_deltas[3 * i + c] = (int16_t)roundf(delta * inv_step);
+      }
+    }
+  });
+  return true;
+}
+
+}  // namespace
+
+// ----------------------------------------------------------------------------
+
+void mfx_bake_cache_frame_path(const OpenMfxModifierData *fxmd,
+                               const Object *object,
+                               int frame,
+                               char *r_path)
+{
+  char filename[FILE_MAX];
+  BLI_snprintf(filename,
+               sizeof(filename),
+               "%s_%s_%06d.mfxcache",
+               object->id.name + 2,
+               fxmd->modifier.name,
+               frame);
+  BLI_filename_make_safe(filename);
+
+  BLI_join_dirfile(r_path, FILE_MAX, fxmd->bake_directory, filename);
+  const char *base_path = BKE_main_blendfile_path_from_global();
+  if (NULL != base_path) {
+    BLI_path_abs(r_path, base_path);
+  }
+}
+
+bool mfx_bake_cache_write(const char *path, const char *reference_path, const Mesh *mesh)
+{
+  // The reference frame itself is written without reference
+  if (NULL != reference_path && STREQ(reference_path, path)) {
+    reference_path = NULL;
+  }
+
+  MappedCacheFile reference(reference_path);
+  const bool has_reference = reference.is_valid() &&
+                             0 == (reference.header().flag & CACHE_FLAG_SHARED_TOPOLOGY);
+
+  CacheWriter writer;
+  CacheHeader header;
+  memset(&header, 0, sizeof(CacheHeader));
+  memcpy(header.magic, kCacheMagic, sizeof(kCacheMagic));
+  header.version = kCacheVersion;
+  header.totvert = mesh->totvert;
+  header.totedge = mesh->totedge;
+  header.totloop = mesh->totloop;
+  header.totpoly = mesh->totpoly;
+
+  // Topology is shared with the reference when it did not change
+  bool shared_topology = false;
+  if (has_reference) {
+    const CacheHeader &ref = reference.header();
+    shared_topology = ref.totvert == mesh->totvert && ref.totedge == mesh->totedge &&
+                      ref.totloop == mesh->totloop && ref.totpoly == mesh->totpoly &&
+                      0 == memcmp(reference.section<MEdge>(ref.edges_offset),
+                                  mesh->medge,
+                                  sizeof(MEdge) * mesh->totedge) &&
+                      0 == memcmp(reference.section<MLoop>(ref.loops_offset),
+                                  mesh->mloop,
+                                  sizeof(MLoop) * mesh->totloop) &&
+                      0 == memcmp(reference.section<MPoly>(ref.polys_offset),
+                                  mesh->mpoly,
+                                  sizeof(MPoly) * mesh->totpoly);
+  }
+
+  blender::Vector<int16_t> deltas;
+  if (shared_topology &&
+      quantize_positions(mesh,
+                         reference.section<float[3]>(reference.header().positions_offset),
+                         deltas,
+                         header.position_step)) {
+    header.flag |= CACHE_FLAG_QUANTIZED_POSITIONS;
+    header.positions_offset = writer.append(deltas.data(), sizeof(int16_t) * deltas.size());
+  }
+  else {
+    blender::Vector<float> positions(3 * (int64_t)mesh->totvert);
+    for (int i = 0; i < mesh->totvert; ++i) {
+      memcpy(&positions[3 * i], mesh->mvert[i].co, sizeof(float[3]));
+    }
+    header.positions_offset = writer.append(positions.data(), sizeof(float) * positions.size());
+  }
+
+  if (shared_topology) {
+    header.flag |= CACHE_FLAG_SHARED_TOPOLOGY;
+  }
+  else {
+    header.edges_offset = writer.append(mesh->medge, sizeof(MEdge) * mesh->totedge);
+    header.loops_offset = writer.append(mesh->mloop, sizeof(MLoop) * mesh->totloop);
+    header.polys_offset = writer.append(mesh->mpoly, sizeof(MPoly) * mesh->totpoly);
+  }
+
+  blender::Vector<CacheLayer> layers;
+  append_layers(writer, layers, mesh->vdata, CACHE_DOMAIN_VERT, mesh->totvert);
+  append_layers(writer, layers, mesh->edata, CACHE_DOMAIN_EDGE, mesh->totedge);
+  append_layers(writer, layers, mesh->ldata, CACHE_DOMAIN_LOOP, mesh->totloop);
+  append_layers(writer, layers, mesh->pdata, CACHE_DOMAIN_POLY, mesh->totpoly);
+  header.layer_count = layers.size();
+  header.layers_offset = writer.append(layers.data(), sizeof(CacheLayer) * layers.size());
+
+  writer.header() = header;
+
+  if (!BLI_make_existing_file(path) || !writer.write(path)) {
+    printf("Could not write bake cache file %s\n", path);
+    return false;
+  }
+  return true;
+}
+
+Mesh *mfx_bake_cache_read(const char *path, const char *reference_path, const Mesh *template_mesh)
+{
+  MappedCacheFile file(path);
+  if (!file.is_valid()) {
+    return NULL;
+  }
+  const CacheHeader &header = file.header();
+
+  // Topology and reference positions come from the reference frame when shared
+  const bool use_reference = 0 != (header.flag & CACHE_FLAG_SHARED_TOPOLOGY);
+  MappedCacheFile reference(use_reference ? reference_path : NULL);
+  if (use_reference &&
+      (!reference.is_valid() || reference.header().totvert != header.totvert ||
+       reference.header().totedge != header.totedge ||
+       reference.header().totloop != header.totloop ||
+       reference.header().totpoly != header.totpoly ||
+       0 != (reference.header().flag & (CACHE_FLAG_SHARED_TOPOLOGY |
+                                        CACHE_FLAG_QUANTIZED_POSITIONS)))) {
+    printf("Invalid bake cache reference frame %s\n", reference_path);
+    return NULL;
+  }
+  const MappedCacheFile &topology = use_reference ? reference : file;
+
+  Mesh *mesh = BKE_mesh_new_nomain(
+      header.totvert, header.totedge, 0, header.totloop, header.totpoly);
+  BKE_mesh_copy_settings(mesh, template_mesh);
+
+  memcpy(mesh->medge,
+         topology.section<MEdge>(topology.header().edges_offset),
+         sizeof(MEdge) * header.totedge);
+  memcpy(mesh->mloop,
+         topology.section<MLoop>(topology.header().loops_offset),
+         sizeof(MLoop) * header.totloop);
+  memcpy(mesh->mpoly,
+         topology.section<MPoly>(topology.header().polys_offset),
+         sizeof(MPoly) * header.totpoly);
+
+  // Positions are read straight from the mapping, decoding deltas if needed
+  const bool is_quantized = 0 != (header.flag & CACHE_FLAG_QUANTIZED_POSITIONS);
+  const float(*positions)[3] = file.section<float[3]>(header.positions_offset);
+  const int16_t(*deltas)[3] = file.section<int16_t[3]>(header.positions_offset);
+  const float(*reference_positions)[3] =
+      use_reference ? reference.section<float[3]>(reference.header().positions_offset) : NULL;
+  const float step = header.position_step;
+  blender::parallel_for(blender::IndexRange(header.totvert), 4096, [&](blender::IndexRange range) {
+    for (int64_t i : range) {
+      for (int c = 0; c < 3; ++c) {
+        mesh->mvert[i].co[c] = is_quantized ? reference_positions[i][c] + deltas[i][c] * step :
+                                              positions[i][c];
+      }
+    }
+  });
+
+  for (const CacheLayer &layer : file.layers()) {
+    CustomData *data;
+    int count;
+    switch (layer.domain) {
+      case CACHE_DOMAIN_VERT:
+        data = &mesh->vdata;
+        count = mesh->totvert;
+        break;
+      case CACHE_DOMAIN_EDGE:
+        data = &mesh->edata;
+        count = mesh->totedge;
+        break;
+      case CACHE_DOMAIN_LOOP:
+        data = &mesh->ldata;
+        count = mesh->totloop;
+        break;
+      case CACHE_DOMAIN_POLY:
+        data = &mesh->pdata;
+        count = mesh->totpoly;
+        break;
+      default:
+        continue;
+    }
+    if (!is_cached_layer_type(layer.type) ||
+        layer.size != (uint64_t)CustomData_sizeof(layer.type) * count) {
+      continue;
+    }
+    char name[MAX_CUSTOMDATA_LAYER_NAME];
+    BLI_strncpy(name, layer.name, sizeof(name));
+    void *layer_data = CustomData_add_layer_named(data, layer.type, CD_CALLOC, NULL, count, name);
+    if (NULL != layer_data) {
+      memcpy(layer_data, file.section<char>(layer.offset), layer.size);
+    }
+  }
+
+  mesh->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
+
+  return mesh;
+}
+
+void mfx_bake_cache_free(const OpenMfxModifierData *fxmd, const Object *object)
+{
+  char path[FILE_MAX];
+  for (int frame = fxmd->bake_frame_start; frame <= fxmd->bake_frame_end; ++frame) {
+    mfx_bake_cache_frame_path(fxmd, object, frame, path);
+    if (BLI_exists(path)) {
+      BLI_delete(path, false, false);
+    }
+  }
+}
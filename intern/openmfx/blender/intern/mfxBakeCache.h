@@ -0,0 +1,69 @@
+/**
+ * Open Mesh Effect modifier for Blender
+ * Copyright (C) 2019 - 2021 Elie Michel
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** \file
+ * \ingroup openmesheffect
+ *
+ * Bake cache of the OpenMfx modifier: one file per frame storing the output
+ * of the effect, read back through a memory mapping on playback instead of
+ * cooking again.
+ *
+ * The first frame of the bake range is the reference frame. Frames that have
+ * the same topology as the reference only store their point positions, as
+ * 16 bit deltas to the reference when the motion is small enough for the
+ * quantization error to stay under MFX_BAKE_CACHE_MAX_ERROR.
+ */
+
+#pragma once
+
+#include "DNA_mesh_types.h"
+#include "DNA_modifier_types.h"
+#include "DNA_object_types.h"
+
+/**
+ * Maximum error on point positions introduced by delta encoding, in object units
+ */
+#define MFX_BAKE_CACHE_MAX_ERROR 1e-5f
+
+/**
+ * Absolute path of the cache file storing the result of a modifier at a given
+ * frame. r_path must be FILE_MAX long.
+ */
+void mfx_bake_cache_frame_path(const OpenMfxModifierData *fxmd,
+                               const Object *object,
+                               int frame,
+                               char *r_path);
+
+/**
+ * Write the result of a cook. Frames other than the reference one are encoded
+ * relatively to the reference file when it exists, otherwise reference_path
+ * may be NULL. Returns false if the file could not be written.
+ */
+bool mfx_bake_cache_write(const char *path, const char *reference_path, const Mesh *mesh);
+
+/**
+ * Read back a frame written by mfx_bake_cache_write(), copying mesh settings
+ * (e.g. materials) from template_mesh. Returns NULL if the file does not
+ * exist or is not a valid cache file.
+ */
+Mesh *mfx_bake_cache_read(const char *path, const char *reference_path, const Mesh *template_mesh);
+
+/**
+ * Remove all the cache files of the bake range of the modifier.
+ */
+void mfx_bake_cache_free(const OpenMfxModifierData *fxmd, const Object *object);
@@ -22,24 +22,43 @@
 
 #include "MEM_guardedalloc.h"
 
+#include <algorithm>
 #include <cassert>
+#include <memory>
 
 #include "mfxCallbacks.h"
 #include "mfxModifier.h"
 #include "ofxExtras.h"
 #include "mfxHost.h"
 #include <mfxHost/mesh>
+#include <mfxHost/parameters>
 #include "util/memory_util.h"
+#include "mfxAttributeMapping.h"
 
 #include "DNA_mesh_types.h" // Mesh
 #include "DNA_meshdata_types.h" // MVert
-
+#include "DNA_anim_types.h" // AnimData
+#include "DNA_action_types.h" // bAction
+#include "DNA_modifier_types.h"
+
+#include "BKE_customdata.h"
+#include "BKE_editmesh.h" // BMEditMesh
+#include "BKE_fcurve.h" // BKE_fcurve_find
+#include "BKE_global.h" // G.moving
+#include "BKE_lib_id.h" // BKE_id_free
 #include "BKE_mesh.h" // BKE_mesh_new_nomain
+#include "BKE_mesh_wrapper.h" // BKE_mesh_wrapper_ensure_mdata
+#include "BKE_pointcloud.h" // BKE_pointcloud_new_for_eval
 #include "BKE_main.h" // BKE_main_blendfile_path_from_global
+#include "BKE_subdiv.h"
+#include "BKE_subdiv_eval.h"
 
 #include "BLI_math_vector.h"
 #include "BLI_string.h"
 #include "BLI_path_util.h"
+#include "BLI_task.hh" // parallel_for
+
+#include "bmesh.h"
 
 #define MFX_CHECK(call) { \
   OfxStatus status = call; \
@@ -51,7 +70,22 @@
 #define max(a,b) (((a) > (b)) ? (a) : (b))
 #endif
 
-constexpr int MAX_CORNER_ATTRIB_NAME = 32;
+/**
+ * Attachment string of point, corner and face attributes, NULL for others
+ */
+static const char *attachmentAsString(AttributeAttachment attachment)
+{
+  switch (attachment) {
+    case AttributeAttachment::Point:
+      return kOfxMeshAttribPoint;
+    case AttributeAttachment::Corner:
+      return kOfxMeshAttribCorner;
+    case AttributeAttachment::Face:
+      return kOfxMeshAttribFace;
+    default:
+      return NULL;
+  }
+}
 
 // TODO: this is provided already in some utility header, avoid replicating it here
 template <typename T>
@@ -86,7 +120,13 @@ class Converter {
    * for the case when there are no proper faces, just loose edges (ie. edge wireframe) - in this case,
    * we use kOfxMeshPropConstantFaceCount instead of face count buffer.
    *
-   * This function will also convert any corner color and UV attributes.
+   * Inputs that set kOfxInputPropLooseEdgeAttachment rather get loose edges in a separate edge
+   * attachment, so they take the fast path whatever loose edges the mesh has. Only the points of
+   * the loose edges are then copied.
+   *
+   * This function will also convert any other attribute of the mesh, reusing buffers for points
+   * and, when there is no loose edge, for corners and faces. Edge attributes are forwarded to
+   * corners and vertex groups that the effect requested are forwarded as point weights.
    */
   OfxStatus blenderToMfx(OfxMeshHandle ofx_mesh) const;
 
@@ -96,11 +136,131 @@ class Converter {
    * This function receives output mesh from the effect, converting it into new Blender mesh.
    * We have to filter out any 2-corner faces and turn them into Blender loose edges.
    *
-   * This function will also convert UV attributes called uv0, uv1, uv2, uv3.
+   * This function will also convert any other attribute of the output mesh, matching domain and
+   * type of the attributes of the source mesh when names match.
    */
   OfxStatus mfxToBlender(OfxMeshHandle ofx_mesh) const;
 
+  /**
+   * @brief Allocate the Blender mesh of an output before the effect fills it
+   *
+   * Called at the beginning of meshAlloc(), once element counts are known. Positions, corner
+   * points and face sizes that the host would allocate are pointed to the vertices, loops and
+   * polys of the new mesh instead, so that the effect writes them in place rather than into
+   * buffers that mfxToBlender() then copies. This is only done for meshes without 2-corner faces,
+   * since these become edges rather than loops, and whose layout is left to the host.
+   * mfxToBlender() falls back to a new mesh if counts changed in between.
+   */
+  OfxStatus preallocateBlender(OfxMeshHandle ofx_mesh) const;
+
 private:
+  /**
+   * Convert a mesh wrapping an edit-mode BMesh, reading its element tables directly instead of
+   * converting it to a Blender mesh first. Only point positions are read in place, when the
+   * wrapper holds deformed coordinates. The tables are kept in internal data (when provided) and
+   * only rebuilt while transforming elements if element counts changed, so that moving
+   * elements only costs copying positions and other attributes.
+   */
+  OfxStatus bmeshToMfx(OfxMeshHandle ofx_mesh, const MeshInternalData &internal_data) const;
+
+  /**
+   * Convert a Blender point cloud, forwarding positions and point attributes in place when the
+   * layout allows it. There is neither corner nor face, so nothing else is allocated.
+   */
+  OfxStatus pointCloudToMfx(OfxMeshHandle ofx_mesh, const MeshInternalData &internal_data) const;
+
+  /**
+   * Store an output that has no face into a new Blender point cloud, without going through a
+   * Blender mesh.
+   */
+  OfxStatus mfxToPointCloud(OfxMeshHandle ofx_mesh,
+                            MeshInternalData &internal_data,
+                            int point_count,
+                            const char *point_data,
+                            int point_stride,
+                            int point_component_stride) const;
+
+  /**
+   * Store an output that has instance transforms and no face as instances of the objects
+   * connected to other inputs, without realizing them.
+   */
+  OfxStatus mfxToInstances(OfxMeshHandle ofx_mesh,
+                           MeshInternalData &internal_data,
+                           int point_count) const;
+
+  /**
+   * Blender buffers can be forwarded unless the effect asked for a specific layout
+   */
+  bool useHostBuffers(OfxMeshHandle ofx_mesh) const;
+
+  /**
+   * Attributes requested by the effect on an input (which may be NULL)
+   */
+  blender::Vector<MfxAttributeRequest> listRequests(
+      const OfxAttributeSetStruct *requested_attributes) const;
+
+  /**
+   * Define the attributes listed by bindings, sharing Blender buffers when possible. Bindings
+   * that must rather be copied once buffers are allocated are listed in r_to_fill.
+   */
+  void defineAttributes(OfxMeshHandle ofx_mesh,
+                        blender::Span<MfxAttributeBinding> bindings,
+                        bool use_host_buffers,
+                        bool has_loose_edges,
+                        blender::Vector<OfxPropertySetHandle> &r_handles,
+                        blender::Vector<int> &r_to_fill) const;
+
+  /**
+   * Copy the attributes that could not share Blender buffers, after meshAlloc()
+   */
+  void fillAttributes(const GeometryComponent &component,
+                      blender::Span<MfxAttributeBinding> bindings,
+                      blender::Span<OfxPropertySetHandle> handles,
+                      blender::Span<int> to_fill,
+                      blender::Span<int> loose_edges,
+                      int point_count,
+                      int corner_count,
+                      int face_count) const;
+
+  /**
+   * Transpose point positions into the buffer allocated for the position attribute
+   */
+  void copyPositions(OfxPropertySetHandle pos_attrib,
+                     const char *src_data,
+                     int src_stride,
+                     int point_count) const;
+
+  /**
+   * Move an output mesh to the sample matching the time at which it was got, or to the first
+   * sample if no time matches.
+   */
+  void storeSample(OfxMeshHandle ofx_mesh, MfxOutputSamples &samples, Mesh *mesh) const;
+
+  /**
+   * Sample already converted, whose edges may be reused (may return NULL)
+   */
+  static const Mesh *topologyReference(const MfxOutputSamples *samples);
+
+  /**
+   * Copy the edges of a mesh that has exactly the same faces and no loose edge, which is much
+   * cheaper than BKE_mesh_calc_edges(). Returns false, leaving the mesh untouched, if faces
+   * differ.
+   */
+  static bool reuseEdges(Mesh *mesh, const Mesh *reference);
+
+  /**
+   * Whether the corners and faces of an output alias those of the source mesh, e.g. when the
+   * effect forwarded them from its input, so that its topology can be copied as a whole.
+   */
+  static bool sharesTopology(const Mesh *source_mesh,
+                             int corner_count,
+                             int face_count,
+                             int constant_face_size,
+                             const char *corner_data,
+                             int corner_stride,
+                             const char *face_data,
+                             int face_stride);
+
   static bool check_no_loose_edges_in_ofx_mesh(int face_count,
                                                const int *face_data,
                                                int face_stride);
@@ -119,10 +279,12 @@ private:
 
   /**
    * Count the number of point/corner/face in Blender mesh, as well as loose edge
-   * and constant face size flags.
+   * and constant face size flags. Loose edges are only counted as faces when
+   * use_loose_edge_attachment is false.
    * (it's static because it does not use the suites)
    */
   static void countMeshElements(Mesh * blender_mesh,
+                               bool use_loose_edge_attachment,
                                int & ofx_point_count,
                                int & ofx_corner_count,
                                int & ofx_face_count,
@@ -152,6 +314,7 @@ OfxStatus Converter::blenderToMfx(OfxMeshHandle ofx_mesh) const
       ofx_constant_face_size;
   int blender_loop_count, blender_loose_edge_count;
   MeshInternalData *internal_data;
+  OfxPropertySetHandle edgepoint_attrib;
 
   MFX_CHECK(ps->propGetPointer(
       &ofx_mesh->properties, kOfxMeshPropInternalData, 0, (void **)&internal_data));
@@ -183,14 +346,28 @@ OfxStatus Converter::blenderToMfx(OfxMeshHandle ofx_mesh) const
     return kOfxStatOK;
   }
 
+  if (NULL != internal_data->point_cloud) {
+    return pointCloudToMfx(ofx_mesh, *internal_data);
+  }
+
   if (NULL == blender_mesh) {
     printf("NOT converting blender mesh into ofx mesh (no blender mesh, already converted)...\n");
     return kOfxStatOK;
   }
 
+  if (ME_WRAPPER_TYPE_BMESH == blender_mesh->runtime.wrapper_type) {
+    return bmeshToMfx(ofx_mesh, *internal_data);
+  }
+
   printf("Converting blender mesh into ofx mesh...\n");
 
+  // The edge attachment is only defined when the effect asked for it
+  const bool use_loose_edge_attachment =
+      kOfxStatOK ==
+      mes->meshGetAttribute(ofx_mesh, kOfxMeshAttribEdge, kOfxMeshAttribEdgePoint, &edgepoint_attrib);
+
   countMeshElements(blender_mesh,
+                    use_loose_edge_attachment,
                     ofx_point_count,
                     ofx_corner_count,
                     ofx_face_count,
@@ -202,113 +379,55 @@ OfxStatus Converter::blenderToMfx(OfxMeshHandle ofx_mesh) const
   MFX_CHECK(ps->propSetInt(&ofx_mesh->properties, kOfxMeshPropPointCount, 0, ofx_point_count));
   MFX_CHECK(ps->propSetInt(&ofx_mesh->properties, kOfxMeshPropCornerCount, 0, ofx_corner_count));
   MFX_CHECK(ps->propSetInt(&ofx_mesh->properties, kOfxMeshPropFaceCount, 0, ofx_face_count));
+  MFX_CHECK(ps->propSetInt(&ofx_mesh->properties,
+                           kOfxMeshPropLooseEdgeCount,
+                           0,
+                           use_loose_edge_attachment ? blender_loose_edge_count : 0));
   MFX_CHECK(ps->propSetInt(&ofx_mesh->properties, kOfxMeshPropNoLooseEdge, 0, ofx_no_loose_edge));
   MFX_CHECK(ps->propSetInt(
       &ofx_mesh->properties, kOfxMeshPropConstantFaceSize, 0, ofx_constant_face_size));
 
-  // Define corner colors attributes
-  int vcolor_layers = CustomData_number_of_layers(&blender_mesh->ldata, CD_MLOOPCOL);
-  char name[MAX_CORNER_ATTRIB_NAME];
-  OfxPropertySetHandle vcolor_attrib;
-  for (int k = 0; k < vcolor_layers; ++k) {
-    sprintf(name, "color%d", k);
-
-    // Note: CustomData_get() is not the correct function to call here, since that returns
-    // individual values from an "active" layer of given type. We want CustomData_get_layer_n().
-    MLoopCol *vcolor_data = (MLoopCol *)CustomData_get_layer_n(
-        &blender_mesh->ldata, CD_MLOOPCOL, k);
-    if (NULL == vcolor_data) {
-      printf("WARNING: missing color attribute!\n");
-      continue;
-    }
+  const bool use_host_buffers = useHostBuffers(ofx_mesh);
 
-    if (ofx_no_loose_edge) {
-      // reuse host buffer, kOfxMeshPropNoLooseEdge optimization
-      MFX_CHECK(mes->attributeDefine(ofx_mesh,
-                                     kOfxMeshAttribCorner,
-                                     name,
-                                     3,
-                                     kOfxMeshAttribTypeUByte,
-                                     kOfxMeshAttribSemanticColor,
-                                     &vcolor_attrib));
-      MFX_CHECK(ps->propSetInt(vcolor_attrib, kOfxMeshAttribPropIsOwner, 0, 0));
-      MFX_CHECK(
-          ps->propSetPointer(vcolor_attrib, kOfxMeshAttribPropData, 0, (void *)&vcolor_data[0].r));
-      MFX_CHECK(ps->propSetInt(vcolor_attrib, kOfxMeshAttribPropStride, 0, sizeof(MLoopCol)));
-    }
-    else if (blender_loop_count > 0) {
-      // request new buffer to copy data from existing polys, fill default values for edges
-      MFX_CHECK(mes->attributeDefine(ofx_mesh,
-                                     kOfxMeshAttribCorner,
-                                     name,
-                                     3,
-                                     kOfxMeshAttribTypeUByte,
-                                     kOfxMeshAttribSemanticColor,
-                                     &vcolor_attrib));
-      MFX_CHECK(ps->propSetInt(vcolor_attrib, kOfxMeshAttribPropIsOwner, 0, 1));
-    }
-    else {
-      // we have just loose edges, no data to copy
-      printf("WARNING: I want to copy corner colors but there are no corners\n");
-    }
+  // Wrap the mesh to access its attributes generically, including vertex groups
+  MeshComponent component;
+  component.replace(blender_mesh, GeometryOwnershipType::ReadOnly);
+  if (NULL != internal_data->geometry_component) {
+    component.vertex_group_names() = internal_data->geometry_component->vertex_group_names();
   }
-
-  // Define corner UV attributes
-  int uv_layers = CustomData_number_of_layers(&blender_mesh->ldata, CD_MLOOPUV);
-  OfxPropertySetHandle uv_attrib;
-  for (int k = 0; k < uv_layers; ++k) {
-    sprintf(name, "uv%d", k);
-    MLoopUV *uv_data = (MLoopUV *)CustomData_get_layer_n(&blender_mesh->ldata, CD_MLOOPUV, k);
-    if (NULL == uv_data) {
-      printf("WARNING: missing UV attribute!\n");
-      continue;
-    }
-
-    if (ofx_no_loose_edge) {
-      // reuse host buffer, kOfxMeshPropNoLooseEdge optimization
-      MFX_CHECK(mes->attributeDefine(ofx_mesh,
-                                     kOfxMeshAttribCorner,
-                                     name,
-                                     2,
-                                     kOfxMeshAttribTypeFloat,
-                                     kOfxMeshAttribSemanticTextureCoordinate,
-                                     &uv_attrib));
-      MFX_CHECK(ps->propSetInt(uv_attrib, kOfxMeshAttribPropIsOwner, 0, 0));
-      MFX_CHECK(ps->propSetPointer(uv_attrib, kOfxMeshAttribPropData, 0, (void *)&uv_data[0].uv[0]));
-      MFX_CHECK(ps->propSetInt(uv_attrib, kOfxMeshAttribPropStride, 0, sizeof(MLoopUV)));
-    }
-    else if (blender_loop_count > 0) {
-      // request new buffer to copy data from existing polys, fill default values for edges
-      MFX_CHECK(mes->attributeDefine(ofx_mesh,
-                                     kOfxMeshAttribCorner,
-                                     name,
-                                     2,
-                                     kOfxMeshAttribTypeFloat,
-                                     kOfxMeshAttribSemanticTextureCoordinate,
-                                     &uv_attrib));
-      MFX_CHECK(ps->propSetInt(uv_attrib, kOfxMeshAttribPropIsOwner, 0, 1));
-    }
-    else {
-      // we have just loose edges, no data to copy
-      printf("WARNING: I want to copy UV but there are no corners\n");
-    }
+  else {
+    component.copy_vertex_group_names_from_object(*internal_data->object);
   }
 
+  // Define attributes, reusing Blender buffers when possible
+  blender::Vector<MfxAttributeBinding> bindings = mfx_list_mesh_attributes(
+      component, listRequests(internal_data->requested_attributes), internal_data->weight_cache);
+  blender::Vector<int> bindings_to_fill;
+  blender::Vector<OfxPropertySetHandle> attrib_handles;
+  defineAttributes(
+      ofx_mesh, bindings, use_host_buffers, !ofx_no_loose_edge, attrib_handles, bindings_to_fill);
+
   // Point position
   OfxPropertySetHandle pos_attrib;
   MFX_CHECK(mes->meshGetAttribute(
       ofx_mesh, kOfxMeshAttribPoint, kOfxMeshAttribPointPosition, &pos_attrib));
-  MFX_CHECK(ps->propSetInt(pos_attrib, kOfxMeshAttribPropIsOwner, 0, 0));
-  MFX_CHECK(ps->propSetPointer(
-      pos_attrib, kOfxMeshAttribPropData, 0, (void *)&blender_mesh->mvert[0].co[0]));
-  MFX_CHECK(ps->propSetInt(pos_attrib, kOfxMeshAttribPropStride, 0, sizeof(MVert)));
+  if (use_host_buffers) {
+    MFX_CHECK(ps->propSetInt(pos_attrib, kOfxMeshAttribPropIsOwner, 0, 0));
+    MFX_CHECK(ps->propSetPointer(
+        pos_attrib, kOfxMeshAttribPropData, 0, (void *)&blender_mesh->mvert[0].co[0]));
+    MFX_CHECK(ps->propSetInt(pos_attrib, kOfxMeshAttribPropStride, 0, sizeof(MVert)));
+  }
+  else {
+    // request new buffer, filled by transposing MVert coordinates
+    MFX_CHECK(ps->propSetInt(pos_attrib, kOfxMeshAttribPropIsOwner, 0, 1));
+  }
 
   // Corner point
   OfxPropertySetHandle cornerpoint_attrib;
   MFX_CHECK(mes->meshGetAttribute(
       ofx_mesh, kOfxMeshAttribCorner, kOfxMeshAttribCornerPoint, &cornerpoint_attrib));
 
-  if (ofx_no_loose_edge) {
+  if (ofx_no_loose_edge && use_host_buffers) {
     // use host buffers, kOfxMeshPropNoLooseEdge optimization
     MFX_CHECK(ps->propSetInt(cornerpoint_attrib, kOfxMeshAttribPropIsOwner, 0, 0));
     MFX_CHECK(ps->propSetPointer(
@@ -316,7 +435,7 @@ OfxStatus Converter::blenderToMfx(OfxMeshHandle ofx_mesh) const
     MFX_CHECK(ps->propSetInt(cornerpoint_attrib, kOfxMeshAttribPropStride, 0, sizeof(MLoop)));
   }
   else {
-    // request new buffer, we need to append new corners for loose edges
+    // request new buffer, we need to append new corners for loose edges or to change layout
     MFX_CHECK(ps->propSetInt(cornerpoint_attrib, kOfxMeshAttribPropIsOwner, 0, 1));
   }
 
@@ -331,7 +450,7 @@ OfxStatus Converter::blenderToMfx(OfxMeshHandle ofx_mesh) const
     MFX_CHECK(ps->propSetPointer(facesize_attrib, kOfxMeshAttribPropData, 0, NULL));
     MFX_CHECK(ps->propSetInt(facesize_attrib, kOfxMeshAttribPropStride, 0, 0));
   }
-  else if (ofx_no_loose_edge) {
+  else if (ofx_no_loose_edge && use_host_buffers) {
     // use host buffers, kOfxMeshPropNoLooseEdge optimization
     MFX_CHECK(ps->propSetInt(facesize_attrib, kOfxMeshAttribPropIsOwner, 0, 0));
     MFX_CHECK(ps->propSetPointer(
@@ -339,106 +458,308 @@ OfxStatus Converter::blenderToMfx(OfxMeshHandle ofx_mesh) const
     MFX_CHECK(ps->propSetInt(facesize_attrib, kOfxMeshAttribPropStride, 0, sizeof(MPoly)));
   }
   else {
-    // request new buffer, we need to append new faces for loose edges
+    // request new buffer, we need to append new faces for loose edges or to change layout
     MFX_CHECK(ps->propSetInt(facesize_attrib, kOfxMeshAttribPropIsOwner, 0, 1));
   }
 
   // finished adding attributes, allocate any requested buffers
   MFX_CHECK(mes->meshAlloc(ofx_mesh));
 
+  // Point position, transposed in parallel when a specific layout is requested
+  if (!use_host_buffers) {
+    copyPositions(
+        pos_attrib, (const char *)blender_mesh->mvert[0].co, sizeof(MVert), ofx_point_count);
+  }
+
+  blender::Vector<int> loose_edges;
+  if (blender_loose_edge_count > 0) {
+    loose_edges.reserve(blender_loose_edge_count);
+    for (int j = 0; j < blender_mesh->totedge; ++j) {
+      if (blender_mesh->medge[j].flag & ME_LOOSEEDGE) {
+        loose_edges.append(j);
+      }
+    }
+  }
+
+  // Loose edges stored apart from faces only need their points
+  if (use_loose_edge_attachment) {
+    char *ofx_edge_buffer;
+    int edge_stride, edge_component_stride;
+    MFX_CHECK(ps->propGetPointer(
+        edgepoint_attrib, kOfxMeshAttribPropData, 0, (void **)&ofx_edge_buffer));
+    MFX_CHECK(ps->propGetInt(edgepoint_attrib, kOfxMeshAttribPropStride, 0, &edge_stride));
+    MFX_CHECK(ps->propGetInt(
+        edgepoint_attrib, kOfxMeshAttribPropComponentStride, 0, &edge_component_stride));
+    for (int i = 0; i < loose_edges.size(); ++i) {
+      const MEdge &edge = blender_mesh->medge[loose_edges[i]];
+      char *ofx_edge = ofx_edge_buffer + (size_t)edge_stride * i;
+      *(int *)ofx_edge = edge.v1;
+      *(int *)(ofx_edge + edge_component_stride) = edge.v2;
+    }
+  }
+
   // loose edge cleanup
   // There were loose edge, so we have to copy memory rather than pointing to existing buffers
-  if (!ofx_no_loose_edge) {
-    // check that meshAlloc() gave us contiguous buffers
-    int stride;
-    MFX_CHECK(ps->propGetInt(cornerpoint_attrib, kOfxMeshAttribPropStride, 0, &stride));
-    assert(stride == sizeof(int));
-    MFX_CHECK(ps->propGetInt(facesize_attrib, kOfxMeshAttribPropStride, 0, &stride));
-    assert(stride == sizeof(int));
+  blender::Span<int> loose_edge_faces = use_loose_edge_attachment ? blender::Span<int>() :
+                                                                    loose_edges.as_span();
 
+  if (!ofx_no_loose_edge || !use_host_buffers) {
     // Corner point
     int i;
-    int *ofx_corner_buffer;
+    char *ofx_corner_buffer;
+    int corner_stride;
     MFX_CHECK(ps->propGetPointer(
         cornerpoint_attrib, kOfxMeshAttribPropData, 0, (void **)&ofx_corner_buffer));
+    MFX_CHECK(ps->propGetInt(cornerpoint_attrib, kOfxMeshAttribPropStride, 0, &corner_stride));
     for (i = 0; i < blender_mesh->totloop; ++i) {
-      ofx_corner_buffer[i] = blender_mesh->mloop[i].v;
+      *attributeAt<int>(ofx_corner_buffer, corner_stride, i) = blender_mesh->mloop[i].v;
     }
-    for (int j = 0; j < blender_mesh->totedge; ++j) {
-      if (blender_mesh->medge[j].flag & ME_LOOSEEDGE) {
-        ofx_corner_buffer[i] = blender_mesh->medge[j].v1;
-        ofx_corner_buffer[i + 1] = blender_mesh->medge[j].v2;
-        i += 2;
-      }
+    for (int j : loose_edge_faces) {
+      *attributeAt<int>(ofx_corner_buffer, corner_stride, i) = blender_mesh->medge[j].v1;
+      *attributeAt<int>(ofx_corner_buffer, corner_stride, i + 1) = blender_mesh->medge[j].v2;
+      i += 2;
     }
 
     // Face size
     if (-1 == ofx_constant_face_size) {
-      int *ofx_face_buffer;
+      char *ofx_face_buffer;
+      int face_stride;
       MFX_CHECK(ps->propGetPointer(
           facesize_attrib, kOfxMeshAttribPropData, 0, (void **)&ofx_face_buffer));
+      MFX_CHECK(ps->propGetInt(facesize_attrib, kOfxMeshAttribPropStride, 0, &face_stride));
       for (i = 0; i < blender_mesh->totpoly; ++i) {
-        ofx_face_buffer[i] = blender_mesh->mpoly[i].totloop;
+        *attributeAt<int>(ofx_face_buffer, face_stride, i) = blender_mesh->mpoly[i].totloop;
       }
-      for (int j = 0; j < blender_loose_edge_count; ++j) {
-        ofx_face_buffer[i] = 2;
+      for (int j = 0; j < loose_edge_faces.size(); ++j) {
+        *attributeAt<int>(ofx_face_buffer, face_stride, i) = 2;
         ++i;
       }
     }
+  }  // end loose edge cleanup
 
-    // Corner colors attributes
-    for (int k = 0; k < vcolor_layers; ++k) {
-      sprintf(name, "color%d", k);
-      MLoopCol *vcolor_data = (MLoopCol *)CustomData_get_layer_n(
-          &blender_mesh->ldata, CD_MLOOPCOL, k);
-
-      if (NULL != vcolor_data && blender_loop_count > 0) {
-        unsigned char *ofx_vcolor_buffer;
-        MFX_CHECK(ps->propGetPointer(
-            vcolor_attrib, kOfxMeshAttribPropData, 0, (void **)&ofx_vcolor_buffer));
-        MFX_CHECK(ps->propGetInt(vcolor_attrib, kOfxMeshAttribPropStride, 0, &stride));
-        assert(stride == 3 * sizeof(unsigned char));
-
-        for (i = 0; i < ofx_corner_count; i++) {
-          if (i < blender_loop_count) {
-            ofx_vcolor_buffer[3 * i + 0] = vcolor_data[i].r;
-            ofx_vcolor_buffer[3 * i + 1] = vcolor_data[i].g;
-            ofx_vcolor_buffer[3 * i + 2] = vcolor_data[i].b;
-          }
-          else {
-            ofx_vcolor_buffer[3 * i + 0] = 0;
-            ofx_vcolor_buffer[3 * i + 1] = 0;
-            ofx_vcolor_buffer[3 * i + 2] = 0;
-          }
-        }
-      }
-    }
+  // Copy attributes that could not reuse Blender buffers
+  fillAttributes(component,
+                 bindings,
+                 attrib_handles,
+                 bindings_to_fill,
+                 loose_edge_faces,
+                 ofx_point_count,
+                 ofx_corner_count,
+                 ofx_face_count);
 
-    // Define corner UV attributes
-    for (int k = 0; k < uv_layers; ++k) {
-      sprintf(name, "uv%d", k);
-      MLoopUV *uv_data = (MLoopUV *)CustomData_get_layer_n(&blender_mesh->ldata, CD_MLOOPUV, k);
+  return kOfxStatOK;
+}
 
-      if (NULL != uv_data && blender_loop_count > 0) {
-        float *ofx_uv_buffer;
-        MFX_CHECK(
-            ps->propGetPointer(uv_attrib, kOfxMeshAttribPropData, 0, (void **)&ofx_uv_buffer));
-        MFX_CHECK(ps->propGetInt(uv_attrib, kOfxMeshAttribPropStride, 0, &stride));
-        assert(stride == 2 * sizeof(float));
+// ----------------------------------------------------------------------------
 
-        for (i = 0; i < ofx_corner_count; i++) {
-          if (i < blender_loop_count) {
-            ofx_uv_buffer[2 * i] = uv_data[i].uv[0];
-            ofx_uv_buffer[2 * i + 1] = uv_data[i].uv[1];
-          }
-          else {
-            ofx_uv_buffer[2 * i] = 0;
-            ofx_uv_buffer[2 * i + 1] = 0;
+OfxStatus Converter::bmeshToMfx(OfxMeshHandle ofx_mesh,
+                                const MeshInternalData &internal_data) const
+{
+  const Mesh *wrapper = internal_data.blender_mesh;
+  BMesh *bm = wrapper->edit_mesh->bm;
+  const float(*vert_coords)[3] = wrapper->runtime.edit_data->vertexCos;
+
+  printf("Converting edit-mode BMesh into ofx mesh...\n");
+
+  // The topology of the BMesh does not change while transforming elements. Tables that are not
+  // kept in internal data only last for this call, so their buffers cannot be shared.
+  MfxBMeshTopology local_topology;
+  const bool is_topology_kept = NULL != internal_data.bmesh_topology;
+  MfxBMeshTopology &topology = is_topology_kept ? *internal_data.bmesh_topology : local_topology;
+  if (0 != (G.moving & G_TRANSFORM_EDIT) && topology.matches(bm)) {
+    BM_mesh_elem_table_ensure(bm, BM_VERT | BM_FACE);
+  }
+  else {
+    topology.update(bm);
+  }
+
+  // Loose edges come last in the tables, they are left out of faces when the effect asked for
+  // the edge attachment
+  OfxPropertySetHandle edgepoint_attrib;
+  const bool use_loose_edge_attachment =
+      kOfxStatOK ==
+      mes->meshGetAttribute(ofx_mesh, kOfxMeshAttribEdge, kOfxMeshAttribEdgePoint, &edgepoint_attrib);
+  const int loose_edge_count = (int)topology.loose_edges.size();
+  const int loose_edge_face_count = use_loose_edge_attachment ? 0 : loose_edge_count;
+  const int ofx_point_count = bm->totvert;
+  const int ofx_corner_count = (int)topology.corner_points.size() -
+                               2 * (loose_edge_count - loose_edge_face_count);
+  const int ofx_face_count = (int)topology.face_sizes.size() -
+                             (loose_edge_count - loose_edge_face_count);
+  const int ofx_no_loose_edge = 0 == loose_edge_face_count ? 1 : 0;
+  const int ofx_constant_face_size = (loose_edge_face_count > 0 && 0 == bm->totface) ? 2 : -1;
+
+  MFX_CHECK(ps->propSetInt(&ofx_mesh->properties, kOfxMeshPropPointCount, 0, ofx_point_count));
+  MFX_CHECK(ps->propSetInt(&ofx_mesh->properties, kOfxMeshPropCornerCount, 0, ofx_corner_count));
+  MFX_CHECK(ps->propSetInt(&ofx_mesh->properties, kOfxMeshPropFaceCount, 0, ofx_face_count));
+  MFX_CHECK(ps->propSetInt(&ofx_mesh->properties,
+                           kOfxMeshPropLooseEdgeCount,
+                           0,
+                           use_loose_edge_attachment ? loose_edge_count : 0));
+  MFX_CHECK(ps->propSetInt(&ofx_mesh->properties, kOfxMeshPropNoLooseEdge, 0, ofx_no_loose_edge));
+  MFX_CHECK(ps->propSetInt(
+      &ofx_mesh->properties, kOfxMeshPropConstantFaceSize, 0, ofx_constant_face_size));
+
+  const bool use_host_buffers = useHostBuffers(ofx_mesh);
+  const bool share_topology = use_host_buffers && is_topology_kept;
+
+  // Vertex group names are looked up the same way as for meshes
+  MeshComponent names_component;
+  if (NULL != internal_data.geometry_component) {
+    names_component.vertex_group_names() =
+        internal_data.geometry_component->vertex_group_names();
+  }
+  else {
+    names_component.copy_vertex_group_names_from_object(*internal_data.object);
+  }
+
+  blender::Vector<MfxAttributeBinding> bindings = mfx_list_bmesh_attributes(
+      bm,
+      names_component.vertex_group_names(),
+      listRequests(internal_data.requested_attributes),
+      internal_data.weight_cache);
+  blender::Vector<int> bindings_to_fill;
+  blender::Vector<OfxPropertySetHandle> attrib_handles;
+  defineAttributes(
+      ofx_mesh, bindings, use_host_buffers, !ofx_no_loose_edge, attrib_handles, bindings_to_fill);
+
+  // Point position, only contiguous when the wrapper holds deformed coordinates
+  OfxPropertySetHandle pos_attrib;
+  MFX_CHECK(mes->meshGetAttribute(
+      ofx_mesh, kOfxMeshAttribPoint, kOfxMeshAttribPointPosition, &pos_attrib));
+  if (use_host_buffers && NULL != vert_coords) {
+    MFX_CHECK(ps->propSetInt(pos_attrib, kOfxMeshAttribPropIsOwner, 0, 0));
+    MFX_CHECK(ps->propSetPointer(pos_attrib, kOfxMeshAttribPropData, 0, (void *)vert_coords));
+    MFX_CHECK(ps->propSetInt(pos_attrib, kOfxMeshAttribPropStride, 0, sizeof(float[3])));
+  }
+  else {
+    MFX_CHECK(ps->propSetInt(pos_attrib, kOfxMeshAttribPropIsOwner, 0, 1));
+  }
+
+  // Corner point and face size, shared from the tables when they outlive the cook
+  OfxPropertySetHandle cornerpoint_attrib, facesize_attrib;
+  MFX_CHECK(mes->meshGetAttribute(
+      ofx_mesh, kOfxMeshAttribCorner, kOfxMeshAttribCornerPoint, &cornerpoint_attrib));
+  MFX_CHECK(mes->meshGetAttribute(
+      ofx_mesh, kOfxMeshAttribFace, kOfxMeshAttribFaceSize, &facesize_attrib));
+
+  if (share_topology) {
+    MFX_CHECK(ps->propSetInt(cornerpoint_attrib, kOfxMeshAttribPropIsOwner, 0, 0));
+    MFX_CHECK(ps->propSetPointer(
+        cornerpoint_attrib, kOfxMeshAttribPropData, 0, (void *)topology.corner_points.data()));
+    MFX_CHECK(ps->propSetInt(cornerpoint_attrib, kOfxMeshAttribPropStride, 0, sizeof(int)));
+  }
+  else {
+    MFX_CHECK(ps->propSetInt(cornerpoint_attrib, kOfxMeshAttribPropIsOwner, 0, 1));
+  }
+
+  if (-1 != ofx_constant_face_size) {
+    // no buffer, kOfxMeshPropConstantFaceCount optimization
+    MFX_CHECK(ps->propSetInt(facesize_attrib, kOfxMeshAttribPropIsOwner, 0, 0));
+    MFX_CHECK(ps->propSetPointer(facesize_attrib, kOfxMeshAttribPropData, 0, NULL));
+    MFX_CHECK(ps->propSetInt(facesize_attrib, kOfxMeshAttribPropStride, 0, 0));
+  }
+  else if (share_topology) {
+    MFX_CHECK(ps->propSetInt(facesize_attrib, kOfxMeshAttribPropIsOwner, 0, 0));
+    MFX_CHECK(ps->propSetPointer(
+        facesize_attrib, kOfxMeshAttribPropData, 0, (void *)topology.face_sizes.data()));
+    MFX_CHECK(ps->propSetInt(facesize_attrib, kOfxMeshAttribPropStride, 0, sizeof(int)));
+  }
+  else {
+    MFX_CHECK(ps->propSetInt(facesize_attrib, kOfxMeshAttribPropIsOwner, 0, 1));
+  }
+
+  // finished adding attributes, allocate any requested buffers
+  MFX_CHECK(mes->meshAlloc(ofx_mesh));
+
+  if (!use_host_buffers || NULL == vert_coords) {
+    if (NULL != vert_coords) {
+      copyPositions(pos_attrib, (const char *)vert_coords, sizeof(float[3]), ofx_point_count);
+    }
+    else {
+      char *ofx_pos_buffer;
+      int stride, component_stride;
+      MFX_CHECK(
+          ps->propGetPointer(pos_attrib, kOfxMeshAttribPropData, 0, (void **)&ofx_pos_buffer));
+      MFX_CHECK(ps->propGetInt(pos_attrib, kOfxMeshAttribPropStride, 0, &stride));
+      MFX_CHECK(
+          ps->propGetInt(pos_attrib, kOfxMeshAttribPropComponentStride, 0, &component_stride));
+      BMVert **vtable = bm->vtable;
+      blender::parallel_for(
+          blender::IndexRange(ofx_point_count), 4096, [&](blender::IndexRange range) {
+            for (int64_t i : range) {
+              char *p = ofx_pos_buffer + i * stride;
+              for (int c = 0; c < 3; ++c) {
+                *(float *)(p + c * component_stride) = vtable[i]->co[c];
+              }
+            }
+          });
+    }
+  }
+
+  if (!share_topology) {
+    char *ofx_corner_buffer;
+    int corner_stride;
+    MFX_CHECK(ps->propGetPointer(
+        cornerpoint_attrib, kOfxMeshAttribPropData, 0, (void **)&ofx_corner_buffer));
+    MFX_CHECK(ps->propGetInt(cornerpoint_attrib, kOfxMeshAttribPropStride, 0, &corner_stride));
+    blender::parallel_for(
+        blender::IndexRange(ofx_corner_count), 4096, [&](blender::IndexRange range) {
+          for (int64_t i : range) {
+            *attributeAt<int>(ofx_corner_buffer, corner_stride, (int)i) =
+                topology.corner_points[i];
           }
-        }
-      }
+        });
+
+    if (-1 == ofx_constant_face_size) {
+      char *ofx_face_buffer;
+      int face_stride;
+      MFX_CHECK(ps->propGetPointer(
+          facesize_attrib, kOfxMeshAttribPropData, 0, (void **)&ofx_face_buffer));
+      MFX_CHECK(ps->propGetInt(facesize_attrib, kOfxMeshAttribPropStride, 0, &face_stride));
+      blender::parallel_for(
+          blender::IndexRange(ofx_face_count), 4096, [&](blender::IndexRange range) {
+            for (int64_t i : range) {
+              *attributeAt<int>(ofx_face_buffer, face_stride, (int)i) = topology.face_sizes[i];
+            }
+          });
     }
-  }  // end loose edge cleanup
+  }
+
+  if (use_loose_edge_attachment) {
+    char *ofx_edge_buffer;
+    int edge_stride, edge_component_stride;
+    MFX_CHECK(ps->propGetPointer(
+        edgepoint_attrib, kOfxMeshAttribPropData, 0, (void **)&ofx_edge_buffer));
+    MFX_CHECK(ps->propGetInt(edgepoint_attrib, kOfxMeshAttribPropStride, 0, &edge_stride));
+    MFX_CHECK(ps->propGetInt(
+        edgepoint_attrib, kOfxMeshAttribPropComponentStride, 0, &edge_component_stride));
+    for (int i = 0; i < loose_edge_count; ++i) {
+      const BMEdge *edge = topology.loose_edges[i];
+      char *ofx_edge = ofx_edge_buffer + (size_t)edge_stride * i;
+      *(int *)ofx_edge = BM_elem_index_get(edge->v1);
+      *(int *)(ofx_edge + edge_component_stride) = BM_elem_index_get(edge->v2);
+    }
+  }
+
+  // Copy attributes, read from the custom data blocks of BMesh elements
+  for (int i : bindings_to_fill) {
+    const MfxAttributeBinding &binding = bindings[i];
+    char *ofx_data;
+    int ofx_stride, ofx_component_stride;
+    MFX_CHECK(
+        ps->propGetPointer(attrib_handles[i], kOfxMeshAttribPropData, 0, (void **)&ofx_data));
+    MFX_CHECK(ps->propGetInt(attrib_handles[i], kOfxMeshAttribPropStride, 0, &ofx_stride));
+    MFX_CHECK(ps->propGetInt(
+        attrib_handles[i], kOfxMeshAttribPropComponentStride, 0, &ofx_component_stride));
+    int ofx_count = 0 == strcmp(binding.attachment, kOfxMeshAttribPoint)  ? ofx_point_count :
+                    0 == strcmp(binding.attachment, kOfxMeshAttribCorner) ? ofx_corner_count :
+                                                                            ofx_face_count;
+    if (NULL != ofx_data) {
+      mfx_fill_bmesh_attribute_buffer(
+          bm, topology, binding, ofx_data, ofx_stride, ofx_component_stride, ofx_count);
+    }
+  }
 
   return kOfxStatOK;
 }
@@ -451,10 +772,11 @@ OfxStatus Converter::mfxToBlender(OfxMeshHandle ofx_mesh) const
   Mesh *blender_mesh;
   int ofx_point_count, ofx_corner_count, ofx_face_count, ofx_no_loose_edge,
       ofx_constant_face_size;
-  int blender_poly_count, loose_edge_count, blender_loop_count;
-  int point_stride, corner_stride, face_stride;
-  char *point_data, *corner_data, *face_data;
-  OfxStatus status;
+  int blender_poly_count, loose_edge_count, blender_loop_count, attached_edge_count;
+  int point_stride, point_component_stride, corner_stride, face_stride;
+  int edge_stride = 0, edge_component_stride = 0;
+  char *point_data, *corner_data, *face_data, *edge_data = NULL;
+  blender::Vector<int> loop_to_corner, poly_to_face;
   MeshInternalData *internal_data;
 
   propFreeTransformMatrix(&ofx_mesh->properties);
@@ -471,14 +793,22 @@ OfxStatus Converter::mfxToBlender(OfxMeshHandle ofx_mesh) const
     return kOfxStatOK;
   }
 
+  // Mesh that the effect may have written to, freed on return unless it becomes the output
+  auto free_mesh = [](Mesh *mesh) { BKE_id_free(NULL, mesh); };
+  std::unique_ptr<Mesh, decltype(free_mesh)> preallocated_mesh(internal_data->preallocated_mesh,
+                                                               free_mesh);
+  internal_data->preallocated_mesh = NULL;
+
   ps->propGetInt(&ofx_mesh->properties, kOfxMeshPropPointCount, 0, &ofx_point_count);
   ps->propGetInt(&ofx_mesh->properties, kOfxMeshPropCornerCount, 0, &ofx_corner_count);
   ps->propGetInt(&ofx_mesh->properties, kOfxMeshPropFaceCount, 0, &ofx_face_count);
   ps->propGetInt(&ofx_mesh->properties, kOfxMeshPropNoLooseEdge, 0, &ofx_no_loose_edge);
   ps->propGetInt(
       &ofx_mesh->properties, kOfxMeshPropConstantFaceSize, 0, &ofx_constant_face_size);
+  ps->propGetInt(&ofx_mesh->properties, kOfxMeshPropLooseEdgeCount, 0, &attached_edge_count);
 
   if (ofx_point_count < 0 || ofx_corner_count < 0 || ofx_face_count < 0 ||
+      attached_edge_count < 0 ||
       (ofx_no_loose_edge != 0 && ofx_no_loose_edge != 1) ||
       (ofx_no_loose_edge == 1 && ofx_constant_face_size == 2 && ofx_face_count > 0) ||
       (ofx_face_count > 0 && (ofx_constant_face_size < 2 && ofx_constant_face_size != -1))) {
@@ -492,6 +822,10 @@ OfxStatus Converter::mfxToBlender(OfxMeshHandle ofx_mesh) const
   mes->meshGetAttribute(ofx_mesh, kOfxMeshAttribPoint, kOfxMeshAttribPointPosition, &pos_attrib);
   ps->propGetPointer(pos_attrib, kOfxMeshAttribPropData, 0, (void **)&point_data);
   ps->propGetInt(pos_attrib, kOfxMeshAttribPropStride, 0, &point_stride);
+  ps->propGetInt(pos_attrib, kOfxMeshAttribPropComponentStride, 0, &point_component_stride);
+  if (0 == point_component_stride) {
+    point_component_stride = sizeof(float);
+  }
   mes->meshGetAttribute(
       ofx_mesh, kOfxMeshAttribCorner, kOfxMeshAttribCornerPoint, &cornerpoint_attrib);
   ps->propGetPointer(cornerpoint_attrib, kOfxMeshAttribPropData, 0, (void **)&corner_data);
@@ -501,15 +835,54 @@ OfxStatus Converter::mfxToBlender(OfxMeshHandle ofx_mesh) const
   ps->propGetPointer(facesize_attrib, kOfxMeshAttribPropData, 0, (void **)&face_data);
   ps->propGetInt(facesize_attrib, kOfxMeshAttribPropStride, 0, &face_stride);
 
-  ps->propSetPointer(&ofx_mesh->properties, kOfxMeshPropInternalData, 0, NULL);
+  // Loose edges stored apart from faces, when the output sets kOfxInputPropLooseEdgeAttachment
+  OfxPropertySetHandle edgepoint_attrib;
+  if (attached_edge_count > 0) {
+    if (kOfxStatOK != mes->meshGetAttribute(
+                          ofx_mesh, kOfxMeshAttribEdge, kOfxMeshAttribEdgePoint, &edgepoint_attrib)) {
+      printf("WARNING: Loose edge count is set but there is no edge attachment\n");
+      return kOfxStatErrBadHandle;
+    }
+    ps->propGetPointer(edgepoint_attrib, kOfxMeshAttribPropData, 0, (void **)&edge_data);
+    ps->propGetInt(edgepoint_attrib, kOfxMeshAttribPropStride, 0, &edge_stride);
+    ps->propGetInt(edgepoint_attrib, kOfxMeshAttribPropComponentStride, 0, &edge_component_stride);
+    if (0 == edge_component_stride) {
+      edge_component_stride = sizeof(int);
+    }
+  }
+
+  // Samples of a multi-time cook get the output again
+  if (NULL == internal_data->samples) {
+    ps->propSetPointer(&ofx_mesh->properties, kOfxMeshPropInternalData, 0, NULL);
+  }
 
   if ((NULL == point_data && ofx_point_count > 0) ||
       (NULL == corner_data && ofx_corner_count > 0) ||
-      (NULL == face_data && ofx_face_count > 0 && -1 == ofx_constant_face_size)) {
+      (NULL == face_data && ofx_face_count > 0 && -1 == ofx_constant_face_size) ||
+      (NULL == edge_data && attached_edge_count > 0)) {
     printf("WARNING: Null data pointers\n");
     return kOfxStatErrBadHandle;
   }
 
+  OfxPropertySetHandle instance_transform_attrib;
+  if (NULL != internal_data->instances_target && 0 == ofx_face_count && 0 == attached_edge_count &&
+      kOfxStatOK == mes->meshGetAttribute(ofx_mesh,
+                                          kOfxMeshAttribPoint,
+                                          kOfxMeshAttribPointInstanceTransform,
+                                          &instance_transform_attrib)) {
+    return mfxToInstances(ofx_mesh, *internal_data, ofx_point_count);
+  }
+
+  if (NULL != internal_data->source_point_cloud && 0 == ofx_face_count &&
+      0 == attached_edge_count) {
+    return mfxToPointCloud(ofx_mesh,
+                           *internal_data,
+                           ofx_point_count,
+                           point_data,
+                           point_stride,
+                           point_component_stride);
+  }
+
   // Figure out geometry size on Blender side.
   // Separate true faces (polys) and 2-corner faces (loose edges), to get proper faces/edges in
   // Blender. This requires reinterpretation of OFX face and corner attributes, since we'll
@@ -520,7 +893,7 @@ OfxStatus Converter::mfxToBlender(OfxMeshHandle ofx_mesh) const
   if (1 == ofx_no_loose_edge) {
     loose_edge_count = 0;
     if (ofx_constant_face_size == -1) {
-      assert(check_no_loose_edges_in_ofx_mesh(ofx_face_count, face_data, face_stride));
+      assert(check_no_loose_edges_in_ofx_mesh(ofx_face_count, (int *)face_data, face_stride));
     }
   }
   else if (2 == ofx_constant_face_size) {
@@ -538,20 +911,45 @@ OfxStatus Converter::mfxToBlender(OfxMeshHandle ofx_mesh) const
 
   blender_poly_count = ofx_face_count - loose_edge_count;
   blender_loop_count = ofx_corner_count - 2 * loose_edge_count;
-
-  printf("Allocating Blender mesh with %d verts %d edges %d loops %d polys\n",
-         ofx_point_count,
-         loose_edge_count,
-         blender_loop_count,
-         blender_poly_count);
-  if (source_mesh) {
-    blender_mesh = BKE_mesh_new_nomain_from_template(
-        source_mesh, ofx_point_count, loose_edge_count, 0, blender_loop_count, blender_poly_count);
+  const int blender_loose_edge_count = loose_edge_count + attached_edge_count;
+
+  // Several outputs may forward the topology of the main input, in which case it is copied by
+  // block rather than converted corner by corner
+  const bool is_topology_shared = 0 == blender_loose_edge_count &&
+                                  sharesTopology(source_mesh,
+                                                 ofx_corner_count,
+                                                 ofx_face_count,
+                                                 ofx_constant_face_size,
+                                                 corner_data,
+                                                 corner_stride,
+                                                 face_data,
+                                                 face_stride);
+
+  const Mesh *preallocated = preallocated_mesh.get();
+  if (NULL != preallocated && preallocated->totvert == ofx_point_count &&
+      preallocated->totedge == blender_loose_edge_count &&
+      preallocated->totloop == blender_loop_count && preallocated->totpoly == blender_poly_count) {
+    blender_mesh = preallocated_mesh.release();
   }
   else {
-    printf("Warning: No source mesh\n");
-    blender_mesh = BKE_mesh_new_nomain(
-        ofx_point_count, loose_edge_count, 0, ofx_corner_count, blender_poly_count);
+    printf("Allocating Blender mesh with %d verts %d edges %d loops %d polys\n",
+           ofx_point_count,
+           blender_loose_edge_count,
+           blender_loop_count,
+           blender_poly_count);
+    if (source_mesh) {
+      blender_mesh = BKE_mesh_new_nomain_from_template(source_mesh,
+                                                       ofx_point_count,
+                                                       blender_loose_edge_count,
+                                                       0,
+                                                       blender_loop_count,
+                                                       blender_poly_count);
+    }
+    else {
+      printf("Warning: No source mesh\n");
+      blender_mesh = BKE_mesh_new_nomain(
+          ofx_point_count, blender_loose_edge_count, 0, ofx_corner_count, blender_poly_count);
+    }
   }
   if (NULL == blender_mesh) {
     printf("WARNING: Could not allocate Blender Mesh data\n");
@@ -560,16 +958,24 @@ OfxStatus Converter::mfxToBlender(OfxMeshHandle ofx_mesh) const
 
   printf("Converting ofx mesh into blender mesh...\n");
 
-  // copy OFX points (= Blender's vertex)
-  for (int i = 0; i < ofx_point_count; ++i) {
-    float *p = attributeAt<float>(point_data, point_stride, i);
-    copy_v3_v3(blender_mesh->mvert[i].co, p);
+  // copy OFX points (= Blender's vertex), unless the effect wrote them in place
+  const bool is_point_in_place = point_data == (char *)blender_mesh->mvert;
+  for (int i = 0; i < ofx_point_count && !is_point_in_place; ++i) {
+    const char *p = point_data + (size_t)i * point_stride;
+    for (int c = 0; c < 3; ++c) {
+      blender_mesh->mvert[i].co[c] = *(const float *)(p + c * point_component_stride);
+    }
   }
 
   // copy OFX corners (= Blender's loops) + OFX faces (= Blender's faces and edges)
-  if (loose_edge_count == 0) {
+  if (is_topology_shared) {
+    memcpy(blender_mesh->mloop, source_mesh->mloop, sizeof(MLoop) * (size_t)blender_loop_count);
+    memcpy(blender_mesh->mpoly, source_mesh->mpoly, sizeof(MPoly) * (size_t)blender_poly_count);
+  }
+  else if (loose_edge_count == 0) {
     // Corners
-    for (int i = 0; i < ofx_corner_count; ++i) {
+    const bool is_corner_in_place = corner_data == (char *)blender_mesh->mloop;
+    for (int i = 0; i < ofx_corner_count && !is_corner_in_place; ++i) {
       blender_mesh->mloop[i].v = *attributeAt<int>(corner_data, corner_stride, i);
     }
 
@@ -586,6 +992,10 @@ OfxStatus Converter::mfxToBlender(OfxMeshHandle ofx_mesh) const
     }
   }
   else {
+    // Remember where Blender loops and polys come from, to copy attributes
+    loop_to_corner.reserve(blender_loop_count);
+    poly_to_face.reserve(blender_poly_count);
+
     int size = ofx_constant_face_size;
     int current_poly = 0, current_edge = 0, current_corner_ofx = 0,
         current_loop_blender = 0;
@@ -596,8 +1006,10 @@ OfxStatus Converter::mfxToBlender(OfxMeshHandle ofx_mesh) const
       }
       if (2 == size) {
         // make Blender edge, no loops
-        blender_mesh->medge[current_edge].v1 = corner_data[current_corner_ofx];
-        blender_mesh->medge[current_edge].v2 = corner_data[current_corner_ofx + 1];
+        blender_mesh->medge[current_edge].v1 = *attributeAt<int>(
+            corner_data, corner_stride, current_corner_ofx);
+        blender_mesh->medge[current_edge].v2 = *attributeAt<int>(
+            corner_data, corner_stride, current_corner_ofx + 1);
         blender_mesh->medge[current_edge].flag |= ME_LOOSEEDGE |
                                                   ME_EDGEDRAW;  // see BKE_mesh_calc_edges_loose()
 
@@ -608,9 +1020,12 @@ OfxStatus Converter::mfxToBlender(OfxMeshHandle ofx_mesh) const
         // make Blender poly and loops
         blender_mesh->mpoly[current_poly].loopstart = current_loop_blender;
         blender_mesh->mpoly[current_poly].totloop = size;
+        poly_to_face.append(i);
 
         for (int j = 0; j < size; ++j) {
-          blender_mesh->mloop[current_loop_blender + j].v = corner_data[current_corner_ofx + j];
+          blender_mesh->mloop[current_loop_blender + j].v = *attributeAt<int>(
+              corner_data, corner_stride, current_corner_ofx + j);
+          loop_to_corner.append(current_corner_ofx + j);
         }
 
         ++current_poly;
@@ -620,63 +1035,640 @@ OfxStatus Converter::mfxToBlender(OfxMeshHandle ofx_mesh) const
     }
   }
 
-  // Get corner UVs if UVs are present in the mesh
-  // TODO: Use semantics to get UV layers back from mfx mesh
-  int uv_layers = 4;
-  char name[MAX_CORNER_ATTRIB_NAME];
-  char *ofx_uv_data;
-  int ofx_uv_stride;
-  for (int k = 0; k < uv_layers; ++k) {
-    OfxPropertySetHandle uv_attrib;
-    sprintf(name, "uv%d", k);
-    printf("Look for attribute '%s'\n", name);
-    status = mes->meshGetAttribute(ofx_mesh, kOfxMeshAttribCorner, name, &uv_attrib);
-    if (kOfxStatOK == status) {
-      printf("Found!\n");
-      ps->propGetPointer(uv_attrib, kOfxMeshAttribPropData, 0, (void **)&ofx_uv_data);
-      ps->propGetInt(uv_attrib, kOfxMeshAttribPropStride, 0, &ofx_uv_stride);
-
-      if (loose_edge_count > 0) {
-        // TODO implement OFX->Blender UV conversion for loose edge meshes
-        // we would need to traverse faces too, since we need to skip loose edges
-        // and they need not be at the end like in before_mesh_get()
-        printf(
-            "WARNING: mesh has loose edges, copying UVs is not currently implemented for this "
-            "case!\n");
-        continue;
-      }
+  // Loose edges of the edge attachment come after those made of 2-corner faces
+  for (int i = 0; i < attached_edge_count; ++i) {
+    const char *e = edge_data + (size_t)i * edge_stride;
+    MEdge &edge = blender_mesh->medge[loose_edge_count + i];
+    edge.v1 = *(const int *)e;
+    edge.v2 = *(const int *)(e + edge_component_stride);
+    edge.flag |= ME_LOOSEEDGE | ME_EDGEDRAW;
+  }
+
+  if (blender_poly_count > 0) {
+    // Samples of a multi-time cook usually share their topology
+    // unless the faces are those of the source mesh
+    const Mesh *reference = is_topology_shared ? source_mesh :
+                                                 topologyReference(internal_data->samples);
+    if (blender_loose_edge_count > 0 || NULL == reference ||
+        !reuseEdges(blender_mesh, reference)) {
+      // if we're here, this dominates before_mesh_get()/before_mesh_release() total running time!
+      BKE_mesh_calc_edges(blender_mesh, (blender_loose_edge_count > 0), false);
+    }
+  }
 
-      // Get UV data pointer in mesh.
-      // elie: The next line does not work idk why, hence the next three lines.
-      // MLoopUV *uv_data = (MLoopUV*)CustomData_add_layer_named(&blender_mesh->ldata, CD_MLOOPUV,
-      // CD_CALLOC, NULL, ofx_corner_count, name);
-      char uvname[MAX_CUSTOMDATA_LAYER_NAME];
-      CustomData_validate_layer_name(&blender_mesh->ldata, CD_MLOOPUV, name, uvname);
-      MLoopUV *uv_data = (MLoopUV *)CustomData_duplicate_referenced_layer_named(
-          &blender_mesh->ldata, CD_MLOOPUV, uvname, ofx_corner_count);
-
-      for (int i = 0; i < ofx_corner_count; ++i) {
-        float *uv = attributeAt<float>(ofx_uv_data, ofx_uv_stride, i);
-        uv_data[i].uv[0] = uv[0];
-        uv_data[i].uv[1] = uv[1];
+  // Copy other attributes, now that topology (including edges) is known
+  MeshComponent component;
+  component.replace(blender_mesh, GeometryOwnershipType::Editable);
+  MeshComponent source_component;
+  if (source_mesh) {
+    source_component.replace(source_mesh, GeometryOwnershipType::ReadOnly);
+  }
+  if (internal_data->geometry_component) {
+    component.vertex_group_names() = internal_data->geometry_component->vertex_group_names();
+    source_component.vertex_group_names() = component.vertex_group_names();
+  }
+  else if (internal_data->object) {
+    component.copy_vertex_group_names_from_object(*internal_data->object);
+    source_component.copy_vertex_group_names_from_object(*internal_data->object);
+  }
+
+  for (int i = 0; i < ofx_mesh->attributes.num_attributes; ++i) {
+    OfxAttributeStruct *attribute = ofx_mesh->attributes.attributes[i];
+    MfxAttributeBuffer buffer;
+    buffer.name = attribute->name;
+    buffer.attachment = attachmentAsString(attribute->attachment);
+    if (NULL == buffer.attachment) {
+      continue;
+    }
+    if (0 == strcmp(buffer.name, kOfxMeshAttribPointPosition) ||
+        0 == strcmp(buffer.name, kOfxMeshAttribCornerPoint) ||
+        0 == strcmp(buffer.name, kOfxMeshAttribFaceSize)) {
+      continue;
+    }
+
+    char *type, *semantic;
+    MFX_CHECK(ps->propGetString(&attribute->properties, kOfxMeshAttribPropType, 0, &type));
+    MFX_CHECK(ps->propGetString(&attribute->properties, kOfxMeshAttribPropSemantic, 0, &semantic));
+    MFX_CHECK(ps->propGetInt(
+        &attribute->properties, kOfxMeshAttribPropComponentCount, 0, &buffer.component_count));
+    MFX_CHECK(ps->propGetPointer(
+        &attribute->properties, kOfxMeshAttribPropData, 0, (void **)&buffer.data));
+    MFX_CHECK(ps->propGetInt(&attribute->properties, kOfxMeshAttribPropStride, 0, &buffer.stride));
+    MFX_CHECK(ps->propGetInt(&attribute->properties,
+                             kOfxMeshAttribPropComponentStride,
+                             0,
+                             &buffer.component_stride));
+    buffer.type = type;
+    buffer.semantic = semantic;
+
+    if (NULL == buffer.data) {
+      continue;
+    }
+
+    mfx_write_attribute_buffer(component,
+                               source_mesh ? &source_component : nullptr,
+                               buffer,
+                               loop_to_corner,
+                               poly_to_face);
+  }
+
+  if (NULL != internal_data->samples) {
+    storeSample(ofx_mesh, *internal_data->samples, blender_mesh);
+  }
+  else {
+    internal_data->blender_mesh = blender_mesh;
+  }
+
+  return kOfxStatOK;
+}
+
+OfxStatus Converter::preallocateBlender(OfxMeshHandle ofx_mesh) const
+{
+  MeshInternalData *internal_data;
+  ps->propGetPointer(&ofx_mesh->properties, kOfxMeshPropInternalData, 0, (void **)&internal_data);
+
+  // Instances and point clouds are not stored in a Blender mesh
+  if (NULL == internal_data || true == internal_data->is_input ||
+      NULL != internal_data->instances_target || NULL != internal_data->source_point_cloud) {
+    return kOfxStatOK;
+  }
+
+  // Out of core buffers are meant to leave memory, which Blender meshes do not
+  int is_out_of_core;
+  MFX_CHECK(ps->propGetInt(&ofx_mesh->properties, kOfxMeshPropOutOfCore, 0, &is_out_of_core));
+  if (!useHostBuffers(ofx_mesh) || is_out_of_core) {
+    return kOfxStatOK;
+  }
+
+  int point_count, corner_count, face_count, no_loose_edge, constant_face_size,
+      attached_edge_count;
+  MFX_CHECK(ps->propGetInt(&ofx_mesh->properties, kOfxMeshPropPointCount, 0, &point_count));
+  MFX_CHECK(ps->propGetInt(&ofx_mesh->properties, kOfxMeshPropCornerCount, 0, &corner_count));
+  MFX_CHECK(ps->propGetInt(&ofx_mesh->properties, kOfxMeshPropFaceCount, 0, &face_count));
+  MFX_CHECK(ps->propGetInt(&ofx_mesh->properties, kOfxMeshPropNoLooseEdge, 0, &no_loose_edge));
+  MFX_CHECK(ps->propGetInt(
+      &ofx_mesh->properties, kOfxMeshPropConstantFaceSize, 0, &constant_face_size));
+  MFX_CHECK(ps->propGetInt(
+      &ofx_mesh->properties, kOfxMeshPropLooseEdgeCount, 0, &attached_edge_count));
+
+  // Corners map to loops one to one only when there is no 2-corner face
+  if (point_count <= 0 || corner_count < 0 || face_count < 0 || attached_edge_count < 0 ||
+      1 != no_loose_edge ||
+      (face_count > 0 && -1 != constant_face_size && constant_face_size < 3)) {
+    return kOfxStatOK;
+  }
+
+  Mesh *blender_mesh;
+  if (NULL != internal_data->source_mesh) {
+    blender_mesh = BKE_mesh_new_nomain_from_template(
+        internal_data->source_mesh, point_count, attached_edge_count, 0, corner_count, face_count);
+  }
+  else {
+    blender_mesh = BKE_mesh_new_nomain(
+        point_count, attached_edge_count, 0, corner_count, face_count);
+  }
+  if (NULL == blender_mesh) {
+    return kOfxStatOK;
+  }
+
+  // Point the attributes that the host would allocate to the mesh, as long as their type matches
+  auto bind = [&](const char *attachment,
+                  const char *name,
+                  const char *type,
+                  int component_count,
+                  void *data,
+                  int stride,
+                  int component_stride) {
+    OfxPropertySetHandle attrib;
+    int is_owner, attrib_component_count;
+    char *attrib_type;
+    if (kOfxStatOK != mes->meshGetAttribute(ofx_mesh, attachment, name, &attrib)) {
+      return;
+    }
+    MFX_CHECK(ps->propGetInt(attrib, kOfxMeshAttribPropIsOwner, 0, &is_owner));
+    MFX_CHECK(ps->propGetString(attrib, kOfxMeshAttribPropType, 0, &attrib_type));
+    MFX_CHECK(
+        ps->propGetInt(attrib, kOfxMeshAttribPropComponentCount, 0, &attrib_component_count));
+    if (!is_owner || 0 != strcmp(attrib_type, type) || attrib_component_count != component_count) {
+      return;
+    }
+    MFX_CHECK(ps->propSetPointer(attrib, kOfxMeshAttribPropData, 0, data));
+    MFX_CHECK(ps->propSetInt(attrib, kOfxMeshAttribPropStride, 0, stride));
+    MFX_CHECK(ps->propSetInt(attrib, kOfxMeshAttribPropComponentStride, 0, component_stride));
+    MFX_CHECK(ps->propSetInt(attrib, kOfxMeshAttribPropIsOwner, 0, 0));
+  };
+
+  bind(kOfxMeshAttribPoint,
+       kOfxMeshAttribPointPosition,
+       kOfxMeshAttribTypeFloat,
+       3,
+       blender_mesh->mvert->co,
+       sizeof(MVert),
+       sizeof(float));
+  if (corner_count > 0) {
+    bind(kOfxMeshAttribCorner,
+         kOfxMeshAttribCornerPoint,
+         kOfxMeshAttribTypeInt,
+         1,
+         &blender_mesh->mloop->v,
+         sizeof(MLoop),
+         sizeof(int));
+  }
+  if (face_count > 0 && -1 == constant_face_size) {
+    bind(kOfxMeshAttribFace,
+         kOfxMeshAttribFaceSize,
+         kOfxMeshAttribTypeInt,
+         1,
+         &blender_mesh->mpoly->totloop,
+         sizeof(MPoly),
+         sizeof(int));
+  }
+
+  free_preallocated_mesh(*internal_data);
+  internal_data->preallocated_mesh = blender_mesh;
+  return kOfxStatOK;
+}
+
+// ----------------------------------------------------------------------------
+
+OfxStatus Converter::pointCloudToMfx(OfxMeshHandle ofx_mesh,
+                                     const MeshInternalData &internal_data) const
+{
+  PointCloud *pointcloud = internal_data.point_cloud;
+  const int point_count = pointcloud->totpoint;
+
+  printf("Converting blender point cloud into ofx mesh...\n");
+
+  MFX_CHECK(ps->propSetInt(&ofx_mesh->properties, kOfxMeshPropPointCount, 0, point_count));
+  MFX_CHECK(ps->propSetInt(&ofx_mesh->properties, kOfxMeshPropCornerCount, 0, 0));
+  MFX_CHECK(ps->propSetInt(&ofx_mesh->properties, kOfxMeshPropFaceCount, 0, 0));
+  MFX_CHECK(ps->propSetInt(&ofx_mesh->properties, kOfxMeshPropNoLooseEdge, 0, 1));
+  MFX_CHECK(ps->propSetInt(&ofx_mesh->properties, kOfxMeshPropConstantFaceSize, 0, -1));
+
+  const bool use_host_buffers = useHostBuffers(ofx_mesh);
+
+  PointCloudComponent component;
+  component.replace(pointcloud, GeometryOwnershipType::ReadOnly);
+
+  blender::Vector<MfxAttributeBinding> bindings = mfx_list_point_cloud_attributes(
+      component, listRequests(internal_data.requested_attributes));
+  blender::Vector<int> bindings_to_fill;
+  blender::Vector<OfxPropertySetHandle> attrib_handles;
+  defineAttributes(ofx_mesh, bindings, use_host_buffers, false, attrib_handles, bindings_to_fill);
+
+  // Point position, forwarded in place
+  OfxPropertySetHandle pos_attrib;
+  MFX_CHECK(mes->meshGetAttribute(
+      ofx_mesh, kOfxMeshAttribPoint, kOfxMeshAttribPointPosition, &pos_attrib));
+  if (use_host_buffers) {
+    MFX_CHECK(ps->propSetInt(pos_attrib, kOfxMeshAttribPropIsOwner, 0, 0));
+    MFX_CHECK(ps->propSetPointer(pos_attrib, kOfxMeshAttribPropData, 0, (void *)pointcloud->co));
+    MFX_CHECK(ps->propSetInt(pos_attrib, kOfxMeshAttribPropStride, 0, 3 * sizeof(float)));
+  }
+  else {
+    MFX_CHECK(ps->propSetInt(pos_attrib, kOfxMeshAttribPropIsOwner, 0, 1));
+  }
+
+  // No corner nor face, hence no buffer
+  const char *topology[][2] = {{kOfxMeshAttribCorner, kOfxMeshAttribCornerPoint},
+                               {kOfxMeshAttribFace, kOfxMeshAttribFaceSize}};
+  for (const auto &attribute : topology) {
+    OfxPropertySetHandle attrib;
+    MFX_CHECK(mes->meshGetAttribute(ofx_mesh, attribute[0], attribute[1], &attrib));
+    MFX_CHECK(ps->propSetInt(attrib, kOfxMeshAttribPropIsOwner, 0, 0));
+    MFX_CHECK(ps->propSetPointer(attrib, kOfxMeshAttribPropData, 0, NULL));
+  }
+
+  MFX_CHECK(mes->meshAlloc(ofx_mesh));
+
+  if (!use_host_buffers) {
+    copyPositions(pos_attrib, (const char *)pointcloud->co, 3 * sizeof(float), point_count);
+  }
+
+  fillAttributes(
+      component, bindings, attrib_handles, bindings_to_fill, {}, point_count, 0, 0);
+
+  return kOfxStatOK;
+}
+
+OfxStatus Converter::mfxToPointCloud(OfxMeshHandle ofx_mesh,
+                                     MeshInternalData &internal_data,
+                                     int point_count,
+                                     const char *point_data,
+                                     int point_stride,
+                                     int point_component_stride) const
+{
+  const PointCloud *source = internal_data.source_point_cloud;
+
+  printf("Allocating Blender point cloud with %d points\n", point_count);
+  PointCloud *pointcloud = BKE_pointcloud_new_for_eval(source, point_count);
+  if (NULL == pointcloud) {
+    printf("WARNING: Could not allocate Blender PointCloud data\n");
+    return kOfxStatErrMemory;
+  }
+
+  const bool is_packed = point_stride == 3 * sizeof(float) &&
+                         point_component_stride == sizeof(float);
+  if (is_packed && point_count > 0) {
+    memcpy(pointcloud->co, point_data, (size_t)point_count * 3 * sizeof(float));
+  }
+  else {
+    blender::parallel_for(
+        blender::IndexRange(point_count), 4096, [&](blender::IndexRange range) {
+          for (int64_t i : range) {
+            const char *p = point_data + i * point_stride;
+            for (int c = 0; c < 3; ++c) {
+              pointcloud->co[i][c] = *(const float *)(p + c * point_component_stride);
+            }
+          }
+        });
+  }
+
+  PointCloudComponent component;
+  component.replace(pointcloud, GeometryOwnershipType::Editable);
+  PointCloudComponent source_component;
+  source_component.replace(const_cast<PointCloud *>(source), GeometryOwnershipType::ReadOnly);
+
+  bool has_radius = false;
+  for (int i = 0; i < ofx_mesh->attributes.num_attributes; ++i) {
+    OfxAttributeStruct *attribute = ofx_mesh->attributes.attributes[i];
+    MfxAttributeBuffer buffer;
+    buffer.name = attribute->name;
+    buffer.attachment = attachmentAsString(attribute->attachment);
+    if (AttributeAttachment::Point != attribute->attachment ||
+        0 == strcmp(buffer.name, kOfxMeshAttribPointPosition)) {
+      continue;
+    }
+
+    char *type, *semantic;
+    MFX_CHECK(ps->propGetString(&attribute->properties, kOfxMeshAttribPropType, 0, &type));
+    MFX_CHECK(ps->propGetString(&attribute->properties, kOfxMeshAttribPropSemantic, 0, &semantic));
+    MFX_CHECK(ps->propGetInt(
+        &attribute->properties, kOfxMeshAttribPropComponentCount, 0, &buffer.component_count));
+    MFX_CHECK(ps->propGetPointer(
+        &attribute->properties, kOfxMeshAttribPropData, 0, (void **)&buffer.data));
+    MFX_CHECK(ps->propGetInt(&attribute->properties, kOfxMeshAttribPropStride, 0, &buffer.stride));
+    MFX_CHECK(ps->propGetInt(&attribute->properties,
+                             kOfxMeshAttribPropComponentStride,
+                             0,
+                             &buffer.component_stride));
+    buffer.type = type;
+    buffer.semantic = semantic;
+
+    if (NULL == buffer.data) {
+      continue;
+    }
+
+    if (mfx_write_point_cloud_attribute_buffer(component, &source_component, buffer) &&
+        0 == strcmp(buffer.name, "radius")) {
+      has_radius = true;
+    }
+  }
+
+  // Layers are not initialized, points without radius would not show
+  BKE_pointcloud_update_customdata_pointers(pointcloud);
+  if (!has_radius && NULL != pointcloud->radius) {
+    if (point_count == source->totpoint && NULL != source->radius) {
+      memcpy(pointcloud->radius, source->radius, (size_t)point_count * sizeof(float));
+    }
+    else {
+      std::fill_n(pointcloud->radius, point_count, 0.05f);
+    }
+  }
+
+  internal_data.point_cloud = pointcloud;
+
+  return kOfxStatOK;
+}
+
+OfxStatus Converter::mfxToInstances(OfxMeshHandle ofx_mesh,
+                                    MeshInternalData &internal_data,
+                                    int point_count) const
+{
+  OfxPropertySetHandle transform_attrib, input_attrib;
+  char *type;
+  int component_count;
+  char *transform_data, *input_data = NULL;
+  int transform_stride, transform_component_stride, input_stride = 0;
+  MFX_CHECK(mes->meshGetAttribute(
+      ofx_mesh, kOfxMeshAttribPoint, kOfxMeshAttribPointInstanceTransform, &transform_attrib));
+  MFX_CHECK(ps->propGetString(transform_attrib, kOfxMeshAttribPropType, 0, &type));
+  MFX_CHECK(ps->propGetInt(transform_attrib, kOfxMeshAttribPropComponentCount, 0, &component_count));
+  if (0 != strcmp(type, kOfxMeshAttribTypeFloat) || 16 != component_count) {
+    printf("WARNING: Instance transforms must have 16 float components\n");
+    return kOfxStatErrBadHandle;
+  }
+  MFX_CHECK(ps->propGetPointer(transform_attrib, kOfxMeshAttribPropData, 0, (void **)&transform_data));
+  MFX_CHECK(ps->propGetInt(transform_attrib, kOfxMeshAttribPropStride, 0, &transform_stride));
+  MFX_CHECK(ps->propGetInt(
+      transform_attrib, kOfxMeshAttribPropComponentStride, 0, &transform_component_stride));
+  if (NULL == transform_data && point_count > 0) {
+    printf("WARNING: Null data pointers\n");
+    return kOfxStatErrBadHandle;
+  }
+
+  // The instanced input is optional, and defaults to the first extra input
+  if (kOfxStatOK ==
+      mes->meshGetAttribute(
+          ofx_mesh, kOfxMeshAttribPoint, kOfxMeshAttribPointInstanceInput, &input_attrib)) {
+    MFX_CHECK(ps->propGetString(input_attrib, kOfxMeshAttribPropType, 0, &type));
+    if (0 == strcmp(type, kOfxMeshAttribTypeInt)) {
+      MFX_CHECK(ps->propGetPointer(input_attrib, kOfxMeshAttribPropData, 0, (void **)&input_data));
+      MFX_CHECK(ps->propGetInt(input_attrib, kOfxMeshAttribPropStride, 0, &input_stride));
+    }
+    else {
+      printf("WARNING: Ignoring instance input attribute, which must be an int\n");
+    }
+  }
+
+  printf("Converting %d points into instances\n", point_count);
+  InstancesComponent &instances =
+      internal_data.instances_target->get_component_for_write<InstancesComponent>();
+  int skipped_count = 0;
+  for (int i = 0; i < point_count; ++i) {
+    int input_index = NULL != input_data ? *attributeAt<int>(input_data, input_stride, i) : 0;
+    Object *source = input_index >= 0 && input_index < internal_data.instance_source_count ?
+                         internal_data.instance_sources[input_index] :
+                         NULL;
+    if (NULL == source) {
+      ++skipped_count;
+      continue;
+    }
+
+    // Row major on OpenMfx side, column major on Blender side
+    const char *matrix = transform_data + (size_t)i * transform_stride;
+    blender::float4x4 transform;
+    for (int row = 0; row < 4; ++row) {
+      for (int col = 0; col < 4; ++col) {
+        transform.values[col][row] = *(const float *)(matrix + (row * 4 + col) *
+                                                                   transform_component_stride);
       }
-      blender_mesh->runtime.cd_dirty_loop |= CD_MASK_MLOOPUV;
-      blender_mesh->runtime.cd_dirty_poly |= CD_MASK_MTFACE;
     }
+    instances.add_instance(source, transform);
   }
 
-  if (blender_poly_count > 0) {
-    // if we're here, this dominates before_mesh_get()/before_mesh_release() total running time!
-    BKE_mesh_calc_edges(blender_mesh, (loose_edge_count > 0), false);
+  if (skipped_count > 0) {
+    printf("WARNING: Skipped %d instances of inputs that have no object\n", skipped_count);
   }
 
-  internal_data->blender_mesh = blender_mesh;
+  internal_data.is_instanced = true;
 
   return kOfxStatOK;
 }
 
+bool Converter::useHostBuffers(OfxMeshHandle ofx_mesh) const
+{
+  // Effects asking for a specific layout get contiguous copies of all buffers
+  char *layout;
+  int alignment;
+  MFX_CHECK(ps->propGetString(&ofx_mesh->properties, kOfxMeshPropAttributeLayout, 0, &layout));
+  MFX_CHECK(ps->propGetInt(&ofx_mesh->properties, kOfxMeshPropAttributeAlignment, 0, &alignment));
+  return 0 == alignment &&
+         (NULL == layout || 0 == strcmp(layout, kOfxMeshAttribLayoutInterleaved));
+}
+
+blender::Vector<MfxAttributeRequest> Converter::listRequests(
+    const OfxAttributeSetStruct *requested_attributes) const
+{
+  blender::Vector<MfxAttributeRequest> requests;
+  if (NULL == requested_attributes) {
+    return requests;
+  }
+  for (int i = 0; i < requested_attributes->num_attributes; ++i) {
+    OfxAttributeStruct *attribute = requested_attributes->attributes[i];
+    MfxAttributeRequest request;
+    request.name = attribute->name;
+    request.attachment = attachmentAsString(attribute->attachment);
+    if (NULL == request.attachment) {
+      continue;
+    }
+    char *type;
+    MFX_CHECK(ps->propGetString(&attribute->properties, kOfxMeshAttribPropType, 0, &type));
+    MFX_CHECK(ps->propGetInt(
+        &attribute->properties, kOfxMeshAttribPropComponentCount, 0, &request.component_count));
+    request.type = type;
+    requests.append(request);
+  }
+  return requests;
+}
+
+void Converter::defineAttributes(OfxMeshHandle ofx_mesh,
+                                 blender::Span<MfxAttributeBinding> bindings,
+                                 bool use_host_buffers,
+                                 bool has_loose_edges,
+                                 blender::Vector<OfxPropertySetHandle> &r_handles,
+                                 blender::Vector<int> &r_to_fill) const
+{
+  for (int i = 0; i < bindings.size(); ++i) {
+    const MfxAttributeBinding &binding = bindings[i];
+    OfxPropertySetHandle attrib;
+    MFX_CHECK(mes->attributeDefine(ofx_mesh,
+                                   binding.attachment,
+                                   binding.name.c_str(),
+                                   binding.component_count,
+                                   binding.type,
+                                   binding.semantic,
+                                   &attrib));
+    r_handles.append(attrib);
+
+    if (use_host_buffers && binding.can_share_buffer(has_loose_edges)) {
+      MFX_CHECK(ps->propSetInt(attrib, kOfxMeshAttribPropIsOwner, 0, 0));
+      MFX_CHECK(ps->propSetPointer(attrib, kOfxMeshAttribPropData, 0, (void *)binding.raw_data));
+      MFX_CHECK(ps->propSetInt(attrib, kOfxMeshAttribPropStride, 0, binding.raw_stride));
+    }
+    else {
+      // request new buffer, filled after allocation
+      MFX_CHECK(ps->propSetInt(attrib, kOfxMeshAttribPropIsOwner, 0, 1));
+      r_to_fill.append(i);
+    }
+  }
+}
+
+void Converter::fillAttributes(const GeometryComponent &component,
+                               blender::Span<MfxAttributeBinding> bindings,
+                               blender::Span<OfxPropertySetHandle> handles,
+                               blender::Span<int> to_fill,
+                               blender::Span<int> loose_edges,
+                               int point_count,
+                               int corner_count,
+                               int face_count) const
+{
+  for (int i : to_fill) {
+    const MfxAttributeBinding &binding = bindings[i];
+    char *ofx_data;
+    int ofx_stride, ofx_component_stride;
+    MFX_CHECK(ps->propGetPointer(handles[i], kOfxMeshAttribPropData, 0, (void **)&ofx_data));
+    MFX_CHECK(ps->propGetInt(handles[i], kOfxMeshAttribPropStride, 0, &ofx_stride));
+    MFX_CHECK(
+        ps->propGetInt(handles[i], kOfxMeshAttribPropComponentStride, 0, &ofx_component_stride));
+    int ofx_count = 0 == strcmp(binding.attachment, kOfxMeshAttribPoint) ? point_count :
+                    0 == strcmp(binding.attachment, kOfxMeshAttribCorner) ? corner_count :
+                                                                            face_count;
+    if (NULL != ofx_data) {
+      mfx_fill_attribute_buffer(
+          component, binding, loose_edges, ofx_data, ofx_stride, ofx_component_stride, ofx_count);
+    }
+  }
+}
+
+void Converter::copyPositions(OfxPropertySetHandle pos_attrib,
+                              const char *src_data,
+                              int src_stride,
+                              int point_count) const
+{
+  char *ofx_pos_buffer;
+  int stride, component_stride;
+  MFX_CHECK(ps->propGetPointer(pos_attrib, kOfxMeshAttribPropData, 0, (void **)&ofx_pos_buffer));
+  MFX_CHECK(ps->propGetInt(pos_attrib, kOfxMeshAttribPropStride, 0, &stride));
+  MFX_CHECK(ps->propGetInt(pos_attrib, kOfxMeshAttribPropComponentStride, 0, &component_stride));
+  blender::parallel_for(blender::IndexRange(point_count), 4096, [&](blender::IndexRange range) {
+    for (int64_t i : range) {
+      const float *co = (const float *)(src_data + i * src_stride);
+      char *p = ofx_pos_buffer + i * stride;
+      for (int c = 0; c < 3; ++c) {
+        *(float *)(p + c * component_stride) = co[c];
+      }
+    }
+  });
+}
+
 // ----------------------------------------------------------------------------
 
+void Converter::storeSample(OfxMeshHandle ofx_mesh, MfxOutputSamples &samples, Mesh *mesh) const
+{
+  double time = 0.0;
+  ps->propGetDouble(&ofx_mesh->properties, kOfxMeshPropTime, 0, &time);
+
+  int index = 0;
+  for (int i = 0; i < samples.count; ++i) {
+    if (fabs(samples.times[i] - time) < 1e-4) {
+      index = i;
+      break;
+    }
+  }
+
+  // The effect may output the same time twice, the last one wins
+  if (NULL != samples.meshes[index]) {
+    BKE_id_free(NULL, samples.meshes[index]);
+  }
+  samples.meshes[index] = mesh;
+}
+
+const Mesh *Converter::topologyReference(const MfxOutputSamples *samples)
+{
+  if (NULL == samples) {
+    return NULL;
+  }
+  for (int i = 0; i < samples->count; ++i) {
+    if (NULL != samples->meshes[i]) {
+      return samples->meshes[i];
+    }
+  }
+  return NULL;
+}
+
+bool Converter::reuseEdges(Mesh *mesh, const Mesh *reference)
+{
+  if (mesh->totvert != reference->totvert || mesh->totloop != reference->totloop ||
+      mesh->totpoly != reference->totpoly || mesh->totedge != 0) {
+    return false;
+  }
+  for (int i = 0; i < mesh->totpoly; ++i) {
+    if (mesh->mpoly[i].loopstart != reference->mpoly[i].loopstart ||
+        mesh->mpoly[i].totloop != reference->mpoly[i].totloop) {
+      return false;
+    }
+  }
+  for (int i = 0; i < mesh->totloop; ++i) {
+    if (mesh->mloop[i].v != reference->mloop[i].v) {
+      return false;
+    }
+  }
+  for (int i = 0; i < reference->totedge; ++i) {
+    if (reference->medge[i].flag & ME_LOOSEEDGE) {
+      return false;
+    }
+  }
+
+  // Same as the end of BKE_mesh_calc_edges()
+  CustomData_free(&mesh->edata, mesh->totedge);
+  CustomData_reset(&mesh->edata);
+  mesh->medge = (MEdge *)CustomData_add_layer(
+      &mesh->edata, CD_MEDGE, CD_DUPLICATE, reference->medge, reference->totedge);
+  mesh->totedge = reference->totedge;
+  for (int i = 0; i < mesh->totloop; ++i) {
+    mesh->mloop[i].e = reference->mloop[i].e;
+  }
+  return true;
+}
+
+bool Converter::sharesTopology(const Mesh *source_mesh,
+                               int corner_count,
+                               int face_count,
+                               int constant_face_size,
+                               const char *corner_data,
+                               int corner_stride,
+                               const char *face_data,
+                               int face_stride)
+{
+  if (NULL == source_mesh || ME_WRAPPER_TYPE_MDATA != source_mesh->runtime.wrapper_type ||
+      0 == face_count || corner_count != source_mesh->totloop ||
+      face_count != source_mesh->totpoly || corner_data != (const char *)source_mesh->mloop ||
+      corner_stride != sizeof(MLoop)) {
+    return false;
+  }
+  if (-1 == constant_face_size) {
+    return face_data == (const char *)&source_mesh->mpoly[0].totloop &&
+           face_stride == sizeof(MPoly);
+  }
+  for (int i = 0; i < face_count; ++i) {
+    if (source_mesh->mpoly[i].totloop != constant_face_size) {
+      return false;
+    }
+  }
+  return true;
+}
+
 bool Converter::check_no_loose_edges_in_ofx_mesh(int face_count,
                                                  const int *face_data,
                                                  int face_stride)
@@ -716,6 +1708,7 @@ void Converter::propFreeTransformMatrix(OfxPropertySetHandle properties) const
 }
 
 void Converter::countMeshElements(Mesh * blender_mesh,
+                                 bool use_loose_edge_attachment,
                                  int & ofx_point_count,
                                  int & ofx_corner_count,
                                  int & ofx_face_count,
@@ -744,6 +1737,14 @@ void Converter::countMeshElements(Mesh * blender_mesh,
   ofx_point_count = blender_point_count;
   ofx_corner_count = blender_loop_count;
   ofx_face_count = blender_poly_count;
+
+  if (use_loose_edge_attachment) {
+    // loose edges are not part of the faces
+    ofx_no_loose_edge = 1;
+    ofx_constant_face_size = -1;
+    return;
+  }
+
   ofx_no_loose_edge = (blender_loose_edge_count > 0) ? 0 : 1;
   ofx_constant_face_size = (blender_loose_edge_count > 0 && blender_poly_count == 0) ? 2 : -1;
 
@@ -764,8 +1765,257 @@ OfxStatus before_mesh_get(OfxHost *host, OfxMeshHandle ofx_mesh) {
   return converter.blenderToMfx(ofx_mesh);
 }
 
+OfxStatus before_mesh_alloc(OfxHost *host, OfxMeshHandle ofx_mesh) {
+  Converter converter(host);
+  return converter.preallocateBlender(ofx_mesh);
+}
+
 OfxStatus before_mesh_release(OfxHost *host, OfxMeshHandle ofx_mesh) {
   Converter converter(host);
   return converter.mfxToBlender(ofx_mesh);
 }
 
+void free_preallocated_mesh(MeshInternalData &internal_data) {
+  if (NULL != internal_data.preallocated_mesh) {
+    BKE_id_free(NULL, internal_data.preallocated_mesh);
+    internal_data.preallocated_mesh = NULL;
+  }
+}
+
+MfxLimitSurfaceCache::~MfxLimitSurfaceCache()
+{
+  if (NULL != subdiv) {
+    BKE_subdiv_free(subdiv);
+  }
+}
+
+/**
+ * Limit surface handed to the host as a blind pointer
+ */
+struct MfxLimitSurface {
+  Subdiv *subdiv;
+  const Mesh *mesh;
+  // Index of the first ptex face of each face of mesh
+  const int *face_ptex_offset;
+  // Cache that subdiv belongs to, NULL if owned by this limit surface
+  MfxLimitSurfaceCache *cache;
+};
+
+OfxStatus limit_surface_create(OfxHost *host,
+                               OfxMeshHandle ofx_mesh,
+                               int quality,
+                               void **r_limit_surface)
+{
+  OfxPropertySuiteV1 *ps = (OfxPropertySuiteV1 *)host->fetchSuite(
+      host->host, kOfxPropertySuite, 1);
+  MeshInternalData *internal_data = NULL;
+  ps->propGetPointer(
+      &ofx_mesh->properties, kOfxMeshPropInternalData, 0, (void **)&internal_data);
+  if (NULL == internal_data || !internal_data->is_input) {
+    return kOfxStatErrBadHandle;
+  }
+
+  Mesh *mesh = internal_data->blender_mesh;
+  if (NULL == mesh || 0 == mesh->totpoly) {
+    return kOfxStatErrUnsupported;
+  }
+  // Edit-mode inputs only wrap their BMesh
+  BKE_mesh_wrapper_ensure_mdata(mesh);
+
+  // Same as the Subdivision Surface modifier with default options, at the given quality
+  SubdivSettings settings;
+  settings.is_simple = false;
+  settings.is_adaptive = true;
+  settings.level = quality;
+  settings.use_creases = true;
+  settings.vtx_boundary_interpolation = SUBDIV_VTX_BOUNDARY_EDGE_ONLY;
+  settings.fvar_linear_interpolation = SUBDIV_FVAR_LINEAR_INTERPOLATION_BOUNDARIES;
+
+  MfxLimitSurfaceCache *cache = internal_data->limit_surface_cache;
+  bool is_used = false;
+  if (NULL != cache && !cache->is_used.compare_exchange_strong(is_used, true)) {
+    cache = NULL;
+  }
+
+  Subdiv *subdiv;
+  if (NULL != cache) {
+    // Only rebuilt if the topology or the settings changed
+    subdiv = BKE_subdiv_update_from_mesh(cache->subdiv, &settings, mesh);
+    cache->subdiv = subdiv;
+  }
+  else {
+    subdiv = BKE_subdiv_new_from_mesh(&settings, mesh);
+  }
+
+  if (NULL == subdiv || !BKE_subdiv_eval_begin_from_mesh(subdiv, mesh, NULL)) {
+    printf("Could not build the limit surface of the input mesh\n");
+    if (NULL != cache) {
+      cache->is_used = false;
+    }
+    else if (NULL != subdiv) {
+      BKE_subdiv_free(subdiv);
+    }
+    return kOfxStatFailed;
+  }
+
+  MfxLimitSurface *limit_surface = new MfxLimitSurface;
+  limit_surface->subdiv = subdiv;
+  limit_surface->mesh = mesh;
+  limit_surface->face_ptex_offset = BKE_subdiv_face_ptex_offset_get(subdiv);
+  limit_surface->cache = cache;
+  *r_limit_surface = (void *)limit_surface;
+  return kOfxStatOK;
+}
+
+OfxStatus limit_surface_evaluate(void *limit_surface,
+                                 int count,
+                                 const int *faces,
+                                 const float *coords,
+                                 float *positions,
+                                 float *normals)
+{
+  const MfxLimitSurface *surface = (const MfxLimitSurface *)limit_surface;
+  const Mesh *mesh = surface->mesh;
+
+  for (int i = 0; i < count; ++i) {
+    if (faces[i] < 0 || faces[i] >= mesh->totpoly) {
+      return kOfxStatErrBadIndex;
+    }
+  }
+
+  blender::parallel_for(blender::IndexRange(count), 1024, [&](blender::IndexRange range) {
+    for (const int64_t i : range) {
+      const int face = faces[i];
+      const int corner_count = mesh->mpoly[face].totloop;
+
+      // Faces other than quads are split into one ptex face per corner
+      int ptex_face_index = surface->face_ptex_offset[face];
+      float u = coords[2 * i + 0];
+      const float v = coords[2 * i + 1];
+      if (4 != corner_count) {
+        const int corner = std::clamp((int)floorf(u), 0, corner_count - 1);
+        ptex_face_index += corner;
+        u -= (float)corner;
+      }
+
+      float P[3], N[3];
+      if (NULL != normals) {
+        BKE_subdiv_eval_limit_point_and_normal(surface->subdiv, ptex_face_index, u, v, P, N);
+        copy_v3_v3(&normals[3 * i], N);
+      }
+      else {
+        BKE_subdiv_eval_limit_point(surface->subdiv, ptex_face_index, u, v, P);
+      }
+      if (NULL != positions) {
+        copy_v3_v3(&positions[3 * i], P);
+      }
+    }
+  });
+
+  return kOfxStatOK;
+}
+
+void limit_surface_destroy(void *limit_surface)
+{
+  MfxLimitSurface *surface = (MfxLimitSurface *)limit_surface;
+  if (NULL != surface->cache) {
+    surface->cache->is_used = false;
+  }
+  else {
+    BKE_subdiv_free(surface->subdiv);
+  }
+  delete surface;
+}
+
+OfxStatus param_get_value_at_time(OfxHost *host,
+                                  OfxParamHandle param,
+                                  OfxTime time,
+                                  OfxParamValueStruct *values)
+{
+  OfxPropertySuiteV1 *ps = (OfxPropertySuiteV1 *)host->fetchSuite(
+      host->host, kOfxPropertySuite, 1);
+  ParamInternalData *internal_data = NULL;
+  ps->propGetPointer(&param->properties, kOfxParamPropInternalData, 0, (void **)&internal_data);
+  if (NULL == internal_data || NULL == internal_data->object) {
+    return kOfxStatReplyDefault;
+  }
+
+  const AnimData *adt = internal_data->object->adt;
+  if (NULL == adt || NULL == adt->action) {
+    return kOfxStatReplyDefault;
+  }
+
+  // Name of the RNA property displayed for this type of parameter
+  const char *prop_name;
+  switch (param->type) {
+    case PARAM_TYPE_INTEGER:
+      prop_name = "integer_value";
+      break;
+    case PARAM_TYPE_INTEGER_2D:
+      prop_name = "integer2d_value";
+      break;
+    case PARAM_TYPE_INTEGER_3D:
+      prop_name = "integer3d_value";
+      break;
+    case PARAM_TYPE_DOUBLE:
+      prop_name = "float_value";
+      break;
+    case PARAM_TYPE_DOUBLE_2D:
+      prop_name = "float2d_value";
+      break;
+    case PARAM_TYPE_DOUBLE_3D:
+      prop_name = "float3d_value";
+      break;
+    case PARAM_TYPE_RGB:
+      prop_name = "rgb_value";
+      break;
+    case PARAM_TYPE_RGBA:
+      prop_name = "rgba_value";
+      break;
+    case PARAM_TYPE_BOOLEAN:
+      prop_name = "boolean_value";
+      break;
+    default:
+      return kOfxStatReplyDefault;
+  }
+
+  // Same path as rna_OpenMfxParameter_path()
+  char mod_name_esc[sizeof(internal_data->modifier->name) * 2];
+  BLI_str_escape(mod_name_esc, internal_data->modifier->name, sizeof(mod_name_esc));
+  char rna_path[512];
+  BLI_snprintf(rna_path,
+               sizeof(rna_path),
+               "modifiers[\"%s\"].parameters[%d].%s",
+               mod_name_esc,
+               internal_data->index,
+               prop_name);
+
+  // Components that are not animated keep their current value
+  bool is_animated = false;
+  int dimensions = (int)parameter_type_dimensions(param->type);
+  for (int i = 0; i < dimensions; ++i) {
+    FCurve *fcu = BKE_fcurve_find(&adt->action->curves, rna_path, i);
+    if (NULL == fcu) {
+      continue;
+    }
+    is_animated = true;
+
+    // Same conversions as when the animation system writes to RNA
+    float value = evaluate_fcurve(fcu, (float)time);
+    switch (param->type) {
+      case PARAM_TYPE_INTEGER:
+      case PARAM_TYPE_INTEGER_2D:
+      case PARAM_TYPE_INTEGER_3D:
+        values[i].as_int = (int)value;
+        break;
+      case PARAM_TYPE_BOOLEAN:
+        values[i].as_bool = value > (1.0f - FLT_EPSILON);
+        break;
+      default:
+        values[i].as_double = (double)value;
+        break;
+    }
+  }
+
+  return is_animated ? kOfxStatOK : kOfxStatReplyDefault;
+}
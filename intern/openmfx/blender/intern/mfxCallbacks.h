@@ -27,6 +27,44 @@
 
 #include "DNA_mesh_types.h"
 #include "DNA_object_types.h"
+#include "DNA_pointcloud_types.h"
+
+#include <atomic>
+
+struct OfxAttributeSetStruct;
+struct ModifierData;
+union OfxParamValueStruct;
+class MfxVertexWeightCache;
+struct MfxBMeshTopology;
+class MeshComponent;
+struct GeometrySet;
+struct Subdiv;
+
+/**
+ * Outputs of a cook asking for several times (see kOfxMeshEffectPropSampleTimes)
+ */
+typedef struct MfxOutputSamples {
+  int count;
+  const OfxTime *times;
+  // Output mesh converted for each time, NULL until the effect releases it
+  Mesh **meshes;
+} MfxOutputSamples;
+
+/**
+ * Subdivision descriptor of an input kept from one cook to the next, so that
+ * its limit surface is only rebuilt when the topology of the input changes
+ */
+struct MfxLimitSurfaceCache {
+  MfxLimitSurfaceCache() = default;
+  ~MfxLimitSurfaceCache();
+
+  MfxLimitSurfaceCache(const MfxLimitSurfaceCache &) = delete;
+  MfxLimitSurfaceCache &operator=(const MfxLimitSurfaceCache &) = delete;
+
+  Subdiv *subdiv = nullptr;
+  // Set while a limit surface evaluates subdiv, other ones then build their own
+  std::atomic<bool> is_used{false};
+};
 
 /**
  * Data shared as a blind handle from Blender GPL code to host code
@@ -40,15 +78,106 @@ typedef struct MeshInternalData {
   Mesh *blender_mesh;
   Mesh *source_mesh;
   Object *object;
+  // For an input mesh, attributes requested by the effect (may be NULL)
+  const OfxAttributeSetStruct *requested_attributes;
+  // Vertex group weights densified during this cook (may be NULL)
+  MfxVertexWeightCache *weight_cache;
+  // Geometry component the mesh comes from, when cooked from a geometry node (may be NULL).
+  // Vertex group names are read from it rather than from the object.
+  const MeshComponent *geometry_component;
+  // For an input, point cloud read instead of blender_mesh (may be NULL).
+  // For an output, set instead of blender_mesh when the effect only outputs points and the
+  // source is a point cloud.
+  PointCloud *point_cloud;
+  // For an output, point cloud from which layers are copied (may be NULL)
+  const PointCloud *source_point_cloud;
+  // For an output, geometry that gets an instances component when the effect outputs points
+  // with a kOfxMeshAttribPointInstanceTransform attribute and no face (may be NULL, in which case
+  // such points are kept as vertices). is_instanced is then set instead of blender_mesh.
+  GeometrySet *instances_target;
+  bool is_instanced;
+  // For an output, object connected to each input other than the main input and output, in
+  // definition order, that instances refer to (NULL for inputs not connected to an object)
+  Object *const *instance_sources;
+  int instance_source_count;
+  // For an output, meshes of a multi-time cook (may be NULL). Each released sample is moved there
+  // rather than kept in blender_mesh, and reuses the edges of the first one when its faces match.
+  MfxOutputSamples *samples;
+  // For an input whose blender_mesh wraps an edit-mode BMesh, element tables kept from one cook
+  // to the next (may be NULL, in which case they are built for this cook only)
+  MfxBMeshTopology *bmesh_topology;
+  // For an output, Blender mesh allocated in meshAlloc() and that the effect writes positions,
+  // corners and face sizes into, until it is taken by the conversion on release (may be NULL)
+  Mesh *preallocated_mesh;
+  // For an input, descriptor that limit surfaces of blender_mesh reuse (may be NULL, in which
+  // case each limit surface builds its own)
+  MfxLimitSurfaceCache *limit_surface_cache;
 } MeshInternalData;
 
+/**
+ * Data shared as a blind handle with parameters, to evaluate their animation
+ */
+typedef struct ParamInternalData {
+  // Object whose animation data holds the F-Curves of the parameter
+  const Object *object;
+  const ModifierData *modifier;
+  // Index of the parameter in OpenMfxModifierData::parameter_values
+  int index;
+} ParamInternalData;
+
 /**
  * Convert blender mesh from internal pointer into ofx mesh.
  * /pre no ofx mesh has been allocated or internal pointer is null
  */
 OfxStatus before_mesh_get(OfxHost *host, OfxMeshHandle ofx_mesh);
 
+/**
+ * Allocate the blender mesh of an output once its element counts are known, and
+ * have the effect write some attributes straight into it
+ */
+OfxStatus before_mesh_alloc(OfxHost *host, OfxMeshHandle ofx_mesh);
+
 /**
  * Convert ofx mesh into blender mesh and store it in internal pointer
  */
 OfxStatus before_mesh_release(OfxHost *host, OfxMeshHandle ofx_mesh);
+
+/**
+ * Free the mesh allocated by before_mesh_alloc() if the effect did not release
+ * its output, to call once the cook is over
+ */
+void free_preallocated_mesh(MeshInternalData &internal_data);
+
+/**
+ * Evaluate the F-Curves animating a parameter of the modifier given in its internal data
+ */
+OfxStatus param_get_value_at_time(OfxHost *host,
+                                  OfxParamHandle param,
+                                  OfxTime time,
+                                  OfxParamValueStruct *values);
+
+/**
+ * Prepare the evaluation of the limit surface of an input mesh with OpenSubdiv,
+ * backing limitSurfaceCreate() (see LimitSurfaceCreateCbFunc)
+ */
+OfxStatus limit_surface_create(OfxHost *host,
+                               OfxMeshHandle ofx_mesh,
+                               int quality,
+                               void **r_limit_surface);
+
+/**
+ * Evaluate a limit surface created by limit_surface_create() at a batch of
+ * face coordinates (see LimitSurfaceEvaluateCbFunc)
+ */
+OfxStatus limit_surface_evaluate(void *limit_surface,
+                                 int count,
+                                 const int *faces,
+                                 const float *coords,
+                                 float *positions,
+                                 float *normals);
+
+/**
+ * Free a limit surface created by limit_surface_create(), keeping its
+ * descriptor in the cache of the input if it came from there
+ */
+void limit_surface_destroy(void *limit_surface);
@@ -18,11 +18,18 @@
 
 #include "mfxConvert.h"
 #include "mfxHost.h"
+#include "mfxParameters.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_string.h"
 
 #include <iostream>
 #include <cstring>
+#include <climits>
+#include <cfloat>
 
-void copy_parameter_value_from_rna(OfxParamHandle param, const OpenMfxParameter *rna)
+void copy_parameter_value_from_rna(OfxParamHandle param, const OpenMfxParameterValue *rna)
 {
   param->type = static_cast<ParamType>(rna->type);
   switch (rna->type) {
@@ -50,8 +57,8 @@ void copy_parameter_value_from_rna(OfxParamHandle param, const OpenMfxParameter
       break;
 
     case PARAM_TYPE_STRING:
-      param->realloc_string(MOD_OPENMFX_MAX_STRING_VALUE);
-      strncpy(param->value[0].as_char, rna->string_value, MOD_OPENMFX_MAX_STRING_VALUE);
+      param->realloc_string(strlen(mfx_Parameter_string_value(rna)));
+      strcpy(param->value[0].as_char, mfx_Parameter_string_value(rna));
       break;
 
     default:
@@ -62,7 +69,7 @@ void copy_parameter_value_from_rna(OfxParamHandle param, const OpenMfxParameter
   }
 }
 
-void copy_parameter_value_to_rna(OpenMfxParameter *rna, const OfxPropertyStruct *prop)
+void copy_parameter_value_to_rna(OpenMfxParameterValue *rna, const OfxPropertyStruct *prop)
 {
   switch (rna->type) {
     case PARAM_TYPE_INTEGER_3D:
@@ -89,13 +96,11 @@ void copy_parameter_value_to_rna(OpenMfxParameter *rna, const OfxPropertyStruct
       break;
 
     case PARAM_TYPE_STRING:
-      strncpy(rna->string_value,
-              prop->value[0].as_char,
-              MOD_OPENMFX_MAX_STRING_VALUE);
+      mfx_Parameter_set_string_value(rna, prop->value[0].as_char);
       break;
 
     default:
-      std::cerr << "-- Skipping parameter " << rna->name
+      std::cerr << "-- Skipping parameter " << mfx_Parameter_info(rna)->name
                 << " (unsupported type: " << rna->type << ")"
                 << std::endl;
       break;
@@ -128,7 +133,7 @@ void copy_parameter_minmax_to_rna(int rna_type,
   }
 }
 
-void copy_parameter_value_to_rna(OpenMfxParameter *rna, const OfxParamHandle param)
+void copy_parameter_value_to_rna(OpenMfxParameterValue *rna, const OfxParamHandle param)
 {
   rna->type = static_cast<int>(param->type);
   switch (rna->type) {
@@ -156,12 +161,88 @@ void copy_parameter_value_to_rna(OpenMfxParameter *rna, const OfxParamHandle par
       break;
 
     case PARAM_TYPE_STRING:
-      strncpy(rna->string_value, param->value[0].as_char, MOD_OPENMFX_MAX_STRING_VALUE);
+      mfx_Parameter_set_string_value(rna, param->value[0].as_char);
       break;
 
     default:
-      std::cerr << "-- Skipping parameter " << rna->name << " (unsupported type: " << rna->type
-                << ")" << std::endl;
+      std::cerr << "-- Skipping parameter " << mfx_Parameter_info(rna)->name
+                << " (unsupported type: " << rna->type << ")" << std::endl;
       break;
   }
-}
\ No newline at end of file
+}
+
+void copy_parameter_info_to_rna(OpenMfxParameterInfo *info, const OfxParamStruct *param)
+{
+  const OfxPropertySetStruct &props = param->properties;
+
+  int script_name_idx = props.find_property(kOfxParamPropScriptName);
+  int label_idx = props.find_property(kOfxPropLabel);
+
+  const char *parameter_name = param->name;
+  const char *system_name = (script_name_idx != -1) ?
+                                props.properties[script_name_idx]->value->as_const_char :
+                                parameter_name;
+  const char *label_name = (label_idx != -1) ?
+                               props.properties[label_idx]->value->as_const_char :
+                               parameter_name;
+
+  MEM_SAFE_FREE(info->name);
+  MEM_SAFE_FREE(info->label);
+  info->name = BLI_strdup(system_name);
+  info->label = BLI_strdup(label_name);
+  const int type = static_cast<int>(param->type);
+
+  // Handle boundaries
+  // (TODO: there must be some factorization possible)
+  info->int_min = INT_MIN;
+  info->int_softmin = INT_MIN;
+  info->int_max = INT_MAX;
+  info->int_softmax = INT_MAX;
+  info->float_min = FLT_MIN;
+  info->float_softmin = FLT_MIN;
+  info->float_max = FLT_MAX;
+  info->float_softmax = FLT_MAX;
+
+  int min_idx = props.find_property(kOfxParamPropMin);
+  if (min_idx > -1) {
+    copy_parameter_minmax_to_rna(
+        type, info->int_min, info->float_min, props.properties[min_idx]);
+  }
+
+  int softmin_idx = props.find_property(kOfxParamPropDisplayMin);
+  if (softmin_idx > -1) {
+    copy_parameter_minmax_to_rna(
+        type, info->int_softmin, info->float_softmin, props.properties[softmin_idx]);
+  }
+  else if (min_idx > -1) {
+    copy_parameter_minmax_to_rna(
+        type, info->int_softmin, info->float_softmin, props.properties[min_idx]);
+  }
+
+  int max_idx = props.find_property(kOfxParamPropMax);
+  if (max_idx > -1) {
+    copy_parameter_minmax_to_rna(
+        type, info->int_max, info->float_max, props.properties[max_idx]);
+  }
+
+  int softmax_idx = props.find_property(kOfxParamPropDisplayMax);
+  if (softmax_idx > -1) {
+    copy_parameter_minmax_to_rna(
+        type, info->int_softmax, info->float_softmax, props.properties[softmax_idx]);
+  }
+  else if (max_idx > -1) {
+    copy_parameter_minmax_to_rna(
+        type, info->int_softmax, info->float_softmax, props.properties[max_idx]);
+  }
+}
+
+void copy_parameter_default_to_rna(OpenMfxParameterValue *rna, const OfxParamStruct *param)
+{
+  const OfxPropertySetStruct &props = param->properties;
+  rna->type = static_cast<int>(param->type);
+
+  int default_idx = props.find_property(kOfxParamPropDefault);
+  if (default_idx > -1) {
+    copy_parameter_value_to_rna(rna, props.properties[default_idx]);
+  }
+}
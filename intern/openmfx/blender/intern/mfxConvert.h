@@ -26,9 +26,9 @@
 #include "DNA_modifier_types.h"
 
 void copy_parameter_value_from_rna(OfxParamHandle param,
-                                   const OpenMfxParameter *rna);
+                                   const OpenMfxParameterValue *rna);
 
-void copy_parameter_value_to_rna(OpenMfxParameter *rna,
+void copy_parameter_value_to_rna(OpenMfxParameterValue *rna,
                                  const OfxPropertyStruct * prop);
 
 void copy_parameter_minmax_to_rna(int rna_type,
@@ -36,5 +36,15 @@ void copy_parameter_minmax_to_rna(int rna_type,
                                   float &float_rna,
                                   const OfxPropertyStruct *prop);
 
-void copy_parameter_value_to_rna(OpenMfxParameter *rna,
+void copy_parameter_value_to_rna(OpenMfxParameterValue *rna,
                                  const OfxParamHandle param);
+
+/**
+ * Fill name, label and bounds of a parameter from its descriptor
+ */
+void copy_parameter_info_to_rna(OpenMfxParameterInfo *info, const OfxParamStruct *param);
+
+/**
+ * Fill type and default value of a parameter from its descriptor
+ */
+void copy_parameter_default_to_rna(OpenMfxParameterValue *rna, const OfxParamStruct *param);
@@ -0,0 +1,298 @@
+/**
+ * Open Mesh Effect modifier for Blender
+ * Copyright (C) 2019 - 2021 Elie Michel
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** \file
+ * \ingroup openmesheffect
+ */
+
+#include "mfxCookCache.h"
+#include "mfxParameters.h"
+
+#include "DNA_anim_types.h"
+#include "DNA_object_types.h"
+
+#include "BKE_callbacks.h"
+#include "BKE_lib_id.h" // BKE_id_free
+#include "BKE_mesh.h" // BKE_mesh_copy_for_eval
+
+#include "BLI_listbase.h"
+#include "BLI_map.hh"
+#include "BLI_string.h"
+#include "BLI_utildefines.h"
+
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+
+#ifdef WITH_TBB
+#  include <tbb/task_arena.h>
+#  include <tbb/task_group.h>
+#endif
+
+namespace {
+
+/**
+ * Result of a cook, which is not ready yet while the first modifier asking for
+ * it is cooking.
+ */
+struct CookCacheEntry {
+  bool is_ready = false;
+  /** NULL if the cook failed or must not be shared */
+  MfxSharedMesh mesh;
+  std::string message;
+#ifdef WITH_TBB
+  /** Cook of the first modifier, which the other ones join */
+  std::shared_ptr<tbb::task_group> cook_tasks;
+#endif
+};
+
+void free_mesh(Mesh *mesh)
+{
+  BKE_id_free(NULL, mesh);
+}
+
+class CookCache {
+ public:
+  static CookCache &get()
+  {
+    static CookCache cache;
+    return cache;
+  }
+
+  Mesh *cook(const std::string &key,
+             const Mesh *input,
+             char *r_message,
+             blender::FunctionRef<Mesh *()> cook,
+             MfxSharedMesh &r_shared_output,
+             bool *r_did_cook)
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    CookCacheEntry *entry = m_entries.lookup_ptr(key);
+    *r_did_cook = NULL == entry;
+
+    if (*r_did_cook) {
+      Mesh *output = NULL;
+      MfxSharedMesh shared_output;
+      auto run = [&]() {
+        output = cook();
+        // An identity effect returns its input, which is not worth sharing
+        if (NULL != output && output != input) {
+          shared_output = MfxSharedMesh(output, free_mesh);
+        }
+        store(key, shared_output, r_message);
+      };
+
+#ifdef WITH_TBB
+      // Duplicates wait for this cook, so the thread must not pick up their evaluation while
+      // waiting for the tasks of the cook itself.
+      CookCacheEntry &new_entry = m_entries.lookup_or_add_default(key);
+      new_entry.cook_tasks = std::make_shared<tbb::task_group>();
+      std::shared_ptr<tbb::task_group> cook_tasks = new_entry.cook_tasks;
+      cook_tasks->run([&]() { tbb::this_task_arena::isolate(run); });
+      lock.unlock();
+      cook_tasks->wait();
+#else
+      m_entries.add_new(key, CookCacheEntry());
+      lock.unlock();
+      run();
+#endif
+
+      if (NULL == shared_output) {
+        return output;
+      }
+      r_shared_output = shared_output;
+      return BKE_mesh_copy_for_eval(output, true);
+    }
+
+    if (!entry->is_ready) {
+#ifdef WITH_TBB
+      // Rather than blocking a worker, run tasks of the cook (or other ones) until it is done
+      std::shared_ptr<tbb::task_group> cook_tasks = entry->cook_tasks;
+      lock.unlock();
+      cook_tasks->wait();
+      lock.lock();
+#else
+      // The entry may also be removed while waiting, if the cache gets cleared
+      m_condition.wait(lock, [this, &key]() {
+        const CookCacheEntry *entry = m_entries.lookup_ptr(key);
+        return NULL == entry || entry->is_ready;
+      });
+#endif
+    }
+
+    // The cache may have been cleared meanwhile
+    entry = m_entries.lookup_ptr(key);
+    if (NULL == entry || !entry->is_ready || NULL == entry->mesh) {
+      return NULL;
+    }
+    BLI_strncpy(r_message, entry->message.c_str(), MOD_OPENMFX_MAX_MESSAGE);
+    r_shared_output = entry->mesh;
+    return BKE_mesh_copy_for_eval(entry->mesh.get(), true);
+  }
+
+  void clear()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      // Meshes remain referenced by the modifiers that output them
+      m_entries.clear();
+    }
+    m_condition.notify_all();
+  }
+
+ private:
+  CookCache() = default;
+
+  void store(const std::string &key, const MfxSharedMesh &mesh, const char *message)
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      CookCacheEntry *entry = m_entries.lookup_ptr(key);
+      if (NULL != entry) {
+        entry->is_ready = true;
+        entry->mesh = mesh;
+        entry->message = message;
+      }
+    }
+    m_condition.notify_all();
+  }
+
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  blender::Map<std::string, CookCacheEntry> m_entries;
+};
+
+template<typename T> void append_bytes(std::string &key, const T &value)
+{
+  key.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+void append_string(std::string &key, const char *value)
+{
+  key.append(value, strlen(value) + 1);
+}
+
+void clear_cache_cb(Main *UNUSED(bmain),
+                    PointerRNA **UNUSED(pointers),
+                    const int UNUSED(num_pointers),
+                    void *UNUSED(arg))
+{
+  mfx_cook_cache_clear();
+}
+
+bCallbackFuncStore clear_on_depsgraph_update = {NULL, NULL, clear_cache_cb, NULL, 0};
+bCallbackFuncStore clear_on_frame_change = {NULL, NULL, clear_cache_cb, NULL, 0};
+bCallbackFuncStore clear_on_render_init = {NULL, NULL, clear_cache_cb, NULL, 0};
+bCallbackFuncStore clear_on_load = {NULL, NULL, clear_cache_cb, NULL, 0};
+
+}  // namespace
+
+bool mfx_cook_cache_key(const OpenMfxModifierData *fxmd,
+                        const char *plugin_path,
+                        const Mesh *mesh,
+                        const Object *object,
+                        bool use_render_quality,
+                        float time,
+                        std::string &r_key)
+{
+  if (NULL == mesh || NULL == object || OB_MESH != object->type ||
+      ME_WRAPPER_TYPE_MDATA != mesh->runtime.wrapper_type) {
+    return false;
+  }
+
+  // Only share the input of modifiers that come first in the stack, which
+  // references the layers of the object data as long as nothing deformed it
+  const Mesh *data = (const Mesh *)(NULL != object->runtime.data_orig ? object->runtime.data_orig :
+                                                                        object->data);
+  if (NULL == data || mesh->mvert != data->mvert || mesh->medge != data->medge ||
+      mesh->mloop != data->mloop || mesh->mpoly != data->mpoly ||
+      mesh->totvert != data->totvert || mesh->totedge != data->totedge ||
+      mesh->totloop != data->totloop || mesh->totpoly != data->totpoly) {
+    return false;
+  }
+
+  const ID *orig_id = NULL != data->id.orig_id ? data->id.orig_id : &data->id;
+  if (orig_id->us < 2) {
+    return false;
+  }
+
+  // Parameters animated at other times than the cook are read from the
+  // animation of the object, drivers may read anything else
+  const AnimData *adt = object->adt;
+  if (NULL != adt && !BLI_listbase_is_empty(&adt->drivers)) {
+    return false;
+  }
+
+  r_key.clear();
+  append_string(r_key, plugin_path);
+  append_bytes(r_key, fxmd->active_effect_index);
+  append_bytes(r_key, use_render_quality);
+  append_bytes(r_key, time);
+  if (!use_render_quality && (fxmd->flag & MOD_OPENMFX_FLAG_VIEWPORT_PROXY)) {
+    append_bytes(r_key, fxmd->viewport_proxy_ratio);
+  }
+
+  append_bytes(r_key, data);
+  append_bytes(r_key, data->mvert);
+  append_bytes(r_key, data->medge);
+  append_bytes(r_key, data->mloop);
+  append_bytes(r_key, data->mpoly);
+  append_bytes(r_key, data->totvert);
+  append_bytes(r_key, data->totedge);
+  append_bytes(r_key, data->totloop);
+  append_bytes(r_key, data->totpoly);
+  append_bytes(r_key, NULL != adt ? adt->action : NULL);
+
+  for (int i = 0; i < fxmd->num_parameters; ++i) {
+    const OpenMfxParameterValue &parameter = fxmd->parameter_values[i];
+    append_bytes(r_key, parameter.type);
+    append_bytes(r_key, parameter.float_vec_value);
+    append_bytes(r_key, parameter.integer_vec_value);
+    append_string(r_key, mfx_Parameter_string_value(&parameter));
+  }
+
+  // Vertex groups are looked up by name in the list of the object
+  LISTBASE_FOREACH (const bDeformGroup *, group, &object->defbase) {
+    append_string(r_key, group->name);
+  }
+
+  return true;
+}
+
+Mesh *mfx_cook_cache_cook(const std::string &key,
+                          const Mesh *input,
+                          char *r_message,
+                          blender::FunctionRef<Mesh *()> cook,
+                          MfxSharedMesh &r_shared_output,
+                          bool *r_did_cook)
+{
+  return CookCache::get().cook(key, input, r_message, cook, r_shared_output, r_did_cook);
+}
+
+void mfx_cook_cache_clear(void)
+{
+  CookCache::get().clear();
+}
+
+void mfx_cook_cache_register_callbacks(void)
+{
+  BKE_callback_add(&clear_on_depsgraph_update, BKE_CB_EVT_DEPSGRAPH_UPDATE_PRE);
+  BKE_callback_add(&clear_on_frame_change, BKE_CB_EVT_FRAME_CHANGE_PRE);
+  BKE_callback_add(&clear_on_render_init, BKE_CB_EVT_RENDER_INIT);
+  BKE_callback_add(&clear_on_load, BKE_CB_EVT_LOAD_PRE);
+}
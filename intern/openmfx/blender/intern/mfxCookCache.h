@@ -0,0 +1,95 @@
+/**
+ * Open Mesh Effect modifier for Blender
+ * Copyright (C) 2019 - 2021 Elie Michel
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** \file
+ * \ingroup openmesheffect
+ *
+ * Cook cache shared by all the OpenMfx modifiers of a scene evaluation: linked
+ * duplicates running the same effect with the same parameters on the same mesh
+ * datablock only cook once, the other ones receiving a copy of the result.
+ * Copies reference the layers of the cooked mesh, which each modifier keeps
+ * alive until its next cook.
+ *
+ * The cache is emptied before each depsgraph update, frame change and render,
+ * so that it never outlives the evaluated meshes its keys point to.
+ */
+
+#pragma once
+
+#include "DNA_mesh_types.h"
+#include "DNA_modifier_types.h"
+#include "DNA_object_types.h"
+
+#include "BLI_function_ref.hh"
+
+#include <memory>
+#include <string>
+
+/**
+ * Cooked mesh shared by modifiers, freed once none of them references it
+ */
+using MfxSharedMesh = std::shared_ptr<Mesh>;
+
+/**
+ * Build the key identifying the result of a cook among all the objects of the
+ * scene: effect, parameter values, cook settings and evaluated input mesh.
+ * Returns false if the result must not be shared, i.e. when the input mesh is
+ * in edit mode or has been changed by preceding modifiers, or when its
+ * datablock is not used by several objects.
+ * It is up to the caller to check that the effect reads neither the transform
+ * of the object nor other objects.
+ */
+bool mfx_cook_cache_key(const OpenMfxModifierData *fxmd,
+                        const char *plugin_path,
+                        const Mesh *mesh,
+                        const Object *object,
+                        bool use_render_quality,
+                        float time,
+                        std::string &r_key);
+
+/**
+ * Cook once for all the modifiers asking for the same key. The first one runs
+ * cook(), which returns the output of the effect and writes its message to
+ * r_message (MOD_OPENMFX_MAX_MESSAGE long), while the other ones wait for it,
+ * running tasks of the scheduler meanwhile, and get a copy of its message.
+ * r_did_cook tells whether the caller is the one that ran cook().
+ *
+ * Shared results are returned as copies referencing the layers of the cooked
+ * mesh, which is also set to r_shared_output: the caller must keep it until
+ * the returned mesh is freed. Otherwise the output of cook() is returned to
+ * the first modifier, i.e. when the cook failed or returned input, and NULL
+ * to the other ones, which must then cook by themselves.
+ */
+Mesh *mfx_cook_cache_cook(const std::string &key,
+                          const Mesh *input,
+                          char *r_message,
+                          blender::FunctionRef<Mesh *()> cook,
+                          MfxSharedMesh &r_shared_output,
+                          bool *r_did_cook);
+
+/**
+ * Forget all the cached results, which are freed once no modifier output
+ * references them anymore.
+ */
+void mfx_cook_cache_clear(void);
+
+/**
+ * Register the callbacks that clear the cache before new evaluations.
+ * Called once at startup.
+ */
+void mfx_cook_cache_register_callbacks(void);
@@ -0,0 +1,569 @@
+/**
+ * Open Mesh Effect modifier for Blender
+ * Copyright (C) 2019 - 2021 Elie Michel
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** \file
+ * \ingroup openmesheffect
+ */
+
+#include "mfxGeometryNode.h"
+
+#include "mfxAttributeMapping.h"
+#include "mfxCallbacks.h"
+#include "mfxConvert.h"
+#include "mfxParameters.h"
+#include "mfxHost.h"
+#include "mfxPluginRegistryPool.h"
+#include <mfxHost/mesheffect>
+#include <mfxHost/messages>
+#include "ofxExtras.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_pointcloud_types.h"
+
+#include "BKE_main.h" // BKE_main_blendfile_path_from_global
+#include "BKE_modifier.h" // BKE_modifier_get_evaluated_mesh_from_evaluated_object
+
+#include "BLI_map.hh"
+#include "BLI_path_util.h"
+#include "BLI_string.h"
+
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+using blender::MutableSpan;
+using blender::Span;
+using blender::Vector;
+
+namespace {
+
+/**
+ * A plugin loaded on behalf of geometry nodes, with the descriptors of the
+ * effects that have been used so far.
+ */
+struct GeometryNodePlugin {
+  PluginRegistry *registry = nullptr;
+  Vector<OfxMeshEffectHandle> descriptors;
+  /** Names, labels and bounds of the parameters of each effect, built with its descriptor */
+  Vector<OpenMfxParameterInfoTable *> parameter_infos;
+  /**
+   * Plugins are not required to be reentrant, so calls to a same plugin are
+   * serialized even when several objects are evaluated in parallel.
+   */
+  std::mutex mutex;
+};
+
+/**
+ * Plugins used by geometry nodes, indexed by absolute path. Nodes are copied
+ * around by the depsgraph, so they do not own plugins: these remain loaded
+ * until the end of the session.
+ */
+class GeometryNodePluginCache {
+ public:
+  static GeometryNodePluginCache &get()
+  {
+    static GeometryNodePluginCache cache;
+    return cache;
+  }
+
+  /**
+   * Get the plugin at the given path, loading it on first use. Returns
+   * nullptr if the plugin could not be loaded.
+   */
+  GeometryNodePlugin *ensure_plugin(const char *plugin_path)
+  {
+    char abs_path[FILE_MAX];
+    BLI_strncpy(abs_path, plugin_path, FILE_MAX);
+    const char *base_path = BKE_main_blendfile_path_from_global();
+    if (NULL != base_path) {
+      BLI_path_abs(abs_path, base_path);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::unique_ptr<GeometryNodePlugin> &plugin = m_plugins.lookup_or_add_default(abs_path);
+    if (!plugin) {
+      plugin = std::make_unique<GeometryNodePlugin>();
+      printf("Loading OFX plugin %s for geometry nodes\n", abs_path);
+      plugin->registry = get_registry(abs_path);
+      if (NULL != plugin->registry) {
+        plugin->descriptors.resize(plugin->registry->num_plugins, nullptr);
+        plugin->parameter_infos.resize(plugin->registry->num_plugins, nullptr);
+      }
+    }
+    return NULL != plugin->registry ? plugin.get() : nullptr;
+  }
+
+  /**
+   * Get the descriptor of an effect, loading the effect if needed.
+   * The mutex of the plugin must be locked.
+   */
+  OfxMeshEffectHandle ensure_descriptor(GeometryNodePlugin &plugin, int effect_index)
+  {
+    if (effect_index < 0 || effect_index >= plugin.descriptors.size()) {
+      return nullptr;
+    }
+    if (nullptr != plugin.descriptors[effect_index]) {
+      return plugin.descriptors[effect_index];
+    }
+
+    // Preloaded registries already hold the descriptors
+    if (nullptr != plugin.registry->descriptors &&
+        nullptr != plugin.registry->descriptors[effect_index]) {
+      plugin.descriptors[effect_index] = plugin.registry->descriptors[effect_index];
+      return plugin.descriptors[effect_index];
+    }
+
+    // The cache keeps its use of the plugin until the end of the session, so that modifiers
+    // releasing the same plugin do not unload it under the descriptor
+    OfxHost *host = this->host();
+    OfxPlugin *ofx_plugin = plugin.registry->plugins[effect_index];
+    if (!registry_acquire_plugin(plugin.registry, effect_index, host)) {
+      printf("Error while loading plugin!\n");
+      return nullptr;
+    }
+
+    if (!ofxhost_get_descriptor(host, ofx_plugin, &plugin.descriptors[effect_index])) {
+      registry_release_plugin(plugin.registry, effect_index);
+      return nullptr;
+    }
+    return plugin.descriptors[effect_index];
+  }
+
+  /**
+   * Host used for geometry nodes, configured on first call.
+   */
+  OfxHost *host()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (NULL == m_host) {
+      m_host = getGlobalHost();
+
+      // Same callbacks as the modifier, geometry components wrap regular meshes
+      OfxPropertySuiteV1 *propertySuite = (OfxPropertySuiteV1 *)m_host->fetchSuite(
+          m_host->host, kOfxPropertySuite, 1);
+      propertySuite->propSetPointer(
+          m_host->host, kOfxHostPropBeforeMeshGetCb, 0, (void *)before_mesh_get);
+      propertySuite->propSetPointer(
+          m_host->host, kOfxHostPropBeforeMeshReleaseCb, 0, (void *)before_mesh_release);
+      propertySuite->propSetPointer(
+          m_host->host, kOfxHostPropBeforeMeshAllocCb, 0, (void *)before_mesh_alloc);
+      propertySuite->propSetPointer(
+          m_host->host, kOfxHostPropLimitSurfaceCreateCb, 0, (void *)limit_surface_create);
+      propertySuite->propSetPointer(
+          m_host->host, kOfxHostPropLimitSurfaceEvaluateCb, 0, (void *)limit_surface_evaluate);
+      propertySuite->propSetPointer(
+          m_host->host, kOfxHostPropLimitSurfaceDestroyCb, 0, (void *)limit_surface_destroy);
+    }
+    return m_host;
+  }
+
+ private:
+  GeometryNodePluginCache() = default;
+
+  std::mutex m_mutex;
+  OfxHost *m_host = nullptr;
+  blender::Map<std::string, std::unique_ptr<GeometryNodePlugin>> m_plugins;
+};
+
+/**
+ * Name under which a parameter is exposed, as in copy_parameter_info_to_rna()
+ */
+const char *parameter_system_name(const OfxParamStruct *param)
+{
+  const OfxPropertySetStruct &props = param->properties;
+  int script_name_idx = props.find_property(kOfxParamPropScriptName);
+  return (script_name_idx != -1) ? props.properties[script_name_idx]->value->as_const_char :
+                                   param->name;
+}
+
+/**
+ * Inputs other than the main input and outputs, exposed as object sockets
+ */
+bool is_extra_input(const OfxMeshInputStruct *input)
+{
+  return 0 != strcmp(input->name, kOfxMeshMainInput) && !input->is_output();
+}
+
+/**
+ * Outputs other than the main output, exposed as extra geometry sockets
+ */
+bool is_extra_output(const OfxMeshInputStruct *input)
+{
+  return 0 != strcmp(input->name, kOfxMeshMainOutput) && input->is_output();
+}
+
+/**
+ * Name and label of the inputs of an effect that pass the filter
+ */
+bool get_input_infos(const char *plugin_path,
+                     int effect_index,
+                     bool (*filter)(const OfxMeshInputStruct *),
+                     Vector<OpenMfxInput> &r_inputs)
+{
+  r_inputs.clear();
+  if ('\0' == plugin_path[0]) {
+    return false;
+  }
+
+  GeometryNodePluginCache &cache = GeometryNodePluginCache::get();
+  GeometryNodePlugin *plugin = cache.ensure_plugin(plugin_path);
+  if (nullptr == plugin) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(plugin->mutex);
+  OfxMeshEffectHandle descriptor = cache.ensure_descriptor(*plugin, effect_index);
+  if (nullptr == descriptor) {
+    return false;
+  }
+
+  const OfxMeshInputSetStruct &inputs = descriptor->inputs;
+  for (int i = 0; i < inputs.num_inputs; ++i) {
+    const OfxMeshInputStruct *input = inputs.inputs[i];
+    if (!filter(input)) {
+      continue;
+    }
+    const OfxPropertySetStruct &props = input->properties;
+    int label_idx = props.find_property(kOfxPropLabel);
+    const char *label = (label_idx != -1) ? props.properties[label_idx]->value->as_const_char :
+                                            input->name;
+
+    OpenMfxInput rna;
+    memset(&rna, 0, sizeof(OpenMfxInput));
+    BLI_strncpy(rna.name, input->name, sizeof(rna.name));
+    BLI_strncpy(rna.label, label, sizeof(rna.label));
+    r_inputs.append(rna);
+  }
+  return true;
+}
+
+}  // namespace
+
+// ----------------------------------------------------------------------------
+
+Vector<std::string> mfx_GeometryNode_list_effects(const char *plugin_path)
+{
+  Vector<std::string> effects;
+  if ('\0' == plugin_path[0]) {
+    return effects;
+  }
+
+  GeometryNodePlugin *plugin = GeometryNodePluginCache::get().ensure_plugin(plugin_path);
+  if (nullptr == plugin) {
+    return effects;
+  }
+
+  for (int i = 0; i < plugin->registry->num_plugins; ++i) {
+    effects.append(plugin->registry->plugins[i]->pluginIdentifier);
+  }
+  return effects;
+}
+
+bool mfx_GeometryNode_get_parameters(const char *plugin_path,
+                                     int effect_index,
+                                     Vector<OpenMfxParameterValue> &r_parameters)
+{
+  r_parameters.clear();
+  if ('\0' == plugin_path[0]) {
+    return false;
+  }
+
+  GeometryNodePluginCache &cache = GeometryNodePluginCache::get();
+  GeometryNodePlugin *plugin = cache.ensure_plugin(plugin_path);
+  if (nullptr == plugin) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(plugin->mutex);
+  OfxMeshEffectHandle descriptor = cache.ensure_descriptor(*plugin, effect_index);
+  if (nullptr == descriptor) {
+    return false;
+  }
+
+  const OfxParamSetStruct &parameters = descriptor->parameters;
+  OpenMfxParameterInfoTable *&table = plugin->parameter_infos[effect_index];
+  if (nullptr == table) {
+    table = mfx_ParameterInfoTable_new(parameters.num_parameters);
+    for (int i = 0; i < parameters.num_parameters; ++i) {
+      copy_parameter_info_to_rna(&table->infos[i], parameters.parameters[i]);
+    }
+  }
+
+  r_parameters.resize(parameters.num_parameters);
+  for (int i = 0; i < parameters.num_parameters; ++i) {
+    memset(&r_parameters[i], 0, sizeof(OpenMfxParameterValue));
+    r_parameters[i].info = &table->infos[i];
+    copy_parameter_default_to_rna(&r_parameters[i], parameters.parameters[i]);
+  }
+  return true;
+}
+
+void mfx_GeometryNode_free_parameters(Vector<OpenMfxParameterValue> &parameters)
+{
+  for (OpenMfxParameterValue &parameter : parameters) {
+    mfx_Parameter_set_string_value(&parameter, nullptr);
+  }
+  parameters.clear();
+}
+
+bool mfx_GeometryNode_get_inputs(const char *plugin_path,
+                                 int effect_index,
+                                 Vector<OpenMfxInput> &r_inputs)
+{
+  return get_input_infos(plugin_path, effect_index, is_extra_input, r_inputs);
+}
+
+bool mfx_GeometryNode_get_outputs(const char *plugin_path,
+                                  int effect_index,
+                                  Vector<OpenMfxInput> &r_outputs)
+{
+  return get_input_infos(plugin_path, effect_index, is_extra_output, r_outputs);
+}
+
+bool mfx_GeometryNode_cook(const char *plugin_path,
+                           int effect_index,
+                           Span<OpenMfxParameterValue> parameters,
+                           Span<Object *> input_objects,
+                           const Object *object,
+                           bool use_render_quality,
+                           GeometrySet &geometry_set,
+                           MutableSpan<GeometrySet> r_extra_outputs,
+                           std::string &r_message)
+{
+  GeometryNodePluginCache &cache = GeometryNodePluginCache::get();
+  GeometryNodePlugin *plugin = '\0' != plugin_path[0] ? cache.ensure_plugin(plugin_path) :
+                                                       nullptr;
+  if (nullptr == plugin) {
+    r_message = "Could not load ofx plugins!";
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(plugin->mutex);
+  OfxMeshEffectHandle descriptor = cache.ensure_descriptor(*plugin, effect_index);
+  if (nullptr == descriptor) {
+    r_message = "Could not load effect";
+    return false;
+  }
+
+  OfxPlugin *ofx_plugin = plugin->registry->plugins[effect_index];
+  OfxMeshEffectHandle instance;
+  if (!ofxhost_create_instance(ofx_plugin, descriptor, &instance)) {
+    r_message = "Could not create effect instance";
+    return false;
+  }
+
+  // Set parameters, matched by name since sockets may be outdated
+  blender::Map<blender::StringRef, const OpenMfxParameterValue *> values;
+  for (const OpenMfxParameterValue &value : parameters) {
+    values.add(mfx_Parameter_info(&value)->name, &value);
+  }
+  for (int i = 0; i < instance->parameters.num_parameters; ++i) {
+    OfxParamStruct *param = instance->parameters.parameters[i];
+    const OpenMfxParameterValue *value = values.lookup_default(parameter_system_name(param),
+                                                               nullptr);
+    if (nullptr != value && value->type == static_cast<int>(param->type)) {
+      copy_parameter_value_from_rna(param, value);
+    }
+  }
+
+  OfxHost *host = cache.host();
+  OfxMeshEffectSuiteV1 *meshEffectSuite = (OfxMeshEffectSuiteV1 *)host->fetchSuite(
+      host->host, kOfxMeshEffectSuite, 1);
+  OfxPropertySuiteV1 *propertySuite = (OfxPropertySuiteV1 *)host->fetchSuite(
+      host->host, kOfxPropertySuite, 1);
+
+  // Let the effect know whether it is cooking a preview
+  propertySuite->propSetInt(
+      &instance->properties, kOfxMeshEffectPropRenderQualityDraft, 0, use_render_quality ? 0 : 1);
+
+  bool should_cook = true;
+  ofxhost_is_identity(ofx_plugin, instance, &should_cook);
+
+  bool success = true;
+  if (should_cook) {
+    OfxMeshInputHandle input = NULL, output = NULL;
+    meshEffectSuite->inputGetHandle(instance, kOfxMeshMainInput, &input, NULL);
+    meshEffectSuite->inputGetHandle(instance, kOfxMeshMainOutput, &output, NULL);
+
+    // The component is only read by the effect, it is replaced by the output
+    const MeshComponent *mesh_component = geometry_set.get_component_for_read<MeshComponent>();
+    Mesh *mesh = nullptr != mesh_component ? const_cast<Mesh *>(mesh_component->get_for_read()) :
+                                             nullptr;
+
+    // Point clouds are converted directly when there is no mesh to process
+    PointCloud *pointcloud = nullptr;
+    if (nullptr == mesh && geometry_set.has_pointcloud()) {
+      pointcloud = const_cast<PointCloud *>(geometry_set.get_pointcloud_for_read());
+      mesh_component = nullptr;
+    }
+    MfxVertexWeightCache weight_cache;
+
+    MeshInternalData input_data;
+    input_data.is_input = true;
+    input_data.blender_mesh = mesh;
+    input_data.source_mesh = NULL;
+    input_data.object = const_cast<Object *>(object);
+    input_data.requested_attributes = NULL != input ? &input->requested_attributes : NULL;
+    input_data.weight_cache = &weight_cache;
+    input_data.geometry_component = mesh_component;
+    input_data.point_cloud = pointcloud;
+    input_data.source_point_cloud = NULL;
+    input_data.instances_target = NULL;
+    input_data.is_instanced = false;
+    input_data.instance_sources = NULL;
+    input_data.instance_source_count = 0;
+    input_data.samples = NULL;
+    input_data.bmesh_topology = NULL;
+    input_data.preallocated_mesh = NULL;
+    input_data.limit_surface_cache = NULL;
+
+    // Extra inputs, in the same order as input_objects. Their geometry is only converted when
+    // the effect requests it, which it typically does not when only instancing them.
+    Vector<OfxMeshInputHandle> extra_inputs;
+    for (int i = 0; i < instance->inputs.num_inputs; ++i) {
+      if (is_extra_input(instance->inputs.inputs[i])) {
+        extra_inputs.append(instance->inputs.inputs[i]);
+      }
+    }
+    Vector<Object *> instance_sources(extra_inputs.size(), nullptr);
+    Vector<MeshInternalData> extra_input_data(extra_inputs.size());
+    for (int i = 0; i < extra_inputs.size(); ++i) {
+      OfxMeshInputHandle extra_input = extra_inputs[i];
+      Object *input_object = i < input_objects.size() ? input_objects[i] : nullptr;
+      int request_geometry = 1;
+      propertySuite->propGetInt(
+          &extra_input->properties, kOfxInputPropRequestGeometry, 0, &request_geometry);
+
+      MeshInternalData &data = extra_input_data[i];
+      memset(&data, 0, sizeof(MeshInternalData));
+      data.is_input = true;
+      data.blender_mesh = request_geometry && nullptr != input_object ?
+                              BKE_modifier_get_evaluated_mesh_from_evaluated_object(
+                                  input_object, false) :
+                              NULL;
+      data.object = input_object;
+      data.requested_attributes = &extra_input->requested_attributes;
+      data.weight_cache = &weight_cache;
+      propertySuite->propSetPointer(
+          &extra_input->mesh.properties, kOfxMeshPropInternalData, 0, (void *)&data);
+
+      // Instancing the object being evaluated would be recursive
+      instance_sources[i] = input_object != object ? input_object : nullptr;
+    }
+
+    // Extra outputs, in the same order as r_extra_outputs. They are converted with the main input
+    // as source, whose topology they may share.
+    Vector<OfxMeshInputHandle> extra_outputs;
+    for (int i = 0; i < instance->inputs.num_inputs; ++i) {
+      if (is_extra_output(instance->inputs.inputs[i]) &&
+          extra_outputs.size() < r_extra_outputs.size()) {
+        extra_outputs.append(instance->inputs.inputs[i]);
+      }
+    }
+    Vector<MeshInternalData> extra_output_data(extra_outputs.size());
+    for (int i = 0; i < extra_outputs.size(); ++i) {
+      MeshInternalData &data = extra_output_data[i];
+      memset(&data, 0, sizeof(MeshInternalData));
+      data.is_input = false;
+      data.source_mesh = mesh;
+      data.object = const_cast<Object *>(object);
+      data.geometry_component = mesh_component;
+      data.source_point_cloud = pointcloud;
+      propertySuite->propSetPointer(
+          &extra_outputs[i]->mesh.properties, kOfxMeshPropInternalData, 0, (void *)&data);
+    }
+
+    MeshInternalData output_data;
+    output_data.is_input = false;
+    output_data.blender_mesh = NULL;
+    output_data.source_mesh = mesh;
+    output_data.object = const_cast<Object *>(object);
+    output_data.requested_attributes = NULL;
+    output_data.weight_cache = NULL;
+    output_data.geometry_component = mesh_component;
+    output_data.point_cloud = NULL;
+    output_data.source_point_cloud = pointcloud;
+    // Instances are realized before cooking, so an instances component is only added back when
+    // the output is instanced
+    output_data.instances_target = &geometry_set;
+    output_data.is_instanced = false;
+    output_data.instance_sources = instance_sources.data();
+    output_data.instance_source_count = instance_sources.size();
+    output_data.samples = NULL;
+    output_data.bmesh_topology = NULL;
+    output_data.preallocated_mesh = NULL;
+    output_data.limit_surface_cache = NULL;
+
+    if (NULL != input) {
+      propertySuite->propSetPointer(
+          &input->mesh.properties, kOfxMeshPropInternalData, 0, (void *)&input_data);
+    }
+    if (NULL != output) {
+      propertySuite->propSetPointer(
+          &output->mesh.properties, kOfxMeshPropInternalData, 0, (void *)&output_data);
+    }
+
+    success = ofxhost_cook(ofx_plugin, instance);
+    free_preallocated_mesh(output_data);
+
+    for (int i = 0; i < extra_outputs.size(); ++i) {
+      MeshInternalData &data = extra_output_data[i];
+      free_preallocated_mesh(data);
+      GeometrySet &extra_output = r_extra_outputs[i];
+      if (NULL != data.blender_mesh) {
+        MeshComponent &component = extra_output.get_component_for_write<MeshComponent>();
+        component.replace(data.blender_mesh);
+        if (nullptr != mesh_component) {
+          component.vertex_group_names() = mesh_component->vertex_group_names();
+        }
+      }
+      else if (NULL != data.point_cloud) {
+        extra_output.replace_pointcloud(data.point_cloud);
+      }
+    }
+
+    if (output_data.is_instanced) {
+      // Nothing is realized, instances replace the mesh
+      geometry_set.remove<MeshComponent>();
+    }
+    else if (NULL != output_data.blender_mesh) {
+      // Output attributes have already been written with the vertex group names of the input
+      MeshComponent &component = geometry_set.get_component_for_write<MeshComponent>();
+      component.replace_mesh_but_keep_vertex_group_names(output_data.blender_mesh);
+    }
+    else if (NULL != output_data.point_cloud) {
+      geometry_set.replace_pointcloud(output_data.point_cloud);
+    }
+    else if (success) {
+      r_message = "Effect did not produce any output";
+      success = false;
+    }
+  }
+
+  OfxMessageType type = instance->messageType;
+  if (type == OfxMessageType::Error || type == OfxMessageType::Fatal) {
+    r_message = instance->message;
+    success = false;
+  }
+  else if (!success && r_message.empty()) {
+    r_message = "Effect failed to cook";
+  }
+
+  ofxhost_destroy_instance(ofx_plugin, instance);
+  return success;
+}
@@ -23,20 +23,32 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "mfxBakeCache.h"
 #include "mfxCallbacks.h"
+#include "mfxCookCache.h"
 #include "mfxRuntime.h"
 #include "mfxConvert.h"
+#include "mfxParameters.h"
+#include "mfxPluginRegistryPool.h"
 
 #include "DNA_mesh_types.h"      // Mesh
 #include "DNA_meshdata_types.h"  // MVert
 
+#include "BKE_appdir.h"  // BKE_tempdir_base
 #include "BKE_main.h"  // BKE_main_blendfile_path_from_global
 #include "BKE_mesh.h"  // BKE_mesh_new_nomain
+#include "BKE_mesh_wrapper.h"  // BKE_mesh_wrapper_ensure_mdata
 #include "BKE_modifier.h"  // BKE_modifier_setError
 
 #include "BLI_math_vector.h"
 #include "BLI_path_util.h"
 #include "BLI_string.h"
+#include "BLI_task.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
 
 /**
  * Ensure that fxmd->modifier.runtime points to a valid OpenMfxRuntime and return
@@ -53,7 +65,8 @@ static OpenMfxRuntime *ensure_runtime(OpenMfxModifierData *fxmd) {
   }
 
   // Update
-  runtime->set_plugin_path(fxmd->plugin_path);
+  runtime->set_plugin_path(fxmd->plugin_path,
+                           (fxmd->flag & MOD_OPENMFX_FLAG_OUT_OF_PROCESS) != 0);
   runtime->set_effect_index(fxmd->active_effect_index);
 
   if (false == runtime->is_plugin_valid()) {
@@ -67,6 +80,7 @@ void mfx_Modifier_reload_effect_info(OpenMfxModifierData *fxmd) {
 
   OpenMfxRuntime *runtime = ensure_runtime(fxmd);
   runtime->reload_effect_info(fxmd);
+  runtime->ensure_parameter_info(fxmd);
 
 }
 
@@ -94,19 +108,129 @@ void mfx_Modifier_free_runtime_data(void * runtime_data)
   
 }
 
-Mesh * mfx_Modifier_do(OpenMfxModifierData *fxmd, Mesh *mesh, Object *object)
+Mesh *mfx_Modifier_do(OpenMfxModifierData *fxmd,
+                      Mesh *mesh,
+                      Object *object,
+                      bool use_render_quality,
+                      float ctime,
+                      float motion_blur_shutter)
 {
-  
+  // Only whole frames of the bake range are cached
+  const int frame = (int)floorf(ctime);
+  const bool is_baking = (fxmd->flag & MOD_OPENMFX_FLAG_BAKING) != 0;
+  const bool is_baked = (fxmd->flag & MOD_OPENMFX_FLAG_BAKED) != 0;
+  const bool use_cache = (is_baking || is_baked) && ctime == (float)frame &&
+                         frame >= fxmd->bake_frame_start && frame <= fxmd->bake_frame_end;
+
+  // Edit-mode meshes are otherwise read straight from their BMesh, but the cache and motion
+  // blur steps need Blender mesh data
+  const bool use_motion_blur = use_render_quality && motion_blur_shutter > 0.0f && !is_baking;
+  if (use_cache || use_motion_blur) {
+    BKE_mesh_wrapper_ensure_mdata(mesh);
+  }
+
+  char path[FILE_MAX], reference_path[FILE_MAX];
+  if (use_cache) {
+    mfx_bake_cache_frame_path(fxmd, object, frame, path);
+    mfx_bake_cache_frame_path(fxmd, object, fxmd->bake_frame_start, reference_path);
+  }
+
+  if (use_cache && !is_baking) {
+    Mesh *cached_mesh = mfx_bake_cache_read(path, reference_path, mesh);
+    if (NULL != cached_mesh) {
+      return cached_mesh;
+    }
+    printf("Frame %d is missing from the bake cache, cooking it\n", frame);
+  }
+
   OpenMfxRuntime *runtime = ensure_runtime(fxmd);
-  Mesh *output_mesh = runtime->cook(fxmd, mesh, object);
+
+  // Bakes are meant for final renders
+  auto cook = [&]() -> Mesh * {
+    if (use_motion_blur) {
+      return runtime->cook_with_motion_blur(fxmd, mesh, object, ctime, motion_blur_shutter);
+    }
+    return runtime->cook(fxmd, mesh, object, use_render_quality || is_baking, ctime);
+  };
+
+  // Linked duplicates running the same effect on the same mesh share a single cook. The previous
+  // output, which may reference the last shared result, has been freed by now.
+  std::string cook_key;
+  MfxSharedMesh shared_output;
+  Mesh *output_mesh = NULL;
+  bool did_cook = false;
+  if (!use_cache && !use_motion_blur && !is_baking && runtime->ensure_effect_instance() &&
+      !runtime->depends_on_object(fxmd) &&
+      mfx_cook_cache_key(
+          fxmd, runtime->plugin_path, mesh, object, use_render_quality, ctime, cook_key)) {
+    output_mesh = mfx_cook_cache_cook(
+        cook_key, mesh, fxmd->message, cook, shared_output, &did_cook);
+  }
+  runtime->shared_output = shared_output;
+
+  if (NULL == output_mesh && !did_cook) {
+    output_mesh = cook();
+  }
+
+  if (use_cache && is_baking && NULL != output_mesh) {
+    mfx_bake_cache_write(path, reference_path, output_mesh);
+  }
 
   return output_mesh;
 }
 
+int mfx_Modifier_cook_batch(OpenMfxModifierData *fxmd,
+                            Object *object,
+                            Object **targets,
+                            int target_count,
+                            bool use_render_quality,
+                            float ctime)
+{
+  OpenMfxRuntime *runtime = ensure_runtime(fxmd);
+  if (false == runtime->is_plugin_valid()) {
+    return 0;
+  }
+  return runtime->cook_batch(fxmd,
+                             object,
+                             blender::Span<Object *>(targets, target_count),
+                             use_render_quality,
+                             ctime);
+}
+
+void mfx_Modifier_memory_usage(const OpenMfxModifierData *fxmd, OpenMfxMemoryUsage *r_usage)
+{
+  OfxHostMemoryUsage usage = {0, 0, 0, 0};
+  const OpenMfxRuntime *runtime = (const OpenMfxRuntime *)fxmd->modifier.runtime;
+  if (NULL != runtime) {
+    runtime->get_memory_usage(&usage);
+  }
+  r_usage->attribute_bytes = usage.attributeBytes;
+  r_usage->attribute_peak_bytes = usage.attributePeakBytes;
+  r_usage->plugin_bytes = usage.pluginBytes;
+  r_usage->plugin_peak_bytes = usage.pluginPeakBytes;
+}
+
+size_t mfx_Modifier_memory_in_use(void)
+{
+  // Mapped buffers live in temporary files rather than in MEM_guardedalloc
+  size_t allocated_bytes, mapped_bytes, pooled_bytes;
+  ofxhost_get_memory_usage(&allocated_bytes, &mapped_bytes, &pooled_bytes);
+  return allocated_bytes + pooled_bytes;
+}
+
+void mfx_Modifier_free_bake(OpenMfxModifierData *fxmd, Object *object)
+{
+  mfx_bake_cache_free(fxmd, object);
+  fxmd->flag &= ~MOD_OPENMFX_FLAG_BAKED;
+}
+
 void mfx_Modifier_copydata(OpenMfxModifierData *source, OpenMfxModifierData *destination)
 {
-  if (source->parameters) {
-    destination->parameters = (OpenMfxParameter *)MEM_dupallocN(source->parameters);
+  // Only values are duplicated, the description of the parameters is shared
+  destination->parameter_values = mfx_Parameters_dup(source->parameter_values,
+                                                     source->num_parameters);
+  if (NULL != source->parameter_info) {
+    mfx_ParameterInfoTable_add_user(source->parameter_info);
   }
 
   if (source->extra_inputs) {
@@ -123,8 +247,94 @@ void mfx_Modifier_copydata(OpenMfxModifierData *source, OpenMfxModifierData *des
   }
 }
 
+void mfx_Modifier_free_parameters(OpenMfxModifierData *fxmd)
+{
+  mfx_Parameters_free(fxmd->parameter_values, fxmd->num_parameters);
+  mfx_ParameterInfoTable_release(fxmd->parameter_info);
+  fxmd->parameter_values = NULL;
+  fxmd->parameter_info = NULL;
+  fxmd->num_parameters = 0;
+}
+
 void mfx_Modifier_before_updateDepsgraph(OpenMfxModifierData *fxmd)
 {
   OpenMfxRuntime *runtime = ensure_runtime(fxmd);
   runtime->set_input_prop_in_rna(fxmd);
 }
+
+void mfx_Modifier_preload_plugins(void)
+{
+  const char *search_path = getenv("OPENMFX_PLUGIN_PATH");
+  if (NULL == search_path || '\0' == search_path[0]) {
+    return;
+  }
+  printf("OpenMfx: preloading plugins from %s\n", search_path);
+  preload_registries(search_path);
+}
+
+void mfx_Modifier_free_preloaded_plugins(void)
+{
+  release_preloaded_registries();
+}
+
+void mfx_Modifier_init_cook_cache(void)
+{
+  mfx_cook_cache_register_callbacks();
+}
+
+void mfx_Modifier_free_cook_cache(void)
+{
+  mfx_cook_cache_clear();
+}
+
+static void *mfx_buffer_malloc(size_t size)
+{
+  return MEM_mallocN(size, "mfx attribute buffer");
+}
+
+static void mfx_buffer_free(void *ptr)
+{
+  MEM_freeN(ptr);
+}
+
+void mfx_Modifier_init_allocator(void)
+{
+  ofxhost_set_allocator(mfx_buffer_malloc, mfx_buffer_free);
+  // Follows the temporary directory of the preferences when it changes
+  ofxhost_set_temp_directory(BKE_tempdir_base);
+}
+
+struct MfxParallelForData {
+  void (*func)(unsigned int index, void *user_data);
+  void *user_data;
+};
+
+static void mfx_parallel_for_task(void *__restrict userdata,
+                                  const int iter,
+                                  const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const MfxParallelForData *data = (const MfxParallelForData *)userdata;
+  data->func((unsigned int)iter, data->user_data);
+}
+
+static void mfx_parallel_for(unsigned int count,
+                             void (*func)(unsigned int index, void *user_data),
+                             void *user_data)
+{
+  MfxParallelForData data = {func, user_data};
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  // Effects ask for as many indices as they have threads to keep busy
+  settings.min_iter_per_thread = 1;
+  BLI_task_parallel_range(0, (int)count, &data, mfx_parallel_for_task, &settings);
+}
+
+void mfx_Modifier_init_thread_pool(void)
+{
+  ofxhost_set_parallel_for(mfx_parallel_for);
+}
+
+void mfx_Modifier_free_memory(void)
+{
+  ofxhost_trim_memory();
+}
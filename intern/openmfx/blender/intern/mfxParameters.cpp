@@ -0,0 +1,203 @@
+/**
+ * Open Mesh Effect modifier for Blender
+ * Copyright (C) 2019 - 2021 Elie Michel
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** \file
+ * \ingroup openmesheffect
+ */
+
+#include "mfxParameters.h"
+
+#include "MEM_guardedalloc.h"
+#include "atomic_ops.h"
+
+#include "BLI_string.h"
+#include "BLI_utildefines.h"
+
+#include <cfloat>
+#include <climits>
+#include <cstring>
+
+static void init_parameter_info(OpenMfxParameterInfo *info)
+{
+  info->name = NULL;
+  info->label = NULL;
+  info->int_min = INT_MIN;
+  info->int_softmin = INT_MIN;
+  info->int_max = INT_MAX;
+  info->int_softmax = INT_MAX;
+  info->float_min = -FLT_MAX;
+  info->float_softmin = -FLT_MAX;
+  info->float_max = FLT_MAX;
+  info->float_softmax = FLT_MAX;
+}
+
+OpenMfxParameterInfoTable *mfx_ParameterInfoTable_new(int num_parameters)
+{
+  OpenMfxParameterInfoTable *table = (OpenMfxParameterInfoTable *)MEM_callocN(
+      sizeof(OpenMfxParameterInfoTable), "mfx parameter info table");
+  table->users = 1;
+  table->num_parameters = num_parameters;
+  if (num_parameters > 0) {
+    table->infos = (OpenMfxParameterInfo *)MEM_calloc_arrayN(
+        num_parameters, sizeof(OpenMfxParameterInfo), "mfx parameter infos");
+    for (int i = 0; i < num_parameters; ++i) {
+      init_parameter_info(&table->infos[i]);
+    }
+  }
+  return table;
+}
+
+void mfx_ParameterInfoTable_add_user(OpenMfxParameterInfoTable *table)
+{
+  atomic_add_and_fetch_int32(&table->users, 1);
+}
+
+void mfx_ParameterInfoTable_release(OpenMfxParameterInfoTable *table)
+{
+  if (NULL == table || atomic_sub_and_fetch_int32(&table->users, 1) > 0) {
+    return;
+  }
+
+  for (int i = 0; i < table->num_parameters; ++i) {
+    MEM_SAFE_FREE(table->infos[i].name);
+    MEM_SAFE_FREE(table->infos[i].label);
+  }
+  MEM_SAFE_FREE(table->infos);
+  MEM_freeN(table);
+}
+
+OpenMfxParameterValue *mfx_Parameters_new(OpenMfxParameterInfoTable *table)
+{
+  if (0 == table->num_parameters) {
+    return NULL;
+  }
+
+  OpenMfxParameterValue *parameters = (OpenMfxParameterValue *)MEM_calloc_arrayN(
+      table->num_parameters, sizeof(OpenMfxParameterValue), "mfx parameters");
+  for (int i = 0; i < table->num_parameters; ++i) {
+    parameters[i].info = &table->infos[i];
+  }
+  return parameters;
+}
+
+OpenMfxParameterValue *mfx_Parameters_dup(const OpenMfxParameterValue *parameters,
+                                          int num_parameters)
+{
+  if (NULL == parameters) {
+    return NULL;
+  }
+
+  OpenMfxParameterValue *copy = (OpenMfxParameterValue *)MEM_dupallocN(parameters);
+  for (int i = 0; i < num_parameters; ++i) {
+    if (NULL != parameters[i].string_value) {
+      copy[i].string_value = BLI_strdup(parameters[i].string_value);
+    }
+  }
+  return copy;
+}
+
+static char *strdup_fixed(const char *str, size_t maxlen)
+{
+  return BLI_strdupn(str, BLI_strnlen(str, maxlen));
+}
+
+OpenMfxParameterValue *mfx_Parameters_from_legacy(const OpenMfxParameter *legacy,
+                                                  int num_parameters,
+                                                  OpenMfxParameterInfoTable **r_table)
+{
+  OpenMfxParameterInfoTable *table = mfx_ParameterInfoTable_new(num_parameters);
+  OpenMfxParameterValue *parameters = mfx_Parameters_new(table);
+
+  for (int i = 0; i < num_parameters; ++i) {
+    const OpenMfxParameter &old = legacy[i];
+
+    OpenMfxParameterInfo *info = &table->infos[i];
+    info->name = strdup_fixed(old.name, MOD_OPENMFX_MAX_PARAMETER_NAME);
+    info->label = strdup_fixed(old.label, MOD_OPENMFX_MAX_PARAMETER_LABEL);
+    info->float_min = old.float_min;
+    info->float_softmin = old.float_softmin;
+    info->float_max = old.float_max;
+    info->float_softmax = old.float_softmax;
+    info->int_min = old.int_min;
+    info->int_softmin = old.int_softmin;
+    info->int_max = old.int_max;
+    info->int_softmax = old.int_softmax;
+
+    OpenMfxParameterValue *parameter = &parameters[i];
+    parameter->type = old.type;
+    memcpy(parameter->float_vec_value, old.float_vec_value, sizeof(old.float_vec_value));
+    memcpy(parameter->integer_vec_value, old.integer_vec_value, sizeof(old.integer_vec_value));
+    if ('\0' != old.string_value[0]) {
+      parameter->string_value = strdup_fixed(old.string_value, MOD_OPENMFX_MAX_STRING_VALUE);
+    }
+  }
+
+  *r_table = table;
+  return parameters;
+}
+
+void mfx_Parameters_free(OpenMfxParameterValue *parameters, int num_parameters)
+{
+  if (NULL == parameters) {
+    return;
+  }
+
+  for (int i = 0; i < num_parameters; ++i) {
+    MEM_SAFE_FREE(parameters[i].string_value);
+  }
+  MEM_freeN(parameters);
+}
+
+const OpenMfxParameterInfo *mfx_Parameter_info(const OpenMfxParameterValue *parameter)
+{
+  static const OpenMfxParameterInfo unknown_info = {(char *)"",
+                                                    (char *)"",
+                                                    -FLT_MAX,
+                                                    -FLT_MAX,
+                                                    FLT_MAX,
+                                                    FLT_MAX,
+                                                    INT_MIN,
+                                                    INT_MIN,
+                                                    INT_MAX,
+                                                    INT_MAX};
+  if (NULL == parameter->info || NULL == parameter->info->name) {
+    return &unknown_info;
+  }
+  return parameter->info;
+}
+
+const char *mfx_Parameter_string_value(const OpenMfxParameterValue *parameter)
+{
+  return NULL != parameter->string_value ? parameter->string_value : "";
+}
+
+void mfx_Parameter_set_string_value(OpenMfxParameterValue *parameter, const char *value)
+{
+  MEM_SAFE_FREE(parameter->string_value);
+  if (NULL != value && '\0' != value[0]) {
+    parameter->string_value = BLI_strdup(value);
+  }
+}
+
+bool mfx_Parameter_values_equal(const OpenMfxParameterValue *a, const OpenMfxParameterValue *b)
+{
+  return a->type == b->type &&
+         0 == memcmp(a->float_vec_value, b->float_vec_value, sizeof(a->float_vec_value)) &&
+         0 == memcmp(a->integer_vec_value, b->integer_vec_value, sizeof(a->integer_vec_value)) &&
+         STREQ(mfx_Parameter_string_value(a), mfx_Parameter_string_value(b));
+}
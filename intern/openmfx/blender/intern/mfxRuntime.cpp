@@ -25,6 +25,8 @@
 #include "mfxCallbacks.h"
 #include "mfxRuntime.h"
 #include "mfxConvert.h"
+#include "mfxParameters.h"
+#include "mfxAttributeMapping.h"
 #include "mfxPluginRegistryPool.h"
 #include <mfxHost/mesheffect>
 #include <mfxHost/messages>
@@ -34,16 +36,53 @@
 #include "DNA_modifier_types.h"
 #include "DNA_meshdata_types.h" // MVert
 
+#include "BKE_appdir.h" // BKE_appdir_program_dir
+#include "BKE_customdata.h"
+#include "BKE_deform.h" // BKE_object_defgroup_name_index
+#include "BKE_editmesh.h" // BMEditMesh
+#include "BKE_lib_id.h" // BKE_id_free
 #include "BKE_mesh.h" // BKE_mesh_new_nomain
+#include "BKE_mesh_wrapper.h" // BKE_mesh_wrapper_ensure_mdata
 #include "BKE_main.h" // BKE_main_blendfile_path_from_global
 #include "BKE_modifier.h" // BKE_modifier_set_error
 
+#include "BLI_disjoint_set.hh"
 #include "BLI_math_vector.h"
+#include "BLI_span.hh"
 #include "BLI_string.h"
 #include "BLI_path_util.h"
+#include "BLI_set.hh"
+#include "BLI_task.h" // TaskPool
+#include "BLI_task.hh" // parallel_for
 
+#include "bmesh.h"
+#include "bmesh_tools.h" // BM_mesh_decimate_collapse
+
+#include <algorithm>
+#include <cstdlib>
+#include <numeric>
 #include <vector>
 
+// ----------------------------------------------------------------------------
+// Private utils
+
+#ifdef WITH_OPENMFX_REMOTE
+/**
+ * The helper process is installed next to the blender executable, unless
+ * overridden by the OPENMFX_REMOTE_HOST environment variable.
+ */
+static void get_remote_host_path(char *out_path)
+{
+  const char *env_path = getenv("OPENMFX_REMOTE_HOST");
+  if (NULL != env_path && '\0' != env_path[0]) {
+    BLI_strncpy(out_path, env_path, FILE_MAX);
+  }
+  else {
+    BLI_join_dirfile(out_path, FILE_MAX, BKE_appdir_program_dir(), "mfx_remote_host");
+  }
+}
+#endif
+
 // ----------------------------------------------------------------------------
 // Public
 
@@ -51,16 +90,28 @@ OpenMfxRuntime::OpenMfxRuntime()
 {
   plugin_path[0] = '\0';
   m_is_plugin_valid = false;
+  m_is_out_of_process = false;
+  m_is_descriptor_shared = false;
+#ifdef WITH_OPENMFX_REMOTE
+  m_remote_host = nullptr;
+#endif
   effect_index = 0;
   ofx_host = nullptr;
   effect_desc = nullptr;
   effect_instance = nullptr;
   registry = nullptr;
+  m_motion_input_totloop = 0;
+  m_motion_input_totpoly = 0;
+  m_bmesh_topology = nullptr;
+  m_limit_surface_cache = new MfxLimitSurfaceCache;
 }
 
 OpenMfxRuntime::~OpenMfxRuntime()
 {
+  free_motion_samples();
   reset_plugin_path();
+  delete m_bmesh_topology;
+  delete m_limit_surface_cache;
 
   if (nullptr != this->ofx_host) {
     releaseGlobalHost();
@@ -68,25 +119,46 @@ OpenMfxRuntime::~OpenMfxRuntime()
   }
 }
 
-void OpenMfxRuntime::set_plugin_path(const char *plugin_path)
+void OpenMfxRuntime::set_plugin_path(const char *plugin_path, bool use_out_of_process)
 {
-  if (0 == strcmp(this->plugin_path, plugin_path)) {
+#ifndef WITH_OPENMFX_REMOTE
+  if (use_out_of_process) {
+    printf("Out of process plugins are not supported on this platform, loading in process\n");
+    use_out_of_process = false;
+  }
+#endif
+
+  if (0 == strcmp(this->plugin_path, plugin_path) &&
+      m_is_out_of_process == use_out_of_process) {
     return;
   }
 
   reset_plugin_path();
 
   strncpy(this->plugin_path, plugin_path, sizeof(this->plugin_path));
+  m_is_out_of_process = use_out_of_process;
 
   if (0 == strcmp(this->plugin_path, "")) {
     return;
   }
 
-  printf("Loading OFX plugin %s\n", this->plugin_path);
+  printf("Loading OFX plugin %s%s\n", this->plugin_path, use_out_of_process ? " out of process" : "");
   
   char abs_path[FILE_MAX];
   normalize_plugin_path(this->plugin_path, abs_path);
 
+#ifdef WITH_OPENMFX_REMOTE
+  if (use_out_of_process) {
+    // Each modifier has its own helper process, the registry pool is not used
+    char helper_path[FILE_MAX];
+    get_remote_host_path(helper_path);
+    m_remote_host = remote_host_start(helper_path, abs_path);
+    this->registry = NULL != m_remote_host ? remote_host_registry(m_remote_host) : NULL;
+    m_is_plugin_valid = this->registry != NULL;
+    return;
+  }
+#endif
+
   this->registry = get_registry(abs_path);
   m_is_plugin_valid = this->registry != NULL;
 }
@@ -116,26 +188,31 @@ void OpenMfxRuntime::get_parameters_from_rna(OpenMfxModifierData *fxmd)
 {
   OfxParamHandle *parameters = this->effect_instance->parameters.parameters;
   for (int i = 0 ; i < fxmd->num_parameters ; ++i) {
-    copy_parameter_value_from_rna(parameters[i], fxmd->parameters + i);
+    copy_parameter_value_from_rna(parameters[i], fxmd->parameter_values + i);
   }
 }
 
-void OpenMfxRuntime::set_message_in_rna(OpenMfxModifierData *fxmd)
+static void set_instance_message_in_rna(OpenMfxModifierData *fxmd, OfxMeshEffectHandle instance)
 {
-  if (NULL == this->effect_instance) {
-    return;
-  }
-
-  OfxMessageType type = this->effect_instance->messageType;
+  OfxMessageType type = instance->messageType;
 
   if (type != OfxMessageType::Invalid) {
-    BLI_strncpy(fxmd->message, this->effect_instance->message, MOD_OPENMFX_MAX_MESSAGE);
+    BLI_strncpy(fxmd->message, instance->message, MOD_OPENMFX_MAX_MESSAGE);
     fxmd->message[MOD_OPENMFX_MAX_MESSAGE - 1] = '\0';
   }
 
   if (type == OfxMessageType::Error || type == OfxMessageType::Fatal) {
-    BKE_modifier_set_error(NULL, &fxmd->modifier, this->effect_instance->message);
+    BKE_modifier_set_error(NULL, &fxmd->modifier, instance->message);
+  }
+}
+
+void OpenMfxRuntime::set_message_in_rna(OpenMfxModifierData *fxmd)
+{
+  if (NULL == this->effect_instance) {
+    return;
   }
+
+  set_instance_message_in_rna(fxmd, this->effect_instance);
 }
 
 bool OpenMfxRuntime::ensure_effect_instance()
@@ -154,21 +231,26 @@ bool OpenMfxRuntime::ensure_effect_instance()
 
   OfxPlugin *plugin = this->registry->plugins[this->effect_index];
 
+  // Preloaded registries already hold the descriptors
+  if (NULL == this->effect_desc && NULL != this->registry->descriptors &&
+      NULL != this->registry->descriptors[this->effect_index]) {
+    this->effect_desc = this->registry->descriptors[this->effect_index];
+    m_is_descriptor_shared = true;
+  }
+
   if (NULL == this->effect_desc) {
-    // Load plugin if not already loaded
-    OfxPluginStatus *pStatus = &this->registry->status[this->effect_index];
-    if (OfxPluginStatNotLoaded == *pStatus) {
-      if (ofxhost_load_plugin(this->ofx_host, plugin)) {
-        *pStatus = OfxPluginStatOK;
-      }
-      else {
-        printf("Error while loading plugin!\n");
-        *pStatus = OfxPluginStatError;
-        return false;
-      }
+    m_is_descriptor_shared = false;
+
+    // Load plugin if not already loaded, geometry nodes may share it
+    if (!registry_acquire_plugin(this->registry, this->effect_index, this->ofx_host)) {
+      printf("Error while loading plugin!\n");
+      return false;
     }
 
-    ofxhost_get_descriptor(this->ofx_host, plugin, &this->effect_desc);
+    if (!ofxhost_get_descriptor(this->ofx_host, plugin, &this->effect_desc)) {
+      registry_release_plugin(this->registry, this->effect_index);
+      return false;
+    }
   }
 
   if (NULL == this->effect_instance) {
@@ -187,8 +269,8 @@ void OpenMfxRuntime::save_rna_parameter_values(OpenMfxModifierData *fxmd)
 {
   m_saved_parameter_values.clear();
   for (int i = 0; i < fxmd->num_parameters; ++i) {
-    OpenMfxParameter* rna = fxmd->parameters + i;
-    std::string key = std::string(rna->name);
+    OpenMfxParameterValue* rna = fxmd->parameter_values + i;
+    std::string key = std::string(mfx_Parameter_info(rna)->name);
     copy_parameter_value_from_rna(&m_saved_parameter_values[key], rna);
   }
 }
@@ -196,18 +278,420 @@ void OpenMfxRuntime::save_rna_parameter_values(OpenMfxModifierData *fxmd)
 void OpenMfxRuntime::try_restore_rna_parameter_values(OpenMfxModifierData *fxmd)
 {
   for (int i = 0; i < fxmd->num_parameters; ++i) {
-    OpenMfxParameter *rna = fxmd->parameters + i;
-    std::string key = std::string(rna->name);
+    OpenMfxParameterValue *rna = fxmd->parameter_values + i;
+    std::string key = std::string(mfx_Parameter_info(rna)->name);
     if (m_saved_parameter_values.count(key)) {
       copy_parameter_value_to_rna(rna, &m_saved_parameter_values[key]);
     }
   }
 }
 
+/**
+ * Build a decimated copy of the mesh, used as a cheaper input for viewport cooks
+ */
+static Mesh *mesh_new_viewport_proxy(Mesh *mesh, float ratio)
+{
+  BMeshCreateParams create_params = {0};
+  BMeshFromMeshParams from_mesh_params = {0};
+  from_mesh_params.calc_face_normal = true;
+
+  BMesh *bm = BKE_mesh_to_bmesh_ex(mesh, &create_params, &from_mesh_params);
+  BM_mesh_decimate_collapse(bm, ratio, NULL, 1.0f, false, -1, 0.0f);
+  Mesh *proxy = BKE_mesh_from_bmesh_for_eval_nomain(bm, NULL, mesh);
+  BM_mesh_free(bm);
+
+  proxy->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
+  return proxy;
+}
+
+/**
+ * Build an empty mesh with the settings and layers of the BMesh that an edit-mode mesh wraps.
+ * Outputs are created from it rather than from the wrapper, whose own layers are empty.
+ */
+static Mesh *mesh_new_bmesh_template(const Mesh *wrapper)
+{
+  BMesh *bm = wrapper->edit_mesh->bm;
+  Mesh *mesh = BKE_mesh_new_nomain(0, 0, 0, 0, 0);
+  BKE_mesh_copy_settings(mesh, wrapper);
+
+  // Same layers as BM_mesh_bm_to_me_for_eval() would create
+  CustomData_MeshMasks mask = CD_MASK_MESH;
+  CustomData_MeshMasks_update(&mask, &wrapper->runtime.cd_mask_extra);
+  CustomData_merge(&bm->vdata, &mesh->vdata, mask.vmask, CD_CALLOC, 0);
+  CustomData_merge(&bm->edata, &mesh->edata, mask.emask, CD_CALLOC, 0);
+  CustomData_merge(&bm->ldata, &mesh->ldata, mask.lmask, CD_CALLOC, 0);
+  CustomData_merge(&bm->pdata, &mesh->pdata, mask.pmask, CD_CALLOC, 0);
+  mesh->cd_flag = BM_mesh_cd_flag_from_bmesh(bm);
+  return mesh;
+}
+
+/**
+ * Copy the custom data of the given source elements to the first elements of dest, by runs of
+ * consecutive indices
+ */
+static void copy_custom_data_elements(const CustomData *source,
+                                      CustomData *dest,
+                                      blender::Span<int> indices)
+{
+  int64_t i = 0;
+  while (i < indices.size()) {
+    int64_t run = 1;
+    while (i + run < indices.size() && indices[i + run] == indices[i] + run) {
+      ++run;
+    }
+    CustomData_copy_data(source, dest, indices[i], (int)i, (int)run);
+    i += run;
+  }
+}
+
+/**
+ * Build a mesh made of some of the elements of another one, edges and faces only using the
+ * given vertices. vert_map and edge_map give the new index of each vertex and edge of mesh.
+ */
+static Mesh *mesh_new_from_elements(const Mesh *mesh,
+                                    blender::Span<int> verts,
+                                    blender::Span<int> edges,
+                                    blender::Span<int> polys,
+                                    blender::Span<int> vert_map,
+                                    blender::Span<int> edge_map)
+{
+  int totloop = 0;
+  for (const int p : polys) {
+    totloop += mesh->mpoly[p].totloop;
+  }
+
+  Mesh *result = BKE_mesh_new_nomain_from_template(
+      mesh, (int)verts.size(), (int)edges.size(), 0, totloop, (int)polys.size());
+
+  copy_custom_data_elements(&mesh->vdata, &result->vdata, verts);
+  copy_custom_data_elements(&mesh->edata, &result->edata, edges);
+  copy_custom_data_elements(&mesh->pdata, &result->pdata, polys);
+
+  for (int i = 0; i < result->totedge; ++i) {
+    MEdge &edge = result->medge[i];
+    edge.v1 = vert_map[edge.v1];
+    edge.v2 = vert_map[edge.v2];
+  }
+
+  int loopstart = 0;
+  for (int i = 0; i < result->totpoly; ++i) {
+    MPoly &poly = result->mpoly[i];
+    CustomData_copy_data(&mesh->ldata, &result->ldata, poly.loopstart, loopstart, poly.totloop);
+    poly.loopstart = loopstart;
+    loopstart += poly.totloop;
+  }
+
+  for (int i = 0; i < result->totloop; ++i) {
+    MLoop &loop = result->mloop[i];
+    loop.v = vert_map[loop.v];
+    loop.e = edge_map[loop.e];
+  }
+
+  return result;
+}
+
+/**
+ * Allocate a mesh made of as many elements as all the given meshes, with the layers of all of
+ * them
+ */
+static Mesh *mesh_new_with_layers_of(blender::Span<Mesh *> meshes)
+{
+  int totvert = 0, totedge = 0, totloop = 0, totpoly = 0;
+  for (const Mesh *mesh : meshes) {
+    totvert += mesh->totvert;
+    totedge += mesh->totedge;
+    totloop += mesh->totloop;
+    totpoly += mesh->totpoly;
+  }
+
+  Mesh *result = BKE_mesh_new_nomain_from_template(
+      meshes[0], totvert, totedge, 0, totloop, totpoly);
+  for (const Mesh *mesh : meshes.drop_front(1)) {
+    CustomData_merge(&mesh->vdata, &result->vdata, CD_MASK_EVERYTHING.vmask, CD_CALLOC, totvert);
+    CustomData_merge(&mesh->edata, &result->edata, CD_MASK_EVERYTHING.emask, CD_CALLOC, totedge);
+    CustomData_merge(&mesh->ldata, &result->ldata, CD_MASK_EVERYTHING.lmask, CD_CALLOC, totloop);
+    CustomData_merge(&mesh->pdata, &result->pdata, CD_MASK_EVERYTHING.pmask, CD_CALLOC, totpoly);
+  }
+  BKE_mesh_update_customdata_pointers(result, false);
+  return result;
+}
+
+/**
+ * Copy the first elements of source to the given elements of dest, by runs of consecutive
+ * indices, matching layers by name
+ */
+static void copy_custom_data_elements_to(const CustomData *source,
+                                         CustomData *dest,
+                                         blender::Span<int> dest_indices)
+{
+  int64_t i = 0;
+  while (i < dest_indices.size()) {
+    int64_t run = 1;
+    while (i + run < dest_indices.size() && dest_indices[i + run] == dest_indices[i] + run) {
+      ++run;
+    }
+    CustomData_copy_data_named(source, dest, (int)i, dest_indices[i], (int)run);
+    i += run;
+  }
+}
+
+/**
+ * Match the edges of meshes cooked from groups of elements of mesh (see
+ * mesh_new_from_elements()) with the edges of mesh. Edges of faces are matched through the loops,
+ * loose edges by their order. Returns false unless each output has exactly the topology of its
+ * group.
+ */
+static bool match_group_edges(const Mesh *mesh,
+                              blender::Span<Mesh *> meshes,
+                              const std::vector<std::vector<int>> &group_verts,
+                              const std::vector<std::vector<int>> &group_edges,
+                              const std::vector<std::vector<int>> &group_polys,
+                              blender::Span<int> vert_map,
+                              std::vector<std::vector<int>> &r_edge_orig)
+{
+  std::vector<bool> is_edge_matched(mesh->totedge, false);
+  r_edge_orig.resize(meshes.size());
+  for (int64_t g = 0; g < meshes.size(); ++g) {
+    const Mesh *output = meshes[g];
+    const std::vector<int> &polys = group_polys[g];
+    int totloop = 0;
+    for (const int p : polys) {
+      totloop += mesh->mpoly[p].totloop;
+    }
+    if (output->totvert != (int)group_verts[g].size() ||
+        output->totedge != (int)group_edges[g].size() || output->totpoly != (int)polys.size() ||
+        output->totloop != totloop) {
+      return false;
+    }
+
+    std::vector<int> &edge_orig = r_edge_orig[g];
+    edge_orig.assign(output->totedge, -1);
+    for (int k = 0; k < output->totpoly; ++k) {
+      const MPoly &output_poly = output->mpoly[k];
+      const MPoly &poly = mesh->mpoly[polys[k]];
+      if (output_poly.totloop != poly.totloop || output_poly.loopstart < 0 ||
+          output_poly.loopstart + output_poly.totloop > output->totloop) {
+        return false;
+      }
+      for (int j = 0; j < poly.totloop; ++j) {
+        const MLoop &output_loop = output->mloop[output_poly.loopstart + j];
+        const MLoop &loop = mesh->mloop[poly.loopstart + j];
+        if ((int)output_loop.v != vert_map[loop.v] || (int)output_loop.e >= output->totedge) {
+          return false;
+        }
+        int &orig = edge_orig[output_loop.e];
+        if (-1 == orig) {
+          if (is_edge_matched[loop.e]) {
+            return false;
+          }
+          orig = (int)loop.e;
+          is_edge_matched[loop.e] = true;
+        }
+        else if (orig != (int)loop.e) {
+          return false;
+        }
+      }
+    }
+
+    // Remaining edges are loose, and come in the same order as in the group
+    int e = 0;
+    for (const int orig : group_edges[g]) {
+      if (is_edge_matched[orig]) {
+        continue;
+      }
+      while (e < output->totedge && -1 != edge_orig[e]) {
+        ++e;
+      }
+      if (e == output->totedge) {
+        return false;
+      }
+      const MEdge &output_edge = output->medge[e];
+      const MEdge &edge = mesh->medge[orig];
+      const int v1 = vert_map[edge.v1], v2 = vert_map[edge.v2];
+      if (!(((int)output_edge.v1 == v1 && (int)output_edge.v2 == v2) ||
+            ((int)output_edge.v1 == v2 && (int)output_edge.v2 == v1))) {
+        return false;
+      }
+      edge_orig[e] = orig;
+      is_edge_matched[orig] = true;
+    }
+    for (; e < output->totedge; ++e) {
+      if (-1 == edge_orig[e]) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * Put the elements of meshes cooked from groups of elements of mesh back at the index they come
+ * from, so that the result does not depend on how islands were grouped. Returns NULL if the
+ * effect changed the topology of any group.
+ */
+static Mesh *mesh_new_ungrouped(const Mesh *mesh,
+                                blender::Span<Mesh *> meshes,
+                                const std::vector<std::vector<int>> &group_verts,
+                                const std::vector<std::vector<int>> &group_edges,
+                                const std::vector<std::vector<int>> &group_polys,
+                                blender::Span<int> vert_map)
+{
+  std::vector<std::vector<int>> edge_orig;
+  if (!match_group_edges(
+          mesh, meshes, group_verts, group_edges, group_polys, vert_map, edge_orig)) {
+    return NULL;
+  }
+
+  Mesh *result = mesh_new_with_layers_of(meshes);
+  for (int64_t g = 0; g < meshes.size(); ++g) {
+    const Mesh *output = meshes[g];
+    copy_custom_data_elements_to(&output->vdata, &result->vdata, group_verts[g]);
+    copy_custom_data_elements_to(&output->edata, &result->edata, edge_orig[g]);
+    copy_custom_data_elements_to(&output->pdata, &result->pdata, group_polys[g]);
+    for (int k = 0; k < output->totpoly; ++k) {
+      const MPoly &output_poly = output->mpoly[k];
+      CustomData_copy_data_named(&output->ldata,
+                                 &result->ldata,
+                                 output_poly.loopstart,
+                                 mesh->mpoly[group_polys[g][k]].loopstart,
+                                 output_poly.totloop);
+    }
+  }
+
+  // Topology is that of the input, only flags and layers come from the outputs
+  for (int i = 0; i < result->totedge; ++i) {
+    result->medge[i].v1 = mesh->medge[i].v1;
+    result->medge[i].v2 = mesh->medge[i].v2;
+  }
+  for (int i = 0; i < result->totloop; ++i) {
+    result->mloop[i] = mesh->mloop[i];
+  }
+  for (int i = 0; i < result->totpoly; ++i) {
+    result->mpoly[i].loopstart = mesh->mpoly[i].loopstart;
+  }
+
+  result->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
+  return result;
+}
+
+/**
+ * Concatenate meshes, keeping the layers of all of them
+ */
+static Mesh *mesh_new_joined(blender::Span<Mesh *> meshes)
+{
+  Mesh *result = mesh_new_with_layers_of(meshes);
+
+  int vert_offset = 0, edge_offset = 0, loop_offset = 0, poly_offset = 0;
+  for (const Mesh *mesh : meshes) {
+    CustomData_copy_data_named(&mesh->vdata, &result->vdata, 0, vert_offset, mesh->totvert);
+    CustomData_copy_data_named(&mesh->edata, &result->edata, 0, edge_offset, mesh->totedge);
+    CustomData_copy_data_named(&mesh->ldata, &result->ldata, 0, loop_offset, mesh->totloop);
+    CustomData_copy_data_named(&mesh->pdata, &result->pdata, 0, poly_offset, mesh->totpoly);
+
+    for (int i = edge_offset; i < edge_offset + mesh->totedge; ++i) {
+      result->medge[i].v1 += vert_offset;
+      result->medge[i].v2 += vert_offset;
+    }
+    for (int i = loop_offset; i < loop_offset + mesh->totloop; ++i) {
+      result->mloop[i].v += vert_offset;
+      result->mloop[i].e += edge_offset;
+    }
+    for (int i = poly_offset; i < poly_offset + mesh->totpoly; ++i) {
+      result->mpoly[i].loopstart += loop_offset;
+    }
+
+    vert_offset += mesh->totvert;
+    edge_offset += mesh->totedge;
+    loop_offset += mesh->totloop;
+    poly_offset += mesh->totpoly;
+  }
+
+  result->runtime.cd_dirty_vert |= CD_MASK_NORMAL;
+  return result;
+}
+
+/**
+ * Unbind the meshes of all the inputs and outputs of an instance, whose internal data only lasts
+ * for one cook. Inputs that are not bound again appear as not connected.
+ */
+static void clear_mesh_bindings(OfxPropertySuiteV1 *propertySuite, OfxMeshEffectHandle instance)
+{
+  for (int i = 0; i < instance->inputs.num_inputs; ++i) {
+    propertySuite->propSetPointer(
+        &instance->inputs.inputs[i]->mesh.properties, kOfxMeshPropInternalData, 0, NULL);
+  }
+}
+
 Mesh *OpenMfxRuntime::cook(OpenMfxModifierData *fxmd,
-                                  Mesh *mesh,
-                                  Object *object)
+                           Mesh *mesh,
+                           Object *object,
+                           bool use_render_quality,
+                           float time)
+{
+  OfxTime cook_time = (OfxTime)time;
+
+  Mesh *output_mesh;
+  if (cook_islands(fxmd, mesh, object, use_render_quality, cook_time, &output_mesh)) {
+    return output_mesh;
+  }
+
+  return cook_samples(fxmd, mesh, object, use_render_quality, &cook_time, 1, NULL);
+}
+
+Mesh *OpenMfxRuntime::cook_with_motion_blur(
+    OpenMfxModifierData *fxmd, Mesh *mesh, Object *object, float time, float shutter)
+{
+  Mesh *sample = take_motion_sample(fxmd, mesh, time);
+  if (NULL != sample) {
+    printf("Reusing motion blur step cooked for time %f\n", time);
+    return sample;
+  }
+
+  // Steps are batched from the whole frame, that renderers evaluate first
+  if (time != floorf(time)) {
+    return cook(fxmd, mesh, object, true, time);
+  }
+
+  free_motion_samples();
+
+  // Inputs are read at the whole frame for all steps, which only holds as long as they do not
+  // move, hence the check in take_motion_sample()
+  const OfxTime times[3] = {time, time - 0.5 * shutter, time + 0.5 * shutter};
+  Mesh *other_samples[2] = {NULL, NULL};
+  Mesh *output_mesh = cook_samples(fxmd, mesh, object, true, times, 3, other_samples);
+
+  for (int i = 0; i < 2; ++i) {
+    if (NULL != other_samples[i]) {
+      m_motion_samples.push_back({(float)times[i + 1], other_samples[i]});
+    }
+  }
+
+  if (!m_motion_samples.empty()) {
+    m_motion_input_positions.resize(3 * (size_t)mesh->totvert);
+    for (int i = 0; i < mesh->totvert; ++i) {
+      copy_v3_v3(&m_motion_input_positions[3 * (size_t)i], mesh->mvert[i].co);
+    }
+    m_motion_input_totloop = mesh->totloop;
+    m_motion_input_totpoly = mesh->totpoly;
+    m_motion_parameters = mfx_Parameters_dup(fxmd->parameter_values, fxmd->num_parameters);
+    m_num_motion_parameters = fxmd->num_parameters;
+  }
+
+  return output_mesh;
+}
+
+Mesh *OpenMfxRuntime::cook_samples(OpenMfxModifierData *fxmd,
+                                   Mesh *mesh,
+                                   Object *object,
+                                   bool use_render_quality,
+                                   const OfxTime *times,
+                                   int count,
+                                   Mesh **r_other_samples)
 {
+  for (int i = 1; i < count; ++i) {
+    r_other_samples[i - 1] = NULL;
+  }
+
   if (false == this->ensure_effect_instance()) {
     printf("failed to get effect instance\n");
     return NULL;
@@ -226,6 +710,12 @@ Mesh *OpenMfxRuntime::cook(OpenMfxModifierData *fxmd,
   // Get parameters
   this->get_parameters_from_rna(fxmd);
 
+  // Let the effect know whether it is cooking a preview
+  propertySuite->propSetInt(&this->effect_instance->properties,
+                            kOfxMeshEffectPropRenderQualityDraft,
+                            0,
+                            use_render_quality ? 0 : 1);
+
   // Test if we can skip cooking
   OfxPlugin *plugin = this->registry->plugins[this->effect_index];
   bool shouldCook = true;
@@ -236,13 +726,69 @@ Mesh *OpenMfxRuntime::cook(OpenMfxModifierData *fxmd,
     return mesh;
   }
 
+  // Let the effect evaluate the animation of parameters at other times
+  std::vector<ParamInternalData> param_data(fxmd->num_parameters);
+  OfxParamHandle *parameters = this->effect_instance->parameters.parameters;
+  for (int i = 0; i < fxmd->num_parameters; ++i) {
+    param_data[i].object = object;
+    param_data[i].modifier = &fxmd->modifier;
+    param_data[i].index = i;
+    propertySuite->propSetPointer(
+        &parameters[i]->properties, kOfxParamPropInternalData, 0, (void *)&param_data[i]);
+    propertySuite->propSetPointer(
+        &parameters[i]->properties, kOfxParamPropHostHandle, 0, (void *)ofxHost);
+  }
+
+  // In the viewport, effects may be fed with a decimated copy of their input
+  Mesh *proxy_mesh = NULL;
+  if (!use_render_quality && (fxmd->flag & MOD_OPENMFX_FLAG_VIEWPORT_PROXY) &&
+      fxmd->viewport_proxy_ratio < 1.0f && NULL != mesh) {
+    BKE_mesh_wrapper_ensure_mdata(mesh);
+    if (mesh->totpoly > 0) {
+      proxy_mesh = mesh_new_viewport_proxy(mesh, fxmd->viewport_proxy_ratio);
+    }
+  }
+
+  // Edit-mode meshes are converted straight from their BMesh, keeping its element tables for
+  // the next cook in case only positions changed.
+  const bool is_edit_mesh = NULL != mesh && NULL == proxy_mesh &&
+                            ME_WRAPPER_TYPE_BMESH == mesh->runtime.wrapper_type;
+  Mesh *template_mesh = NULL;
+  if (is_edit_mesh) {
+    if (NULL == m_bmesh_topology) {
+      m_bmesh_topology = new MfxBMeshTopology;
+    }
+    template_mesh = mesh_new_bmesh_template(mesh);
+  }
+  else if (NULL != m_bmesh_topology) {
+    delete m_bmesh_topology;
+    m_bmesh_topology = NULL;
+  }
+
+  // Vertex group weights requested by the effect are densified at most once
+  // per evaluated mesh, even if several inputs read the same mesh.
+  MfxVertexWeightCache weight_cache; // must remain in scope
+
   // Set input mesh data binding, used by before/after callbacks
   MeshInternalData input_data; // must remain in scope
   if (NULL != input) {
     input_data.is_input = true;
-    input_data.blender_mesh = mesh;
+    input_data.blender_mesh = NULL != proxy_mesh ? proxy_mesh : mesh;
     input_data.source_mesh = NULL;
     input_data.object = object;
+    input_data.requested_attributes = &input->requested_attributes;
+    input_data.weight_cache = &weight_cache;
+    input_data.geometry_component = NULL;
+    input_data.point_cloud = NULL;
+    input_data.source_point_cloud = NULL;
+    input_data.instances_target = NULL;
+    input_data.is_instanced = false;
+    input_data.instance_sources = NULL;
+    input_data.instance_source_count = 0;
+    input_data.samples = NULL;
+    input_data.bmesh_topology = is_edit_mesh ? m_bmesh_topology : NULL;
+    input_data.preallocated_mesh = NULL;
+    input_data.limit_surface_cache = m_limit_surface_cache;
     propertySuite->propSetPointer(
         &input->mesh.properties, kOfxMeshPropInternalData, 0, (void *)&input_data);
   }
@@ -250,6 +796,8 @@ Mesh *OpenMfxRuntime::cook(OpenMfxModifierData *fxmd,
   // Same for extra inputs
   // allocate here so that it last until after the call to ofxhost_cook
   std::vector<MeshInternalData> extra_input_data(fxmd->num_extra_inputs);
+  // Objects connected to extra inputs may be in edit mode as well
+  std::vector<MfxBMeshTopology> extra_input_topologies(fxmd->num_extra_inputs);
   for (int i = 0; i < fxmd->num_extra_inputs; ++i) {
     OfxMeshInputHandle input;
     meshEffectSuite->inputGetHandle(this->effect_instance, fxmd->extra_inputs[i].name, &input, NULL);
@@ -264,6 +812,19 @@ Mesh *OpenMfxRuntime::cook(OpenMfxModifierData *fxmd,
     extra_input_data[i].blender_mesh = mesh;
     extra_input_data[i].source_mesh = NULL;
     extra_input_data[i].object = object;
+    extra_input_data[i].requested_attributes = &input->requested_attributes;
+    extra_input_data[i].weight_cache = &weight_cache;
+    extra_input_data[i].geometry_component = NULL;
+    extra_input_data[i].point_cloud = NULL;
+    extra_input_data[i].source_point_cloud = NULL;
+    extra_input_data[i].instances_target = NULL;
+    extra_input_data[i].is_instanced = false;
+    extra_input_data[i].instance_sources = NULL;
+    extra_input_data[i].instance_source_count = 0;
+    extra_input_data[i].samples = NULL;
+    extra_input_data[i].bmesh_topology = &extra_input_topologies[i];
+    extra_input_data[i].preallocated_mesh = NULL;
+    extra_input_data[i].limit_surface_cache = NULL;
 
     propertySuite->propSetPointer(&input->mesh.properties, kOfxMeshPropInternalData, 0, (void *)&extra_input_data[i]);
   }
@@ -272,12 +833,56 @@ Mesh *OpenMfxRuntime::cook(OpenMfxModifierData *fxmd,
   MeshInternalData output_data;
   output_data.is_input = false;
   output_data.blender_mesh = NULL;
-  output_data.source_mesh = mesh;
+  output_data.source_mesh = NULL != template_mesh ? template_mesh : mesh;
   output_data.object = object;
+  output_data.requested_attributes = NULL;
+  output_data.weight_cache = NULL;
+  output_data.geometry_component = NULL;
+  output_data.point_cloud = NULL;
+  output_data.source_point_cloud = NULL;
+  output_data.instances_target = NULL;
+  output_data.is_instanced = false;
+  output_data.instance_sources = NULL;
+  output_data.instance_source_count = 0;
+  output_data.samples = NULL;
+  output_data.bmesh_topology = NULL;
+  output_data.preallocated_mesh = NULL;
+  output_data.limit_surface_cache = NULL;
+
+  // Outputs at each time when several are asked for
+  std::vector<Mesh *> sample_meshes(count, NULL);
+  MfxOutputSamples samples;
+  samples.count = count;
+  samples.times = times;
+  samples.meshes = sample_meshes.data();
+  if (count > 1) {
+    output_data.samples = &samples;
+  }
   propertySuite->propSetPointer(
       &output->mesh.properties, kOfxMeshPropInternalData, 0, (void *)&output_data);
 
-  ofxhost_cook(plugin, this->effect_instance);
+  ofxhost_cook_samples(plugin, this->effect_instance, times, count);
+  free_preallocated_mesh(output_data);
+
+  clear_mesh_bindings(propertySuite, this->effect_instance);
+  for (int i = 0; i < fxmd->num_parameters; ++i) {
+    propertySuite->propSetPointer(&parameters[i]->properties, kOfxParamPropInternalData, 0, NULL);
+  }
+
+  if (count > 1) {
+    output_data.blender_mesh = sample_meshes[0];
+    for (int i = 1; i < count; ++i) {
+      r_other_samples[i - 1] = sample_meshes[i];
+    }
+  }
+
+  // Output data has been copied, the proxy and template are no longer referenced
+  if (NULL != proxy_mesh) {
+    BKE_id_free(NULL, proxy_mesh);
+  }
+  if (NULL != template_mesh) {
+    BKE_id_free(NULL, template_mesh);
+  }
 
   // Free mesh on Blender side -> nope, ModifierTypeInfo's doc says a modifier must not free its input
   /*
@@ -291,6 +896,510 @@ Mesh *OpenMfxRuntime::cook(OpenMfxModifierData *fxmd,
   return output_data.blender_mesh;
 }
 
+bool OpenMfxRuntime::cook_islands(OpenMfxModifierData *fxmd,
+                                  Mesh *mesh,
+                                  Object *object,
+                                  bool use_render_quality,
+                                  OfxTime time,
+                                  Mesh **r_output)
+{
+  *r_output = NULL;
+
+  if (m_is_out_of_process || NULL == mesh ||
+      ME_WRAPPER_TYPE_MDATA != mesh->runtime.wrapper_type || mesh->totvert < 2) {
+    return false;
+  }
+  if (!use_render_quality && (fxmd->flag & MOD_OPENMFX_FLAG_VIEWPORT_PROXY) &&
+      fxmd->viewport_proxy_ratio < 1.0f) {
+    return false;
+  }
+  for (int i = 0; i < fxmd->num_extra_inputs; ++i) {
+    if (NULL != fxmd->extra_inputs[i].connected_object) {
+      return false;
+    }
+  }
+
+  if (false == this->ensure_effect_instance()) {
+    return false;
+  }
+
+  const OfxPropertySetStruct &desc_props = this->effect_desc->properties;
+  int island_independent_idx = desc_props.find_property(kOfxMeshEffectPropIslandIndependent);
+  if (-1 == island_independent_idx ||
+      0 == desc_props.properties[island_independent_idx]->value[0].as_int) {
+    return false;
+  }
+
+  // Find connected components, weighted by their number of vertices and corners
+  blender::DisjointSet disjoint_set(mesh->totvert);
+  for (int i = 0; i < mesh->totedge; ++i) {
+    disjoint_set.join(mesh->medge[i].v1, mesh->medge[i].v2);
+  }
+
+  std::vector<int> vert_island(mesh->totvert);
+  std::vector<int> root_island(mesh->totvert, -1);
+  std::vector<int64_t> island_weights;
+  for (int v = 0; v < mesh->totvert; ++v) {
+    int root = (int)disjoint_set.find_root(v);
+    if (-1 == root_island[root]) {
+      root_island[root] = (int)island_weights.size();
+      island_weights.push_back(0);
+    }
+    vert_island[v] = root_island[root];
+    ++island_weights[vert_island[v]];
+  }
+  for (int p = 0; p < mesh->totpoly; ++p) {
+    const MPoly &poly = mesh->mpoly[p];
+    island_weights[vert_island[mesh->mloop[poly.loopstart].v]] += poly.totloop;
+  }
+
+  // A fixed number of groups of islands rather than one instance per island, to bound the
+  // overhead of converting and cooking meshes made of many small pieces. It does not depend on
+  // the number of threads, so that outputs are the same on all machines.
+  const int max_group_count = 16;
+  const int island_count = (int)island_weights.size();
+  const int group_count = std::min(island_count, max_group_count);
+  if (group_count < 2) {
+    return false;
+  }
+
+  // Balance groups by giving the heaviest remaining island to the lightest group
+  std::vector<int> island_order(island_count);
+  std::iota(island_order.begin(), island_order.end(), 0);
+  std::sort(island_order.begin(), island_order.end(), [&](int a, int b) {
+    return island_weights[a] > island_weights[b];
+  });
+  std::vector<int64_t> group_weights(group_count, 0);
+  std::vector<int> island_group(island_count);
+  for (const int island : island_order) {
+    auto lightest = std::min_element(group_weights.begin(), group_weights.end());
+    island_group[island] = (int)(lightest - group_weights.begin());
+    *lightest += island_weights[island];
+  }
+
+  std::vector<std::vector<int>> group_verts(group_count), group_edges(group_count),
+      group_polys(group_count);
+  std::vector<int> vert_map(mesh->totvert), edge_map(mesh->totedge);
+  for (int v = 0; v < mesh->totvert; ++v) {
+    std::vector<int> &verts = group_verts[island_group[vert_island[v]]];
+    vert_map[v] = (int)verts.size();
+    verts.push_back(v);
+  }
+  for (int e = 0; e < mesh->totedge; ++e) {
+    std::vector<int> &edges = group_edges[island_group[vert_island[mesh->medge[e].v1]]];
+    edge_map[e] = (int)edges.size();
+    edges.push_back(e);
+  }
+  for (int p = 0; p < mesh->totpoly; ++p) {
+    const int v = mesh->mloop[mesh->mpoly[p].loopstart].v;
+    group_polys[island_group[vert_island[v]]].push_back(p);
+  }
+
+  OfxHost *ofxHost = this->ofx_host;
+  OfxMeshEffectSuiteV1 *meshEffectSuite = (OfxMeshEffectSuiteV1 *)ofxHost->fetchSuite(
+      ofxHost->host, kOfxMeshEffectSuite, 1);
+  OfxPropertySuiteV1 *propertySuite = (OfxPropertySuiteV1 *)ofxHost->fetchSuite(
+      ofxHost->host, kOfxPropertySuite, 1);
+  OfxPlugin *plugin = this->registry->plugins[this->effect_index];
+
+  while ((int)m_island_instances.size() < group_count - 1) {
+    OfxMeshEffectHandle instance = NULL;
+    if (!ofxhost_create_instance(plugin, this->effect_desc, &instance) || NULL == instance) {
+      printf("failed to create an instance to cook islands\n");
+      return false;
+    }
+    m_island_instances.push_back(instance);
+  }
+
+  std::vector<OfxMeshEffectHandle> instances(group_count);
+  instances[0] = this->effect_instance;
+  std::copy_n(m_island_instances.begin(), group_count - 1, instances.begin() + 1);
+
+  // Set parameters of all instances, but only the first one tells whether to skip cooking
+  this->get_parameters_from_rna(fxmd);
+  for (int g = 1; g < group_count; ++g) {
+    OfxParamHandle *parameters = instances[g]->parameters.parameters;
+    for (int i = 0; i < fxmd->num_parameters; ++i) {
+      copy_parameter_value_from_rna(parameters[i], fxmd->parameter_values + i);
+    }
+  }
+  for (const OfxMeshEffectHandle instance : instances) {
+    propertySuite->propSetInt(&instance->properties,
+                              kOfxMeshEffectPropRenderQualityDraft,
+                              0,
+                              use_render_quality ? 0 : 1);
+  }
+
+  bool shouldCook = true;
+  ofxhost_is_identity(plugin, this->effect_instance, &shouldCook);
+  if (false == shouldCook) {
+    printf("effect is identity, skipping cooking\n");
+    *r_output = mesh;
+    return true;
+  }
+
+  std::vector<ParamInternalData> param_data(fxmd->num_parameters);
+  for (int i = 0; i < fxmd->num_parameters; ++i) {
+    param_data[i].object = object;
+    param_data[i].modifier = &fxmd->modifier;
+    param_data[i].index = i;
+  }
+
+  // Each group is converted by its own thread, with its own weight cache
+  std::vector<Mesh *> island_meshes(group_count, NULL);
+  std::vector<MfxVertexWeightCache> weight_caches(group_count);
+  std::vector<MeshInternalData> input_data(group_count);
+  std::vector<MeshInternalData> output_data(group_count);
+  for (int g = 0; g < group_count; ++g) {
+    OfxParamHandle *parameters = instances[g]->parameters.parameters;
+    for (int i = 0; i < fxmd->num_parameters; ++i) {
+      propertySuite->propSetPointer(
+          &parameters[i]->properties, kOfxParamPropInternalData, 0, (void *)&param_data[i]);
+      propertySuite->propSetPointer(
+          &parameters[i]->properties, kOfxParamPropHostHandle, 0, (void *)ofxHost);
+    }
+
+    // Only the main input is fed, other inputs appear as not connected
+    clear_mesh_bindings(propertySuite, instances[g]);
+
+    OfxMeshInputHandle input, output;
+    meshEffectSuite->inputGetHandle(instances[g], kOfxMeshMainInput, &input, NULL);
+    meshEffectSuite->inputGetHandle(instances[g], kOfxMeshMainOutput, &output, NULL);
+
+    if (NULL != input) {
+      input_data[g].is_input = true;
+      input_data[g].blender_mesh = NULL; // set once split
+      input_data[g].source_mesh = NULL;
+      input_data[g].object = object;
+      input_data[g].requested_attributes = &input->requested_attributes;
+      input_data[g].weight_cache = &weight_caches[g];
+      input_data[g].geometry_component = NULL;
+      input_data[g].point_cloud = NULL;
+      input_data[g].source_point_cloud = NULL;
+      input_data[g].instances_target = NULL;
+      input_data[g].is_instanced = false;
+      input_data[g].instance_sources = NULL;
+      input_data[g].instance_source_count = 0;
+      input_data[g].samples = NULL;
+      input_data[g].bmesh_topology = NULL;
+      input_data[g].preallocated_mesh = NULL;
+      input_data[g].limit_surface_cache = NULL;
+      propertySuite->propSetPointer(
+          &input->mesh.properties, kOfxMeshPropInternalData, 0, (void *)&input_data[g]);
+    }
+
+    output_data[g].is_input = false;
+    output_data[g].blender_mesh = NULL;
+    output_data[g].source_mesh = mesh;
+    output_data[g].object = object;
+    output_data[g].requested_attributes = NULL;
+    output_data[g].weight_cache = NULL;
+    output_data[g].geometry_component = NULL;
+    output_data[g].point_cloud = NULL;
+    output_data[g].source_point_cloud = NULL;
+    output_data[g].instances_target = NULL;
+    output_data[g].is_instanced = false;
+    output_data[g].instance_sources = NULL;
+    output_data[g].instance_source_count = 0;
+    output_data[g].samples = NULL;
+    output_data[g].bmesh_topology = NULL;
+    output_data[g].preallocated_mesh = NULL;
+    output_data[g].limit_surface_cache = NULL;
+    if (NULL != output) {
+      propertySuite->propSetPointer(
+          &output->mesh.properties, kOfxMeshPropInternalData, 0, (void *)&output_data[g]);
+    }
+  }
+
+  blender::parallel_for(blender::IndexRange(group_count), 1, [&](blender::IndexRange range) {
+    for (const int64_t g : range) {
+      island_meshes[g] = mesh_new_from_elements(
+          mesh, group_verts[g], group_edges[g], group_polys[g], vert_map, edge_map);
+      input_data[g].blender_mesh = island_meshes[g];
+      ofxhost_cook_samples(plugin, instances[g], &time, 1);
+      free_preallocated_mesh(output_data[g]);
+    }
+  });
+
+  for (int g = 0; g < group_count; ++g) {
+    clear_mesh_bindings(propertySuite, instances[g]);
+    OfxParamHandle *parameters = instances[g]->parameters.parameters;
+    for (int i = 0; i < fxmd->num_parameters; ++i) {
+      propertySuite->propSetPointer(
+          &parameters[i]->properties, kOfxParamPropInternalData, 0, NULL);
+    }
+    BKE_id_free(NULL, island_meshes[g]);
+  }
+
+  // Errors of any group prevail over the messages of the other ones
+  bool is_complete = true;
+  for (const OfxMeshEffectHandle instance : instances) {
+    if (instance->messageType != OfxMessageType::Error &&
+        instance->messageType != OfxMessageType::Fatal) {
+      set_instance_message_in_rna(fxmd, instance);
+    }
+  }
+  for (int g = 0; g < group_count; ++g) {
+    if (instances[g]->messageType == OfxMessageType::Error ||
+        instances[g]->messageType == OfxMessageType::Fatal) {
+      set_instance_message_in_rna(fxmd, instances[g]);
+    }
+    is_complete = is_complete && NULL != output_data[g].blender_mesh;
+  }
+
+  std::vector<Mesh *> output_meshes(group_count);
+  for (int g = 0; g < group_count; ++g) {
+    output_meshes[g] = output_data[g].blender_mesh;
+  }
+  if (is_complete) {
+    // Effects that keep the topology give elements in the same order as a single cook
+    *r_output = mesh_new_ungrouped(
+        mesh, output_meshes, group_verts, group_edges, group_polys, vert_map);
+    if (NULL == *r_output) {
+      *r_output = mesh_new_joined(output_meshes);
+    }
+  }
+  for (Mesh *output_mesh : output_meshes) {
+    if (NULL != output_mesh) {
+      BKE_id_free(NULL, output_mesh);
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Mesh going through the stages of a batch cook
+ */
+struct BatchCookItem {
+  Object *object;
+  /** Evaluated copy of the mesh of the object, referencing its layers */
+  Mesh *input = NULL;
+  /** Result of the cook, NULL if the effect failed */
+  Mesh *output = NULL;
+  MfxVertexWeightCache weight_cache;
+  bool is_written = false;
+};
+
+/**
+ * Copy the mesh of an object for a batch cook, and densify ahead of the cook the vertex groups
+ * that the effect asked for, the costliest part of the conversion.
+ */
+static void batch_cook_prepare(TaskPool *__restrict pool, void *taskdata)
+{
+  BatchCookItem *item = (BatchCookItem *)taskdata;
+  const OfxAttributeSetStruct *requested_attributes =
+      (const OfxAttributeSetStruct *)BLI_task_pool_user_data(pool);
+
+  item->input = BKE_mesh_copy_for_eval((Mesh *)item->object->data, true);
+
+  for (int i = 0; i < requested_attributes->num_attributes; ++i) {
+    const OfxAttributeStruct *attribute = requested_attributes->attributes[i];
+    if (AttributeAttachment::Point != attribute->attachment) {
+      continue;
+    }
+    const int group_index = BKE_object_defgroup_name_index(item->object, attribute->name);
+    if (-1 != group_index) {
+      item->weight_cache.get(item->input, group_index);
+    }
+  }
+}
+
+/**
+ * Write the result of a batch cook to the mesh of its object
+ */
+static void batch_cook_finalize(TaskPool *__restrict UNUSED(pool), void *taskdata)
+{
+  BatchCookItem *item = (BatchCookItem *)taskdata;
+
+  // The input references the layers that the output replaces
+  BKE_id_free(NULL, item->input);
+  item->input = NULL;
+  item->weight_cache.clear();
+
+  if (NULL != item->output) {
+    BKE_mesh_nomain_to_mesh(
+        item->output, (Mesh *)item->object->data, item->object, &CD_MASK_MESH, true);
+    item->output = NULL;
+    item->is_written = true;
+  }
+}
+
+int OpenMfxRuntime::cook_batch(OpenMfxModifierData *fxmd,
+                               Object *object,
+                               blender::Span<Object *> targets,
+                               bool use_render_quality,
+                               float time)
+{
+  // Each mesh is only cooked once, for the first object using it. Write-backs then never touch
+  // the datablock that another worker is copying.
+  blender::Vector<Object *> unique_targets;
+  blender::Set<const ID *> target_meshes;
+  for (Object *target : targets) {
+    if (NULL != target && OB_MESH == target->type && NULL != target->data &&
+        target_meshes.add((const ID *)target->data)) {
+      unique_targets.append(target);
+    }
+  }
+  if (unique_targets.is_empty()) {
+    return 0;
+  }
+
+  if (false == this->ensure_effect_instance()) {
+    printf("failed to get effect instance\n");
+    return 0;
+  }
+
+  OfxHost *ofxHost = this->ofx_host;
+  OfxMeshEffectSuiteV1 *meshEffectSuite = (OfxMeshEffectSuiteV1 *)ofxHost->fetchSuite(
+      ofxHost->host, kOfxMeshEffectSuite, 1);
+  OfxPropertySuiteV1 *propertySuite = (OfxPropertySuiteV1 *)ofxHost->fetchSuite(
+      ofxHost->host, kOfxPropertySuite, 1);
+
+  OfxMeshInputHandle input, output;
+  meshEffectSuite->inputGetHandle(this->effect_instance, kOfxMeshMainInput, &input, NULL);
+  meshEffectSuite->inputGetHandle(this->effect_instance, kOfxMeshMainOutput, &output, NULL);
+  if (NULL == input || NULL == output) {
+    printf("Batch cooking requires an effect with a main input and output\n");
+    return 0;
+  }
+
+  // Everything that does not depend on the mesh is set once for the whole batch
+  this->get_parameters_from_rna(fxmd);
+  propertySuite->propSetInt(&this->effect_instance->properties,
+                            kOfxMeshEffectPropRenderQualityDraft,
+                            0,
+                            use_render_quality ? 0 : 1);
+
+  OfxPlugin *plugin = this->registry->plugins[this->effect_index];
+  bool shouldCook = true;
+  ofxhost_is_identity(plugin, this->effect_instance, &shouldCook);
+  if (false == shouldCook) {
+    printf("effect is identity, skipping batch\n");
+    return 0;
+  }
+
+  std::vector<ParamInternalData> param_data(fxmd->num_parameters);
+  OfxParamHandle *parameters = this->effect_instance->parameters.parameters;
+  for (int i = 0; i < fxmd->num_parameters; ++i) {
+    param_data[i].object = object;
+    param_data[i].modifier = &fxmd->modifier;
+    param_data[i].index = i;
+    propertySuite->propSetPointer(
+        &parameters[i]->properties, kOfxParamPropInternalData, 0, (void *)&param_data[i]);
+    propertySuite->propSetPointer(
+        &parameters[i]->properties, kOfxParamPropHostHandle, 0, (void *)ofxHost);
+  }
+
+  // Only the main input is fed, other inputs appear as not connected
+  for (int i = 0; i < fxmd->num_extra_inputs; ++i) {
+    OfxMeshInputHandle extra_input;
+    meshEffectSuite->inputGetHandle(
+        this->effect_instance, fxmd->extra_inputs[i].name, &extra_input, NULL);
+    if (NULL != extra_input) {
+      propertySuite->propSetPointer(
+          &extra_input->mesh.properties, kOfxMeshPropInternalData, 0, NULL);
+    }
+  }
+
+  // Bindings are only pointed to the mesh of each step
+  MeshInternalData input_data;
+  input_data.is_input = true;
+  input_data.blender_mesh = NULL;
+  input_data.source_mesh = NULL;
+  input_data.object = NULL;
+  input_data.requested_attributes = &input->requested_attributes;
+  input_data.weight_cache = NULL;
+  input_data.geometry_component = NULL;
+  input_data.point_cloud = NULL;
+  input_data.source_point_cloud = NULL;
+  input_data.instances_target = NULL;
+  input_data.is_instanced = false;
+  input_data.instance_sources = NULL;
+  input_data.instance_source_count = 0;
+  input_data.samples = NULL;
+  input_data.bmesh_topology = NULL;
+  input_data.preallocated_mesh = NULL;
+  input_data.limit_surface_cache = NULL;
+  propertySuite->propSetPointer(
+      &input->mesh.properties, kOfxMeshPropInternalData, 0, (void *)&input_data);
+
+  MeshInternalData output_data = input_data;
+  output_data.is_input = false;
+  output_data.requested_attributes = NULL;
+  propertySuite->propSetPointer(
+      &output->mesh.properties, kOfxMeshPropInternalData, 0, (void *)&output_data);
+
+  // While the effect cooks a mesh, the worker pool writes back the previous one and prepares
+  // the next one.
+  std::vector<BatchCookItem> items(unique_targets.size());
+  for (int k = 0; k < unique_targets.size(); ++k) {
+    items[k].object = unique_targets[k];
+  }
+
+  TaskPool *pool = BLI_task_pool_create((void *)&input->requested_attributes,
+                                        TASK_PRIORITY_HIGH);
+  BLI_task_pool_push(pool, batch_cook_prepare, &items[0], false, NULL);
+  BLI_task_pool_work_and_wait(pool);
+
+  const OfxTime cook_time = (OfxTime)time;
+  bool has_error = false;
+  for (int k = 0; k < items.size(); ++k) {
+    if (k + 1 < items.size()) {
+      BLI_task_pool_push(pool, batch_cook_prepare, &items[k + 1], false, NULL);
+    }
+    if (k > 0) {
+      BLI_task_pool_push(pool, batch_cook_finalize, &items[k - 1], false, NULL);
+    }
+
+    BatchCookItem &item = items[k];
+    input_data.blender_mesh = item.input;
+    input_data.object = item.object;
+    input_data.weight_cache = &item.weight_cache;
+    output_data.blender_mesh = NULL;
+    output_data.source_mesh = item.input;
+    output_data.object = item.object;
+
+    const bool is_cooked = ofxhost_cook_samples(plugin, this->effect_instance, &cook_time, 1);
+    free_preallocated_mesh(output_data);
+    if (is_cooked) {
+      item.output = output_data.blender_mesh;
+    }
+    else if (NULL != output_data.blender_mesh) {
+      BKE_id_free(NULL, output_data.blender_mesh);
+    }
+
+    // Report the first failure rather than the outcome of the last mesh
+    if (!has_error && (this->effect_instance->messageType == OfxMessageType::Error ||
+                       this->effect_instance->messageType == OfxMessageType::Fatal)) {
+      this->set_message_in_rna(fxmd);
+      has_error = true;
+    }
+
+    BLI_task_pool_work_and_wait(pool);
+  }
+
+  BLI_task_pool_push(pool, batch_cook_finalize, &items.back(), false, NULL);
+  BLI_task_pool_work_and_wait(pool);
+  BLI_task_pool_free(pool);
+
+  propertySuite->propSetPointer(&input->mesh.properties, kOfxMeshPropInternalData, 0, NULL);
+  propertySuite->propSetPointer(&output->mesh.properties, kOfxMeshPropInternalData, 0, NULL);
+  for (int i = 0; i < fxmd->num_parameters; ++i) {
+    propertySuite->propSetPointer(&parameters[i]->properties, kOfxParamPropInternalData, 0, NULL);
+  }
+
+  if (!has_error) {
+    this->set_message_in_rna(fxmd);
+  }
+
+  int written_count = 0;
+  for (const BatchCookItem &item : items) {
+    written_count += item.is_written ? 1 : 0;
+  }
+  return written_count;
+}
+
 void OpenMfxRuntime::reload_effect_info(OpenMfxModifierData *fxmd)
 {
   // Free previous info
@@ -319,12 +1428,14 @@ void OpenMfxRuntime::reload_effect_info(OpenMfxModifierData *fxmd)
 void OpenMfxRuntime::reload_parameters(OpenMfxModifierData *fxmd)
 {
   // Reset parameter DNA
-  if (NULL != fxmd->parameters) {
+  if (NULL != fxmd->parameter_values) {
     save_rna_parameter_values(fxmd);
-    MEM_freeN(fxmd->parameters);
-    fxmd->parameters = NULL;
-    fxmd->num_parameters = 0;
   }
+  mfx_Parameters_free(fxmd->parameter_values, fxmd->num_parameters);
+  mfx_ParameterInfoTable_release(fxmd->parameter_info);
+  fxmd->parameter_values = NULL;
+  fxmd->parameter_info = NULL;
+  fxmd->num_parameters = 0;
 
   if (NULL == this->effect_desc) {
     return;
@@ -333,78 +1444,38 @@ void OpenMfxRuntime::reload_parameters(OpenMfxModifierData *fxmd)
   OfxParamSetHandle parameters = &this->effect_desc->parameters;
 
   fxmd->num_parameters = parameters->num_parameters;
-  fxmd->parameters = (OpenMfxParameter *)MEM_calloc_arrayN(
-      sizeof(OpenMfxParameter), fxmd->num_parameters, "openmesheffect parameter info");
+  fxmd->parameter_info = mfx_ParameterInfoTable_new(fxmd->num_parameters);
+  fxmd->parameter_values = mfx_Parameters_new(fxmd->parameter_info);
 
   for (int i = 0; i < fxmd->num_parameters; ++i) {
-    const OfxPropertySetStruct & props = parameters->parameters[i]->properties;
-    OpenMfxParameter &rna = fxmd->parameters[i];
-
-    int script_name_idx = props.find_property(kOfxParamPropScriptName);
-    int label_idx = props.find_property(kOfxPropLabel);
-
-    const char *parameter_name = parameters->parameters[i]->name;
-    const char *system_name = (script_name_idx != -1) ?
-                                  props.properties[script_name_idx]->value->as_const_char :
-                                  parameter_name;
-    const char *label_name = (label_idx != -1) ?
-                                  props.properties[label_idx]->value->as_const_char :
-                                  parameter_name;
-
-    strncpy(rna.name, system_name, sizeof(rna.name));
-    strncpy(rna.label, label_name, sizeof(rna.label));
-    rna.type = static_cast<int>(parameters->parameters[i]->type);
-
-    int default_idx = props.find_property(kOfxParamPropDefault);
-    if (default_idx > -1) {
-      copy_parameter_value_to_rna(&rna, props.properties[default_idx]);
-    }
-
-    // Handle boundaries
-    // (TODO: there must be some factorization possible)
-    rna.int_min = INT_MIN;
-    rna.int_softmin = INT_MIN;
-    rna.int_max = INT_MAX;
-    rna.int_softmax = INT_MAX;
-    rna.float_min = FLT_MIN;
-    rna.float_softmin = FLT_MIN;
-    rna.float_max = FLT_MAX;
-    rna.float_softmax = FLT_MAX;
-
-    int min_idx = props.find_property(kOfxParamPropMin);
-    if (min_idx > -1) {
-      copy_parameter_minmax_to_rna(
-          rna.type, rna.int_min, rna.float_min, props.properties[min_idx]);
-    }
+    copy_parameter_info_to_rna(&fxmd->parameter_info->infos[i], parameters->parameters[i]);
+    copy_parameter_default_to_rna(&fxmd->parameter_values[i], parameters->parameters[i]);
+  }
 
-    int softmin_idx = props.find_property(kOfxParamPropDisplayMin);
-    if (softmin_idx > -1) {
-      copy_parameter_minmax_to_rna(
-          rna.type, rna.int_softmin, rna.float_softmin, props.properties[softmin_idx]);
-    }
-    else if (min_idx > -1) {
-      copy_parameter_minmax_to_rna(
-          rna.type, rna.int_softmin, rna.float_softmin, props.properties[min_idx]);
-    }
+  try_restore_rna_parameter_values(fxmd);
+}
 
-    int max_idx = props.find_property(kOfxParamPropMax);
-    if (max_idx > -1) {
-      copy_parameter_minmax_to_rna(
-          rna.type, rna.int_max, rna.float_max, props.properties[max_idx]);
-    }
+void OpenMfxRuntime::ensure_parameter_info(OpenMfxModifierData *fxmd)
+{
+  if (NULL != fxmd->parameter_info || 0 == fxmd->num_parameters ||
+      NULL == this->effect_desc ||
+      fxmd->num_parameters != this->effect_desc->parameters.num_parameters) {
+    return;
+  }
 
-    int softmax_idx = props.find_property(kOfxParamPropDisplayMax);
-    if (softmax_idx > -1) {
-      copy_parameter_minmax_to_rna(
-          rna.type, rna.int_softmax, rna.float_softmax, props.properties[softmax_idx]);
-    }
-    else if (max_idx > -1) {
-      copy_parameter_minmax_to_rna(
-          rna.type, rna.int_softmax, rna.float_softmax, props.properties[max_idx]);
+  // Parameters were stored by a version that did not save their description
+  OfxParamSetHandle parameters = &this->effect_desc->parameters;
+  for (int i = 0; i < fxmd->num_parameters; ++i) {
+    if (fxmd->parameter_values[i].type != static_cast<int>(parameters->parameters[i]->type)) {
+      return;
     }
   }
 
-  try_restore_rna_parameter_values(fxmd);
+  fxmd->parameter_info = mfx_ParameterInfoTable_new(fxmd->num_parameters);
+  for (int i = 0; i < fxmd->num_parameters; ++i) {
+    copy_parameter_info_to_rna(&fxmd->parameter_info->infos[i], parameters->parameters[i]);
+    fxmd->parameter_values[i].info = &fxmd->parameter_info->infos[i];
+  }
 }
 
 void OpenMfxRuntime::reload_extra_inputs(OpenMfxModifierData *fxmd)
@@ -426,7 +1497,7 @@ void OpenMfxRuntime::reload_extra_inputs(OpenMfxModifierData *fxmd)
   fxmd->num_extra_inputs = 0;
   for (int i = 0; i < inputs->num_inputs; ++i) {
     if (0 == strcmp(inputs->inputs[i]->name, kOfxMeshMainInput) ||
-        0 == strcmp(inputs->inputs[i]->name, kOfxMeshMainOutput)) {
+        inputs->inputs[i]->is_output()) {
       continue;
     }
     ++fxmd->num_extra_inputs;
@@ -438,7 +1509,7 @@ void OpenMfxRuntime::reload_extra_inputs(OpenMfxModifierData *fxmd)
   OpenMfxInput *current_input = fxmd->extra_inputs;
   for (int i = 0; i < inputs->num_inputs; ++i) {
     if (0 == strcmp(inputs->inputs[i]->name, kOfxMeshMainInput) ||
-        0 == strcmp(inputs->inputs[i]->name, kOfxMeshMainOutput)) {
+        inputs->inputs[i]->is_output()) {
       continue;
     }
     const OfxPropertySetStruct &props = inputs->inputs[i]->properties;
@@ -477,7 +1548,7 @@ void OpenMfxRuntime::set_input_prop_in_rna(OpenMfxModifierData *fxmd)
   OpenMfxInput *current_input = fxmd->extra_inputs;
   for (int i = 0; i < inputs->num_inputs; ++i) {
     if (0 == strcmp(inputs->inputs[i]->name, kOfxMeshMainInput) ||
-        0 == strcmp(inputs->inputs[i]->name, kOfxMeshMainOutput)) {
+        inputs->inputs[i]->is_output()) {
       continue;
     }
     const OfxPropertySetStruct &props = inputs->inputs[i]->properties;
@@ -492,6 +1563,48 @@ void OpenMfxRuntime::set_input_prop_in_rna(OpenMfxModifierData *fxmd)
   }
 }
 
+bool OpenMfxRuntime::depends_on_object(OpenMfxModifierData *fxmd)
+{
+  if (NULL == this->effect_desc) {
+    return true;
+  }
+
+  for (int i = 0; i < fxmd->num_extra_inputs; ++i) {
+    if (NULL != fxmd->extra_inputs[i].connected_object) {
+      return true;
+    }
+  }
+
+  const OfxMeshInputSetStruct &inputs = this->effect_desc->inputs;
+  int main_input_idx = inputs.find(kOfxMeshMainInput);
+  if (-1 == main_input_idx) {
+    return false;
+  }
+  const OfxPropertySetStruct &props = inputs.inputs[main_input_idx]->properties;
+  int request_transform_idx = props.find_property(kOfxInputPropRequestTransform);
+  return -1 != request_transform_idx &&
+         props.properties[request_transform_idx]->value->as_int != 0;
+}
+
+void OpenMfxRuntime::get_memory_usage(OfxHostMemoryUsage *usage) const
+{
+  *usage = OfxHostMemoryUsage{0, 0, 0, 0};
+  if (NULL == this->effect_instance) {
+    return;
+  }
+
+  std::vector<OfxMeshEffectHandle> instances = m_island_instances;
+  instances.push_back(this->effect_instance);
+  for (OfxMeshEffectHandle instance : instances) {
+    OfxHostMemoryUsage instance_usage;
+    ofxhost_get_instance_memory_usage(instance, &instance_usage);
+    usage->attributeBytes += instance_usage.attributeBytes;
+    usage->attributePeakBytes += instance_usage.attributePeakBytes;
+    usage->pluginBytes += instance_usage.pluginBytes;
+    usage->pluginPeakBytes += instance_usage.pluginPeakBytes;
+  }
+}
+
 // ----------------------------------------------------------------------------
 // Private static
 
@@ -513,26 +1626,79 @@ void OpenMfxRuntime::free_effect_instance()
 {
   if (is_plugin_valid() && -1 != this->effect_index) {
     OfxPlugin *plugin = this->registry->plugins[this->effect_index];
-    OfxPluginStatus status = this->registry->status[this->effect_index];
 
+    for (OfxMeshEffectHandle instance : m_island_instances) {
+      ofxhost_destroy_instance(plugin, instance);
+    }
+    m_island_instances.clear();
     if (NULL != this->effect_instance) {
       ofxhost_destroy_instance(plugin, this->effect_instance);
       this->effect_instance = NULL;
     }
+    // Shared descriptors and their plugins belong to the registry
     if (NULL != this->effect_desc) {
-      ofxhost_release_descriptor(this->effect_desc);
+      if (!m_is_descriptor_shared) {
+        ofxhost_release_descriptor(this->effect_desc);
+        registry_release_plugin(this->registry, this->effect_index);
+      }
       this->effect_desc = NULL;
     }
-    if (OfxPluginStatOK == status) {
-      // TODO: loop over all plugins?
-      ofxhost_unload_plugin(plugin);
-      this->registry->status[this->effect_index] = OfxPluginStatNotLoaded;
-    }
 
     this->effect_index = -1;
   }
 }
 
+Mesh *OpenMfxRuntime::take_motion_sample(const OpenMfxModifierData *fxmd,
+                                          const Mesh *mesh,
+                                          float time)
+{
+  auto it = m_motion_samples.begin();
+  for (; it != m_motion_samples.end(); ++it) {
+    if (fabsf(it->time - time) < 1e-4f) {
+      break;
+    }
+  }
+  if (it == m_motion_samples.end()) {
+    return NULL;
+  }
+
+  if (3 * (size_t)mesh->totvert != m_motion_input_positions.size() ||
+      mesh->totloop != m_motion_input_totloop || mesh->totpoly != m_motion_input_totpoly ||
+      fxmd->num_parameters != m_num_motion_parameters) {
+    free_motion_samples();
+    return NULL;
+  }
+  for (int i = 0; i < fxmd->num_parameters; ++i) {
+    if (!mfx_Parameter_values_equal(&fxmd->parameter_values[i], &m_motion_parameters[i])) {
+      free_motion_samples();
+      return NULL;
+    }
+  }
+  for (int i = 0; i < mesh->totvert; ++i) {
+    if (!equals_v3v3(&m_motion_input_positions[3 * (size_t)i], mesh->mvert[i].co)) {
+      // The input moves, the steps must be cooked from it
+      free_motion_samples();
+      return NULL;
+    }
+  }
+
+  Mesh *sample = it->mesh;
+  m_motion_samples.erase(it);
+  return sample;
+}
+
+void OpenMfxRuntime::free_motion_samples()
+{
+  for (const MotionSample &sample : m_motion_samples) {
+    BKE_id_free(NULL, sample.mesh);
+  }
+  m_motion_samples.clear();
+  m_motion_input_positions.clear();
+  mfx_Parameters_free(m_motion_parameters, m_num_motion_parameters);
+  m_motion_parameters = nullptr;
+  m_num_motion_parameters = 0;
+}
+
 void OpenMfxRuntime::ensure_host()
 {
   if (NULL == this->ofx_host) {
@@ -546,6 +1712,20 @@ void OpenMfxRuntime::ensure_host()
         this->ofx_host->host, kOfxHostPropBeforeMeshGetCb, 0, (void *)before_mesh_get);
     propertySuite->propSetPointer(
         this->ofx_host->host, kOfxHostPropBeforeMeshReleaseCb, 0, (void *)before_mesh_release);
+    propertySuite->propSetPointer(
+        this->ofx_host->host, kOfxHostPropBeforeMeshAllocCb, 0, (void *)before_mesh_alloc);
+    propertySuite->propSetPointer(
+        this->ofx_host->host, kOfxHostPropLimitSurfaceCreateCb, 0, (void *)limit_surface_create);
+    propertySuite->propSetPointer(this->ofx_host->host,
+                                  kOfxHostPropLimitSurfaceEvaluateCb,
+                                  0,
+                                  (void *)limit_surface_evaluate);
+    propertySuite->propSetPointer(
+        this->ofx_host->host, kOfxHostPropLimitSurfaceDestroyCb, 0, (void *)limit_surface_destroy);
+    propertySuite->propSetPointer(this->ofx_host->host,
+                                  kOfxHostPropParamGetValueAtTimeCb,
+                                  0,
+                                  (void *)param_get_value_at_time);
   }
 }
 
@@ -555,11 +1735,22 @@ void OpenMfxRuntime::reset_plugin_path()
     printf("Unloading OFX plugin %s\n", this->plugin_path);
     free_effect_instance();
 
-    char abs_path[FILE_MAX];
-    normalize_plugin_path(this->plugin_path, abs_path);
-    release_registry(abs_path);
+#ifdef WITH_OPENMFX_REMOTE
+    if (NULL != m_remote_host) {
+      remote_host_stop(m_remote_host);
+      m_remote_host = NULL;
+    }
+    else
+#endif
+    {
+      char abs_path[FILE_MAX];
+      normalize_plugin_path(this->plugin_path, abs_path);
+      release_registry(abs_path);
+    }
+    this->registry = NULL;
     m_is_plugin_valid = false;
   }
   this->plugin_path[0] = '\0';
+  m_is_out_of_process = false;
   this->effect_index = -1;
 }
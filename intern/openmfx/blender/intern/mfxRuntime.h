@@ -20,16 +20,26 @@
  * \ingroup openmesheffect
  */
 
+#include "mfxCookCache.h"
 #include "mfxModifier.h"
 #include "mfxHost.h"
 #include "mfxPluginRegistry.h"
+#ifdef WITH_OPENMFX_REMOTE
+#  include "mfxRemoteHost.h"
+#endif
 
 #include "ofxCore.h"
 
 #include "DNA_modifier_types.h"
 
+#include "BLI_span.hh"
+
 #include <map>
 #include <string>
+#include <vector>
+
+struct MfxBMeshTopology;
+struct MfxLimitSurfaceCache;
 
 /**
  * Structure holding runtime allocated data for OpenMfx plug-in hosting.
@@ -43,8 +53,10 @@ class OpenMfxRuntime {
 
   /**
    * Set the plugin path, as put return status in is_plugin_valid
+   * When use_out_of_process is true, the plugin is loaded by a helper process
+   * and the registry holds proxies forwarding actions to it.
    */
-  void set_plugin_path(const char *plugin_path);
+  void set_plugin_path(const char *plugin_path, bool use_out_of_process = false);
 
   /**
    * Pick an effect in the plugin by its index. Value is clamped to valid values (including -1 to
@@ -85,9 +97,36 @@ class OpenMfxRuntime {
   void try_restore_rna_parameter_values(OpenMfxModifierData *fxmd);
 
   /**
-   * Actually apply the modifier
+   * Actually apply the modifier at the given time. When use_render_quality is false, the effect
+   * is cooked as a draft, on a decimated proxy of the input if the modifier asks so.
+   */
+  Mesh *cook(OpenMfxModifierData *fxmd,
+             Mesh *mesh,
+             Object *object,
+             bool use_render_quality,
+             float time);
+
+  /**
+   * Apply the modifier for a render using motion blur. At a whole frame, the effect is also asked
+   * for the steps half a shutter time before and after in the same cook. These are then returned
+   * when the motion blur evaluates its steps, provided that neither the input mesh nor the
+   * parameters changed in between, instead of cooking again.
+   */
+  Mesh *cook_with_motion_blur(
+      OpenMfxModifierData *fxmd, Mesh *mesh, Object *object, float time, float shutter);
+
+  /**
+   * Apply the effect to the mesh data of each target object, replacing its geometry, with a
+   * single instance whose parameters, quality and identity are only set up once. A small worker
+   * pool copies the next mesh and writes back the previous result while the effect cooks the
+   * current one. Targets sharing a mesh are only cooked once, and objects that are not meshes
+   * are skipped. Returns the number of meshes written.
    */
-  Mesh *cook(OpenMfxModifierData *fxmd, Mesh *mesh, Object *object);
+  int cook_batch(OpenMfxModifierData *fxmd,
+                 Object *object,
+                 blender::Span<Object *> targets,
+                 bool use_render_quality,
+                 float time);
 
   /**
    * Reload the list of effects contaiend in the plugin
@@ -99,6 +138,12 @@ class OpenMfxRuntime {
    */
   void reload_parameters(OpenMfxModifierData *fxmd);
 
+  /**
+   * Rebuild the names, labels and bounds of the parameters from the current effect if they are
+   * missing, as long as the parameters still match the effect. Values are left untouched.
+   */
+  void ensure_parameter_info(OpenMfxModifierData *fxmd);
+
   /**
    * Reload the list of extra inputs of the current effect
    */
@@ -109,6 +154,20 @@ class OpenMfxRuntime {
    */
   void set_input_prop_in_rna(OpenMfxModifierData *fxmd);
 
+  /**
+   * Tells whether the result of the effect depends on the object it is applied to, because it
+   * requests the transform of its main input or reads other objects through extra inputs.
+   * Results that do not may be shared between linked duplicates. The effect instance must be
+   * valid.
+   */
+  bool depends_on_object(OpenMfxModifierData *fxmd);
+
+  /**
+   * Memory used by all the instances of the effect, including the ones cooking islands. Peaks
+   * are the ones of their last cook. Leaves usage to zero when there is no instance.
+   */
+  void get_memory_usage(OfxHostMemoryUsage *usage) const;
+
  public:
   /**
    * Path to the OFX plug-in bundle.
@@ -145,6 +204,12 @@ class OpenMfxRuntime {
    */
   OfxMeshEffectHandle effect_instance;
 
+  /**
+   * Result of the cook cache that the output of the last cook references the layers of, if any
+   * (see mfx_cook_cache_cook())
+   */
+  MfxSharedMesh shared_output;
+
 private:
   /**
    * Get absolute path (ui file browser returns relative path for saved files)
@@ -167,6 +232,44 @@ private:
    */
   void reset_plugin_path();
 
+  /**
+   * Cook asking for the output at several times, the first one being the cook time. Returns the
+   * output at times[0] and stores the other ones in r_other_samples (count - 1 long), leaving
+   * NULL the samples that the effect did not output.
+   */
+  Mesh *cook_samples(OpenMfxModifierData *fxmd,
+                     Mesh *mesh,
+                     Object *object,
+                     bool use_render_quality,
+                     const OfxTime *times,
+                     int count,
+                     Mesh **r_other_samples);
+
+  /**
+   * Cook an effect declaring kOfxMeshEffectPropIslandIndependent by splitting the main input
+   * into a fixed number of groups of connected components, cooking them concurrently on extra
+   * instances of the effect and joining their outputs. When the effect keeps the topology, output
+   * elements are put back in the order of the input. Returns false without cooking when this
+   * is not worth it or not possible (single island, out of process plugin, viewport proxy,
+   * edit-mode input, connected extra inputs), in which case the caller cooks the whole mesh.
+   */
+  bool cook_islands(OpenMfxModifierData *fxmd,
+                    Mesh *mesh,
+                    Object *object,
+                    bool use_render_quality,
+                    OfxTime time,
+                    Mesh **r_output);
+
+  /**
+   * Return and forget the motion blur step cooked for this time, if its input still matches
+   */
+  Mesh *take_motion_sample(const OpenMfxModifierData *fxmd, const Mesh *mesh, float time);
+
+  /**
+   * Free the motion blur steps that have not been used
+   */
+  void free_motion_samples();
+
 private:
   /**
    * Tells whether the plugin specified by plugin_path is valid. If true, then 'registry' can be
@@ -174,5 +277,59 @@ private:
    */
   bool m_is_plugin_valid;
 
+  /**
+   * Whether the plugin was loaded out of process (even if it failed to)
+   */
+  bool m_is_out_of_process;
+
+  /**
+   * Whether effect_desc comes from a preloaded registry, which owns it
+   */
+  bool m_is_descriptor_shared;
+
+#ifdef WITH_OPENMFX_REMOTE
+  /**
+   * Helper process running the plugin when loaded out of process, owning the registry
+   */
+  MfxRemoteHost *m_remote_host;
+#endif
+
   std::map<std::string, OfxParamStruct> m_saved_parameter_values;
+
+  /**
+   * Motion blur steps output by the last cook_with_motion_blur()
+   */
+  struct MotionSample {
+    float time;
+    Mesh *mesh;
+  };
+  std::vector<MotionSample> m_motion_samples;
+
+  /**
+   * Input vertex positions, face and corner counts and parameters the motion blur steps were
+   * cooked from, to check that they are still valid
+   */
+  std::vector<float> m_motion_input_positions;
+  int m_motion_input_totloop;
+  int m_motion_input_totpoly;
+  OpenMfxParameterValue *m_motion_parameters = nullptr;
+  int m_num_motion_parameters = 0;
+
+  /**
+   * Instances of the effect cooking groups of islands next to effect_instance, kept from one
+   * cook to the next (see cook_islands())
+   */
+  std::vector<OfxMeshEffectHandle> m_island_instances;
+
+  /**
+   * Element tables of the main input when it is an edit-mode BMesh, reused while transforming
+   * (NULL until first needed)
+   */
+  MfxBMeshTopology *m_bmesh_topology;
+
+  /**
+   * Subdivision descriptor of the main input, reused by the limit surfaces of the next cooks
+   * while its topology does not change
+   */
+  MfxLimitSurfaceCache *m_limit_surface_cache;
 };
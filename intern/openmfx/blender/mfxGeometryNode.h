@@ -0,0 +1,106 @@
+/**
+ * Open Mesh Effect modifier for Blender
+ * Copyright (C) 2019 - 2021 Elie Michel
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** \file
+ * \ingroup openmesheffect
+ *
+ * Entry points used by the OpenMfx geometry node. Contrary to the modifier,
+ * the node does not own any runtime data: plugins and effect descriptors are
+ * shared by all the nodes that use them and remain loaded for the session.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "../host/mfxParamType.h"
+
+#include "BKE_geometry_set.hh"
+
+#include "BLI_span.hh"
+#include "BLI_vector.hh"
+
+#include "DNA_modifier_types.h"  // OpenMfxParameterValue
+
+struct Object;
+
+/**
+ * Identifiers of the effects contained in the plugin, empty if it could not
+ * be loaded. The path may be relative to the current blend file.
+ */
+blender::Vector<std::string> mfx_GeometryNode_list_effects(const char *plugin_path);
+
+/**
+ * Describe the parameters of an effect: name, label, type, default value and
+ * bounds, using the same structure as the modifier. Returns false if the
+ * effect could not be loaded.
+ */
+bool mfx_GeometryNode_get_parameters(const char *plugin_path,
+                                     int effect_index,
+                                     blender::Vector<OpenMfxParameterValue> &r_parameters);
+
+/**
+ * Free the string values of parameters returned by
+ * mfx_GeometryNode_get_parameters(). Their names, labels and bounds belong to
+ * the plugin cache.
+ */
+void mfx_GeometryNode_free_parameters(blender::Vector<OpenMfxParameterValue> &parameters);
+
+/**
+ * Describe the inputs of an effect other than its main input and output, which
+ * the node exposes as object sockets. Only name and label are filled in.
+ * Returns false if the effect could not be loaded.
+ */
+bool mfx_GeometryNode_get_inputs(const char *plugin_path,
+                                 int effect_index,
+                                 blender::Vector<OpenMfxInput> &r_inputs);
+
+/**
+ * Describe the outputs of an effect other than its main output (see
+ * kOfxInputPropIsOutput), which the node exposes as extra geometry sockets.
+ * Only name and label are filled in. Returns false if the effect could not be
+ * loaded.
+ */
+bool mfx_GeometryNode_get_outputs(const char *plugin_path,
+                                  int effect_index,
+                                  blender::Vector<OpenMfxInput> &r_outputs);
+
+/**
+ * Cook an effect on the mesh component of a geometry set, replacing it with
+ * the output of the effect. Other components are left untouched. When there
+ * is no mesh, the point cloud component is used instead, and an output that
+ * has no face is stored as a point cloud rather than a mesh.
+ * Extra inputs are connected to input_objects, in the order returned by
+ * mfx_GeometryNode_get_inputs(). An output of instances transforms (see
+ * kOfxMeshAttribPointInstanceTransform) is added to the instances component
+ * as instances of these objects and replaces the mesh.
+ * Extra outputs are stored in r_extra_outputs, in the order returned by
+ * mfx_GeometryNode_get_outputs(), and remain empty when the effect does not
+ * fill them. They are all produced by the same cook.
+ * Parameter values are matched with the parameters of the effect by name.
+ * Returns false and sets r_message if the effect could not be cooked.
+ */
+bool mfx_GeometryNode_cook(const char *plugin_path,
+                           int effect_index,
+                           blender::Span<OpenMfxParameterValue> parameters,
+                           blender::Span<Object *> input_objects,
+                           const Object *object,
+                           bool use_render_quality,
+                           GeometrySet &geometry_set,
+                           blender::MutableSpan<GeometrySet> r_extra_outputs,
+                           std::string &r_message);
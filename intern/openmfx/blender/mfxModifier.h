@@ -74,8 +74,60 @@ void mfx_Modifier_free_runtime_data(void *runtime_data);
 
 /**
  * Actually run the modifier, calling the cook action of the plugin
+ * \param use_render_quality false when evaluating for the viewport, in which
+ * case the effect is told to cook a draft and may receive a proxy input.
+ * \param ctime current scene time, used to read and write the bake cache.
+ * \param motion_blur_shutter shutter time of the render motion blur, 0 if it is
+ * disabled. Otherwise the motion blur steps are cooked together with the frame.
  */
-Mesh *mfx_Modifier_do(OpenMfxModifierData *fxmd, Mesh *mesh, Object *object);
+Mesh *mfx_Modifier_do(OpenMfxModifierData *fxmd,
+                      Mesh *mesh,
+                      Object *object,
+                      bool use_render_quality,
+                      float ctime,
+                      float motion_blur_shutter);
+
+/**
+ * Apply the effect of an original modifier, owned by object, to the mesh data
+ * of several other objects at once, replacing their geometry with the result.
+ * Meant for processing many assets with the same settings, from an operator or
+ * a headless tool. Targets must not be in edit mode, and inputs other than the
+ * main one are not connected. A mesh shared by several targets is cooked once.
+ * Returns the number of meshes that were written.
+ */
+int mfx_Modifier_cook_batch(OpenMfxModifierData *fxmd,
+                            Object *object,
+                            Object **targets,
+                            int target_count,
+                            bool use_render_quality,
+                            float ctime);
+
+/**
+ * Memory used by the effect of a modifier, in bytes. Attribute buffers are the
+ * ones allocated to convert meshes from and to the effect, plugin memory is the
+ * one that the plugin allocated through the memory suite. Peaks are measured
+ * during the last cook, of the evaluated modifier since that is the one cooking.
+ */
+typedef struct OpenMfxMemoryUsage {
+  size_t attribute_bytes;
+  size_t attribute_peak_bytes;
+  size_t plugin_bytes;
+  size_t plugin_peak_bytes;
+} OpenMfxMemoryUsage;
+
+void mfx_Modifier_memory_usage(const OpenMfxModifierData *fxmd, OpenMfxMemoryUsage *r_usage);
+
+/**
+ * Memory allocated by all the effects through MEM_guardedalloc, including the
+ * buffers kept for later reuse, in bytes.
+ */
+size_t mfx_Modifier_memory_in_use(void);
+
+/**
+ * Remove the cache files written by a previous bake, so that frames are
+ * cooked again.
+ */
+void mfx_Modifier_free_bake(OpenMfxModifierData *fxmd, Object *object);
 
 /**
  * Copy parameter_info, effect_info.
@@ -84,8 +136,59 @@ Mesh *mfx_Modifier_do(OpenMfxModifierData *fxmd, Mesh *mesh, Object *object);
 void mfx_Modifier_copydata(OpenMfxModifierData *source,
                            OpenMfxModifierData *destination);
 
+/**
+ * Free the values of the parameters and release their shared description.
+ */
+void mfx_Modifier_free_parameters(OpenMfxModifierData *fxmd);
+
 void mfx_Modifier_before_updateDepsgraph(OpenMfxModifierData *fxmd);
 
+/**
+ * Start loading in a background thread the plugins found in the directories
+ * listed in the OPENMFX_PLUGIN_PATH environment variable, so that modifiers
+ * using them do not wait for the plugin to be loaded and described.
+ * Called once at startup.
+ */
+void mfx_Modifier_preload_plugins(void);
+
+/**
+ * Release the plugins preloaded by mfx_Modifier_preload_plugins().
+ * Called once at exit.
+ */
+void mfx_Modifier_free_preloaded_plugins(void);
+
+/**
+ * Set up the cache through which linked duplicates share the result of a
+ * cook, emptied before each depsgraph update, frame change and render.
+ * Called once at startup.
+ */
+void mfx_Modifier_init_cook_cache(void);
+
+/**
+ * Have the host allocate attribute buffers and the memory that plugins ask for
+ * with MEM_guardedalloc, and back out of core buffers with files of the
+ * temporary directory of Blender. Called once at startup, before loading any
+ * plugin.
+ */
+void mfx_Modifier_init_allocator(void);
+
+/**
+ * Have the multi thread suite run effects on the task scheduler of Blender
+ * rather than on threads spawned at each call. Called once at startup.
+ */
+void mfx_Modifier_init_thread_pool(void);
+
+/**
+ * Free the buffers that the host keeps for later reuse. Called once at exit,
+ * after releasing the plugins.
+ */
+void mfx_Modifier_free_memory(void);
+
+/**
+ * Free the results held by the cook cache. Called once at exit.
+ */
+void mfx_Modifier_free_cook_cache(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,104 @@
+/**
+ * Open Mesh Effect modifier for Blender
+ * Copyright (C) 2019 - 2021 Elie Michel
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** \file
+ * \ingroup openmesheffect
+ *
+ * Storage of the parameters listed in OpenMfxModifierData. Each copy of the
+ * modifier owns the values of its parameters, while their names, labels and
+ * bounds live in a reference counted OpenMfxParameterInfoTable shared by all
+ * the copies, so that copy-on-write does not duplicate them.
+ */
+
+#pragma once
+
+#include "DNA_modifier_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Allocate a table describing num_parameters parameters, with a single user.
+ * Bounds are initialized to the full range of their type and strings to NULL.
+ */
+OpenMfxParameterInfoTable *mfx_ParameterInfoTable_new(int num_parameters);
+
+/**
+ * Register a new user of the table, safe to call from several threads.
+ */
+void mfx_ParameterInfoTable_add_user(OpenMfxParameterInfoTable *table);
+
+/**
+ * Unregister a user of the table and free it if it was the last one.
+ * table may be NULL.
+ */
+void mfx_ParameterInfoTable_release(OpenMfxParameterInfoTable *table);
+
+/**
+ * Allocate the values of the parameters of a table, each one pointing to its
+ * info. The table is not given a new user.
+ */
+OpenMfxParameterValue *mfx_Parameters_new(OpenMfxParameterInfoTable *table);
+
+/**
+ * Duplicate an array of parameter values, including their strings.
+ * Infos are shared with the source.
+ */
+OpenMfxParameterValue *mfx_Parameters_dup(const OpenMfxParameterValue *parameters,
+                                          int num_parameters);
+
+/**
+ * Convert parameters read from a file saved before their description was
+ * split from their values. Returns their values and sets r_table to a new
+ * table, with a single user, holding their names, labels and bounds.
+ */
+OpenMfxParameterValue *mfx_Parameters_from_legacy(const OpenMfxParameter *legacy,
+                                                  int num_parameters,
+                                                  OpenMfxParameterInfoTable **r_table);
+
+/**
+ * Free an array of parameter values allocated by mfx_Parameters_new() or
+ * mfx_Parameters_dup(). parameters may be NULL.
+ */
+void mfx_Parameters_free(OpenMfxParameterValue *parameters, int num_parameters);
+
+/**
+ * Description of the parameter, or a description with empty name and label
+ * and unbounded ranges if it is not known, e.g. when loaded from an older file.
+ */
+const OpenMfxParameterInfo *mfx_Parameter_info(const OpenMfxParameterValue *parameter);
+
+/**
+ * Value of a string parameter, never NULL.
+ */
+const char *mfx_Parameter_string_value(const OpenMfxParameterValue *parameter);
+
+/**
+ * Replace the value of a string parameter, freeing it if value is NULL.
+ */
+void mfx_Parameter_set_string_value(OpenMfxParameterValue *parameter, const char *value);
+
+/**
+ * Whether two parameters have the same type and value, regardless of their info.
+ */
+bool mfx_Parameter_values_equal(const OpenMfxParameterValue *a, const OpenMfxParameterValue *b);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,718 @@
+/**
+ * Open Mesh Effect modifier for Blender
+ * Copyright (C) 2019 - 2021 Elie Michel
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** \file
+ * \ingroup openmesheffect
+ *
+ * Round-trip of synthetic Blender meshes through the converter (before_mesh_get() and
+ * before_mesh_release()) and the identity and mirror sample plugins, conversion of the instance
+ * sample plugin output to geometry instances, plus a throughput check
+ * against the baseline in mfx_convert_test_baseline.h. Edit-mode meshes, which are read straight
+ * from their BMesh, must give the same output as the mesh they are built from.
+ */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "mfx_convert_test_baseline.h"
+
+#include "mfxCallbacks.h"
+#include "mfxHost.h"
+#include "mfxPluginRegistry.h"
+#include <mfxHost/mesheffect>
+#include "ofxExtras.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_object_types.h"
+
+#include "BKE_customdata.h"
+#include "BKE_editmesh.h"
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+#include "BKE_mesh_wrapper.h"
+
+#include "BLI_string.h"
+
+#include "BKE_geometry_set.hh"
+
+#include "bmesh.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace blender::openmfx::tests {
+
+#define IDENTITY_PLUGIN FULL_LIBRARY_OUTPUT_PATH "openmfx_identity_plugin.ofx"
+#define MIRROR_PLUGIN FULL_LIBRARY_OUTPUT_PATH "openmfx_mirror_plugin.ofx"
+#define INSTANCE_PLUGIN FULL_LIBRARY_OUTPUT_PATH "openmfx_instance_plugin.ofx"
+
+struct TestMeshSettings {
+  // Faces of the grid, in each direction (0 for no face)
+  int grid_size = 0;
+  // Points that are not used by any face
+  int loose_point_count = 0;
+  // Loose edges, each using two of the loose points
+  int loose_edge_count = 0;
+  int uv_layers = 0;
+  int color_layers = 0;
+};
+
+static int count_loose_edges(const Mesh *mesh)
+{
+  int count = 0;
+  for (int i = 0; i < mesh->totedge; ++i) {
+    if (mesh->medge[i].flag & ME_LOOSEEDGE) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+/**
+ * Build a grid of quads, followed by loose points and loose edges, with deterministic UV and
+ * color values. The mesh must be freed with BKE_id_free().
+ */
+static Mesh *make_test_mesh(const TestMeshSettings &settings)
+{
+  const int n = settings.grid_size;
+  const int grid_vert_count = n > 0 ? (n + 1) * (n + 1) : 0;
+  const int vert_count = grid_vert_count + settings.loose_point_count;
+  const int poly_count = n * n;
+  const int loop_count = 4 * poly_count;
+
+  Mesh *mesh = BKE_mesh_new_nomain(
+      vert_count, settings.loose_edge_count, 0, loop_count, poly_count);
+
+  for (int i = 0; i < grid_vert_count; ++i) {
+    mesh->mvert[i].co[0] = (float)(i % (n + 1)) + 1.0f;
+    mesh->mvert[i].co[1] = (float)(i / (n + 1));
+    mesh->mvert[i].co[2] = 0.1f * (float)(i % 7);
+  }
+  for (int i = grid_vert_count; i < vert_count; ++i) {
+    mesh->mvert[i].co[0] = 0.5f * (float)i + 1.0f;
+    mesh->mvert[i].co[1] = -1.0f;
+    mesh->mvert[i].co[2] = 2.0f;
+  }
+
+  for (int y = 0; y < n; ++y) {
+    for (int x = 0; x < n; ++x) {
+      const int p = y * n + x;
+      const int v = y * (n + 1) + x;
+      mesh->mpoly[p].loopstart = 4 * p;
+      mesh->mpoly[p].totloop = 4;
+      mesh->mloop[4 * p + 0].v = v;
+      mesh->mloop[4 * p + 1].v = v + 1;
+      mesh->mloop[4 * p + 2].v = v + n + 2;
+      mesh->mloop[4 * p + 3].v = v + n + 1;
+    }
+  }
+
+  for (int i = 0; i < settings.loose_edge_count; ++i) {
+    mesh->medge[i].v1 = grid_vert_count + (2 * i) % settings.loose_point_count;
+    mesh->medge[i].v2 = grid_vert_count + (2 * i + 1) % settings.loose_point_count;
+    mesh->medge[i].flag = ME_LOOSEEDGE | ME_EDGEDRAW;
+  }
+  if (poly_count > 0) {
+    BKE_mesh_calc_edges(mesh, true, false);
+  }
+
+  char name[MAX_CUSTOMDATA_LAYER_NAME];
+  for (int k = 0; k < settings.uv_layers; ++k) {
+    BLI_snprintf(name, sizeof(name), "UVMap.%03d", k);
+    MLoopUV *uv = (MLoopUV *)CustomData_add_layer_named(
+        &mesh->ldata, CD_MLOOPUV, CD_CALLOC, NULL, loop_count, name);
+    for (int i = 0; i < loop_count; ++i) {
+      uv[i].uv[0] = (float)(i % 5) * 0.25f + (float)k;
+      uv[i].uv[1] = (float)(i % 3) * 0.5f;
+    }
+  }
+  for (int k = 0; k < settings.color_layers; ++k) {
+    BLI_snprintf(name, sizeof(name), "Col.%03d", k);
+    MLoopCol *color = (MLoopCol *)CustomData_add_layer_named(
+        &mesh->ldata, CD_MLOOPCOL, CD_CALLOC, NULL, loop_count, name);
+    for (int i = 0; i < loop_count; ++i) {
+      color[i].r = (unsigned char)(i % 256);
+      color[i].g = (unsigned char)((17 * k) % 256);
+      color[i].b = (unsigned char)((3 * i) % 256);
+      color[i].a = 255;
+    }
+  }
+
+  return mesh;
+}
+
+/**
+ * Plugin loaded through the host API, the same way mfxRuntime does, with the converter
+ * callbacks installed on the global host.
+ */
+class MfxConverterTest : public testing::Test {
+ protected:
+  static void SetUpTestCase()
+  {
+    BKE_idtype_init();
+  }
+
+  void SetUp() override
+  {
+    m_host = getGlobalHost();
+    OfxPropertySuiteV1 *propertySuite = (OfxPropertySuiteV1 *)m_host->fetchSuite(
+        m_host->host, kOfxPropertySuite, 1);
+    propertySuite->propSetPointer(
+        m_host->host, kOfxHostPropBeforeMeshGetCb, 0, (void *)before_mesh_get);
+    propertySuite->propSetPointer(
+        m_host->host, kOfxHostPropBeforeMeshReleaseCb, 0, (void *)before_mesh_release);
+    propertySuite->propSetPointer(
+        m_host->host, kOfxHostPropBeforeMeshAllocCb, 0, (void *)before_mesh_alloc);
+
+    IDType_ID_OB.init_data(&m_object.id);
+    m_object.type = OB_MESH;
+  }
+
+  void TearDown() override
+  {
+    unload();
+    IDType_ID_OB.free_data(&m_object.id);
+    releaseGlobalHost();
+  }
+
+  bool load(const char *plugin_path)
+  {
+    if (!load_registry(&m_registry, plugin_path)) {
+      return false;
+    }
+    m_is_loaded = true;
+    describe_registry(&m_registry, m_host);
+    if (m_registry.num_plugins < 1 || NULL == m_registry.descriptors[0]) {
+      return false;
+    }
+    return ofxhost_create_instance(
+        m_registry.plugins[0], m_registry.descriptors[0], &m_instance);
+  }
+
+  void unload()
+  {
+    if (NULL != m_instance) {
+      ofxhost_destroy_instance(m_registry.plugins[0], m_instance);
+      m_instance = NULL;
+    }
+    if (m_is_loaded) {
+      free_registry(&m_registry);
+      m_is_loaded = false;
+    }
+  }
+
+  /**
+   * Parameter values are otherwise copied from RNA by mfxRuntime
+   */
+  void set_int_parameter(const char *name, int value)
+  {
+    OfxMeshEffectSuiteV1 *meshEffectSuite = (OfxMeshEffectSuiteV1 *)m_host->fetchSuite(
+        m_host->host, kOfxMeshEffectSuite, 1);
+    OfxParameterSuiteV1 *parameterSuite = (OfxParameterSuiteV1 *)m_host->fetchSuite(
+        m_host->host, kOfxParameterSuite, 1);
+    OfxParamSetHandle parameters;
+    OfxParamHandle param;
+    meshEffectSuite->getParamSet(m_instance, &parameters);
+    ASSERT_EQ(parameterSuite->paramGetHandle(parameters, name, &param, NULL), kOfxStatOK);
+    parameterSuite->paramSetValue(param, value);
+  }
+
+  /**
+   * Cook the loaded effect on a mesh, returning the converted output (or NULL). When
+   * instances_target is set, outputs made of instances are added to it rather than converted to
+   * a mesh, instancing m_object.
+   */
+  Mesh *cook(Mesh *mesh, GeometrySet *instances_target = nullptr)
+  {
+    OfxMeshEffectSuiteV1 *meshEffectSuite = (OfxMeshEffectSuiteV1 *)m_host->fetchSuite(
+        m_host->host, kOfxMeshEffectSuite, 1);
+    OfxPropertySuiteV1 *propertySuite = (OfxPropertySuiteV1 *)m_host->fetchSuite(
+        m_host->host, kOfxPropertySuite, 1);
+
+    OfxMeshInputHandle input, output;
+    meshEffectSuite->inputGetHandle(m_instance, kOfxMeshMainInput, &input, NULL);
+    meshEffectSuite->inputGetHandle(m_instance, kOfxMeshMainOutput, &output, NULL);
+
+    MeshInternalData input_data = {};
+    input_data.is_input = true;
+    input_data.blender_mesh = mesh;
+    input_data.object = &m_object;
+    input_data.requested_attributes = &input->requested_attributes;
+    propertySuite->propSetPointer(
+        &input->mesh.properties, kOfxMeshPropInternalData, 0, (void *)&input_data);
+
+    MeshInternalData output_data = {};
+    output_data.is_input = false;
+    output_data.source_mesh = mesh;
+    output_data.object = &m_object;
+    Object *instance_sources[] = {&m_object};
+    if (nullptr != instances_target) {
+      output_data.instances_target = instances_target;
+      output_data.instance_sources = instance_sources;
+      output_data.instance_source_count = 1;
+    }
+    propertySuite->propSetPointer(
+        &output->mesh.properties, kOfxMeshPropInternalData, 0, (void *)&output_data);
+
+    bool ok = ofxhost_cook(m_registry.plugins[0], m_instance);
+    free_preallocated_mesh(output_data);
+
+    propertySuite->propSetPointer(&input->mesh.properties, kOfxMeshPropInternalData, 0, NULL);
+    propertySuite->propSetPointer(&output->mesh.properties, kOfxMeshPropInternalData, 0, NULL);
+
+    if (!ok && NULL != output_data.blender_mesh) {
+      BKE_id_free(NULL, output_data.blender_mesh);
+      return NULL;
+    }
+    return output_data.blender_mesh;
+  }
+
+  /**
+   * Cook the edit-mode wrapper of a BMesh built from the mesh, as the modifier stack gives it to
+   * modifiers accepting BMesh inputs.
+   */
+  Mesh *cook_edit_mesh(Mesh *mesh)
+  {
+    BMeshCreateParams create_params = {0};
+    BMeshFromMeshParams from_mesh_params = {0};
+    BMesh *bm = BKE_mesh_to_bmesh_ex(mesh, &create_params, &from_mesh_params);
+    BMEditMesh *em = BKE_editmesh_create(bm, false);
+    Mesh *wrapper = BKE_mesh_wrapper_from_editmesh(em, NULL, mesh);
+
+    Mesh *output = cook(wrapper);
+
+    BKE_id_free(NULL, wrapper);
+    BKE_editmesh_free(em);
+    MEM_freeN(em);
+    return output;
+  }
+
+  /**
+   * Measure the throughput of cooks, in elements (points, corners and faces of both the input
+   * and the output) per second, and compare the best run with the baseline. Timings are only
+   * checked in optimized builds.
+   */
+  void check_throughput(const char *label, Mesh *mesh, double baseline)
+  {
+    double best_rate = 0.0;
+    for (int run = 0; run < MFX_CONVERT_BENCHMARK_RUNS; ++run) {
+      auto start = std::chrono::steady_clock::now();
+      Mesh *output = cook(mesh);
+      auto end = std::chrono::steady_clock::now();
+      ASSERT_NE(output, nullptr);
+      double seconds = std::chrono::duration<double>(end - start).count();
+      double elements = (double)mesh->totvert + mesh->totloop + mesh->totpoly + output->totvert +
+                        output->totloop + output->totpoly;
+      best_rate = std::max(best_rate, elements / std::max(seconds, 1e-9));
+      BKE_id_free(NULL, output);
+    }
+
+    printf("OpenMfx %s round-trip: %.2f M elements/s (baseline %.2f M elements/s)\n",
+           label,
+           best_rate * 1e-6,
+           baseline * 1e-6);
+#ifdef NDEBUG
+    EXPECT_GE(best_rate, baseline / MFX_CONVERT_BASELINE_TOLERANCE);
+#else
+    (void)baseline;
+#endif
+  }
+
+  OfxHost *m_host = NULL;
+  Object m_object = {{nullptr}};
+  PluginRegistry m_registry;
+  bool m_is_loaded = false;
+  OfxMeshEffectHandle m_instance = NULL;
+};
+
+static void expect_same_topology(const Mesh *expected, const Mesh *actual)
+{
+  ASSERT_EQ(expected->totvert, actual->totvert);
+  ASSERT_EQ(expected->totpoly, actual->totpoly);
+  ASSERT_EQ(expected->totloop, actual->totloop);
+  EXPECT_EQ(expected->totedge, actual->totedge);
+  EXPECT_EQ(count_loose_edges(expected), count_loose_edges(actual));
+
+  for (int i = 0; i < expected->totvert; ++i) {
+    EXPECT_EQ(expected->mvert[i].co[0], actual->mvert[i].co[0]);
+    EXPECT_EQ(expected->mvert[i].co[1], actual->mvert[i].co[1]);
+    EXPECT_EQ(expected->mvert[i].co[2], actual->mvert[i].co[2]);
+  }
+  for (int i = 0; i < expected->totpoly; ++i) {
+    EXPECT_EQ(expected->mpoly[i].loopstart, actual->mpoly[i].loopstart);
+    EXPECT_EQ(expected->mpoly[i].totloop, actual->mpoly[i].totloop);
+  }
+  for (int i = 0; i < expected->totloop; ++i) {
+    EXPECT_EQ(expected->mloop[i].v, actual->mloop[i].v);
+  }
+}
+
+static void expect_same_layers(const Mesh *expected, const Mesh *actual)
+{
+  const int uv_layers = CustomData_number_of_layers(&expected->ldata, CD_MLOOPUV);
+  ASSERT_EQ(uv_layers, CustomData_number_of_layers(&actual->ldata, CD_MLOOPUV));
+  for (int k = 0; k < uv_layers; ++k) {
+    const MLoopUV *a = (const MLoopUV *)CustomData_get_layer_n(&expected->ldata, CD_MLOOPUV, k);
+    const MLoopUV *b = (const MLoopUV *)CustomData_get_layer_n(&actual->ldata, CD_MLOOPUV, k);
+    for (int i = 0; i < expected->totloop; ++i) {
+      EXPECT_EQ(a[i].uv[0], b[i].uv[0]);
+      EXPECT_EQ(a[i].uv[1], b[i].uv[1]);
+    }
+  }
+
+  const int color_layers = CustomData_number_of_layers(&expected->ldata, CD_MLOOPCOL);
+  ASSERT_EQ(color_layers, CustomData_number_of_layers(&actual->ldata, CD_MLOOPCOL));
+  for (int k = 0; k < color_layers; ++k) {
+    const MLoopCol *a = (const MLoopCol *)CustomData_get_layer_n(
+        &expected->ldata, CD_MLOOPCOL, k);
+    const MLoopCol *b = (const MLoopCol *)CustomData_get_layer_n(&actual->ldata, CD_MLOOPCOL, k);
+    for (int i = 0; i < expected->totloop; ++i) {
+      EXPECT_EQ(a[i].r, b[i].r);
+      EXPECT_EQ(a[i].g, b[i].g);
+      EXPECT_EQ(a[i].b, b[i].b);
+    }
+  }
+}
+
+/**
+ * The mirror plugin appends a copy of the mesh flipped along X, when its axis parameter is 1
+ */
+static void expect_mirrored(const Mesh *input, const Mesh *output)
+{
+  ASSERT_EQ(2 * input->totvert, output->totvert);
+  ASSERT_EQ(2 * input->totpoly, output->totpoly);
+  ASSERT_EQ(2 * input->totloop, output->totloop);
+  EXPECT_EQ(2 * count_loose_edges(input), count_loose_edges(output));
+
+  for (int i = 0; i < input->totvert; ++i) {
+    const float *co = input->mvert[i].co;
+    const float *mirror_co = output->mvert[input->totvert + i].co;
+    EXPECT_EQ(co[0], output->mvert[i].co[0]);
+    EXPECT_EQ(-co[0], mirror_co[0]);
+    EXPECT_EQ(co[1], mirror_co[1]);
+    EXPECT_EQ(co[2], mirror_co[2]);
+  }
+  for (int i = 0; i < input->totloop; ++i) {
+    EXPECT_EQ(input->mloop[i].v, output->mloop[i].v);
+    EXPECT_EQ(input->mloop[i].v + input->totvert, output->mloop[input->totloop + i].v);
+  }
+}
+
+TEST_F(MfxConverterTest, IdentityPolygons)
+{
+  ASSERT_TRUE(load(IDENTITY_PLUGIN));
+  TestMeshSettings settings;
+  settings.grid_size = 8;
+  Mesh *mesh = make_test_mesh(settings);
+  Mesh *output = cook(mesh);
+  ASSERT_NE(output, nullptr);
+  expect_same_topology(mesh, output);
+  BKE_id_free(NULL, output);
+  BKE_id_free(NULL, mesh);
+}
+
+TEST_F(MfxConverterTest, IdentityLooseEdges)
+{
+  ASSERT_TRUE(load(IDENTITY_PLUGIN));
+  TestMeshSettings settings;
+  settings.grid_size = 4;
+  settings.loose_point_count = 6;
+  settings.loose_edge_count = 3;
+  Mesh *mesh = make_test_mesh(settings);
+  Mesh *output = cook(mesh);
+  ASSERT_NE(output, nullptr);
+  expect_same_topology(mesh, output);
+  BKE_id_free(NULL, output);
+  BKE_id_free(NULL, mesh);
+}
+
+TEST_F(MfxConverterTest, IdentityWireframe)
+{
+  ASSERT_TRUE(load(IDENTITY_PLUGIN));
+  TestMeshSettings settings;
+  settings.loose_point_count = 10;
+  settings.loose_edge_count = 5;
+  Mesh *mesh = make_test_mesh(settings);
+  Mesh *output = cook(mesh);
+  ASSERT_NE(output, nullptr);
+  expect_same_topology(mesh, output);
+  BKE_id_free(NULL, output);
+  BKE_id_free(NULL, mesh);
+}
+
+TEST_F(MfxConverterTest, IdentityLayers)
+{
+  ASSERT_TRUE(load(IDENTITY_PLUGIN));
+  TestMeshSettings settings;
+  settings.grid_size = 6;
+  settings.uv_layers = 2;
+  settings.color_layers = 2;
+  Mesh *mesh = make_test_mesh(settings);
+  Mesh *output = cook(mesh);
+  ASSERT_NE(output, nullptr);
+  expect_same_topology(mesh, output);
+  expect_same_layers(mesh, output);
+  BKE_id_free(NULL, output);
+  BKE_id_free(NULL, mesh);
+}
+
+TEST_F(MfxConverterTest, IdentityLayersWithLooseEdges)
+{
+  ASSERT_TRUE(load(IDENTITY_PLUGIN));
+  TestMeshSettings settings;
+  settings.grid_size = 3;
+  settings.loose_point_count = 4;
+  settings.loose_edge_count = 2;
+  settings.uv_layers = 2;
+  settings.color_layers = 1;
+  Mesh *mesh = make_test_mesh(settings);
+  Mesh *output = cook(mesh);
+  ASSERT_NE(output, nullptr);
+  expect_same_topology(mesh, output);
+  expect_same_layers(mesh, output);
+  BKE_id_free(NULL, output);
+  BKE_id_free(NULL, mesh);
+}
+
+/**
+ * Edge layers are forwarded to the corners starting each edge, so they must not be shared with
+ * the effect as is even when there is no loose edge.
+ */
+TEST_F(MfxConverterTest, EdgeAttributeWithoutLooseEdges)
+{
+  ASSERT_TRUE(load(IDENTITY_PLUGIN));
+  TestMeshSettings settings;
+  settings.grid_size = 4;
+  Mesh *mesh = make_test_mesh(settings);
+  float *weights = (float *)CustomData_add_layer_named(
+      &mesh->edata, CD_PROP_FLOAT, CD_CALLOC, NULL, mesh->totedge, "edge_weight");
+  for (int i = 0; i < mesh->totedge; ++i) {
+    weights[i] = 0.5f * (float)i;
+  }
+
+  OfxMeshEffectSuiteV1 *meshEffectSuite = (OfxMeshEffectSuiteV1 *)m_host->fetchSuite(
+      m_host->host, kOfxMeshEffectSuite, 1);
+  OfxPropertySuiteV1 *propertySuite = (OfxPropertySuiteV1 *)m_host->fetchSuite(
+      m_host->host, kOfxPropertySuite, 1);
+
+  OfxMeshInputHandle input;
+  meshEffectSuite->inputGetHandle(m_instance, kOfxMeshMainInput, &input, NULL);
+  MeshInternalData input_data = {};
+  input_data.is_input = true;
+  input_data.blender_mesh = mesh;
+  input_data.object = &m_object;
+  input_data.requested_attributes = &input->requested_attributes;
+  propertySuite->propSetPointer(
+      &input->mesh.properties, kOfxMeshPropInternalData, 0, (void *)&input_data);
+
+  OfxMeshHandle ofx_mesh;
+  OfxPropertySetHandle mesh_props, attrib;
+  ASSERT_EQ(meshEffectSuite->inputGetMesh(input, 0.0, &ofx_mesh, &mesh_props), kOfxStatOK);
+  int corner_count = 0, stride = 0;
+  char *data = NULL;
+  propertySuite->propGetInt(mesh_props, kOfxMeshPropCornerCount, 0, &corner_count);
+  EXPECT_EQ(corner_count, mesh->totloop);
+  ASSERT_EQ(
+      meshEffectSuite->meshGetAttribute(ofx_mesh, kOfxMeshAttribCorner, "edge_weight", &attrib),
+      kOfxStatOK);
+  propertySuite->propGetPointer(attrib, kOfxMeshAttribPropData, 0, (void **)&data);
+  propertySuite->propGetInt(attrib, kOfxMeshAttribPropStride, 0, &stride);
+  ASSERT_NE(data, nullptr);
+  EXPECT_NE(data, (char *)weights);
+  for (int i = 0; i < corner_count; ++i) {
+    EXPECT_EQ(*(float *)(data + (size_t)i * stride), weights[mesh->mloop[i].e]);
+  }
+
+  meshEffectSuite->inputReleaseMesh(ofx_mesh);
+  propertySuite->propSetPointer(&input->mesh.properties, kOfxMeshPropInternalData, 0, NULL);
+  BKE_id_free(NULL, mesh);
+}
+
+TEST_F(MfxConverterTest, IdentityNoFace)
+{
+  ASSERT_TRUE(load(IDENTITY_PLUGIN));
+  TestMeshSettings settings;
+  settings.loose_point_count = 12;
+  Mesh *mesh = make_test_mesh(settings);
+  Mesh *output = cook(mesh);
+  ASSERT_NE(output, nullptr);
+  expect_same_topology(mesh, output);
+  BKE_id_free(NULL, output);
+  BKE_id_free(NULL, mesh);
+}
+
+TEST_F(MfxConverterTest, IdentityEditMesh)
+{
+  ASSERT_TRUE(load(IDENTITY_PLUGIN));
+  TestMeshSettings settings;
+  settings.grid_size = 6;
+  settings.uv_layers = 1;
+  settings.color_layers = 1;
+  Mesh *mesh = make_test_mesh(settings);
+  Mesh *output = cook_edit_mesh(mesh);
+  ASSERT_NE(output, nullptr);
+  expect_same_topology(mesh, output);
+  BKE_id_free(NULL, output);
+  BKE_id_free(NULL, mesh);
+}
+
+TEST_F(MfxConverterTest, IdentityEditMeshLooseEdges)
+{
+  ASSERT_TRUE(load(IDENTITY_PLUGIN));
+  TestMeshSettings settings;
+  settings.grid_size = 4;
+  settings.loose_point_count = 6;
+  settings.loose_edge_count = 3;
+  Mesh *mesh = make_test_mesh(settings);
+  Mesh *output = cook_edit_mesh(mesh);
+  ASSERT_NE(output, nullptr);
+  expect_same_topology(mesh, output);
+  BKE_id_free(NULL, output);
+  BKE_id_free(NULL, mesh);
+}
+
+TEST_F(MfxConverterTest, IdentityEditMeshWireframe)
+{
+  ASSERT_TRUE(load(IDENTITY_PLUGIN));
+  TestMeshSettings settings;
+  settings.loose_point_count = 10;
+  settings.loose_edge_count = 5;
+  Mesh *mesh = make_test_mesh(settings);
+  Mesh *output = cook_edit_mesh(mesh);
+  ASSERT_NE(output, nullptr);
+  expect_same_topology(mesh, output);
+  BKE_id_free(NULL, output);
+  BKE_id_free(NULL, mesh);
+}
+
+TEST_F(MfxConverterTest, MirrorPolygons)
+{
+  ASSERT_TRUE(load(MIRROR_PLUGIN));
+  set_int_parameter("axis", 1);
+  TestMeshSettings settings;
+  settings.grid_size = 8;
+  settings.uv_layers = 1;
+  Mesh *mesh = make_test_mesh(settings);
+  Mesh *output = cook(mesh);
+  ASSERT_NE(output, nullptr);
+  expect_mirrored(mesh, output);
+  BKE_id_free(NULL, output);
+  BKE_id_free(NULL, mesh);
+}
+
+TEST_F(MfxConverterTest, MirrorLooseEdges)
+{
+  ASSERT_TRUE(load(MIRROR_PLUGIN));
+  set_int_parameter("axis", 1);
+  TestMeshSettings settings;
+  settings.grid_size = 4;
+  settings.loose_point_count = 6;
+  settings.loose_edge_count = 3;
+  Mesh *mesh = make_test_mesh(settings);
+  Mesh *output = cook(mesh);
+  ASSERT_NE(output, nullptr);
+  expect_mirrored(mesh, output);
+  BKE_id_free(NULL, output);
+  BKE_id_free(NULL, mesh);
+}
+
+TEST_F(MfxConverterTest, MirrorWireframe)
+{
+  ASSERT_TRUE(load(MIRROR_PLUGIN));
+  set_int_parameter("axis", 1);
+  TestMeshSettings settings;
+  settings.loose_point_count = 10;
+  settings.loose_edge_count = 5;
+  Mesh *mesh = make_test_mesh(settings);
+  Mesh *output = cook(mesh);
+  ASSERT_NE(output, nullptr);
+  expect_mirrored(mesh, output);
+  BKE_id_free(NULL, output);
+  BKE_id_free(NULL, mesh);
+}
+
+TEST_F(MfxConverterTest, MirrorNoFace)
+{
+  ASSERT_TRUE(load(MIRROR_PLUGIN));
+  set_int_parameter("axis", 1);
+  TestMeshSettings settings;
+  settings.loose_point_count = 12;
+  Mesh *mesh = make_test_mesh(settings);
+  Mesh *output = cook(mesh);
+  ASSERT_NE(output, nullptr);
+  expect_mirrored(mesh, output);
+  BKE_id_free(NULL, output);
+  BKE_id_free(NULL, mesh);
+}
+
+TEST_F(MfxConverterTest, InstancesOnPoints)
+{
+  ASSERT_TRUE(load(INSTANCE_PLUGIN));
+  TestMeshSettings settings;
+  settings.grid_size = 2;
+  Mesh *mesh = make_test_mesh(settings);
+  GeometrySet geometry_set;
+  Mesh *output = cook(mesh, &geometry_set);
+  EXPECT_EQ(output, nullptr);
+
+  ASSERT_TRUE(geometry_set.has<InstancesComponent>());
+  const InstancesComponent &instances = *geometry_set.get_component_for_read<InstancesComponent>();
+  ASSERT_EQ(instances.instances_amount(), mesh->totvert);
+  for (int i = 0; i < mesh->totvert; ++i) {
+    const InstancedData &data = instances.instanced_data()[i];
+    EXPECT_EQ(data.type, INSTANCE_DATA_TYPE_OBJECT);
+    EXPECT_EQ(data.data.object, &m_object);
+    // Blender matrices are column major, the translation is in the last column
+    const blender::float4x4 &transform = instances.transforms()[i];
+    EXPECT_EQ(transform.values[3][0], mesh->mvert[i].co[0]);
+    EXPECT_EQ(transform.values[3][1], mesh->mvert[i].co[1]);
+    EXPECT_EQ(transform.values[3][2], mesh->mvert[i].co[2]);
+    EXPECT_EQ(transform.values[0][0], 1.0f);
+    EXPECT_EQ(transform.values[0][3], 0.0f);
+  }
+  BKE_id_free(NULL, mesh);
+}
+
+TEST_F(MfxConverterTest, IdentityThroughput)
+{
+  ASSERT_TRUE(load(IDENTITY_PLUGIN));
+  TestMeshSettings settings;
+  settings.grid_size = MFX_CONVERT_BENCHMARK_GRID_SIZE;
+  settings.uv_layers = 2;
+  settings.color_layers = 1;
+  Mesh *mesh = make_test_mesh(settings);
+  check_throughput("identity", mesh, MFX_CONVERT_BASELINE_IDENTITY);
+  BKE_id_free(NULL, mesh);
+}
+
+TEST_F(MfxConverterTest, MirrorThroughput)
+{
+  ASSERT_TRUE(load(MIRROR_PLUGIN));
+  set_int_parameter("axis", 1);
+  TestMeshSettings settings;
+  settings.grid_size = MFX_CONVERT_BENCHMARK_GRID_SIZE;
+  Mesh *mesh = make_test_mesh(settings);
+  check_throughput("mirror", mesh, MFX_CONVERT_BASELINE_MIRROR);
+  BKE_id_free(NULL, mesh);
+}
+
+}  // namespace blender::openmfx::tests
@@ -0,0 +1,40 @@
+/**
+ * Open Mesh Effect modifier for Blender
+ * Copyright (C) 2019 - 2021 Elie Michel
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** \file
+ * \ingroup openmesheffect
+ *
+ * Throughput baseline of the converter round-trip tests, in elements (points,
+ * corners and faces of both the input and the output) per second, for an
+ * optimized build. When landing a converter optimization, raise the values to
+ * what the change achieves so that later regressions get noticed.
+ */
+
+#pragma once
+
+// Faces of the benchmark grid in each direction
+#define MFX_CONVERT_BENCHMARK_GRID_SIZE 512
+
+// The best of these runs is compared to the baseline
+#define MFX_CONVERT_BENCHMARK_RUNS 3
+
+// Tests fail when the throughput drops below the baseline divided by this
+#define MFX_CONVERT_BASELINE_TOLERANCE 2.0
+
+#define MFX_CONVERT_BASELINE_IDENTITY 4.0e6
+#define MFX_CONVERT_BASELINE_MIRROR 4.0e6
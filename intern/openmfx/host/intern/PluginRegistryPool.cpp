@@ -15,19 +15,33 @@
  */
 
 #include "PluginRegistryPool.h"
+#include "mfxHost.h"
+
+#include "util/path_util.h"
 
 #include <assert.h>
+#include <stdio.h>
 #include <string.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#else // _WIN32
+#include <dirent.h>
+#include <sys/stat.h>
+#endif // _WIN32
+
 // // PluginRegistryPoolEntry
 
 PluginRegistryPoolEntry::PluginRegistryPoolEntry(const char *filename)
 {
-  m_is_valid = load_registry(&m_registry, filename);
+  memset(&m_registry, 0, sizeof(PluginRegistry));
+  m_is_valid = false;
+  m_is_loading = true;
   size_t len = strlen(filename);
   m_filename = new char[len + 1];
   strncpy(m_filename, filename, len + 1);
   m_count = 0;
+  m_next = NULL;
 }
 
 PluginRegistryPoolEntry::~PluginRegistryPoolEntry()
@@ -65,6 +79,21 @@ bool PluginRegistryPoolEntry::isValid() const
   return m_is_valid;
 }
 
+void PluginRegistryPoolEntry::load()
+{
+  m_is_valid = load_registry(&m_registry, m_filename);
+}
+
+void PluginRegistryPoolEntry::setLoaded()
+{
+  m_is_loading = false;
+}
+
+bool PluginRegistryPoolEntry::isLoading() const
+{
+  return m_is_loading;
+}
+
 void PluginRegistryPoolEntry::incrementReferences()
 {
   ++m_count;
@@ -91,10 +120,17 @@ PluginRegistryPool &PluginRegistryPool::getInstance()
 PluginRegistryPool::PluginRegistryPool()
 {
   m_first_entry = NULL;
+  m_cancel_preload = false;
+  m_preload_host = NULL;
 }
 
 PluginRegistryPool::~PluginRegistryPool()
 {
+  if (m_preload_thread.joinable()) {
+    m_cancel_preload = true;
+    m_preload_thread.join();
+  }
+
   PluginRegistryPoolEntry *it = m_first_entry;
   PluginRegistryPoolEntry *next_it;
   while (NULL != it) {
@@ -119,7 +155,7 @@ PluginRegistryPoolEntry *PluginRegistryPool::find(const char *filename) const
 
 PluginRegistryPoolEntry *PluginRegistryPool::add(const char *filename)
 {
-  // Create and init entry
+  // Create entry, which is still to be loaded
   PluginRegistryPoolEntry *entry = new PluginRegistryPoolEntry(filename);
 
   // Insert at head
@@ -147,3 +183,188 @@ void PluginRegistryPool::remove(PluginRegistryPoolEntry *entry)
 
   delete entry;
 }
+
+std::mutex &PluginRegistryPool::mutex()
+{
+  return m_mutex;
+}
+
+PluginRegistryPoolEntry *PluginRegistryPool::acquire(const char *filename,
+                                                     std::unique_lock<std::mutex> &lock,
+                                                     OfxHost *describe_host)
+{
+  PluginRegistryPoolEntry *entry = find(filename);
+
+  if (NULL == entry) {
+    // Insert a placeholder, referenced so that it cannot be removed meanwhile
+    entry = add(filename);
+    entry->incrementReferences();
+    lock.unlock();
+    entry->load();
+    if (entry->isValid() && NULL != describe_host) {
+      describe_registry(&entry->registry(), describe_host);
+    }
+    lock.lock();
+    entry->setLoaded();
+    m_loaded.notify_all();
+  }
+  else {
+    entry->incrementReferences();
+    m_loaded.wait(lock, [entry]() { return !entry->isLoading(); });
+  }
+
+  return entry;
+}
+
+void PluginRegistryPool::preload(const char *search_path)
+{
+  if (m_preload_thread.joinable()) {
+    printf("[preload] Plugins are already being preloaded\n");
+    return;
+  }
+
+  // The global host is not thread safe, so it is acquired from the calling thread
+  if (NULL == m_preload_host) {
+    m_preload_host = getGlobalHost();
+  }
+
+  std::vector<std::string> directories;
+  const char *begin = search_path;
+  while ('\0' != *begin) {
+    const char *end = strchr(begin, PATH_LIST_SEP);
+    size_t length = NULL != end ? end - begin : strlen(begin);
+    if (length > 0) {
+      directories.emplace_back(begin, length);
+    }
+    begin += NULL != end ? length + 1 : length;
+  }
+
+  m_cancel_preload = false;
+  m_preload_thread = std::thread([this, directories]() {
+    for (const std::string &directory : directories) {
+      preloadDirectory(directory);
+    }
+    printf("[preload] Done preloading plugins\n");
+  });
+}
+
+void PluginRegistryPool::releasePreloaded()
+{
+  if (m_preload_thread.joinable()) {
+    m_cancel_preload = true;
+    m_preload_thread.join();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const std::string &filename : m_preloaded_filenames) {
+      PluginRegistryPoolEntry *entry = find(filename.c_str());
+      if (NULL == entry) {
+        continue;
+      }
+      entry->decrementReferences();
+      if (false == entry->isReferenced()) {
+        remove(entry);
+      }
+    }
+    m_preloaded_filenames.clear();
+  }
+
+  if (NULL != m_preload_host) {
+    releaseGlobalHost();
+    m_preload_host = NULL;
+  }
+}
+
+static bool has_ofx_extension(const char *name)
+{
+  size_t len = strlen(name);
+  return len > 4 && 0 == strcmp(name + len - 4, ".ofx");
+}
+
+void PluginRegistryPool::preloadDirectory(const std::string &directory)
+{
+  // Sub-directories are walked once the directory handle is closed, and
+  // symbolic links to directories are not followed, so that loops cannot occur
+  std::vector<std::string> subdirectories;
+
+#ifdef _WIN32
+  WIN32_FIND_DATAA data;
+  HANDLE handle = FindFirstFileA((directory + PATH_DIR_SEP + "*").c_str(), &data);
+  if (INVALID_HANDLE_VALUE == handle) {
+    printf("[preload] Could not read plugin directory %s\n", directory.c_str());
+    return;
+  }
+  do {
+    if (0 == strcmp(data.cFileName, ".") || 0 == strcmp(data.cFileName, "..")) {
+      continue;
+    }
+    std::string path = directory + PATH_DIR_SEP + data.cFileName;
+    if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+      if (0 == (data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT)) {
+        subdirectories.push_back(path);
+      }
+    }
+    else if (has_ofx_extension(data.cFileName)) {
+      preloadFile(path);
+    }
+  } while (!m_cancel_preload && FindNextFileA(handle, &data));
+  FindClose(handle);
+#else // _WIN32
+  DIR *dir = opendir(directory.c_str());
+  if (NULL == dir) {
+    printf("[preload] Could not read plugin directory %s\n", directory.c_str());
+    return;
+  }
+  struct dirent *dir_entry;
+  while (!m_cancel_preload && NULL != (dir_entry = readdir(dir))) {
+    if (0 == strcmp(dir_entry->d_name, ".") || 0 == strcmp(dir_entry->d_name, "..")) {
+      continue;
+    }
+    std::string path = directory + PATH_DIR_SEP + dir_entry->d_name;
+    struct stat st;
+    if (0 != lstat(path.c_str(), &st)) {
+      continue;
+    }
+    if (S_ISDIR(st.st_mode)) {
+      subdirectories.push_back(path);
+    }
+    else if (has_ofx_extension(dir_entry->d_name)) {
+      // Links to plugin files are followed
+      if (S_ISREG(st.st_mode) || (0 == stat(path.c_str(), &st) && S_ISREG(st.st_mode))) {
+        preloadFile(path);
+      }
+    }
+  }
+  closedir(dir);
+#endif // _WIN32
+
+  for (const std::string &subdirectory : subdirectories) {
+    if (m_cancel_preload) {
+      return;
+    }
+    preloadDirectory(subdirectory);
+  }
+}
+
+void PluginRegistryPool::preloadFile(const std::string &filename)
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  // Registries already in use are left untouched, as their plugins may be loaded
+  if (NULL != find(filename.c_str())) {
+    return;
+  }
+
+  printf("[preload] Preloading plugins from %s\n", filename.c_str());
+  PluginRegistryPoolEntry *entry = acquire(filename.c_str(), lock, m_preload_host);
+  if (false == entry->isValid()) {
+    entry->decrementReferences();
+    if (false == entry->isReferenced()) {
+      remove(entry);
+    }
+    return;
+  }
+
+  m_preloaded_filenames.push_back(filename);
+}
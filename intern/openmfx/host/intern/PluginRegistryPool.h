@@ -19,10 +19,21 @@
 
 #include "mfxPluginRegistry.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 // // PluginRegistryPoolEntry
 
 class PluginRegistryPoolEntry {
  public:
+  /**
+   * Entries are created in a loading state, so that they can be inserted in
+   * the pool before the slow load() is called without holding the pool lock.
+   */
   PluginRegistryPoolEntry(const char *filename);
   ~PluginRegistryPoolEntry();
 
@@ -39,6 +50,14 @@ class PluginRegistryPoolEntry {
 
   bool isValid() const;
 
+  /**
+   * Load the plugin binary. This must be called exactly once, and the entry
+   * remains loading until setLoaded() is called with the pool lock held.
+   */
+  void load();
+  void setLoaded();
+  bool isLoading() const;
+
   /**
    * Use these resp. before and after handling this plugin registry to user code
    */
@@ -54,6 +73,7 @@ class PluginRegistryPoolEntry {
   PluginRegistry m_registry;
   char *m_filename;
   bool m_is_valid;
+  bool m_is_loading;  // guarded by the pool lock
   int m_count;  // reference counter
 
   PluginRegistryPoolEntry *m_next;  // chained list
@@ -80,8 +100,49 @@ class PluginRegistryPool {
   PluginRegistryPoolEntry *add(const char *filename);
   void remove(PluginRegistryPoolEntry *entry);
 
+  /**
+   * Lock this before using find(), add() and remove(), since the pool may be
+   * filled by the preloading thread at the same time.
+   */
+  std::mutex &mutex();
+
+  /**
+   * Get the entry of a file, adding it if needed, with an extra reference.
+   * The binary is loaded, and described if describe_host is not NULL, with
+   * the pool lock released so that other entries remain available meanwhile.
+   * Callers asking for the same file wait until it is loaded. The lock must
+   * be held when calling this.
+   */
+  PluginRegistryPoolEntry *acquire(const char *filename,
+                                   std::unique_lock<std::mutex> &lock,
+                                   OfxHost *describe_host = NULL);
+
+  /**
+   * Start loading and describing, in a background thread, all the .ofx files
+   * found in the directories listed in search_path (separated by
+   * PATH_LIST_SEP). Preloaded registries are referenced by the pool itself
+   * until releasePreloaded() is called.
+   */
+  void preload(const char *search_path);
+
+  /**
+   * Stop preloading and release the references held on preloaded registries
+   */
+  void releasePreloaded();
+
+ private:
+  void preloadDirectory(const std::string &directory);
+  void preloadFile(const std::string &filename);
+
  private:
   PluginRegistryPoolEntry *m_first_entry;
+  std::mutex m_mutex;
+  std::condition_variable m_loaded; // notified when an entry is done loading
+
+  std::thread m_preload_thread;
+  std::atomic<bool> m_cancel_preload;
+  std::vector<std::string> m_preloaded_filenames; // guarded by m_mutex
+  OfxHost *m_preload_host; // host the preloaded descriptors belong to
 };
 
 #endif // __MFX_PLUGIN_REGISTRY_POOL_PRIVATE_H__
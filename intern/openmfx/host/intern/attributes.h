@@ -30,6 +30,7 @@ enum class AttributeAttachment {
   Corner,
   Face,
   Mesh,
+  Edge,
 };
 
 struct OfxAttributeStruct {
@@ -0,0 +1,426 @@
+/*
+ * Copyright 2019-2021 Elie Michel
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "bufferPool.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <vector>
+
+#include <cstring>
+
+#ifdef _WIN32
+#  include <io.h>
+#  include <windows.h>
+#else
+#  include <sys/mman.h>
+#  include <unistd.h>
+#endif
+
+// Blocks are binned by power of two capacities, from 64 bytes
+constexpr int MIN_BIN_SHIFT = 6;
+constexpr int BIN_COUNT = 40;
+
+// Never keep more than this in the pool
+constexpr size_t MAX_POOLED_BYTES = size_t(256) << 20;
+
+// Minimum alignment of all buffers
+constexpr size_t MIN_ALIGNMENT = 16;
+
+/**
+ * Information stored right before the aligned pointer returned to the user
+ */
+struct BlockHeader {
+  void *raw;       // pointer returned by malloc, or by mmap for mapped blocks
+  int bin;         // capacity is (1 << (bin + MIN_BIN_SHIFT)) bytes, alignment included
+                   // -1 for mapped blocks
+  size_t alignment;
+  size_t mapped_size;  // size of the mapping, for mapped blocks only
+  AttributeBufferCounters *counters;  // may be NULL
+};
+
+static AttributeBufferMallocFunc gMalloc = malloc;
+static AttributeBufferFreeFunc gFree = free;
+static AttributeBufferTempDirFunc gTempDir = NULL;
+
+// Bytes of the blocks currently given to users
+static std::atomic<size_t> gAllocatedBytes{0};
+static std::atomic<size_t> gMappedBytes{0};
+
+void AttributeBufferCounters::add(size_t size)
+{
+  size_t current = bytes.fetch_add(size) + size;
+  size_t peak = peakBytes.load();
+  while (current > peak && !peakBytes.compare_exchange_weak(peak, current)) {
+  }
+}
+
+void AttributeBufferCounters::remove(size_t size)
+{
+  bytes.fetch_sub(size);
+}
+
+void AttributeBufferCounters::resetPeak()
+{
+  peakBytes.store(bytes.load());
+}
+
+/**
+ * Path of a new temporary file for an out of core buffer, in the directory
+ * given by the application or else in the one of the system.
+ */
+static void tempFilePath(char *path, size_t size)
+{
+  const char *dir = NULL != gTempDir ? gTempDir() : NULL;
+#ifdef _WIN32
+  char system_dir[MAX_PATH + 1];
+  if (NULL == dir || '\0' == dir[0]) {
+    dir = 0 != GetTempPathA(sizeof(system_dir), system_dir) ? system_dir : ".";
+  }
+  char last = dir[strlen(dir) - 1];
+  const char *sep = '\\' == last || '/' == last ? "" : "\\";
+#else
+  if (NULL == dir || '\0' == dir[0]) {
+    dir = getenv("TMPDIR");
+  }
+  if (NULL == dir || '\0' == dir[0]) {
+    dir = "/tmp";
+  }
+  const char *sep = '/' == dir[strlen(dir) - 1] ? "" : "/";
+#endif
+  snprintf(path, size, "%s%sopenmfx-XXXXXX", dir, sep);
+}
+
+static size_t pageSize()
+{
+#ifdef _WIN32
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return (size_t)info.dwPageSize;
+#else
+  return (size_t)sysconf(_SC_PAGESIZE);
+#endif
+}
+
+/**
+ * Map a new temporary file, which only lives as long as the mapping. Returns
+ * NULL on failure.
+ */
+static void *mapTempFile(size_t mapped_size)
+{
+  char path[1024];
+  tempFilePath(path, sizeof(path));
+#ifdef _WIN32
+  if (0 != _mktemp_s(path, strlen(path) + 1)) {
+    printf("Warning: Could not create a temporary file for an out of core buffer\n");
+    return NULL;
+  }
+  HANDLE file = CreateFileA(path,
+                            GENERIC_READ | GENERIC_WRITE,
+                            0,
+                            NULL,
+                            CREATE_NEW,
+                            FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE,
+                            NULL);
+  if (INVALID_HANDLE_VALUE == file) {
+    printf("Warning: Could not create a temporary file for an out of core buffer\n");
+    return NULL;
+  }
+  // The view references the mapping, which keeps the file open
+  HANDLE mapping = CreateFileMappingA(file,
+                                      NULL,
+                                      PAGE_READWRITE,
+                                      (DWORD)((uint64_t)mapped_size >> 32),
+                                      (DWORD)((uint64_t)mapped_size & 0xFFFFFFFF),
+                                      NULL);
+  CloseHandle(file);
+  if (NULL == mapping) {
+    printf("Warning: Could not resize the temporary file of an out of core buffer\n");
+    return NULL;
+  }
+  void *raw = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, mapped_size);
+  CloseHandle(mapping);
+  if (NULL == raw) {
+    printf("Warning: Could not map the temporary file of an out of core buffer\n");
+    return NULL;
+  }
+  return raw;
+#else
+  int fd = mkstemp(path);
+  if (fd < 0) {
+    printf("Warning: Could not create a temporary file for an out of core buffer\n");
+    return NULL;
+  }
+  unlink(path);
+  if (0 != ftruncate(fd, (off_t)mapped_size)) {
+    printf("Warning: Could not resize the temporary file of an out of core buffer\n");
+    close(fd);
+    return NULL;
+  }
+  void *raw = mmap(NULL, mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (MAP_FAILED == raw) {
+    printf("Warning: Could not map the temporary file of an out of core buffer\n");
+    return NULL;
+  }
+  return raw;
+#endif
+}
+
+/**
+ * The user pointer of mapped blocks starts on a page boundary, after a first
+ * page holding the header, so that releasing ranges of it drops whole pages.
+ */
+static void *allocMapped(size_t size, size_t alignment, AttributeBufferCounters *counters)
+{
+  size_t page_size = pageSize();
+  if (alignment < MIN_ALIGNMENT) {
+    alignment = MIN_ALIGNMENT;
+  }
+  if (0 != (alignment & (alignment - 1))) {
+    return NULL;
+  }
+  size_t offset = alignment > page_size ? alignment : page_size;
+  size_t mapped_size = offset + size;
+
+  void *raw = mapTempFile(mapped_size);
+  if (NULL == raw) {
+    return NULL;
+  }
+
+  void *buffer = static_cast<char *>(raw) + offset;
+  BlockHeader *header = static_cast<BlockHeader *>(buffer) - 1;
+  header->raw = raw;
+  header->bin = -1;
+  header->alignment = alignment;
+  header->mapped_size = mapped_size;
+  header->counters = counters;
+  gMappedBytes += mapped_size;
+  if (NULL != counters) {
+    counters->add(mapped_size);
+  }
+  return buffer;
+}
+
+static void freeMapped(BlockHeader *header)
+{
+  gMappedBytes -= header->mapped_size;
+  if (NULL != header->counters) {
+    header->counters->remove(header->mapped_size);
+  }
+#ifdef _WIN32
+  UnmapViewOfFile(header->raw);
+#else
+  munmap(header->raw, header->mapped_size);
+#endif
+}
+
+static void releaseMapped(void *buffer, size_t offset, size_t size)
+{
+  uintptr_t page_size = (uintptr_t)pageSize();
+  uintptr_t begin = reinterpret_cast<uintptr_t>(buffer) + offset;
+  uintptr_t end = begin + size;
+  begin = (begin + page_size - 1) & ~(page_size - 1);
+  end = end & ~(page_size - 1);
+  if (end <= begin) {
+    return;
+  }
+#ifdef _WIN32
+  // DiscardVirtualMemory() would lose the content, so the pages are written
+  // to the file and removed from the working set. Unlocking pages that are
+  // not locked fails, but still trims them.
+  FlushViewOfFile(reinterpret_cast<void *>(begin), (SIZE_T)(end - begin));
+  VirtualUnlock(reinterpret_cast<void *>(begin), (SIZE_T)(end - begin));
+#else
+  // Pages of a shared file mapping keep their content in the page cache,
+  // from where the system writes them back and evicts them when needed
+  madvise(reinterpret_cast<void *>(begin), (size_t)(end - begin), MADV_DONTNEED);
+#endif
+}
+
+class BufferPool {
+ public:
+  ~BufferPool()
+  {
+    trim();
+  }
+
+  void *alloc(size_t size, size_t alignment, AttributeBufferCounters *counters)
+  {
+    if (alignment < MIN_ALIGNMENT) {
+      alignment = MIN_ALIGNMENT;
+    }
+    if (0 != (alignment & (alignment - 1))) {
+      return NULL;
+    }
+
+    // Room for the header and for aligning the user pointer
+    size_t needed = size + sizeof(BlockHeader) + alignment;
+    int bin = 0;
+    while (bin < BIN_COUNT && (size_t(1) << (bin + MIN_BIN_SHIFT)) < needed) {
+      ++bin;
+    }
+    if (bin == BIN_COUNT) {
+      return NULL;
+    }
+
+    void *raw = NULL;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      std::vector<void *> &free_blocks = m_free_blocks[bin];
+      if (!free_blocks.empty()) {
+        raw = free_blocks.back();
+        free_blocks.pop_back();
+        m_pooled_bytes -= size_t(1) << (bin + MIN_BIN_SHIFT);
+      }
+    }
+    size_t capacity = size_t(1) << (bin + MIN_BIN_SHIFT);
+    if (NULL == raw) {
+      raw = gMalloc(capacity);
+      if (NULL == raw) {
+        return NULL;
+      }
+    }
+    gAllocatedBytes += capacity;
+    if (NULL != counters) {
+      counters->add(capacity);
+    }
+
+    uintptr_t address = reinterpret_cast<uintptr_t>(raw) + sizeof(BlockHeader);
+    address = (address + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    BlockHeader *header = reinterpret_cast<BlockHeader *>(address) - 1;
+    header->raw = raw;
+    header->bin = bin;
+    header->alignment = alignment;
+    header->mapped_size = 0;
+    header->counters = counters;
+    return reinterpret_cast<void *>(address);
+  }
+
+  void free(void *buffer)
+  {
+    if (NULL == buffer) {
+      return;
+    }
+    BlockHeader *header = static_cast<BlockHeader *>(buffer) - 1;
+    if (header->bin < 0) {
+      freeMapped(header);
+      return;
+    }
+    void *raw = header->raw;
+    int bin = header->bin;
+    size_t capacity = size_t(1) << (bin + MIN_BIN_SHIFT);
+    gAllocatedBytes -= capacity;
+    if (NULL != header->counters) {
+      header->counters->remove(capacity);
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (m_pooled_bytes + capacity <= MAX_POOLED_BYTES) {
+        m_free_blocks[bin].push_back(raw);
+        m_pooled_bytes += capacity;
+        return;
+      }
+    }
+    gFree(raw);
+  }
+
+  void trim()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (std::vector<void *> &free_blocks : m_free_blocks) {
+      for (void *raw : free_blocks) {
+        gFree(raw);
+      }
+      free_blocks.clear();
+    }
+    m_pooled_bytes = 0;
+  }
+
+  size_t pooledBytes()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pooled_bytes;
+  }
+
+ private:
+  std::mutex m_mutex;
+  std::vector<void *> m_free_blocks[BIN_COUNT];
+  size_t m_pooled_bytes = 0;
+};
+
+static BufferPool gBufferPool;
+
+void *attributeBufferAlloc(size_t size, size_t alignment, AttributeBufferCounters *counters)
+{
+  return gBufferPool.alloc(size, alignment, counters);
+}
+
+void *attributeBufferAllocMapped(size_t size,
+                                 size_t alignment,
+                                 AttributeBufferCounters *counters)
+{
+  return allocMapped(size, alignment, counters);
+}
+
+void attributeBufferFree(void *buffer)
+{
+  gBufferPool.free(buffer);
+}
+
+void attributeBufferRelease(void *buffer, size_t offset, size_t size)
+{
+  if (NULL == buffer) {
+    return;
+  }
+  BlockHeader *header = static_cast<BlockHeader *>(buffer) - 1;
+  if (header->bin < 0) {
+    releaseMapped(buffer, offset, size);
+  }
+}
+
+void attributeBufferPoolTrim()
+{
+  gBufferPool.trim();
+}
+
+void attributeBufferSetAllocator(AttributeBufferMallocFunc mallocFunc,
+                                 AttributeBufferFreeFunc freeFunc)
+{
+  if (0 != gAllocatedBytes) {
+    printf("Warning: Changing the allocator of attribute buffers while some are in use\n");
+  }
+  gBufferPool.trim();
+  gMalloc = NULL != mallocFunc ? mallocFunc : malloc;
+  gFree = NULL != freeFunc ? freeFunc : free;
+}
+
+void attributeBufferSetTempDirectory(AttributeBufferTempDirFunc tempDirFunc)
+{
+  gTempDir = tempDirFunc;
+}
+
+void attributeBufferGetStats(size_t *r_allocatedBytes,
+                             size_t *r_mappedBytes,
+                             size_t *r_pooledBytes)
+{
+  *r_allocatedBytes = gAllocatedBytes;
+  *r_mappedBytes = gMappedBytes;
+  *r_pooledBytes = gBufferPool.pooledBytes();
+}
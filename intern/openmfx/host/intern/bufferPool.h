@@ -0,0 +1,111 @@
+/*
+ * Copyright 2019-2021 Elie Michel
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** \file
+ * \ingroup openmesheffect
+ *
+ * Pool of aligned memory blocks used for attribute buffers allocated by the
+ * host, so that cooking repeatedly the same effect does not reallocate them.
+ */
+
+#ifndef __MFX_BUFFER_POOL_H__
+#define __MFX_BUFFER_POOL_H__
+
+#include <atomic>
+#include <cstddef>
+
+/**
+ * Bytes held by the buffers allocated on behalf of an effect instance, i.e.
+ * the capacity of the blocks, alignment padding included. The counters must
+ * outlive the buffers that they count.
+ */
+struct AttributeBufferCounters {
+  std::atomic<size_t> bytes{0};
+  // Highest value reached by bytes since the last call to resetPeak()
+  std::atomic<size_t> peakBytes{0};
+
+  void add(size_t size);
+  void remove(size_t size);
+  void resetPeak();
+};
+
+typedef void *(*AttributeBufferMallocFunc)(size_t size);
+typedef void (*AttributeBufferFreeFunc)(void *ptr);
+typedef const char *(*AttributeBufferTempDirFunc)(void);
+
+/**
+ * Get a buffer of at least size bytes starting at an address multiple of
+ * alignment (which must be a power of two). Returns NULL on failure.
+ * The buffer is counted in counters until it is freed, if they are not NULL.
+ */
+void *attributeBufferAlloc(size_t size,
+                           size_t alignment,
+                           AttributeBufferCounters *counters = NULL);
+
+/**
+ * Same as attributeBufferAlloc(), but the buffer is backed by an unlinked
+ * temporary file mapped in memory, so that its pages can be written back and
+ * evicted after attributeBufferRelease(). Such buffers are never pooled.
+ * Returns NULL if no file could be mapped.
+ */
+void *attributeBufferAllocMapped(size_t size,
+                                 size_t alignment,
+                                 AttributeBufferCounters *counters = NULL);
+
+/**
+ * Give a buffer returned by attributeBufferAlloc() or
+ * attributeBufferAllocMapped() back to the pool.
+ */
+void attributeBufferFree(void *buffer);
+
+/**
+ * Drop from memory the whole pages of a mapped buffer that lie in the size
+ * bytes starting at offset. Their content is kept in the file and read back on
+ * next access. Does nothing for buffers that are not mapped.
+ */
+void attributeBufferRelease(void *buffer, size_t offset, size_t size);
+
+/**
+ * Free all the blocks kept in the pool for later reuse.
+ */
+void attributeBufferPoolTrim();
+
+/**
+ * Replace malloc() and free() for the blocks of the pool, e.g. to have the
+ * application account for them. The pool is trimmed, and no buffer must be
+ * alive, since blocks are released with the function they were allocated
+ * with. Mapped buffers are not affected.
+ */
+void attributeBufferSetAllocator(AttributeBufferMallocFunc mallocFunc,
+                                 AttributeBufferFreeFunc freeFunc);
+
+/**
+ * Have temporary files of mapped buffers created in the directory returned by
+ * tempDirFunc, called for each buffer, rather than in the one of the system.
+ * Mapped buffers are the bulk of the memory of large effects, so this should
+ * not be a RAM backed file system such as most /tmp.
+ */
+void attributeBufferSetTempDirectory(AttributeBufferTempDirFunc tempDirFunc);
+
+/**
+ * Get the bytes currently held by buffers in use, allocated from the heap or
+ * mapped from files, and by the blocks kept in the pool for later reuse.
+ */
+void attributeBufferGetStats(size_t *r_allocatedBytes,
+                             size_t *r_mappedBytes,
+                             size_t *r_pooledBytes);
+
+#endif // __MFX_BUFFER_POOL_H__
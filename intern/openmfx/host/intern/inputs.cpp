@@ -31,15 +31,38 @@ OfxMeshInputStruct::OfxMeshInputStruct()
 
   i = properties.ensure_property(kOfxInputPropRequestTransform);
   properties.properties[i]->value[0].as_int = 0;
+
+  i = properties.ensure_property(kOfxInputPropIsOutput);
+  properties.properties[i]->value[0].as_int = 0;
+
+  i = properties.ensure_property(kOfxInputPropLooseEdgeAttachment);
+  properties.properties[i]->value[0].as_int = 0;
+
+  i = properties.ensure_property(kOfxMeshPropAttributeLayout);
+  properties.properties[i]->value[0].as_const_char = kOfxMeshAttribLayoutInterleaved;
+
+  i = properties.ensure_property(kOfxMeshPropAttributeAlignment);
+  properties.properties[i]->value[0].as_int = 0;
+
+  i = properties.ensure_property(kOfxMeshPropOutOfCore);
+  properties.properties[i]->value[0].as_int = 0;
 }
 
 OfxMeshInputStruct::~OfxMeshInputStruct()
 {}
 
+bool OfxMeshInputStruct::is_output() const
+{
+  int i = properties.find_property(kOfxInputPropIsOutput);
+  return (-1 != i && 0 != properties.properties[i]->value[0].as_int) ||
+         0 == strcmp(name, kOfxMeshMainOutput);
+}
+
 void OfxMeshInputStruct::deep_copy_from(const OfxMeshInputStruct &other)
 {
   this->name = other.name;  // weak pointer?
   this->properties.deep_copy_from(other.properties);
+  this->requested_attributes.deep_copy_from(other.requested_attributes);
   this->mesh.deep_copy_from(other.mesh);
   this->host = other.host;  // not deep copied, as this is a weak pointer
 }
@@ -51,6 +74,7 @@ OfxMeshInputSetStruct::OfxMeshInputSetStruct()
   num_inputs = 0;
   inputs = nullptr;
   host = nullptr;
+  counters = nullptr;
 }
 
 OfxMeshInputSetStruct::~OfxMeshInputSetStruct()
@@ -88,6 +112,7 @@ void OfxMeshInputSetStruct::append(int count)
     } else {
       input = new OfxMeshInputStruct();
       input->host = this->host;
+      input->mesh.counters = this->counters;
     }
     this->inputs[i] = input;
   }
@@ -103,6 +128,10 @@ int OfxMeshInputSetStruct::ensure(const char *input)
     append(1);
     i = this->num_inputs - 1;
     this->inputs[i]->name = input;
+    if (0 == strcmp(input, kOfxMeshMainOutput)) {
+      int j = this->inputs[i]->properties.ensure_property(kOfxInputPropIsOutput);
+      this->inputs[i]->properties.properties[j]->value[0].as_int = 1;
+    }
   }
   return i;
 }
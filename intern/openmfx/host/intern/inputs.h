@@ -38,6 +38,12 @@ struct OfxMeshInputStruct {
 
   void deep_copy_from(const OfxMeshInputStruct &other);
 
+  /**
+   * Whether this is the main output or an input declared as an output with
+   * kOfxInputPropIsOutput
+   */
+  bool is_output() const;
+
  public:
   const char *name;
   OfxPropertySetStruct properties;
@@ -65,6 +71,7 @@ struct OfxMeshInputSetStruct {
   int num_inputs;
   OfxMeshInputStruct **inputs;
   OfxHost *host; // weak pointer, do not deep copy
+  AttributeBufferCounters *counters; // weak pointer, do not deep copy, given to input meshes
 };
 
 #endif // __MFX_INPUTS_H__
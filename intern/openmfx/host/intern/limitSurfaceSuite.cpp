@@ -0,0 +1,112 @@
+/*
+ * Copyright 2019 - 2021 Elie Michel
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "limitSurfaceSuite.h"
+#include "propertySuite.h"
+#include "mesh.h"
+
+#include "ofxExtras.h"
+
+#include <algorithm>
+
+// // Limit Surface Suite Entry Points
+
+const OfxMeshLimitSurfaceSuiteV1 gMeshLimitSurfaceSuiteV1 = {
+    /* limitSurfaceCreate */   limitSurfaceCreate,
+    /* limitSurfaceEvaluate */ limitSurfaceEvaluate,
+    /* limitSurfaceDestroy */  limitSurfaceDestroy,
+};
+
+// The evaluation itself is provided by the host application through callbacks, since it
+// depends on its internal representation of meshes. Callbacks are looked up once at creation.
+
+struct OfxMeshLimitSurfaceStruct {
+  LimitSurfaceEvaluateCbFunc evaluateCb;
+  LimitSurfaceDestroyCbFunc destroyCb;
+  void *data;
+};
+
+OfxStatus limitSurfaceCreate(OfxMeshHandle meshHandle,
+                             int quality,
+                             OfxMeshLimitSurfaceHandle *limitSurface)
+{
+  if (NULL == meshHandle || NULL == limitSurface) {
+    return kOfxStatErrBadHandle;
+  }
+  *limitSurface = NULL;
+
+  OfxHost *host = NULL;
+  propGetPointer(&meshHandle->properties, kOfxMeshPropHostHandle, 0, (void **)&host);
+  if (NULL == host) {
+    return kOfxStatErrBadHandle;
+  }
+
+  LimitSurfaceCreateCbFunc createCb = NULL;
+  LimitSurfaceEvaluateCbFunc evaluateCb = NULL;
+  LimitSurfaceDestroyCbFunc destroyCb = NULL;
+  propGetPointer(host->host, kOfxHostPropLimitSurfaceCreateCb, 0, (void **)&createCb);
+  propGetPointer(host->host, kOfxHostPropLimitSurfaceEvaluateCb, 0, (void **)&evaluateCb);
+  propGetPointer(host->host, kOfxHostPropLimitSurfaceDestroyCb, 0, (void **)&destroyCb);
+  if (NULL == createCb || NULL == evaluateCb || NULL == destroyCb) {
+    return kOfxStatErrUnsupported;
+  }
+
+  void *data = NULL;
+  OfxStatus status = createCb(host, meshHandle, std::clamp(quality, 1, 10), &data);
+  if (kOfxStatOK != status) {
+    return status;
+  }
+
+  *limitSurface = new OfxMeshLimitSurfaceStruct;
+  (*limitSurface)->evaluateCb = evaluateCb;
+  (*limitSurface)->destroyCb = destroyCb;
+  (*limitSurface)->data = data;
+  return kOfxStatOK;
+}
+
+OfxStatus limitSurfaceEvaluate(OfxMeshLimitSurfaceHandle limitSurface,
+                               int count,
+                               const int *faces,
+                               const float *coords,
+                               float *positions,
+                               float *normals)
+{
+  if (NULL == limitSurface) {
+    return kOfxStatErrBadHandle;
+  }
+  if (count < 0) {
+    return kOfxStatErrValue;
+  }
+  if (0 == count) {
+    return kOfxStatOK;
+  }
+  if (NULL == faces || NULL == coords || (NULL == positions && NULL == normals)) {
+    return kOfxStatErrValue;
+  }
+
+  return limitSurface->evaluateCb(limitSurface->data, count, faces, coords, positions, normals);
+}
+
+OfxStatus limitSurfaceDestroy(OfxMeshLimitSurfaceHandle limitSurface)
+{
+  if (NULL == limitSurface) {
+    return kOfxStatErrBadHandle;
+  }
+  limitSurface->destroyCb(limitSurface->data);
+  delete limitSurface;
+  return kOfxStatOK;
+}
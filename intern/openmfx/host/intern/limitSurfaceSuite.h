@@ -0,0 +1,53 @@
+/*
+ * Copyright 2019 - 2021 Elie Michel
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+ /** \file
+  * \ingroup openmesheffect
+  *
+  */
+
+#ifndef __MFX_LIMIT_SURFACE_SUITE_H__
+#define __MFX_LIMIT_SURFACE_SUITE_H__
+
+// // Limit Surface Suite Entry Points
+
+#include "ofxMeshEffect.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// See ofxMeshEffect.h for docstrings
+
+extern const OfxMeshLimitSurfaceSuiteV1 gMeshLimitSurfaceSuiteV1;
+
+OfxStatus limitSurfaceCreate(OfxMeshHandle meshHandle,
+                             int quality,
+                             OfxMeshLimitSurfaceHandle *limitSurface);
+OfxStatus limitSurfaceEvaluate(OfxMeshLimitSurfaceHandle limitSurface,
+                               int count,
+                               const int *faces,
+                               const float *coords,
+                               float *positions,
+                               float *normals);
+OfxStatus limitSurfaceDestroy(OfxMeshLimitSurfaceHandle limitSurface);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __MFX_LIMIT_SURFACE_SUITE_H__
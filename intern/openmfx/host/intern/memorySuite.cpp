@@ -0,0 +1,56 @@
+/*
+ * Copyright 2019 - 2021 Elie Michel
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "memorySuite.h"
+#include "mesheffect.h"
+#include "bufferPool.h"
+
+#include <cstddef>
+
+// // Memory Suite Entry Points
+
+const OfxMemorySuiteV1 gMemorySuiteV1 = {
+    /* memoryAlloc */ memoryAlloc,
+    /* memoryFree */  memoryFree,
+};
+
+// Plugin memory shares the pool of attribute buffers, so that it is released to the same
+// allocator and shows up in the same statistics. When given, the handle is the effect
+// instance that the memory is counted for.
+
+OfxStatus memoryAlloc(void *handle, size_t nBytes, void **allocatedData)
+{
+  if (NULL == allocatedData) {
+    return kOfxStatErrBadHandle;
+  }
+
+  AttributeBufferCounters *counters = NULL;
+  if (NULL != handle) {
+    counters = static_cast<OfxMeshEffectHandle>(handle)->pluginCounters;
+  }
+
+  *allocatedData = attributeBufferAlloc(nBytes, alignof(std::max_align_t), counters);
+  return NULL != *allocatedData ? kOfxStatOK : kOfxStatErrMemory;
+}
+
+OfxStatus memoryFree(void *allocatedData)
+{
+  if (NULL == allocatedData) {
+    return kOfxStatErrBadHandle;
+  }
+  attributeBufferFree(allocatedData);
+  return kOfxStatOK;
+}
@@ -0,0 +1,44 @@
+/*
+ * Copyright 2019 - 2021 Elie Michel
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+ /** \file
+  * \ingroup openmesheffect
+  *
+  */
+
+#ifndef __MFX_MEMORY_SUITE_H__
+#define __MFX_MEMORY_SUITE_H__
+
+// // Memory Suite Entry Points
+
+#include "ofxMemory.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// See ofxMemory.h for docstrings
+
+extern const OfxMemorySuiteV1 gMemorySuiteV1;
+
+OfxStatus memoryAlloc(void *handle, size_t nBytes, void **allocatedData);
+OfxStatus memoryFree(void *allocatedData);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __MFX_MEMORY_SUITE_H__
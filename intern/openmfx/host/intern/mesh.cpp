@@ -24,6 +24,7 @@
 
 OfxMeshStruct::OfxMeshStruct()
 	: properties(PropertySetContext::Mesh)
+	, counters(nullptr)
 {}
 
 OfxMeshStruct::~OfxMeshStruct()
@@ -24,6 +24,7 @@
 
 #include "properties.h"
 #include "attributes.h"
+#include "bufferPool.h"
 
 struct OfxMeshStruct {
  public:
@@ -39,6 +40,7 @@ struct OfxMeshStruct {
  public:
   OfxPropertySetStruct properties;
   OfxAttributeSetStruct attributes;
+  AttributeBufferCounters *counters; // weak pointer, do not deep copy
 };
 
 #endif // __MFX_MESH_H__
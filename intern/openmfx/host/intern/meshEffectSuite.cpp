@@ -17,6 +17,7 @@
 #include "meshEffectSuite.h"
 #include "propertySuite.h"
 #include "mesheffect.h"
+#include "bufferPool.h"
 
 #include <cstring>
 #include <cstdio>
@@ -37,11 +38,61 @@ static AttributeAttachment mfxToInternalAttribAttachment(const char *attachment)
   else if (0 == strcmp(attachment, kOfxMeshAttribMesh)) {
     return AttributeAttachment::Mesh;
   }
+  else if (0 == strcmp(attachment, kOfxMeshAttribEdge)) {
+    return AttributeAttachment::Edge;
+  }
   else {
     return AttributeAttachment::Invalid;
   }
 }
 
+/**
+ * Size in bytes of a single component of the given attribute type,
+ * or 0 if the type is not supported.
+ */
+static size_t attributeTypeByteSize(const char *type)
+{
+  if (NULL == type) {
+    return 0;
+  }
+  else if (0 == strcmp(type, kOfxMeshAttribTypeUByte)) {
+    return sizeof(unsigned char);
+  }
+  else if (0 == strcmp(type, kOfxMeshAttribTypeInt)) {
+    return sizeof(int);
+  }
+  else if (0 == strcmp(type, kOfxMeshAttribTypeFloat)) {
+    return sizeof(float);
+  }
+  else if (0 == strcmp(type, kOfxMeshAttribTypeHalf)) {
+    return sizeof(unsigned short);
+  }
+  else if (0 == strcmp(type, kOfxMeshAttribTypeShort)) {
+    return sizeof(short);
+  }
+  else if (0 == strcmp(type, kOfxMeshAttribTypeUShort)) {
+    return sizeof(unsigned short);
+  }
+  else if (0 == strcmp(type, kOfxMeshAttribTypeDouble)) {
+    return sizeof(double);
+  }
+  else {
+    return 0;
+  }
+}
+
+/**
+ * Attributes have from 1 to 4 components, or 16 floats for 4x4 matrices such
+ * as kOfxMeshAttribPointInstanceTransform.
+ */
+static bool isValidComponentCount(const char *type, int componentCount)
+{
+  if (16 == componentCount) {
+    return 0 == strcmp(type, kOfxMeshAttribTypeFloat);
+  }
+  return componentCount >= 1 && componentCount <= 4;
+}
+
 // // Mesh Effect Suite Entry Points
 
 const OfxMeshEffectSuiteV1 gMeshEffectSuiteV1 = {
@@ -59,6 +110,9 @@ const OfxMeshEffectSuiteV1 gMeshEffectSuiteV1 = {
     /* meshAlloc */ meshAlloc,
     /* abort */ ofxAbort};
 
+const OfxMeshOutOfCoreSuiteV1 gMeshOutOfCoreSuiteV1 = {
+    /* meshReleaseRange */ meshReleaseRange};
+
 OfxStatus getPropertySet(OfxMeshEffectHandle meshEffect, OfxPropertySetHandle *propHandle)
 {
   *propHandle = &meshEffect->properties;
@@ -120,11 +174,10 @@ OfxStatus inputRequestAttribute(OfxMeshInputHandle input,
     const char* semantic,
     int mandatory)
 {
-  if (componentCount < 1 || componentCount > 4) {
+  if (0 == attributeTypeByteSize(type)) {
     return kOfxStatErrValue;
   }
-  if (0 != strcmp(type, kOfxMeshAttribTypeInt) && 0 != strcmp(type, kOfxMeshAttribTypeFloat) &&
-      0 != strcmp(type, kOfxMeshAttribTypeUByte)) {
+  if (!isValidComponentCount(type, componentCount)) {
     return kOfxStatErrValue;
   }
 
@@ -157,15 +210,28 @@ OfxStatus inputGetMesh(OfxMeshInputHandle input,
                        OfxMeshHandle *meshHandle,
                        OfxPropertySetHandle *propertySet)
 {
-  (void)time;
   OfxMeshHandle inputMeshHandle = &input->mesh;
   OfxPropertySetHandle inputMeshProperties = &input->mesh.properties;
   propSetPointer(inputMeshProperties, kOfxMeshPropHostHandle, 0, (void *)input->host);
+  propSetDouble(inputMeshProperties, kOfxMeshPropTime, 0, time);
   propSetInt(inputMeshProperties, kOfxMeshPropPointCount, 0, 0);
   propSetInt(inputMeshProperties, kOfxMeshPropCornerCount, 0, 0);
   propSetInt(inputMeshProperties, kOfxMeshPropFaceCount, 0, 0);
+  propSetInt(inputMeshProperties, kOfxMeshPropLooseEdgeCount, 0, 0);
   propSetInt(inputMeshProperties, kOfxMeshPropAttributeCount, 0, 0);
 
+  // Forward layout requested on the input to the mesh
+  char *layout;
+  int alignment;
+  propGetString(&input->properties, kOfxMeshPropAttributeLayout, 0, &layout);
+  propGetInt(&input->properties, kOfxMeshPropAttributeAlignment, 0, &alignment);
+  propSetString(inputMeshProperties, kOfxMeshPropAttributeLayout, 0, layout);
+  propSetInt(inputMeshProperties, kOfxMeshPropAttributeAlignment, 0, alignment);
+
+  int isOutOfCore;
+  propGetInt(&input->properties, kOfxMeshPropOutOfCore, 0, &isOutOfCore);
+  propSetInt(inputMeshProperties, kOfxMeshPropOutOfCore, 0, isOutOfCore);
+
   // Default attributes
   attributeDefine(inputMeshHandle,
                   kOfxMeshAttribPoint,
@@ -189,6 +255,19 @@ OfxStatus inputGetMesh(OfxMeshInputHandle input,
                   NULL,
                   NULL);
 
+  // Loose edges are only stored apart from faces for inputs asking for it
+  int useLooseEdgeAttachment;
+  propGetInt(&input->properties, kOfxInputPropLooseEdgeAttachment, 0, &useLooseEdgeAttachment);
+  if (useLooseEdgeAttachment) {
+    attributeDefine(inputMeshHandle,
+                    kOfxMeshAttribEdge,
+                    kOfxMeshAttribEdgePoint,
+                    2,
+                    kOfxMeshAttribTypeInt,
+                    NULL,
+                    NULL);
+  }
+
   // Call internal callback before actually getting data
   OfxHost *host = input->host;
   BeforeMeshGetCbFunc beforeMeshGetCb;
@@ -232,7 +311,7 @@ OfxStatus inputReleaseMesh(OfxMeshHandle meshHandle)
     propGetPointer(&attribute->properties, kOfxMeshAttribPropData, 0, &data);
     propGetInt(&attribute->properties, kOfxMeshAttribPropIsOwner, 0, &is_owner);
     if (is_owner && NULL != data) {
-      delete[] static_cast<char*>(data);  // delete on void* is undefined behaviour
+      attributeBufferFree(data);
     }
     propSetPointer(&attribute->properties, kOfxMeshAttribPropData, 0, NULL);
     propSetInt(&attribute->properties, kOfxMeshAttribPropIsOwner, 0, 0);
@@ -241,6 +320,7 @@ OfxStatus inputReleaseMesh(OfxMeshHandle meshHandle)
   propSetInt(&meshHandle->properties, kOfxMeshPropPointCount, 0, 0);
   propSetInt(&meshHandle->properties, kOfxMeshPropCornerCount, 0, 0);
   propSetInt(&meshHandle->properties, kOfxMeshPropFaceCount, 0, 0);
+  propSetInt(&meshHandle->properties, kOfxMeshPropLooseEdgeCount, 0, 0);
 
   return kOfxStatOK;
 }
@@ -253,12 +333,10 @@ OfxStatus attributeDefine(OfxMeshHandle meshHandle,
                           const char *semantic,
                           OfxPropertySetHandle *attributeHandle)
 {
-  if (componentCount < 1 || componentCount > 4) {
+  if (0 == attributeTypeByteSize(type)) {
     return kOfxStatErrValue;
   }
-  if (0 != strcmp(type, kOfxMeshAttribTypeInt) &&
-      0 != strcmp(type, kOfxMeshAttribTypeFloat) &&
-      0 != strcmp(type, kOfxMeshAttribTypeUByte)) {
+  if (!isValidComponentCount(type, componentCount)) {
     return kOfxStatErrValue;
   }
 
@@ -284,6 +362,7 @@ OfxStatus attributeDefine(OfxMeshHandle meshHandle,
   propSetString(attributeProperties, kOfxMeshAttribPropType, 0, type);
   propSetString(attributeProperties, kOfxMeshAttribPropSemantic, 0, semantic);
   propSetInt(attributeProperties, kOfxMeshAttribPropIsOwner, 0, 1);
+  propSetInt(attributeProperties, kOfxMeshAttribPropComponentStride, 0, (int)attributeTypeByteSize(type));
 
   // Keep attribute count up-to-date
   propSetInt(&meshHandle->properties, kOfxMeshPropAttributeCount, 0, meshHandle->attributes.num_attributes);
@@ -321,14 +400,14 @@ OfxStatus meshGetPropertySet(OfxMeshHandle mesh, OfxPropertySetHandle *propHandl
   return kOfxStatOK;
 }
 
-OfxStatus meshAlloc(OfxMeshHandle meshHandle)
+/**
+ * Get the number of elements of each attachment, indexed by AttributeAttachment
+ */
+static OfxStatus getElementCounts(OfxMeshHandle meshHandle, int elementCount[5])
 {
   OfxStatus status;
 
-  // Get counts
-
-  int elementCount[4];  // point, corner, face, mesh
-
+  // point, corner, face, mesh, edge
   status = propGetInt(&meshHandle->properties, kOfxMeshPropPointCount, 0, &elementCount[0]);
   if (kOfxStatOK != status) {
     return status;
@@ -342,6 +421,57 @@ OfxStatus meshAlloc(OfxMeshHandle meshHandle)
     return status;
   }
   elementCount[3] = 1;
+  return propGetInt(&meshHandle->properties, kOfxMeshPropLooseEdgeCount, 0, &elementCount[4]);
+}
+
+OfxStatus meshAlloc(OfxMeshHandle meshHandle)
+{
+  OfxStatus status;
+
+  // Get counts
+
+  int elementCount[5];
+  status = getElementCounts(meshHandle, elementCount);
+  if (kOfxStatOK != status) {
+    return status;
+  }
+
+  // Get layout
+
+  char *layout;
+  int alignment;
+  status = propGetString(&meshHandle->properties, kOfxMeshPropAttributeLayout, 0, &layout);
+  if (kOfxStatOK != status) {
+    return status;
+  }
+  status = propGetInt(&meshHandle->properties, kOfxMeshPropAttributeAlignment, 0, &alignment);
+  if (kOfxStatOK != status) {
+    return status;
+  }
+  if (alignment < 0 || 0 != (alignment & (alignment - 1))) {
+    return kOfxStatErrValue;
+  }
+  bool isPlanar = NULL != layout && 0 == strcmp(layout, kOfxMeshAttribLayoutPlanar);
+
+  int isOutOfCore;
+  status = propGetInt(&meshHandle->properties, kOfxMeshPropOutOfCore, 0, &isOutOfCore);
+  if (kOfxStatOK != status) {
+    return status;
+  }
+
+  // Call internal callback, which may provide some buffers itself
+  OfxHost *host = NULL;
+  BeforeMeshAllocCbFunc beforeMeshAllocCb = NULL;
+  propGetPointer(&meshHandle->properties, kOfxMeshPropHostHandle, 0, (void **)&host);
+  if (NULL != host) {
+    propGetPointer(host->host, kOfxHostPropBeforeMeshAllocCb, 0, (void **)&beforeMeshAllocCb);
+    if (NULL != beforeMeshAllocCb) {
+      status = beforeMeshAllocCb(host, meshHandle);
+      if (kOfxStatOK != status) {
+        return status;
+      }
+    }
+  }
 
   // Allocate memory attributes
 
@@ -372,21 +502,32 @@ OfxStatus meshAlloc(OfxMeshHandle meshHandle)
       return status;
     }
 
-    size_t byteSize = 0;
-    if (0 == strcmp(type, kOfxMeshAttribTypeUByte)) {
-      byteSize = sizeof(unsigned char);
-    }
-    else if (0 == strcmp(type, kOfxMeshAttribTypeInt)) {
-      byteSize = sizeof(int);
+    size_t byteSize = attributeTypeByteSize(type);
+    if (0 == byteSize) {
+      return kOfxStatErrBadHandle;
     }
-    else if (0 == strcmp(type, kOfxMeshAttribTypeFloat)) {
-      byteSize = sizeof(float);
+
+    // In planar layout, each component is a plane of which start is aligned
+    size_t elementStride, componentStride, bufferSize;
+    size_t valueCount = elementCount[(int)attribute->attachment];
+    if (isPlanar) {
+      size_t planeAlignment = alignment > 0 ? (size_t)alignment : byteSize;
+      size_t planeSize = byteSize * valueCount;
+      planeSize = (planeSize + planeAlignment - 1) / planeAlignment * planeAlignment;
+      elementStride = byteSize;
+      componentStride = planeSize;
+      bufferSize = planeSize * count;
     }
     else {
-      return kOfxStatErrBadHandle;
+      elementStride = byteSize * count;
+      componentStride = byteSize;
+      bufferSize = elementStride * valueCount;
     }
 
-    void *data = new char[byteSize * count * elementCount[(int)attribute->attachment]];
+    void *data = isOutOfCore ?
+                     attributeBufferAllocMapped(
+                         bufferSize, (size_t)alignment, meshHandle->counters) :
+                     attributeBufferAlloc(bufferSize, (size_t)alignment, meshHandle->counters);
     if (NULL == data) {
       return kOfxStatErrMemory;
     }
@@ -396,8 +537,13 @@ OfxStatus meshAlloc(OfxMeshHandle meshHandle)
       return status;
     }
 
+    status = propSetInt(&attribute->properties, kOfxMeshAttribPropStride, 0, (int)elementStride);
+    if (kOfxStatOK != status) {
+      return status;
+    }
+
     status = propSetInt(
-        &attribute->properties, kOfxMeshAttribPropStride, 0, (int)(byteSize * count));
+        &attribute->properties, kOfxMeshAttribPropComponentStride, 0, (int)componentStride);
     if (kOfxStatOK != status) {
       return status;
     }
@@ -411,6 +557,69 @@ OfxStatus meshAlloc(OfxMeshHandle meshHandle)
   return kOfxStatOK;
 }
 
+OfxStatus meshReleaseRange(OfxMeshHandle meshHandle,
+                           const char *attachment,
+                           int start,
+                           int count)
+{
+  if (NULL == meshHandle) {
+    return kOfxStatErrBadHandle;
+  }
+
+  AttributeAttachment intAttachment = mfxToInternalAttribAttachment(attachment);
+  if (intAttachment == AttributeAttachment::Invalid) {
+    return kOfxStatErrBadIndex;
+  }
+
+  int elementCount[5];
+  OfxStatus status = getElementCounts(meshHandle, elementCount);
+  if (kOfxStatOK != status) {
+    return status;
+  }
+  if (start < 0 || count < 0 || start > elementCount[(int)intAttachment] - count) {
+    return kOfxStatErrValue;
+  }
+
+  int isOutOfCore;
+  propGetInt(&meshHandle->properties, kOfxMeshPropOutOfCore, 0, &isOutOfCore);
+  if (!isOutOfCore || 0 == count) {
+    return kOfxStatOK;
+  }
+
+  for (int i = 0; i < meshHandle->attributes.num_attributes; ++i) {
+    OfxAttributeStruct *attribute = meshHandle->attributes.attributes[i];
+    if (attribute->attachment != intAttachment) {
+      continue;
+    }
+
+    void *data;
+    int is_owner, stride, componentStride, componentCount;
+    propGetPointer(&attribute->properties, kOfxMeshAttribPropData, 0, &data);
+    propGetInt(&attribute->properties, kOfxMeshAttribPropIsOwner, 0, &is_owner);
+    if (!is_owner || NULL == data) {
+      continue;
+    }
+    propGetInt(&attribute->properties, kOfxMeshAttribPropStride, 0, &stride);
+    propGetInt(&attribute->properties, kOfxMeshAttribPropComponentStride, 0, &componentStride);
+    propGetInt(&attribute->properties, kOfxMeshAttribPropComponentCount, 0, &componentCount);
+
+    size_t rangeStart = (size_t)start * (size_t)stride;
+    size_t rangeSize = (size_t)count * (size_t)stride;
+    if (componentStride < stride) {
+      // Interleaved components
+      attributeBufferRelease(data, rangeStart, rangeSize);
+    }
+    else {
+      // One plane per component
+      for (int k = 0; k < componentCount; ++k) {
+        attributeBufferRelease(data, (size_t)k * (size_t)componentStride + rangeStart, rangeSize);
+      }
+    }
+  }
+
+  return kOfxStatOK;
+}
+
 int ofxAbort(OfxMeshEffectHandle meshEffect)
 {
   (void)meshEffect;
@@ -31,6 +31,7 @@ extern "C" {
 #endif
 
 extern const OfxMeshEffectSuiteV1 gMeshEffectSuiteV1;
+extern const OfxMeshOutOfCoreSuiteV1 gMeshOutOfCoreSuiteV1;
 
 // See ofxMeshEffect.h for docstrings
 
@@ -73,6 +74,10 @@ OfxStatus meshGetAttribute(OfxMeshHandle meshHandle,
 OfxStatus meshGetPropertySet(OfxMeshHandle mesh, OfxPropertySetHandle *propHandle);
 OfxStatus meshAlloc(OfxMeshHandle meshHandle);
 int ofxAbort(OfxMeshEffectHandle meshEffect);
+OfxStatus meshReleaseRange(OfxMeshHandle meshHandle,
+                           const char *attachment,
+                           int start,
+                           int count);
 
 #ifdef __cplusplus
 }
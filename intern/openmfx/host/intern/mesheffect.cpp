@@ -31,6 +31,9 @@ OfxMeshEffectStruct::OfxMeshEffectStruct(OfxHost *host)
 {
   this->host = host;
   this->inputs.host = host;
+  this->attributeCounters = new AttributeBufferCounters();
+  this->pluginCounters = new AttributeBufferCounters();
+  this->inputs.counters = this->attributeCounters;
   this->parameters.effect_properties = &this->properties;
   this->messageType = OfxMessageType::Invalid;
   this->message[0] = '\0';
@@ -38,6 +41,18 @@ OfxMeshEffectStruct::OfxMeshEffectStruct(OfxHost *host)
 
 OfxMeshEffectStruct::~OfxMeshEffectStruct()
 {
+  if (0 == this->attributeCounters->bytes) {
+    delete this->attributeCounters;
+  }
+  else {
+    printf("Warning: Destroying a mesh effect while some of its meshes are not released\n");
+  }
+  if (0 == this->pluginCounters->bytes) {
+    delete this->pluginCounters;
+  }
+  else {
+    printf("Warning: Destroying a mesh effect while some of its memory is not freed\n");
+  }
 }
 
 void OfxMeshEffectStruct::deep_copy_from(const OfxMeshEffectStruct &other)
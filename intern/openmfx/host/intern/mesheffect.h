@@ -49,6 +49,12 @@ struct OfxMeshEffectStruct {
   OfxParamSetStruct parameters;
   OfxHost *host; // weak pointer, do not deep copy
 
+  // Bytes of the attribute buffers of the input meshes and of the memory
+  // allocated by the plugin through the memory suite. Not deep copied, and
+  // kept alive if the instance is destroyed while some buffers still use them.
+  AttributeBufferCounters *attributeCounters;
+  AttributeBufferCounters *pluginCounters;
+
   // Only the last persistent message is stored
   OfxMessageType messageType;
   char message[1024];
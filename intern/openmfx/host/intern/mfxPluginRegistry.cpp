@@ -17,12 +17,18 @@
 #include <string.h>
 #include <stdio.h>
 
+#include <mutex>
+
 #include "ofxMeshEffect.h"
 
 #include "util/memory_util.h"
 #include "util/path_util.h"
 
 #include "mfxPluginRegistry.h"
+#include "mfxHost.h"
+
+// Serializes plugin loads and the load counts of all registries, loads are rare enough
+static std::mutex gLoadMutex;
 
 /**
  * Initialize a plugin registry before anything else.
@@ -31,6 +37,8 @@ static void registry_init(PluginRegistry *registry) {
   registry->num_plugins = 0;
   registry->plugins = NULL;
   registry->status = NULL;
+  registry->load_counts = NULL;
+  registry->descriptors = NULL;
   registry->handle = NULL;
   registry->getNumberOfPlugins = NULL;
   registry->getPlugin = NULL;
@@ -88,6 +96,11 @@ static void registry_init_plugins(PluginRegistry *registry) {
     }
     free_array(old_plugins);
     free_array(old_status);
+
+    registry->load_counts = (int*)malloc_array(sizeof(int), registry->num_plugins, "mfx plugins load counts");
+    for (i = 0 ; i < registry->num_plugins ; ++i) {
+      registry->load_counts[i] = 0;
+    }
   }
 }
 
@@ -136,7 +149,74 @@ bool load_registry(PluginRegistry *registry, const char *ofx_filepath) {
   return true;
 }
 
+void describe_registry(PluginRegistry *registry, OfxHost *host) {
+  if (0 == registry->num_plugins) {
+    return;
+  }
+
+  registry->descriptors = (OfxMeshEffectHandle*)malloc_array(sizeof(OfxMeshEffectHandle), registry->num_plugins, "mfx descriptors");
+  for (int i = 0 ; i < registry->num_plugins ; ++i) {
+    OfxPlugin *plugin = registry->plugins[i];
+    registry->descriptors[i] = NULL;
+
+    // The registry itself is a user of the plugins it describes
+    if (false == registry_acquire_plugin(registry, i, host)) {
+      printf("Error while loading plugin %s\n", plugin->pluginIdentifier);
+      continue;
+    }
+    if (false == ofxhost_get_descriptor(host, plugin, &registry->descriptors[i])) {
+      printf("Error while describing plugin %s\n", plugin->pluginIdentifier);
+      ofxhost_release_descriptor(registry->descriptors[i]);
+      registry->descriptors[i] = NULL;
+      registry_release_plugin(registry, i);
+      registry->status[i] = OfxPluginStatError;
+      continue;
+    }
+  }
+}
+
+bool registry_acquire_plugin(PluginRegistry *registry, int index, OfxHost *host) {
+  std::lock_guard<std::mutex> lock(gLoadMutex);
+  OfxPluginStatus *status = &registry->status[index];
+  if (OfxPluginStatNotLoaded == *status) {
+    *status = ofxhost_load_plugin(host, registry->plugins[index]) ? OfxPluginStatOK : OfxPluginStatError;
+  }
+  if (OfxPluginStatOK != *status) {
+    return false;
+  }
+  ++registry->load_counts[index];
+  return true;
+}
+
+void registry_release_plugin(PluginRegistry *registry, int index) {
+  std::lock_guard<std::mutex> lock(gLoadMutex);
+  if (registry->load_counts[index] <= 0 || --registry->load_counts[index] > 0) {
+    return;
+  }
+  ofxhost_unload_plugin(registry->plugins[index]);
+  registry->status[index] = OfxPluginStatNotLoaded;
+}
+
 void free_registry(PluginRegistry *registry) {
+  if (NULL != registry->descriptors) {
+    for (int i = 0 ; i < registry->num_plugins ; ++i) {
+      if (NULL != registry->descriptors[i]) {
+        ofxhost_release_descriptor(registry->descriptors[i]);
+      }
+    }
+    free_array(registry->descriptors);
+    registry->descriptors = NULL;
+  }
+  // Plugins still loaded at this point are unloaded whatever their users
+  if (NULL != registry->load_counts) {
+    for (int i = 0 ; i < registry->num_plugins ; ++i) {
+      if (registry->load_counts[i] > 0) {
+        ofxhost_unload_plugin(registry->plugins[i]);
+      }
+    }
+    free_array(registry->load_counts);
+    registry->load_counts = NULL;
+  }
   registry->num_plugins = 0;
   if (NULL != registry->plugins) {
     free_array(registry->plugins);
@@ -22,16 +22,16 @@
 PluginRegistry *get_registry(const char *ofx_filepath)
 {
   PluginRegistryPool & pluginRegistryPool = PluginRegistryPool::getInstance();
-  PluginRegistryPoolEntry *entry = pluginRegistryPool.find(ofx_filepath);
+  std::unique_lock<std::mutex> lock(pluginRegistryPool.mutex());
   
-  if (NULL == entry) {
+  if (NULL == pluginRegistryPool.find(ofx_filepath)) {
     printf("[get_registry] NEW registry for %s\n", ofx_filepath);
-    entry = pluginRegistryPool.add(ofx_filepath);
   } else {
     printf("[get_registry] reusing registry for %s\n", ofx_filepath);
   }
 
-  entry->incrementReferences();
+  // Waits if the registry is being loaded by the preloading thread
+  PluginRegistryPoolEntry *entry = pluginRegistryPool.acquire(ofx_filepath, lock);
 
   if (false == entry->isValid()) {
     return NULL;
@@ -44,6 +44,7 @@ void release_registry(const char *ofx_filepath)
 {
   printf("[release_registry] releasing registry for %s\n", ofx_filepath);
   PluginRegistryPool &pluginRegistryPool = PluginRegistryPool::getInstance();
+  std::lock_guard<std::mutex> lock(pluginRegistryPool.mutex());
   PluginRegistryPoolEntry *entry = pluginRegistryPool.find(ofx_filepath);
   if (NULL == entry) {
     printf("ERROR: Trying to release plugin that is not loaded; %s\n", ofx_filepath);
@@ -57,3 +58,13 @@ void release_registry(const char *ofx_filepath)
     pluginRegistryPool.remove(entry);
   }
 }
+
+void preload_registries(const char *search_path)
+{
+  PluginRegistryPool::getInstance().preload(search_path);
+}
+
+void release_preloaded_registries(void)
+{
+  PluginRegistryPool::getInstance().releasePreloaded();
+}
@@ -0,0 +1,197 @@
+/*
+ * Copyright 2019 - 2021 Elie Michel
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "multiThreadSuite.h"
+
+#include <cstdio>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+// // Multi Thread Suite Entry Points
+
+const OfxMultiThreadSuiteV1 gMultiThreadSuiteV1 = {
+    /* multiThread */                multiThread,
+    /* multiThreadNumCPUs */         multiThreadNumCPUs,
+    /* multiThreadIndex */           multiThreadIndex,
+    /* multiThreadIsSpawnedThread */ multiThreadIsSpawnedThread,
+    /* mutexCreate */                mutexCreate,
+    /* mutexDestroy */               mutexDestroy,
+    /* mutexLock */                  mutexLock,
+    /* mutexUnLock */                mutexUnLock,
+    /* mutexTryLock */               mutexTryLock,
+};
+
+struct OfxMutex {
+  std::recursive_mutex mutex;
+};
+
+// Index of the current thread among the ones running multiThread(), and
+// whether the current thread is one of them.
+static thread_local unsigned int tThreadIndex = 0;
+static thread_local bool tIsSpawnedThread = false;
+
+static MultiThreadParallelForFunc gParallelFor = NULL;
+
+struct MultiThreadCall {
+  OfxThreadFunctionV1 *func;
+  unsigned int nThreads;
+  void *customArg;
+};
+
+static void runIndex(unsigned int index, void *userData)
+{
+  const MultiThreadCall *call = (const MultiThreadCall *)userData;
+  // Pool threads may also run tasks of the application, and the calling thread
+  // may run some of the indices, so the previous state is restored.
+  unsigned int previousIndex = tThreadIndex;
+  bool previousIsSpawned = tIsSpawnedThread;
+  tThreadIndex = index;
+  tIsSpawnedThread = true;
+  call->func(index, call->nThreads, call->customArg);
+  tThreadIndex = previousIndex;
+  tIsSpawnedThread = previousIsSpawned;
+}
+
+void multiThreadSetParallelFor(MultiThreadParallelForFunc parallelFor)
+{
+  gParallelFor = parallelFor;
+}
+
+OfxStatus multiThread(OfxThreadFunctionV1 func, unsigned int nThreads, void *customArg)
+{
+  if (tIsSpawnedThread) {
+    return kOfxStatErrExists;
+  }
+  if (NULL == func) {
+    return kOfxStatFailed;
+  }
+
+  unsigned int cpuCount;
+  multiThreadNumCPUs(&cpuCount);
+  if (0 == nThreads) {
+    nThreads = cpuCount;
+  }
+
+  if (NULL != gParallelFor) {
+    MultiThreadCall call = {func, nThreads, customArg};
+    gParallelFor(nThreads, runIndex, &call);
+    return kOfxStatOK;
+  }
+
+  // Threads are limited to the number of CPUs, each one running several
+  // indices when more are requested. The calling thread runs the first one.
+  unsigned int workerCount = nThreads < cpuCount ? nThreads : cpuCount;
+  auto work = [=](unsigned int worker) {
+    tIsSpawnedThread = true;
+    for (unsigned int i = worker; i < nThreads; i += workerCount) {
+      tThreadIndex = i;
+      func(i, nThreads, customArg);
+    }
+    tThreadIndex = 0;
+    tIsSpawnedThread = false;
+  };
+
+  // Workers that cannot be spawned are run by the calling thread as well, so
+  // that every index gets run exactly once.
+  std::vector<std::thread> threads;
+  threads.reserve(workerCount - 1);
+  unsigned int spawnedCount = 1;
+  try {
+    for (; spawnedCount < workerCount; ++spawnedCount) {
+      threads.emplace_back(work, spawnedCount);
+    }
+  }
+  catch (const std::system_error &) {
+    printf("Warning: could only spawn %u threads out of %u\n", spawnedCount, workerCount);
+  }
+
+  work(0);
+  for (unsigned int worker = spawnedCount; worker < workerCount; ++worker) {
+    work(worker);
+  }
+
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  return kOfxStatOK;
+}
+
+OfxStatus multiThreadNumCPUs(unsigned int *nCPUs)
+{
+  unsigned int count = std::thread::hardware_concurrency();
+  *nCPUs = count > 0 ? count : 1;
+  return kOfxStatOK;
+}
+
+OfxStatus multiThreadIndex(unsigned int *threadIndex)
+{
+  *threadIndex = tThreadIndex;
+  return kOfxStatOK;
+}
+
+int multiThreadIsSpawnedThread(void)
+{
+  return tIsSpawnedThread ? 1 : 0;
+}
+
+OfxStatus mutexCreate(OfxMutexHandle *mutex, int lockCount)
+{
+  if (NULL == mutex) {
+    return kOfxStatErrBadHandle;
+  }
+  *mutex = new OfxMutex;
+  for (int i = 0; i < lockCount; ++i) {
+    (*mutex)->mutex.lock();
+  }
+  return kOfxStatOK;
+}
+
+OfxStatus mutexDestroy(const OfxMutexHandle mutex)
+{
+  if (NULL == mutex) {
+    return kOfxStatErrBadHandle;
+  }
+  delete mutex;
+  return kOfxStatOK;
+}
+
+OfxStatus mutexLock(const OfxMutexHandle mutex)
+{
+  if (NULL == mutex) {
+    return kOfxStatErrBadHandle;
+  }
+  mutex->mutex.lock();
+  return kOfxStatOK;
+}
+
+OfxStatus mutexUnLock(const OfxMutexHandle mutex)
+{
+  if (NULL == mutex) {
+    return kOfxStatErrBadHandle;
+  }
+  mutex->mutex.unlock();
+  return kOfxStatOK;
+}
+
+OfxStatus mutexTryLock(const OfxMutexHandle mutex)
+{
+  if (NULL == mutex) {
+    return kOfxStatErrBadHandle;
+  }
+  return mutex->mutex.try_lock() ? kOfxStatOK : kOfxStatFailed;
+}
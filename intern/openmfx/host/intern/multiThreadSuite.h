@@ -0,0 +1,63 @@
+/*
+ * Copyright 2019 - 2021 Elie Michel
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+ /** \file
+  * \ingroup openmesheffect
+  *
+  */
+
+#ifndef __MFX_MULTI_THREAD_SUITE_H__
+#define __MFX_MULTI_THREAD_SUITE_H__
+
+// // Multi Thread Suite Entry Points
+
+#include "ofxMultiThread.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// See ofxMultiThread.h for docstrings
+
+extern const OfxMultiThreadSuiteV1 gMultiThreadSuiteV1;
+
+OfxStatus multiThread(OfxThreadFunctionV1 func, unsigned int nThreads, void *customArg);
+OfxStatus multiThreadNumCPUs(unsigned int *nCPUs);
+OfxStatus multiThreadIndex(unsigned int *threadIndex);
+int multiThreadIsSpawnedThread(void);
+OfxStatus mutexCreate(OfxMutexHandle *mutex, int lockCount);
+OfxStatus mutexDestroy(const OfxMutexHandle mutex);
+OfxStatus mutexLock(const OfxMutexHandle mutex);
+OfxStatus mutexUnLock(const OfxMutexHandle mutex);
+OfxStatus mutexTryLock(const OfxMutexHandle mutex);
+
+typedef void (*MultiThreadIndexFunc)(unsigned int index, void *userData);
+typedef void (*MultiThreadParallelForFunc)(unsigned int count,
+                                           MultiThreadIndexFunc func,
+                                           void *userData);
+
+/**
+ * Run the indices of multiThread() with a parallel for loop of the
+ * application, rather than on threads spawned for each call. Reset to the
+ * default behavior when parallelFor is NULL.
+ */
+void multiThreadSetParallelFor(MultiThreadParallelForFunc parallelFor);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __MFX_MULTI_THREAD_SUITE_H__
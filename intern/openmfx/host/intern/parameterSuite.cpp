@@ -16,8 +16,11 @@
 
 #include "parameterSuite.h"
 #include "parameters.h"
+#include "propertySuite.h"
+#include "mesheffect.h"
 
 #include <stdarg.h>
+#include <math.h>
 
 // //Parameter Suite Entry Points
 
@@ -85,60 +88,155 @@ OfxStatus paramGetPropertySet(OfxParamHandle param,
     return kOfxStatOK;
 }
 
-OfxStatus paramGetValue(OfxParamHandle paramHandle, ...) {
+// Write the values of a parameter to the pointers given as variadic arguments
+static void paramWriteValues(OfxParamHandle paramHandle,
+                             const OfxParamValueStruct *values,
+                             va_list valist) {
     size_t dimensions = parameter_type_dimensions(paramHandle->type);
-    va_list valist;
-    va_start(valist, paramHandle);
     for (size_t i = 0; i < dimensions; ++i) {
         switch (paramHandle->type) {
         case PARAM_TYPE_INTEGER:
         case PARAM_TYPE_INTEGER_2D:
         case PARAM_TYPE_INTEGER_3D:
-            *va_arg(valist, int*) = paramHandle->value[i].as_int;
+            *va_arg(valist, int*) = values[i].as_int;
             break;
         case PARAM_TYPE_DOUBLE:
         case PARAM_TYPE_DOUBLE_2D:
         case PARAM_TYPE_DOUBLE_3D:
         case PARAM_TYPE_RGB:
         case PARAM_TYPE_RGBA:
-            *va_arg(valist, double*) = paramHandle->value[i].as_double;
+            *va_arg(valist, double*) = values[i].as_double;
             break;
         case PARAM_TYPE_BOOLEAN:
-            *va_arg(valist, bool*) = paramHandle->value[i].as_bool;
+            *va_arg(valist, bool*) = values[i].as_bool;
             break;
         case PARAM_TYPE_STRING:
             // TODO: check memory management
-            *va_arg(valist, char**) = paramHandle->value[i].as_char;
+            *va_arg(valist, char**) = values[i].as_char;
             break;
         case PARAM_TYPE_UNKNOWN:
             // TODO
             break;
         }
     }
+}
+
+// Evaluate a parameter at a given time, through the host callback when the
+// parameter is animated, otherwise it keeps its current value.
+static void paramEvaluate(OfxParamHandle paramHandle, OfxTime time, OfxParamValueStruct *values) {
+    for (int i = 0; i < 4; ++i) {
+        values[i] = paramHandle->value[i];
+    }
+
+    // Only parameters bound by the host can be evaluated, and getting an unset
+    // property would return an uninitialized value
+    int i = paramHandle->properties.find_property(kOfxParamPropHostHandle);
+    if (-1 == i) {
+        return;
+    }
+    OfxHost *host = (OfxHost *)paramHandle->properties.properties[i]->value[0].as_pointer;
+    if (NULL == host) {
+        return;
+    }
+
+    ParamGetValueAtTimeCbFunc paramGetValueAtTimeCb = NULL;
+    propGetPointer(host->host, kOfxHostPropParamGetValueAtTimeCb, 0, (void **)&paramGetValueAtTimeCb);
+    if (NULL == paramGetValueAtTimeCb) {
+        return;
+    }
+
+    if (kOfxStatOK != paramGetValueAtTimeCb(host, paramHandle, time, values)) {
+        for (int i = 0; i < 4; ++i) {
+            values[i] = paramHandle->value[i];
+        }
+    }
+}
+
+static bool isDoubleParam(OfxParamHandle paramHandle) {
+    switch (paramHandle->type) {
+    case PARAM_TYPE_DOUBLE:
+    case PARAM_TYPE_DOUBLE_2D:
+    case PARAM_TYPE_DOUBLE_3D:
+    case PARAM_TYPE_RGB:
+    case PARAM_TYPE_RGBA:
+        return true;
+    default:
+        return false;
+    }
+}
+
+OfxStatus paramGetValue(OfxParamHandle paramHandle, ...) {
+    va_list valist;
+    va_start(valist, paramHandle);
+    paramWriteValues(paramHandle, paramHandle->value, valist);
     va_end(valist);
     return kOfxStatOK;
 }
 
 OfxStatus paramGetValueAtTime(OfxParamHandle paramHandle, OfxTime time, ...) {
-    (void)paramHandle;
-    (void)time;
-    // TODO
-    return kOfxStatErrUnsupported;
+    OfxParamValueStruct values[4];
+    paramEvaluate(paramHandle, time, values);
+
+    va_list valist;
+    va_start(valist, time);
+    paramWriteValues(paramHandle, values, valist);
+    va_end(valist);
+    return kOfxStatOK;
 }
 
+// Step used for finite differences, in frames
+#define PARAM_DERIVATIVE_STEP 0.01
+// Number of integration steps per frame
+#define PARAM_INTEGRAL_STEPS_PER_FRAME 4
+
 OfxStatus paramGetDerivative(OfxParamHandle paramHandle, OfxTime time, ...) {
-    (void)paramHandle;
-    (void)time;
-    // TODO
-    return kOfxStatErrUnsupported;
+    if (!isDoubleParam(paramHandle)) {
+        return kOfxStatErrBadHandle;
+    }
+
+    OfxParamValueStruct before[4], after[4];
+    paramEvaluate(paramHandle, time - PARAM_DERIVATIVE_STEP, before);
+    paramEvaluate(paramHandle, time + PARAM_DERIVATIVE_STEP, after);
+
+    size_t dimensions = parameter_type_dimensions(paramHandle->type);
+    va_list valist;
+    va_start(valist, time);
+    for (size_t i = 0; i < dimensions; ++i) {
+        *va_arg(valist, double*) =
+            (after[i].as_double - before[i].as_double) / (2 * PARAM_DERIVATIVE_STEP);
+    }
+    va_end(valist);
+    return kOfxStatOK;
 }
 
 OfxStatus paramGetIntegral(OfxParamHandle paramHandle, OfxTime time1, OfxTime time2, ...) {
-    (void)paramHandle;
-    (void)time1;
-    (void)time2;
-    // TODO
-    return kOfxStatErrUnsupported;
+    if (!isDoubleParam(paramHandle)) {
+        return kOfxStatErrBadHandle;
+    }
+
+    // Composite Simpson's rule, which is exact on constant and linear segments
+    int steps = (int)ceil(fabs(time2 - time1) * PARAM_INTEGRAL_STEPS_PER_FRAME);
+    steps = steps < 2 ? 2 : steps + steps % 2;
+    double h = (time2 - time1) / steps;
+
+    double integral[4] = {0.0, 0.0, 0.0, 0.0};
+    OfxParamValueStruct values[4];
+    for (int k = 0; k <= steps; ++k) {
+        double weight = (0 == k || steps == k) ? 1.0 : (k % 2 == 1 ? 4.0 : 2.0);
+        paramEvaluate(paramHandle, time1 + k * h, values);
+        for (int i = 0; i < 4; ++i) {
+            integral[i] += weight * values[i].as_double;
+        }
+    }
+
+    size_t dimensions = parameter_type_dimensions(paramHandle->type);
+    va_list valist;
+    va_start(valist, time2);
+    for (size_t i = 0; i < dimensions; ++i) {
+        *va_arg(valist, double*) = integral[i] * h / 3.0;
+    }
+    va_end(valist);
+    return kOfxStatOK;
 }
 
 OfxStatus paramSetValue(OfxParamHandle paramHandle, ...) {
@@ -139,6 +139,9 @@ bool OfxPropertySetStruct::check_property_context(PropertySetContext context, Pr
     case PropertySetContext::MeshEffect:
     return (
       (0 == strcmp(property, kOfxMeshEffectPropContext) && type == PROP_TYPE_STRING) ||
+      (0 == strcmp(property, kOfxMeshEffectPropRenderQualityDraft) && type == PROP_TYPE_INT) ||
+      (0 == strcmp(property, kOfxMeshEffectPropPluginHandle) && type == PROP_TYPE_POINTER) ||
+      (0 == strcmp(property, kOfxMeshEffectPropIslandIndependent) && type == PROP_TYPE_INT) ||
       false
     );
     case PropertySetContext::Input:
@@ -146,25 +149,40 @@ bool OfxPropertySetStruct::check_property_context(PropertySetContext context, Pr
       (0 == strcmp(property, kOfxPropLabel) && type == PROP_TYPE_STRING) ||
       (0 == strcmp(property, kOfxInputPropRequestTransform) && type == PROP_TYPE_INT) ||
       (0 == strcmp(property, kOfxInputPropRequestGeometry) && type == PROP_TYPE_INT) ||
+      (0 == strcmp(property, kOfxInputPropIsOutput) && type == PROP_TYPE_INT) ||
+      (0 == strcmp(property, kOfxInputPropLooseEdgeAttachment) && type == PROP_TYPE_INT) ||
+      (0 == strcmp(property, kOfxMeshPropAttributeLayout) && type == PROP_TYPE_STRING) ||
+      (0 == strcmp(property, kOfxMeshPropAttributeAlignment) && type == PROP_TYPE_INT) ||
+      (0 == strcmp(property, kOfxMeshPropOutOfCore) && type == PROP_TYPE_INT) ||
       false
     );
     case PropertySetContext::Host:
     return (
       (0 == strcmp(property, kOfxHostPropBeforeMeshReleaseCb) && type == PROP_TYPE_POINTER) ||
       (0 == strcmp(property, kOfxHostPropBeforeMeshGetCb) && type == PROP_TYPE_POINTER) ||
+      (0 == strcmp(property, kOfxHostPropBeforeMeshAllocCb) && type == PROP_TYPE_POINTER) ||
+      (0 == strcmp(property, kOfxHostPropParamGetValueAtTimeCb) && type == PROP_TYPE_POINTER) ||
+      (0 == strcmp(property, kOfxHostPropLimitSurfaceCreateCb) && type == PROP_TYPE_POINTER) ||
+      (0 == strcmp(property, kOfxHostPropLimitSurfaceEvaluateCb) && type == PROP_TYPE_POINTER) ||
+      (0 == strcmp(property, kOfxHostPropLimitSurfaceDestroyCb) && type == PROP_TYPE_POINTER) ||
       false
     );
     case PropertySetContext::Mesh:
     return (
       (0 == strcmp(property, kOfxMeshPropInternalData) && type == PROP_TYPE_POINTER) ||
       (0 == strcmp(property, kOfxMeshPropHostHandle)   && type == PROP_TYPE_POINTER) ||
+      (0 == strcmp(property, kOfxMeshPropTime)         && type == PROP_TYPE_DOUBLE)  ||
       (0 == strcmp(property, kOfxMeshPropPointCount)   && type == PROP_TYPE_INT)     ||
       (0 == strcmp(property, kOfxMeshPropCornerCount)  && type == PROP_TYPE_INT)     ||
       (0 == strcmp(property, kOfxMeshPropFaceCount)    && type == PROP_TYPE_INT)     ||
       (0 == strcmp(property, kOfxMeshPropNoLooseEdge)  && type == PROP_TYPE_INT)     ||
+      (0 == strcmp(property, kOfxMeshPropLooseEdgeCount) && type == PROP_TYPE_INT)   ||
       (0 == strcmp(property, kOfxMeshPropConstantFaceSize) && type == PROP_TYPE_INT) ||
       (0 == strcmp(property, kOfxMeshPropTransformMatrix) && type == PROP_TYPE_POINTER) ||
       (0 == strcmp(property, kOfxMeshPropAttributeCount) && type == PROP_TYPE_INT) ||
+      (0 == strcmp(property, kOfxMeshPropAttributeLayout) && type == PROP_TYPE_STRING) ||
+      (0 == strcmp(property, kOfxMeshPropAttributeAlignment) && type == PROP_TYPE_INT) ||
+      (0 == strcmp(property, kOfxMeshPropOutOfCore) && type == PROP_TYPE_INT) ||
       false
     );
     case PropertySetContext::Param:
@@ -184,12 +202,15 @@ bool OfxPropertySetStruct::check_property_context(PropertySetContext context, Pr
       (0 == strcmp(property, kOfxParamPropMax) && type == PROP_TYPE_INT) ||
       (0 == strcmp(property, kOfxParamPropMax) && type == PROP_TYPE_DOUBLE) ||
       (0 == strcmp(property, kOfxParamPropMax) && type == PROP_TYPE_POINTER) ||
+      (0 == strcmp(property, kOfxParamPropInternalData) && type == PROP_TYPE_POINTER) ||
+      (0 == strcmp(property, kOfxParamPropHostHandle) && type == PROP_TYPE_POINTER) ||
       false
       );
     case PropertySetContext::Attrib:
     return (
       (0 == strcmp(property, kOfxMeshAttribPropData) && type == PROP_TYPE_POINTER) ||
       (0 == strcmp(property, kOfxMeshAttribPropStride) && type == PROP_TYPE_INT) ||
+      (0 == strcmp(property, kOfxMeshAttribPropComponentStride) && type == PROP_TYPE_INT) ||
       (0 == strcmp(property, kOfxMeshAttribPropComponentCount) && type == PROP_TYPE_INT) ||
       (0 == strcmp(property, kOfxMeshAttribPropType) && type == PROP_TYPE_STRING) ||
       (0 == strcmp(property, kOfxMeshAttribPropSemantic) && type == PROP_TYPE_STRING) ||
@@ -199,12 +220,20 @@ bool OfxPropertySetStruct::check_property_context(PropertySetContext context, Pr
     case PropertySetContext::ActionIdentityIn:
     return (
         (0 == strcmp(property, kOfxPropTime) && type == PROP_TYPE_INT) ||
+        (0 == strcmp(property, kOfxMeshEffectPropRenderQualityDraft) && type == PROP_TYPE_INT) ||
         false);
     case PropertySetContext::ActionIdentityOut:
     return (
         (0 == strcmp(property, kOfxPropName) && type == PROP_TYPE_STRING) ||
         (0 == strcmp(property, kOfxPropTime) && type == PROP_TYPE_INT) ||
         false);
+    case PropertySetContext::ActionCookIn:
+    return (
+        (0 == strcmp(property, kOfxPropTime) && type == PROP_TYPE_DOUBLE) ||
+        (0 == strcmp(property, kOfxMeshEffectPropRenderQualityDraft) && type == PROP_TYPE_INT) ||
+        (0 == strcmp(property, kOfxMeshEffectPropSampleCount) && type == PROP_TYPE_INT) ||
+        (0 == strcmp(property, kOfxMeshEffectPropSampleTimes) && type == PROP_TYPE_POINTER) ||
+        false);
     case PropertySetContext::Other:
   default:
     printf("Warning: PROP_CTX_OTHER is depreciated.\n");
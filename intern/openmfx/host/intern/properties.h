@@ -66,6 +66,7 @@ enum class PropertySetContext {
   Attrib,
   ActionIdentityIn,
   ActionIdentityOut,
+  ActionCookIn,
   Other,
   // kOfxTypeParameterInstance
 };
@@ -31,6 +31,10 @@
 #include "intern/propertySuite.h"
 #include "intern/meshEffectSuite.h"
 #include "intern/messageSuite.h"
+#include "intern/multiThreadSuite.h"
+#include "intern/memorySuite.h"
+#include "intern/limitSurfaceSuite.h"
+#include "intern/bufferPool.h"
 #include "mfxPluginRegistry.h"
 
 #include "mfxHost.h"
@@ -88,6 +92,51 @@ static const void * fetchSuite(OfxPropertySetHandle host,
         return NULL;
     }
   }
+  if (0 == strcmp(suiteName, kOfxMultiThreadSuite) && suiteVersion == 1) {
+    switch (suiteVersion) {
+      case 1:
+        return &gMultiThreadSuiteV1;
+      default:
+        printf("Suite '%s' is only supported in version 1.\n", suiteName);
+        return NULL;
+    }
+  }
+
+  if (0 == strcmp(suiteName, kOfxMemorySuite) && suiteVersion == 1) {
+    switch (suiteVersion) {
+      case 1:
+        return &gMemorySuiteV1;
+      default:
+        printf("Suite '%s' is only supported in version 1.\n", suiteName);
+        return NULL;
+    }
+  }
+
+  if (0 == strcmp(suiteName, kOfxMeshOutOfCoreSuite) && suiteVersion == 1) {
+    switch (suiteVersion) {
+      case 1:
+        return &gMeshOutOfCoreSuiteV1;
+      default:
+        printf("Suite '%s' is only supported in version 1.\n", suiteName);
+        return NULL;
+    }
+  }
+
+  // Only provided when the host application can evaluate limit surfaces
+  if (0 == strcmp(suiteName, kOfxMeshLimitSurfaceSuite) && suiteVersion == 1) {
+    LimitSurfaceCreateCbFunc limitSurfaceCreateCb = NULL;
+    propGetPointer(host, kOfxHostPropLimitSurfaceCreateCb, 0, (void **)&limitSurfaceCreateCb);
+    if (NULL == limitSurfaceCreateCb) {
+      return NULL;
+    }
+    switch (suiteVersion) {
+      case 1:
+        return &gMeshLimitSurfaceSuiteV1;
+      default:
+        printf("Suite '%s' is only supported in version 1.\n", suiteName);
+        return NULL;
+    }
+  }
 
   printf("Suite '%s' is not supported by this host.\n", suiteName);
   return NULL;
@@ -107,6 +156,11 @@ OfxHost * getGlobalHost(void) {
     OfxPropertySetHandle hostProperties = new OfxPropertySetStruct(PropertySetContext::Host);
     propSetPointer(hostProperties, kOfxHostPropBeforeMeshReleaseCb, 0, (void*)NULL);
     propSetPointer(hostProperties, kOfxHostPropBeforeMeshGetCb, 0, (void*)NULL);
+    propSetPointer(hostProperties, kOfxHostPropBeforeMeshAllocCb, 0, (void*)NULL);
+    propSetPointer(hostProperties, kOfxHostPropParamGetValueAtTimeCb, 0, (void*)NULL);
+    propSetPointer(hostProperties, kOfxHostPropLimitSurfaceCreateCb, 0, (void*)NULL);
+    propSetPointer(hostProperties, kOfxHostPropLimitSurfaceEvaluateCb, 0, (void*)NULL);
+    propSetPointer(hostProperties, kOfxHostPropLimitSurfaceDestroyCb, 0, (void*)NULL);
     gHost->host = hostProperties;
     gHost->fetchSuite = fetchSuite;
   }
@@ -168,6 +222,7 @@ bool ofxhost_get_descriptor(OfxHost *host, OfxPlugin *plugin, OfxMeshEffectHandl
 
   *effectDescriptor = NULL;
   effectHandle = new OfxMeshEffectStruct(host);
+  propSetPointer(&effectHandle->properties, kOfxMeshEffectPropPluginHandle, 0, (void *)plugin);
 
   status = plugin->mainEntry(kOfxActionDescribe, effectHandle, NULL, NULL);
   printf("%s action returned status %d (%s)\n", kOfxActionDescribe, status, getOfxStateName(status));
@@ -245,9 +300,28 @@ void ofxhost_destroy_instance(OfxPlugin *plugin, OfxMeshEffectHandle effectInsta
 }
 
 bool ofxhost_cook(OfxPlugin *plugin, OfxMeshEffectHandle effectInstance) {
+  return ofxhost_cook_samples(plugin, effectInstance, NULL, 0);
+}
+
+bool ofxhost_cook_samples(OfxPlugin *plugin, OfxMeshEffectHandle effectInstance, const OfxTime *sampleTimes, int sampleCount) {
   OfxStatus status;
+  int is_draft;
+
+  OfxPropertySetStruct inArgs(PropertySetContext::ActionCookIn);
+
+  // Peaks of memory use are measured for each cook
+  effectInstance->attributeCounters->resetPeak();
+  effectInstance->pluginCounters->resetPeak();
+
+  propGetInt(&effectInstance->properties, kOfxMeshEffectPropRenderQualityDraft, 0, &is_draft);
+  propSetDouble(&inArgs, kOfxPropTime, 0, sampleCount > 0 ? sampleTimes[0] : 0.0);
+  propSetInt(&inArgs, kOfxMeshEffectPropRenderQualityDraft, 0, is_draft);
+  if (sampleCount > 1) {
+    propSetInt(&inArgs, kOfxMeshEffectPropSampleCount, 0, sampleCount);
+    propSetPointer(&inArgs, kOfxMeshEffectPropSampleTimes, 0, (void*)sampleTimes);
+  }
 
-  status = plugin->mainEntry(kOfxMeshEffectActionCook, effectInstance, NULL, NULL);
+  status = plugin->mainEntry(kOfxMeshEffectActionCook, effectInstance, &inArgs, NULL);
   printf("%s action returned status %d (%s)\n", kOfxMeshEffectActionCook, status, getOfxStateName(status));
 
   if (kOfxStatErrMemory == status) {
@@ -267,11 +341,14 @@ bool ofxhost_cook(OfxPlugin *plugin, OfxMeshEffectHandle effectInstance) {
 
 bool ofxhost_is_identity(OfxPlugin *plugin, OfxMeshEffectHandle effectInstance, bool *shouldCook) {
   OfxStatus status;
+  int is_draft;
 
   OfxPropertySetStruct inArgs(PropertySetContext::ActionIdentityIn);
   OfxPropertySetStruct outArgs(PropertySetContext::ActionIdentityOut);
 
+  propGetInt(&effectInstance->properties, kOfxMeshEffectPropRenderQualityDraft, 0, &is_draft);
   propSetInt(&inArgs, kOfxPropTime, 0, 0);
+  propSetInt(&inArgs, kOfxMeshEffectPropRenderQualityDraft, 0, is_draft);
   propSetString(&outArgs, kOfxPropName, 0, "");
   propSetInt(&outArgs, kOfxPropTime, 0, 0);
 
@@ -298,3 +375,34 @@ bool ofxhost_is_identity(OfxPlugin *plugin, OfxMeshEffectHandle effectInstance,
   }
   return true;
 }
+
+void ofxhost_get_instance_memory_usage(OfxMeshEffectHandle effectInstance,
+                                       OfxHostMemoryUsage *usage) {
+  usage->attributeBytes = effectInstance->attributeCounters->bytes;
+  usage->attributePeakBytes = effectInstance->attributeCounters->peakBytes;
+  usage->pluginBytes = effectInstance->pluginCounters->bytes;
+  usage->pluginPeakBytes = effectInstance->pluginCounters->peakBytes;
+}
+
+void ofxhost_get_memory_usage(size_t *allocatedBytes, size_t *mappedBytes, size_t *pooledBytes) {
+  attributeBufferGetStats(allocatedBytes, mappedBytes, pooledBytes);
+}
+
+void ofxhost_set_allocator(void *(*mallocFunc)(size_t size), void (*freeFunc)(void *ptr)) {
+  attributeBufferSetAllocator(mallocFunc, freeFunc);
+}
+
+void ofxhost_trim_memory(void) {
+  attributeBufferPoolTrim();
+}
+
+void ofxhost_set_temp_directory(const char *(*tempDirectoryFunc)(void)) {
+  attributeBufferSetTempDirectory(tempDirectoryFunc);
+}
+
+void ofxhost_set_parallel_for(void (*parallelForFunc)(unsigned int count,
+                                                      void (*func)(unsigned int index,
+                                                                   void *userData),
+                                                      void *userData)) {
+  multiThreadSetParallelFor(parallelForFunc);
+}
@@ -48,8 +48,50 @@ void ofxhost_release_descriptor(OfxMeshEffectHandle effectDescriptor);
 bool ofxhost_create_instance(OfxPlugin *plugin, OfxMeshEffectHandle effectDescriptor, OfxMeshEffectHandle *effectInstance);
 void ofxhost_destroy_instance(OfxPlugin *plugin, OfxMeshEffectHandle effectInstance);
 bool ofxhost_cook(OfxPlugin *plugin, OfxMeshEffectHandle effectInstance);
+// Cook asking for the outputs at several times, the first one being the cook time
+// (see kOfxMeshEffectPropSampleTimes). sampleTimes must remain valid during the cook.
+bool ofxhost_cook_samples(OfxPlugin *plugin, OfxMeshEffectHandle effectInstance, const OfxTime *sampleTimes, int sampleCount);
 bool ofxhost_is_identity(OfxPlugin *plugin, OfxMeshEffectHandle effectInstance, bool *shouldCook);
 
+/**
+ * Memory used by an effect instance, in bytes. Attribute buffers are the ones
+ * allocated by the host for the meshes of its inputs, plugin memory is the one
+ * allocated through the memory suite for this instance. Peaks are measured
+ * since the beginning of the last cook.
+ */
+typedef struct OfxHostMemoryUsage {
+  size_t attributeBytes;
+  size_t attributePeakBytes;
+  size_t pluginBytes;
+  size_t pluginPeakBytes;
+} OfxHostMemoryUsage;
+
+void ofxhost_get_instance_memory_usage(OfxMeshEffectHandle effectInstance, OfxHostMemoryUsage *usage);
+
+// Memory used by all the effects: buffers in use, allocated from the heap or mapped from
+// temporary files (see kOfxMeshPropOutOfCore), and blocks kept for later reuse.
+void ofxhost_get_memory_usage(size_t *allocatedBytes, size_t *mappedBytes, size_t *pooledBytes);
+
+// Route the allocations of the host and of the memory suite to other functions than malloc()
+// and free(), to have the application account for them. Must be called before cooking anything.
+void ofxhost_set_allocator(void *(*mallocFunc)(size_t size), void (*freeFunc)(void *ptr));
+
+// Free the memory kept for later reuse
+void ofxhost_trim_memory(void);
+
+// Create the temporary files backing out of core buffers (see kOfxMeshPropOutOfCore) in the
+// directory returned by tempDirectoryFunc rather than in the one of the system, which is often
+// held in memory. tempDirectoryFunc is called for each buffer and may return NULL.
+void ofxhost_set_temp_directory(const char *(*tempDirectoryFunc)(void));
+
+// Run the indices of the multi thread suite on the thread pool of the application rather than on
+// threads spawned for each call. parallelForFunc must call func for each index from 0 to count - 1
+// and return once they all ran. Must be called before cooking anything.
+void ofxhost_set_parallel_for(void (*parallelForFunc)(unsigned int count,
+                                                      void (*func)(unsigned int index,
+                                                                   void *userData),
+                                                      void *userData));
+
 #ifdef __cplusplus
 }
 #endif
@@ -54,6 +54,12 @@ typedef struct PluginRegistry {
     int num_plugins;
     OfxPlugin **plugins;
     OfxPluginStatus *status;
+    // Number of users of each plugin that is loaded, see registry_acquire_plugin()
+    int *load_counts;
+    // Descriptors of the plugins when the registry was preloaded, NULL
+    // otherwise. Plugins that have a descriptor there are loaded and owned by
+    // the registry, others failed to load.
+    struct OfxMeshEffectStruct **descriptors;
 } PluginRegistry;
 
 /**
@@ -64,6 +70,28 @@ typedef struct PluginRegistry {
  */
 bool load_registry(PluginRegistry *registry, const char *ofx_filepath);
 
+/**
+ * Load and describe all the plugins of the registry, filling its descriptors.
+ * /pre registry has been allocated and none of its plugins is loaded
+ */
+void describe_registry(PluginRegistry *registry, OfxHost *host);
+
+/**
+ * Load the plugin at index if it is not loaded yet, and count a new user of
+ * it. Modifiers and geometry nodes using the same registry share the loaded
+ * plugin this way. Thread safe.
+ * /pre registry has been allocated
+ * /post if true is returned, the plugin is loaded until the matching call to
+ *       registry_release_plugin()
+ */
+bool registry_acquire_plugin(PluginRegistry *registry, int index, OfxHost *host);
+
+/**
+ * Unregister a user of the plugin at index, unloading it if it was the last
+ * one. Thread safe.
+ */
+void registry_release_plugin(PluginRegistry *registry, int index);
+
 /**
  * /pre registry has been allocated
  * /post registry will never be used again
@@ -41,6 +41,21 @@ PluginRegistry *get_registry(const char *ofx_filepath);
 
 void release_registry(const char *ofx_filepath);
 
+/**
+ * Start loading and describing, in a background thread, the plugins of all
+ * .ofx files found in the directories of search_path, separated by ':' (';'
+ * on Windows). get_registry() then returns preloaded registries, whose
+ * descriptors are filled, and waits if the file is being loaded.
+ * Must be called from the thread that uses the global host.
+ */
+void preload_registries(const char *search_path);
+
+/**
+ * Stop preloading and release the registries that were preloaded, which are
+ * freed unless get_registry() was called for them.
+ */
+void release_preloaded_registries(void);
+
 #ifdef __cplusplus
 }
 #endif
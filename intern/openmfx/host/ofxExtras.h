@@ -65,6 +65,83 @@ typedef OfxStatus (*BeforeMeshReleaseCbFunc)(OfxHost*, OfxMeshHandle);
 
 typedef OfxStatus (*BeforeMeshGetCbFunc)(OfxHost*, OfxMeshHandle);
 
+/**
+ * Custom callback called at the beginning of meshAlloc(), once the element
+ * counts of an output mesh are known. It may point owned attributes to buffers
+ * of the internal representation that is eventually built from the mesh, and
+ * turn their kOfxMeshAttribPropIsOwner false, so that the effect writes there
+ * directly rather than in buffers allocated by the host and copied afterwards.
+ *
+ * Callback signature must be:
+ *   OfxStatus callback(OfxHost *host, OfxPropertySetHandle meshHandle);
+ * (type BeforeMeshAllocCbFunc)
+ */
+#define kOfxHostPropBeforeMeshAllocCb "OfxHostPropBeforeMeshAllocCb"
+
+typedef OfxStatus (*BeforeMeshAllocCbFunc)(OfxHost*, OfxMeshHandle);
+
+/**
+ * Time at which the mesh was last got with inputGetMesh(), read by the
+ * callbacks above to tell the samples of a multi-time cook apart.
+ */
+#define kOfxMeshPropTime "OfxMeshPropTime"
+
+/**
+ * Blind pointer to some internal data used to evaluate a parameter at another
+ * time than the cook time, e.g. to locate its animation curves.
+ */
+#define kOfxParamPropInternalData "OfxParamPropInternalData"
+/**
+ * Pointer to current ofx host, set together with kOfxParamPropInternalData
+ */
+#define kOfxParamPropHostHandle "OfxParamPropHostHandle"
+
+union OfxParamValueStruct;
+
+/**
+ * Custom callback evaluating a parameter at a given time, used by
+ * paramGetValueAtTime() and co. values is filled with the current value of the
+ * parameter, and the callback overwrites the animated components or returns
+ * kOfxStatReplyDefault if the parameter is not animated at all.
+ *
+ * Callback signature must be:
+ *   OfxStatus callback(OfxHost *host, OfxParamHandle param, OfxTime time,
+ *                      OfxParamValueStruct *values);
+ * (type ParamGetValueAtTimeCbFunc)
+ */
+#define kOfxHostPropParamGetValueAtTimeCb "OfxHostPropParamGetValueAtTimeCb"
+
+typedef OfxStatus (*ParamGetValueAtTimeCbFunc)(OfxHost *,
+                                                OfxParamHandle,
+                                                OfxTime,
+                                                OfxParamValueStruct *);
+
+/**
+ * Custom callbacks backing the limit surface suite, which the host only
+ * provides when they are set.
+ *
+ * The creation callback builds whatever the internal representation of an
+ * input mesh needs to evaluate its limit surface, and returns it as a blind
+ * pointer that is given back to the other two callbacks.
+ *
+ * Callback signatures must be:
+ *   OfxStatus create(OfxHost *host, OfxMeshHandle meshHandle, int quality,
+ *                    void **limitSurfaceData);
+ *   OfxStatus evaluate(void *limitSurfaceData, int count, const int *faces,
+ *                      const float *coords, float *positions, float *normals);
+ *   void destroy(void *limitSurfaceData);
+ * (types LimitSurfaceCreateCbFunc, LimitSurfaceEvaluateCbFunc and
+ * LimitSurfaceDestroyCbFunc)
+ */
+#define kOfxHostPropLimitSurfaceCreateCb "OfxHostPropLimitSurfaceCreateCb"
+#define kOfxHostPropLimitSurfaceEvaluateCb "OfxHostPropLimitSurfaceEvaluateCb"
+#define kOfxHostPropLimitSurfaceDestroyCb "OfxHostPropLimitSurfaceDestroyCb"
+
+typedef OfxStatus (*LimitSurfaceCreateCbFunc)(OfxHost *, OfxMeshHandle, int, void **);
+typedef OfxStatus (*LimitSurfaceEvaluateCbFunc)(
+    void *, int, const int *, const float *, float *, float *);
+typedef void (*LimitSurfaceDestroyCbFunc)(void *);
+
 /**
  * Internal property on attributes that are used to store attribute requests
  */
@@ -112,6 +112,12 @@ attributes include a position for points, a point index for corners and a corner
  */
 #define kOfxMeshAttribMesh "OfxMeshAttribMesh"
 
+/** @brief Mesh attribute attachment to loose edges
+
+Only used by meshes of inputs that set \ref kOfxInputPropLooseEdgeAttachment, see there.
+ */
+#define kOfxMeshAttribEdge "OfxMeshAttribEdge"
+
 /** @brief Name of the point attribute for position
  */
 #define kOfxMeshAttribPointPosition "OfxMeshAttribPointPosition"
@@ -126,6 +132,35 @@ attributes include a position for points, a point index for corners and a corner
  */
 #define kOfxMeshAttribFaceSize "OfxMeshAttribFaceSize"
 
+/** @brief Name of the edge attribute for the indices of the two points of a loose edge
+ *
+ * This is an int attribute with 2 components, defined on meshes of inputs that set
+ * \ref kOfxInputPropLooseEdgeAttachment.
+ */
+#define kOfxMeshAttribEdgePoint "OfxMeshAttribEdgePoint"
+
+/** @brief Name of the point attribute for the transform of an instance
+
+This is a float attribute with 16 components storing a transform matrix in row major order, like
+\ref kOfxMeshPropTransformMatrix. When an output mesh has this attribute and no face, hosts that
+support instancing turn each point into an instance of the geometry of another input rather than
+into a vertex, without realizing the instanced geometry. Point positions are then ignored. The
+instanced input is given by \ref kOfxMeshAttribPointInstanceInput.
+
+Hosts that do not support instancing output the points as regular points.
+ */
+#define kOfxMeshAttribPointInstanceTransform "OfxMeshAttribPointInstanceTransform"
+
+/** @brief Name of the point attribute for the input instanced by a point
+
+This is an int attribute with 1 component giving the index of the instanced input among the
+inputs that are neither the main input nor the main output, in the order in which they were
+defined. It is only used together with \ref kOfxMeshAttribPointInstanceTransform and when it is
+missing all points instance the first such input. Points referring to an input that has no
+geometry are skipped.
+ */
+#define kOfxMeshAttribPointInstanceInput "OfxMeshAttribPointInstanceInput"
+
 /** @brief Attribute type unsigned integer 8 bit
  */
 #define kOfxMeshAttribTypeUByte "OfxMeshAttribTypeUByte"
@@ -138,6 +173,22 @@ attributes include a position for points, a point index for corners and a corner
  */
 #define kOfxMeshAttribTypeFloat "OfxMeshAttribTypeFloat"
 
+/** @brief Attribute type float 16 bit (IEEE 754 half precision)
+ */
+#define kOfxMeshAttribTypeHalf "OfxMeshAttribTypeHalf"
+
+/** @brief Attribute type integer 16 bit
+ */
+#define kOfxMeshAttribTypeShort "OfxMeshAttribTypeShort"
+
+/** @brief Attribute type unsigned integer 16 bit
+ */
+#define kOfxMeshAttribTypeUShort "OfxMeshAttribTypeUShort"
+
+/** @brief Attribute type float 64 bit
+ */
+#define kOfxMeshAttribTypeDouble "OfxMeshAttribTypeDouble"
+
 /** @brief Attribute semantic for texture coordinates (sometimes called "UV")
 
 Such attribute is usually attached to corners (or sometimes to points), has 2 floats or 3 floats
@@ -166,6 +217,16 @@ Weights are simple scalar values (i.e. 1-component floats), often softly limited
  */
 #define kOfxMeshAttribSemanticWeight "OfxMeshAttribSemanticWeight"
 
+/** @brief Attribute layout where the components of an element are next to each other
+(array of structures)
+ */
+#define kOfxMeshAttribLayoutInterleaved "OfxMeshAttribLayoutInterleaved"
+
+/** @brief Attribute layout where each component is stored in its own contiguous plane
+(structure of arrays)
+ */
+#define kOfxMeshAttribLayoutPlanar "OfxMeshAttribLayoutPlanar"
+
 /*@}*/
 
 /**
@@ -199,6 +260,7 @@ For more details on how to deal with actions, see \ref MeshEffectActions.
  @param  handle handle to the instance, cast to an \ref OfxMeshEffectHandle
  @param  inArgs has the following properties
      - \ref kOfxPropTime the time at which to test for identity
+     - \ref kOfxMeshEffectPropRenderQualityDraft whether the result is a preview
 
  @param  outArgs has the following properties which the plugin can set
      - \ref kOfxPropName
@@ -238,6 +300,9 @@ For more details on how to deal with actions, see \ref MeshEffectActions.
  @param  handle handle to the instance, cast to an \ref OfxMeshEffectHandle
  @param  inArgs has the following properties
      -  \ref kOfxPropTime the time at which to cook
+     -  \ref kOfxMeshEffectPropRenderQualityDraft whether the result is a preview
+     -  \ref kOfxMeshEffectPropSampleCount and \ref kOfxMeshEffectPropSampleTimes
+        the times at which the host would like outputs, if there are several
 
  @param  outArgs is redundant and should be set to NULL
 
@@ -331,6 +396,27 @@ true might enable optimizations from the host.
  */
 #define kOfxMeshEffectPropIsDeformation "OfxMeshEffectPropIsDeformation"
 
+/** @brief Tells whether the effect processes each connected component of its
+main input independently of the others
+
+   - Type - bool X 1
+   - Property Set - mesh effect descriptor (read only)
+   - Default - 0
+   - Valid Values - 0 or 1
+
+Set in the describe action by effects whose output for a set of connected
+components (vertices linked by edges, with their faces) does not depend on the
+rest of the main input, e.g. per island smoothing or transforms. The host may
+then split the main input into groups of components, cook them concurrently on
+several instances of the effect and join their main outputs, so that the
+effect must support being cooked by several instances at once. When the output
+of every group has the same topology as its input, output elements are put back
+at the index of their input element, so that the element order is the one of a
+single cook. Otherwise group outputs are concatenated in an order that does not
+depend on the number of threads of the host.
+ */
+#define kOfxMeshEffectPropIslandIndependent "OfxMeshEffectPropIslandIndependent"
+
 /** @brief The plugin handle passed to the initial 'describe' action.
 
    - Type - pointer X 1
@@ -352,6 +438,52 @@ This value will be the same for all instances of a plugin.
  */
 #define kOfxMeshEffectPropContext "OfxMeshEffectPropContext"
 
+/** @brief Tells whether the effect is cooked for an interactive preview rather
+than for a final render
+
+   - Type - bool X 1
+   - Property Set - mesh effect instance (read only), inArgs of
+     ::kOfxMeshEffectActionIsIdentity and ::kOfxMeshEffectActionCook
+   - Default - 0
+   - Valid Values - 0 or 1
+
+When 1, the host is evaluating the effect for its viewport and the effect may
+trade quality for speed, e.g. by using a coarser resolution. The host may also
+have simplified the input meshes itself.
+ */
+#define kOfxMeshEffectPropRenderQualityDraft "OfxMeshEffectPropRenderQualityDraft"
+
+/** @brief Number of times at which the host asks for the outputs of a cook
+
+   - Type - int X 1
+   - Property Set - inArgs of ::kOfxMeshEffectActionCook (read only)
+   - Default - 1
+   - Valid Values - greater than or equal to 1
+
+When greater than 1, e.g. to get the motion blur steps of a render, the host
+would like the outputs at each of the times listed in
+\ref kOfxMeshEffectPropSampleTimes. The effect may then get, fill and release
+the output mesh once per sample, calling inputGetMesh with the time of the
+sample, and read inputs and parameters at that time with inputGetMesh and
+paramGetValueAtTime. Work that only depends on topology can be shared across
+samples. An output sample must be released before the next one is got.
+
+Effects that ignore this property output a single mesh at \ref kOfxPropTime,
+and the host cooks again for the other times.
+ */
+#define kOfxMeshEffectPropSampleCount "OfxMeshEffectPropSampleCount"
+
+/** @brief Times at which the host asks for the outputs of a cook
+
+   - Type - pointer X 1
+   - Property Set - inArgs of ::kOfxMeshEffectActionCook (read only)
+   - Valid Values - pointer to \ref kOfxMeshEffectPropSampleCount OfxTime values,
+     the first one being \ref kOfxPropTime
+
+Only set when \ref kOfxMeshEffectPropSampleCount is greater than 1.
+ */
+#define kOfxMeshEffectPropSampleTimes "OfxMeshEffectPropSampleTimes"
+
 /** @brief The number of points in a mesh
 
     - Type - integer X 1
@@ -385,7 +517,7 @@ This property is the number of faces allocated in the mesh object.
     - Property Set - a mesh instance
 
 This property is the number of attributes stored in the mesh object. Attributes can be attached to
-either points, corners, faces or the whole mesh. There are at least three attributes in a geometry
+either points, corners, faces, loose edges or the whole mesh. There are at least three attributes in a geometry
 namely the point's position, the corner's point association and the face's corner count.
  */
 #define kOfxMeshPropAttributeCount "OfxMeshPropAttributeCount"
@@ -399,9 +531,21 @@ This property is true by default and must be turned false when the mesh has loos
 that are not part of any face (a loose edge is a 2-corners faces). Turning this false when there is
 actually no loose edge must not change any behavior but may affect performances since a host might use
 this information to speed up processing of loose-edge free meshes.
+On an output mesh, hosts may read it as early as in meshAlloc, so it must be set before.
  */
 #define kOfxMeshPropNoLooseEdge "OfxMeshPropNoLooseEdge"
 
+/** @brief The number of loose edges stored in the edge attachment of a mesh
+
+    - Type - integer X 1
+    - Property Set - a mesh instance
+    - Default - 0
+
+Only used by meshes of inputs that set \ref kOfxInputPropLooseEdgeAttachment. Loose edges
+counted here are not part of the faces, so they do not turn \ref kOfxMeshPropNoLooseEdge false.
+ */
+#define kOfxMeshPropLooseEdgeCount "OfxMeshPropLooseEdgeCount"
+
 /** @brief Number of corners per face, or -1.
 
     - Type - int X 1
@@ -446,6 +590,89 @@ Default to false.
  */
 #define kOfxInputPropRequestTransform "OfxInputPropRequestTransform"
 
+/** @brief Whether the input is an output of the effect
+
+    - Type - bool X 1
+    - Property Set - an input's property set
+    - Default - 0, but always 1 for \ref kOfxMeshMainOutput
+
+Can be set in describe mode to declare outputs besides the main output, e.g. one per part of a
+split mesh or per level of detail, so that a single cook fills them all. Their meshes are empty
+when got and are filled like the main output, by setting element counts and calling meshAlloc().
+Hosts route each one to a separate destination, and may not use all of them, in which case getting
+the mesh of an unused output fails with ::kOfxStatErrBadHandle, as for inputs connected to nothing.
+
+Outputs that keep the topology of the main input, like the main output of a deformer, may point
+their \ref kOfxMeshAttribCornerPoint and \ref kOfxMeshAttribFaceSize attributes to the buffers of
+the input mesh with \ref kOfxMeshAttribPropIsOwner set to false, rather than copying them. Hosts
+may then share the topology of the input with all such outputs. The input mesh must in that case
+be released after the outputs.
+ */
+#define kOfxInputPropIsOutput "OfxInputPropIsOutput"
+
+/** @brief Whether loose edges of the input mesh are stored apart from its faces
+
+    - Type - bool X 1
+    - Property Set - an input's property set
+    - Default - 0
+
+Can be set in describe mode to get the loose edges of the input mesh in the
+\ref kOfxMeshAttribEdge attachment rather than as 2-corner faces appended to the other faces.
+Their count is then given by \ref kOfxMeshPropLooseEdgeCount and their points by
+\ref kOfxMeshAttribEdgePoint, while corners and faces only hold the actual faces. This lets the
+host share its own corner and face buffers even when the mesh has a few loose edges.
+
+Set on an output, it tells that the effect may output loose edges the same way, by setting
+\ref kOfxMeshPropLooseEdgeCount before calling meshAlloc(). 2-corner faces remain loose edges.
+ */
+#define kOfxInputPropLooseEdgeAttachment "OfxInputPropLooseEdgeAttachment"
+
+/** @brief Memory layout of the attribute buffers of a mesh
+
+    - Type - string X 1
+    - Property Set - an input's property set, a mesh
+    - Default - \ref kOfxMeshAttribLayoutInterleaved
+
+Can be set on an input in describe mode to ask the host for contiguous buffers using the given
+layout for all the attributes of the input mesh, including point positions, rather than proxies to
+its own strided buffers. This is typically used by vectorized effects, with
+\ref kOfxMeshAttribLayoutPlanar. Setting it on an output mesh before calling meshAlloc() tells how
+buffers are allocated. Attributes tell how to address each component with
+\ref kOfxMeshAttribPropComponentStride.
+ */
+#define kOfxMeshPropAttributeLayout "OfxMeshPropAttributeLayout"
+
+/** @brief Minimum alignment, in bytes, of attribute buffers
+
+    - Type - int X 1
+    - Property Set - an input's property set, a mesh
+    - Default - 0
+
+When not zero, buffers provided by the host start at an address that is a multiple of this value,
+as does each plane of a planar attribute. Must be a power of two, typically 16 or 32. Like
+\ref kOfxMeshPropAttributeLayout, it may be set on inputs and on output meshes, and a non zero
+value implies contiguous buffers.
+ */
+#define kOfxMeshPropAttributeAlignment "OfxMeshPropAttributeAlignment"
+
+/** @brief Whether attribute buffers allocated by the host may live out of core
+
+    - Type - bool X 1
+    - Property Set - an input's property set, a mesh
+    - Default - 0
+    - Valid Values - 0 or 1
+
+When 1, buffers that the host allocates for this mesh in meshAlloc are backed
+by memory-mapped temporary files rather than memory. They are still addressed
+through contiguous pointers, but the elements that the effect has released with
+meshReleaseRange (see \ref OfxMeshOutOfCoreSuiteV1) can be written to storage
+and dropped from memory, so that effects processing huge meshes block by block
+keep a bounded memory footprint.
+Like \ref kOfxMeshPropAttributeLayout, it may be set on inputs, in which case
+it is forwarded to their meshes, and on output meshes before meshAlloc.
+ */
+#define kOfxMeshPropOutOfCore "OfxMeshPropOutOfCore"
+
 /**  @brief The data pointer of an attribute.
 
     - Type - pointer X 1
@@ -479,12 +706,24 @@ in the buffer to which the data property points.
 */
 #define kOfxMeshAttribPropStride "OfxMeshAttribPropStride"
 
+/**  @brief The stride between the components of an attribute.
+
+    - Type - int X 1
+    - Property Set - a mesh attribute (read only)
+
+Number of bytes between two consecutive components of a value, so that component i of value j is at
+data + j * stride + i * componentStride. This is the size of the attribute type for interleaved
+layouts, which is also what 0 means.
+*/
+#define kOfxMeshAttribPropComponentStride "OfxMeshAttribPropComponentStride"
+
 /**  @brief The number of components an attribute.
 
     - Type - int X 1
     - Property Set - a mesh attribute (read only)
 
-An attribute can have between 1 and 4 components.
+An attribute can have between 1 and 4 components, or 16 components for float
+attributes storing a 4x4 matrix such as \ref kOfxMeshAttribPointInstanceTransform.
 */
 #define kOfxMeshAttribPropComponentCount "OfxMeshAttribPropComponentCount"
 
@@ -493,8 +732,9 @@ An attribute can have between 1 and 4 components.
     - Type - string X 1
     - Property Set - a mesh attribute (read only)
 
-Possible values are \ref kOfxMeshAttribTypeFloat, \ref kOfxMeshAttribTypeInt
-or \ref kOfxMeshAttribTypeUByte
+Possible values are \ref kOfxMeshAttribTypeFloat, \ref kOfxMeshAttribTypeInt,
+\ref kOfxMeshAttribTypeUByte, \ref kOfxMeshAttribTypeHalf, \ref kOfxMeshAttribTypeShort,
+\ref kOfxMeshAttribTypeUShort or \ref kOfxMeshAttribTypeDouble
 */
 #define kOfxMeshAttribPropType "OfxMeshAttribPropType"
 
@@ -638,7 +878,7 @@ typedef struct OfxMeshEffectSuiteV1 {
       \arg attachment       - attribute attachment (see \ref MeshAttrib)
       \arg name             - attribute name
       \arg componentCount   - number of components in the attribute, from 1 to 4 (1 is a scalar
-                              attribute, 2 is a vector2, etc.)
+                              attribute, 2 is a vector2, etc.), or 16 for a float 4x4 matrix
       \arg type             - type of the attribute data (float or int, see \ref MeshAttrib)
       \arg semantic        - optional semantic of the attribute data (see \ref MeshAttrib), might be NULL
       \arg mandatory        - whether the attribute is mandatory or not.
@@ -725,7 +965,7 @@ If inputGetMesh is called twice with the same parameters, then two separate mesh
       \arg attachment       - attribute attachment (see \ref MeshAttrib)
       \arg name             - attribute name
       \arg componentCount   - number of components in the attribute, from 1 to 4 (1 is a scalar
-                              attribute, 2 is a vector2, etc.)
+                              attribute, 2 is a vector2, etc.), or 16 for a float 4x4 matrix
       \arg type             - type of the attribute data (float or int, see \ref MeshAttrib)
       \arg semantic        - optional semantic of the attribute data (see \ref MeshAttrib), might be NULL
       \arg attributeHandle  - property set for returning attribute properties, might be NULL.
@@ -809,6 +1049,13 @@ By default, the attribute data is not owned by the mesh (kOfxMeshAttribPropIsOwn
  - all attribut data pointers for which kOfxMeshAttribPropIsOwner is 1 have been allocated
  - meshHandle attributes will no longer change (no call to meshDefineAttribute)
 
+Rather than allocating them, the host may point some of these attributes to its own storage
+for the output, turning their kOfxMeshAttribPropIsOwner to 0, so that the mesh is not held twice
+in memory. Unless the mesh sets \ref kOfxMeshPropAttributeLayout or
+\ref kOfxMeshPropAttributeAlignment, these buffers may be strided, so effects must address them
+using kOfxMeshAttribPropStride. Setting the element counts and \ref kOfxMeshPropNoLooseEdge to
+their final values beforehand lets the host size this storage.
+
 @returns
 - ::kOfxStatOK           - the mesh was successfully allocated,
 - ::kOfxStatErrBadHandle - the mesh handle was invalid,
@@ -834,6 +1081,134 @@ By default, the attribute data is not owned by the mesh (kOfxMeshAttribPropIsOwn
 
 } OfxMeshEffectSuiteV1;
 
+/** @brief the string that names out of core suites, passed to OfxHost::fetchSuite */
+#define kOfxMeshOutOfCoreSuite "OfxMeshOutOfCoreSuite"
+
+/** @brief Optional suite for effects streaming through out of core meshes
+
+Hosts that do not support out of core meshes (see \ref kOfxMeshPropOutOfCore)
+may not provide it, in which case fetchSuite returns NULL and effects can simply
+skip releasing ranges.
+ */
+typedef struct OfxMeshOutOfCoreSuiteV1 {
+  /** @brief Tell the host that a range of elements of a mesh will no longer be accessed
+
+      \arg meshHandle  - mesh handle
+      \arg attachment  - attachment of the elements (see \ref MeshAttrib)
+      \arg start       - index of the first element of the range
+      \arg count       - number of elements in the range
+
+  Meant for effects that stream through huge meshes by blocks of elements: once
+  a block of an input has been read, or a block of an output has been written,
+  releasing it lets the host write the attribute buffers it owns for this range
+  to storage and drop them from memory when the mesh is out of core (see
+  \ref kOfxMeshPropOutOfCore). Released elements remain valid and may still be
+  accessed, at the cost of reading them back. This does nothing for other meshes
+  and for attributes that the host does not own.
+
+\pre
+ - meshHandle was returned by inputGetMesh and has been allocated
+
+@returns
+- ::kOfxStatOK           - the range was released (or nothing needed to be done),
+- ::kOfxStatErrBadIndex  - the attachment is not valid,
+- ::kOfxStatErrValue     - the range does not fit in the elements of the mesh,
+- ::kOfxStatErrBadHandle - the mesh handle was invalid.
+ */
+  OfxStatus (*meshReleaseRange)(OfxMeshHandle meshHandle,
+                                const char *attachment,
+                                int start,
+                                int count);
+
+} OfxMeshOutOfCoreSuiteV1;
+
+/** @brief the string that names limit surface suites, passed to OfxHost::fetchSuite */
+#define kOfxMeshLimitSurfaceSuite "OfxMeshLimitSurfaceSuite"
+
+/** @brief Blind declaration of the limit surface of a mesh, as created by limitSurfaceCreate */
+typedef struct OfxMeshLimitSurfaceStruct *OfxMeshLimitSurfaceHandle;
+
+/** @brief Optional suite evaluating the Catmull-Clark limit surface of an input mesh
+
+This lets an effect sample the smooth surface that a subdivision of its input
+converges to, at arbitrary locations, without the input being subdivided
+beforehand. Hosts that cannot evaluate limit surfaces do not provide it, in
+which case fetchSuite returns NULL.
+
+Locations are given in the coordinates of a face of the input mesh. For a face
+of 4 corners, (u, v) spans the whole face, from its first corner at (0, 0), u
+going towards its second corner and v towards its last one. Other faces are made
+of one quad patch per corner, going from the corner at (0, 0) to the middle of
+the face at (1, 1), u towards the next corner and v towards the previous one.
+The integer part of u then tells the corner, so that u spans [0, n] for a face
+of n corners.
+ */
+typedef struct OfxMeshLimitSurfaceSuiteV1 {
+  /** @brief Prepare the evaluation of the limit surface of an input mesh
+
+      \arg meshHandle    input mesh, as returned by inputGetMesh
+      \arg quality       accuracy of the evaluation, from 1 to 10, at the cost of
+                         a longer creation
+      \arg limitSurface  pointer to the limit surface handle, value is returned here
+
+  Creases of the input are taken into account. The host may keep what it builds
+  from one cook to the next as long as the topology of the input does not change,
+  so that creating the limit surface is cheap when only positions move.
+
+\pre
+ - meshHandle is an input mesh that has not been released
+
+\post
+ - limitSurface must be destroyed with limitSurfaceDestroy before meshHandle is released
+
+@returns
+- ::kOfxStatOK             - the limit surface was created,
+- ::kOfxStatErrBadHandle   - the mesh handle was invalid,
+- ::kOfxStatErrUnsupported - the host cannot evaluate the limit surface of this mesh,
+                             e.g. because it has no face,
+- ::kOfxStatFailed         - the limit surface could not be built.
+ */
+  OfxStatus (*limitSurfaceCreate)(OfxMeshHandle meshHandle,
+                                  int quality,
+                                  OfxMeshLimitSurfaceHandle *limitSurface);
+
+  /** @brief Evaluate the limit surface at a batch of locations
+
+      \arg limitSurface  limit surface handle
+      \arg count         number of locations
+      \arg faces         index of the face of each location, count ints
+      \arg coords        (u, v) coordinates of each location in its face, 2 * count floats
+      \arg positions     position of each location, 3 * count floats written here (may be NULL)
+      \arg normals       unit normal of each location, 3 * count floats written here (may be NULL)
+
+  Locations are independent, so an effect may evaluate several batches from
+  different threads at once on the same limit surface.
+
+@returns
+- ::kOfxStatOK           - the locations were evaluated,
+- ::kOfxStatErrBadHandle - the limit surface handle was invalid,
+- ::kOfxStatErrBadIndex  - a face index was out of range, in which case nothing is evaluated,
+- ::kOfxStatErrValue     - an array was NULL, or both positions and normals were.
+ */
+  OfxStatus (*limitSurfaceEvaluate)(OfxMeshLimitSurfaceHandle limitSurface,
+                                    int count,
+                                    const int *faces,
+                                    const float *coords,
+                                    float *positions,
+                                    float *normals);
+
+  /** @brief Free a limit surface created by limitSurfaceCreate
+
+      \arg limitSurface  limit surface handle
+
+@returns
+- ::kOfxStatOK           - the limit surface was destroyed,
+- ::kOfxStatErrBadHandle - the limit surface handle was invalid.
+ */
+  OfxStatus (*limitSurfaceDestroy)(OfxMeshLimitSurfaceHandle limitSurface);
+
+} OfxMeshLimitSurfaceSuiteV1;
+
 
 
 #ifdef __cplusplus
@@ -15,11 +15,14 @@
  */
 
 /**
- * TODO: At the moment this only copies the position attribute and topology. We should copy all
- * available attributes but there is no mechanism yet to query the list of existing attributes.
+ * Forward the input mesh to the output without copying it.
+ * TODO: At the moment this only forwards the position attribute, topology and UV/color layers. We
+ * should forward all available attributes but there is no mechanism yet to query the list of
+ * existing attributes.
  */
 
 #include <stdbool.h>
+#include <stdio.h>
 #include <string.h>
 
 #include "ofxCore.h"
@@ -48,6 +51,54 @@ static OfxStatus describe(PluginRuntime *runtime, OfxMeshEffectHandle descriptor
     return kOfxStatOK;
 }
 
+// Make an output attribute point to the buffer of the input attribute, without copying it.
+// The output attribute is defined if it does not exist. This has to be done prior to meshAlloc.
+static OfxStatus forwardAttribute(PluginRuntime *runtime,
+                                  OfxMeshHandle input_mesh,
+                                  OfxMeshHandle output_mesh,
+                                  const char *attachment,
+                                  const char *name) {
+    const OfxMeshEffectSuiteV1 *meshEffectSuite = runtime->meshEffectSuite;
+    const OfxPropertySuiteV1 *propertySuite = runtime->propertySuite;
+    OfxStatus status;
+
+    OfxPropertySetHandle input_attrib, output_attrib;
+    status = meshEffectSuite->meshGetAttribute(input_mesh, attachment, name, &input_attrib);
+    if (kOfxStatOK != status) {
+        return status;
+    }
+
+    void *data;
+    int stride, component_stride, component_count;
+    char *type, *semantic;
+    propertySuite->propGetPointer(input_attrib, kOfxMeshAttribPropData, 0, &data);
+    propertySuite->propGetInt(input_attrib, kOfxMeshAttribPropStride, 0, &stride);
+    propertySuite->propGetInt(input_attrib, kOfxMeshAttribPropComponentStride, 0, &component_stride);
+    propertySuite->propGetInt(input_attrib, kOfxMeshAttribPropComponentCount, 0, &component_count);
+    propertySuite->propGetString(input_attrib, kOfxMeshAttribPropType, 0, &type);
+    propertySuite->propGetString(input_attrib, kOfxMeshAttribPropSemantic, 0, &semantic);
+
+    status = meshEffectSuite->meshGetAttribute(output_mesh, attachment, name, &output_attrib);
+    if (kOfxStatOK != status) {
+        status = meshEffectSuite->attributeDefine(output_mesh,
+                                                  attachment,
+                                                  name,
+                                                  component_count,
+                                                  type,
+                                                  NULL != semantic && '\0' != semantic[0] ? semantic : NULL,
+                                                  &output_attrib);
+        if (kOfxStatOK != status) {
+            return status;
+        }
+    }
+
+    propertySuite->propSetInt(output_attrib, kOfxMeshAttribPropIsOwner, 0, 0);
+    propertySuite->propSetPointer(output_attrib, kOfxMeshAttribPropData, 0, data);
+    propertySuite->propSetInt(output_attrib, kOfxMeshAttribPropStride, 0, stride);
+    propertySuite->propSetInt(output_attrib, kOfxMeshAttribPropComponentStride, 0, component_stride);
+    return kOfxStatOK;
+}
+
 static OfxStatus cook(PluginRuntime *runtime, OfxMeshEffectHandle instance) {
     const OfxMeshEffectSuiteV1 *meshEffectSuite = runtime->meshEffectSuite;
     const OfxPropertySuiteV1 *propertySuite = runtime->propertySuite;
@@ -66,50 +117,46 @@ static OfxStatus cook(PluginRuntime *runtime, OfxMeshEffectHandle instance) {
 
     // Get input mesh data
     int input_point_count = 0, input_corner_count = 0, input_face_count = 0;
+    int no_loose_edge = 1, constant_face_size = -1;
     propertySuite->propGetInt(input_mesh_prop, kOfxMeshPropPointCount, 0, &input_point_count);
     propertySuite->propGetInt(input_mesh_prop, kOfxMeshPropCornerCount, 0, &input_corner_count);
     propertySuite->propGetInt(input_mesh_prop, kOfxMeshPropFaceCount, 0, &input_face_count);
-
+    propertySuite->propGetInt(input_mesh_prop, kOfxMeshPropNoLooseEdge, 0, &no_loose_edge);
+    propertySuite->propGetInt(input_mesh_prop, kOfxMeshPropConstantFaceSize, 0, &constant_face_size);
 
     // Allocate output mesh
-    int output_point_count = input_point_count;
-    int output_corner_count = input_corner_count;
-    int output_face_count = input_face_count;
-
-    propertySuite->propSetInt(output_mesh_prop, kOfxMeshPropPointCount, 0, output_point_count);
-    propertySuite->propSetInt(output_mesh_prop, kOfxMeshPropCornerCount, 0, output_corner_count);
-    propertySuite->propSetInt(output_mesh_prop, kOfxMeshPropFaceCount, 0, output_face_count);
-
-    // Two alternatives are possible, either (a) copying input data (commented out bellow)
-    // or even better (b) forwarding attributes by keeping the same pointer:
-    // (This has to be done prior to meshAlloc)
-    OfxPropertySetHandle attr_props;
-    int owner = 0;
-    meshEffectSuite->meshGetAttribute(output_mesh, kOfxMeshAttribPoint, kOfxMeshAttribPointPosition, &attr_props);
-    propertySuite->propGetInt(attr_props, kOfxMeshAttribPropIsOwner, 0, &owner);
+    propertySuite->propSetInt(output_mesh_prop, kOfxMeshPropPointCount, 0, input_point_count);
+    propertySuite->propSetInt(output_mesh_prop, kOfxMeshPropCornerCount, 0, input_corner_count);
+    propertySuite->propSetInt(output_mesh_prop, kOfxMeshPropFaceCount, 0, input_face_count);
+    propertySuite->propSetInt(output_mesh_prop, kOfxMeshPropNoLooseEdge, 0, no_loose_edge);
+    propertySuite->propSetInt(output_mesh_prop, kOfxMeshPropConstantFaceSize, 0, constant_face_size);
+
+    // Rather than copying input data, attributes are forwarded by keeping the same pointer
+    forwardAttribute(runtime, input_mesh, output_mesh, kOfxMeshAttribPoint, kOfxMeshAttribPointPosition);
+    forwardAttribute(runtime, input_mesh, output_mesh, kOfxMeshAttribCorner, kOfxMeshAttribCornerPoint);
+    forwardAttribute(runtime, input_mesh, output_mesh, kOfxMeshAttribFace, kOfxMeshAttribFaceSize);
+
+    // There is no mechanism yet to query the list of existing attributes, so only UV and color
+    // layers, exposed as uv0, uv1, ..., color0, color1, ..., are forwarded.
+    char name[16];
+    for (int k = 0 ; ; ++k) {
+        snprintf(name, sizeof(name), "uv%d", k);
+        if (kOfxStatOK != forwardAttribute(runtime, input_mesh, output_mesh, kOfxMeshAttribCorner, name)) {
+            break;
+        }
+    }
+    for (int k = 0 ; ; ++k) {
+        snprintf(name, sizeof(name), "color%d", k);
+        if (kOfxStatOK != forwardAttribute(runtime, input_mesh, output_mesh, kOfxMeshAttribCorner, name)) {
+            break;
+        }
+    }
 
     meshEffectSuite->meshAlloc(output_mesh);
 
-    // Fill in output data
-
-    Attribute input_pos, output_pos;
-    getPointAttribute(input_mesh, kOfxMeshAttribPointPosition, &input_pos);
-    getPointAttribute(output_mesh, kOfxMeshAttribPointPosition, &output_pos);
-    //copyAttribute(&output_pos, &input_pos, 0, input_point_count); // (uncomment when copying data)
-
-    Attribute input_cornerpoints, output_cornerpoint;
-    getPointAttribute(input_mesh, kOfxMeshAttribCornerPoint, &input_cornerpoints);
-    getPointAttribute(output_mesh, kOfxMeshAttribCornerPoint, &output_cornerpoint);
-    copyAttribute(&output_cornerpoint, &input_cornerpoints, 0, input_corner_count);
-
-    Attribute input_facesize, output_facesize;
-    getPointAttribute(input_mesh, kOfxMeshAttribFaceSize, &input_facesize);
-    getPointAttribute(output_mesh, kOfxMeshAttribFaceSize, &output_facesize);
-    copyAttribute(&output_facesize, &input_facesize, 0, input_face_count);
-
-    // Release meshes
-    meshEffectSuite->inputReleaseMesh(input_mesh);
+    // Release meshes, output first since it points to buffers owned by the input
     meshEffectSuite->inputReleaseMesh(output_mesh);
+    meshEffectSuite->inputReleaseMesh(input_mesh);
     return kOfxStatOK;
 }
 
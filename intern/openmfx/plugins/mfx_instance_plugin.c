@@ -0,0 +1,194 @@
+/*
+ * Copyright 2019-2021 Elie Michel
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Instance the geometry of the "Instance" input on each point of the main input, using
+ * kOfxMeshAttribPointInstanceTransform. Hosts that do not support instancing output the points.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "ofxCore.h"
+#include "ofxMeshEffect.h"
+#include "util/plugin_support.h"
+
+static OfxStatus describe(OfxMeshEffectHandle descriptor) {
+    bool missing_suite =
+        NULL == gRuntime.propertySuite ||
+        NULL == gRuntime.parameterSuite ||
+        NULL == gRuntime.meshEffectSuite;
+    if (missing_suite) {
+        return kOfxStatErrMissingHostFeature;
+    }
+    const OfxMeshEffectSuiteV1 *meshEffectSuite = gRuntime.meshEffectSuite;
+    const OfxPropertySuiteV1 *propertySuite = gRuntime.propertySuite;
+    const OfxParameterSuiteV1 *parameterSuite = gRuntime.parameterSuite;
+
+    OfxPropertySetHandle inputProperties;
+    meshEffectSuite->inputDefine(descriptor, kOfxMeshMainInput, NULL, &inputProperties);
+    propertySuite->propSetString(inputProperties, kOfxPropLabel, 0, "Points");
+
+    // First extra input, which points instance by default
+    meshEffectSuite->inputDefine(descriptor, "Instance", NULL, &inputProperties);
+    propertySuite->propSetString(inputProperties, kOfxPropLabel, 0, "Instance");
+
+    OfxPropertySetHandle outputProperties;
+    meshEffectSuite->inputDefine(descriptor, kOfxMeshMainOutput, NULL, &outputProperties);
+    propertySuite->propSetString(outputProperties, kOfxPropLabel, 0, "Instances");
+
+    OfxParamSetHandle parameters;
+    OfxPropertySetHandle param_props;
+    meshEffectSuite->getParamSet(descriptor, &parameters);
+    parameterSuite->paramDefine(parameters, kOfxParamTypeDouble, "scale", &param_props);
+    propertySuite->propSetDouble(param_props, kOfxParamPropDefault, 0, 1.0);
+
+    return kOfxStatOK;
+}
+
+static OfxStatus cook(OfxMeshEffectHandle instance) {
+    const OfxMeshEffectSuiteV1 *meshEffectSuite = gRuntime.meshEffectSuite;
+    const OfxPropertySuiteV1 *propertySuite = gRuntime.propertySuite;
+    const OfxParameterSuiteV1 *parameterSuite = gRuntime.parameterSuite;
+    OfxTime time = 0;
+
+    OfxMeshInputHandle input, output;
+    meshEffectSuite->inputGetHandle(instance, kOfxMeshMainInput, &input, NULL);
+    meshEffectSuite->inputGetHandle(instance, kOfxMeshMainOutput, &output, NULL);
+
+    OfxMeshHandle input_mesh, output_mesh;
+    OfxPropertySetHandle input_mesh_prop, output_mesh_prop;
+    meshEffectSuite->inputGetMesh(input, time, &input_mesh, &input_mesh_prop);
+    meshEffectSuite->inputGetMesh(output, time, &output_mesh, &output_mesh_prop);
+
+    OfxParamSetHandle parameters;
+    OfxParamHandle scale_param;
+    double scale = 1.0;
+    meshEffectSuite->getParamSet(instance, &parameters);
+    parameterSuite->paramGetHandle(parameters, "scale", &scale_param, NULL);
+    parameterSuite->paramGetValue(scale_param, &scale);
+
+    int point_count = 0;
+    propertySuite->propGetInt(input_mesh_prop, kOfxMeshPropPointCount, 0, &point_count);
+
+    // Only points, each one becoming an instance
+    propertySuite->propSetInt(output_mesh_prop, kOfxMeshPropPointCount, 0, point_count);
+    propertySuite->propSetInt(output_mesh_prop, kOfxMeshPropCornerCount, 0, 0);
+    propertySuite->propSetInt(output_mesh_prop, kOfxMeshPropFaceCount, 0, 0);
+    propertySuite->propSetInt(output_mesh_prop, kOfxMeshPropNoLooseEdge, 0, 1);
+
+    OfxStatus status = meshEffectSuite->attributeDefine(output_mesh,
+                                                        kOfxMeshAttribPoint,
+                                                        kOfxMeshAttribPointInstanceTransform,
+                                                        16,
+                                                        kOfxMeshAttribTypeFloat,
+                                                        NULL,
+                                                        NULL);
+    if (kOfxStatOK != status) {
+        meshEffectSuite->inputReleaseMesh(output_mesh);
+        meshEffectSuite->inputReleaseMesh(input_mesh);
+        return status;
+    }
+
+    meshEffectSuite->meshAlloc(output_mesh);
+
+    Attribute input_pos, output_pos, transform;
+    getPointAttribute(input_mesh, kOfxMeshAttribPointPosition, &input_pos);
+    getPointAttribute(output_mesh, kOfxMeshAttribPointPosition, &output_pos);
+    getPointAttribute(output_mesh, kOfxMeshAttribPointInstanceTransform, &transform);
+
+    if (MFX_FLOAT_ATTR == input_pos.type) {
+        for (int i = 0; i < point_count; ++i) {
+            const float *src = (const float *)&input_pos.data[i * input_pos.stride];
+            float *dst = (float *)&output_pos.data[i * output_pos.stride];
+            memcpy(dst, src, 3 * sizeof(float));
+
+            // Row major scale and translation
+            float matrix[16] = {
+                (float)scale, 0.0f, 0.0f, src[0],
+                0.0f, (float)scale, 0.0f, src[1],
+                0.0f, 0.0f, (float)scale, src[2],
+                0.0f, 0.0f, 0.0f, 1.0f,
+            };
+            char *matrix_data = &transform.data[i * transform.stride];
+            for (int k = 0; k < 16; ++k) {
+                *(float *)(matrix_data + k * transform.componentStride) = matrix[k];
+            }
+        }
+    }
+    else {
+        printf("Warning: unsupported attribute type: %d", input_pos.type);
+    }
+
+    meshEffectSuite->inputReleaseMesh(input_mesh);
+    meshEffectSuite->inputReleaseMesh(output_mesh);
+    return kOfxStatOK;
+}
+
+static OfxStatus mainEntry(const char *action,
+                           const void *handle,
+                           OfxPropertySetHandle inArgs,
+                           OfxPropertySetHandle outArgs) {
+    (void)inArgs;
+    (void)outArgs;
+    if (0 == strcmp(action, kOfxActionLoad)) {
+        return kOfxStatOK;
+    }
+    if (0 == strcmp(action, kOfxActionUnload)) {
+        return kOfxStatOK;
+    }
+    if (0 == strcmp(action, kOfxActionDescribe)) {
+        return describe((OfxMeshEffectHandle)handle);
+    }
+    if (0 == strcmp(action, kOfxActionCreateInstance)) {
+        return kOfxStatOK;
+    }
+    if (0 == strcmp(action, kOfxActionDestroyInstance)) {
+        return kOfxStatOK;
+    }
+    if (0 == strcmp(action, kOfxMeshEffectActionCook)) {
+        return cook((OfxMeshEffectHandle)handle);
+    }
+    return kOfxStatReplyDefault;
+}
+
+static void setHost(OfxHost *host) {
+    gRuntime.host = host;
+    if (NULL != host) {
+      gRuntime.propertySuite = host->fetchSuite(host->host, kOfxPropertySuite, 1);
+      gRuntime.parameterSuite = host->fetchSuite(host->host, kOfxParameterSuite, 1);
+      gRuntime.meshEffectSuite = host->fetchSuite(host->host, kOfxMeshEffectSuite, 1);
+    }
+}
+
+OfxExport int OfxGetNumberOfPlugins(void) {
+    return 1;
+}
+
+OfxExport OfxPlugin *OfxGetPlugin(int nth) {
+    (void)nth;
+    static OfxPlugin plugin = {
+        /* pluginApi */          kOfxMeshEffectPluginApi,
+        /* apiVersion */         kOfxMeshEffectPluginApiVersion,
+        /* pluginIdentifier */   "InstancePlugin",
+        /* pluginVersionMajor */ 1,
+        /* pluginVersionMinor */ 0,
+        /* setHost */            setHost,
+        /* mainEntry */          mainEntry
+    };
+    return &plugin;
+}
@@ -99,6 +99,11 @@ static OfxStatus cook(OfxMeshEffectHandle instance) {
     propertySuite->propGetInt(input_mesh_prop, kOfxMeshPropCornerCount, 0, &input_corner_count);
     propertySuite->propGetInt(input_mesh_prop, kOfxMeshPropFaceCount, 0, &input_face_count);
 
+    // Mirrored faces have the same sizes, so loose edges and constant face size remain
+    int no_loose_edge = 1, constant_face_size = -1;
+    propertySuite->propGetInt(input_mesh_prop, kOfxMeshPropNoLooseEdge, 0, &no_loose_edge);
+    propertySuite->propGetInt(input_mesh_prop, kOfxMeshPropConstantFaceSize, 0, &constant_face_size);
+
     // Allocate output mesh
     int output_point_count = 2 * input_point_count;
     int output_corner_count = 2 * input_corner_count;
@@ -107,6 +112,8 @@ static OfxStatus cook(OfxMeshEffectHandle instance) {
     propertySuite->propSetInt(output_mesh_prop, kOfxMeshPropPointCount, 0, output_point_count);
     propertySuite->propSetInt(output_mesh_prop, kOfxMeshPropCornerCount, 0, output_corner_count);
     propertySuite->propSetInt(output_mesh_prop, kOfxMeshPropFaceCount, 0, output_face_count);
+    propertySuite->propSetInt(output_mesh_prop, kOfxMeshPropNoLooseEdge, 0, no_loose_edge);
+    propertySuite->propSetInt(output_mesh_prop, kOfxMeshPropConstantFaceSize, 0, constant_face_size);
 
     meshEffectSuite->meshAlloc(output_mesh);
 
@@ -164,7 +171,13 @@ static OfxStatus cook(OfxMeshEffectHandle instance) {
     Attribute input_facesize, output_facesize;
     getFaceAttribute(input_mesh, kOfxMeshAttribFaceSize, &input_facesize);
     getFaceAttribute(output_mesh, kOfxMeshAttribFaceSize, &output_facesize);
+    if (-1 != constant_face_size) {
+      // no face size buffer
+      input_facesize.type = MFX_UNKNOWN_ATTR;
+    }
     switch (input_facesize.type) {
+    case MFX_UNKNOWN_ATTR:
+      break;
     case MFX_INT_ATTR:
       for (int i = 0; i < input_face_count; ++i) {
       // 1. copy
@@ -0,0 +1,394 @@
+/*
+ * Copyright 2019-2021 Elie Michel
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "meshTransport.h"
+
+#include "util/ofx_util.h"
+
+#include <cstdio>
+#include <cstring>
+
+#define MFX_ENSURE(call) \
+  { \
+    OfxStatus status = call; \
+    if (kOfxStatOK != status) { \
+      printf("ERROR: Mfx suite call '" #call "' failed with status %d (%s)!\n", \
+             status, \
+             getOfxStateName(status)); \
+      return status; \
+    } \
+  }
+
+// Segment offsets are aligned to a cache line, or more if the mesh layout asks so
+constexpr size_t SEGMENT_ALIGNMENT = 64;
+
+static size_t alignUp(size_t value, size_t alignment)
+{
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+const char *remoteAttachmentName(AttributeAttachment attachment)
+{
+  switch (attachment) {
+    case AttributeAttachment::Point:
+      return kOfxMeshAttribPoint;
+    case AttributeAttachment::Corner:
+      return kOfxMeshAttribCorner;
+    case AttributeAttachment::Face:
+      return kOfxMeshAttribFace;
+    case AttributeAttachment::Mesh:
+      return kOfxMeshAttribMesh;
+    case AttributeAttachment::Edge:
+      return kOfxMeshAttribEdge;
+    default:
+      return NULL;
+  }
+}
+
+const char *remoteStaticAttributeType(const char *type, size_t *byteSize)
+{
+  static const struct {
+    const char *type;
+    size_t byteSize;
+  } types[] = {
+      {kOfxMeshAttribTypeUByte, sizeof(unsigned char)},
+      {kOfxMeshAttribTypeInt, sizeof(int)},
+      {kOfxMeshAttribTypeFloat, sizeof(float)},
+      {kOfxMeshAttribTypeHalf, sizeof(unsigned short)},
+      {kOfxMeshAttribTypeShort, sizeof(short)},
+      {kOfxMeshAttribTypeUShort, sizeof(unsigned short)},
+      {kOfxMeshAttribTypeDouble, sizeof(double)},
+  };
+
+  if (NULL != type) {
+    for (const auto &entry : types) {
+      if (0 == strcmp(type, entry.type)) {
+        if (NULL != byteSize) {
+          *byteSize = entry.byteSize;
+        }
+        return entry.type;
+      }
+    }
+  }
+  return NULL;
+}
+
+const char *remoteStaticAttributeSemantic(const char *semantic)
+{
+  static const char *semantics[] = {
+      kOfxMeshAttribSemanticTextureCoordinate,
+      kOfxMeshAttribSemanticNormal,
+      kOfxMeshAttribSemanticColor,
+      kOfxMeshAttribSemanticWeight,
+  };
+
+  if (NULL != semantic) {
+    for (const char *entry : semantics) {
+      if (0 == strcmp(semantic, entry)) {
+        return entry;
+      }
+    }
+  }
+  return NULL;
+}
+
+// // RemoteMesh
+
+RemoteMesh::RemoteMesh()
+    : pointCount(0),
+      cornerCount(0),
+      faceCount(0),
+      looseEdgeCount(0),
+      noLooseEdge(1),
+      constantFaceSize(-1),
+      hasTransform(false),
+      dataSize(0)
+{
+  memset(transform, 0, sizeof(transform));
+}
+
+void RemoteMesh::write(RemoteMessage &message) const
+{
+  message.writeInt(pointCount);
+  message.writeInt(cornerCount);
+  message.writeInt(faceCount);
+  message.writeInt(looseEdgeCount);
+  message.writeInt(noLooseEdge);
+  message.writeInt(constantFaceSize);
+  message.writeInt(hasTransform ? 1 : 0);
+  if (hasTransform) {
+    message.writeBytes(transform, sizeof(transform));
+  }
+  message.writeInt64((int64_t)dataSize);
+  message.writeInt((int32_t)attributes.size());
+  for (const RemoteAttribute &attribute : attributes) {
+    message.writeInt((int32_t)attribute.attachment);
+    message.writeString(attribute.name.c_str());
+    message.writeString(attribute.type);
+    message.writeString(attribute.semantic);
+    message.writeInt(attribute.componentCount);
+    message.writeInt64(attribute.offset);
+    message.writeInt(attribute.stride);
+    message.writeInt(attribute.componentStride);
+  }
+}
+
+bool RemoteMesh::read(RemoteMessage &message)
+{
+  int32_t has_transform, attribute_count;
+  int64_t data_size;
+  message.readInt(&pointCount);
+  message.readInt(&cornerCount);
+  message.readInt(&faceCount);
+  message.readInt(&looseEdgeCount);
+  message.readInt(&noLooseEdge);
+  message.readInt(&constantFaceSize);
+  message.readInt(&has_transform);
+  hasTransform = 0 != has_transform;
+  if (hasTransform) {
+    message.readBytes(transform, sizeof(transform));
+  }
+  message.readInt64(&data_size);
+  dataSize = (size_t)data_size;
+
+  if (!message.readInt(&attribute_count) || attribute_count < 0) {
+    return false;
+  }
+
+  attributes.resize(attribute_count);
+  std::string type, semantic;
+  for (RemoteAttribute &attribute : attributes) {
+    int32_t attachment;
+    message.readInt(&attachment);
+    attribute.attachment = (AttributeAttachment)attachment;
+    message.readString(&attribute.name);
+    message.readString(&type);
+    message.readString(&semantic);
+    attribute.type = remoteStaticAttributeType(type.c_str(), NULL);
+    attribute.semantic = remoteStaticAttributeSemantic(semantic.c_str());
+    message.readInt(&attribute.componentCount);
+    message.readInt64(&attribute.offset);
+    message.readInt(&attribute.stride);
+    message.readInt(&attribute.componentStride);
+
+    if (NULL == attribute.type || NULL == remoteAttachmentName(attribute.attachment)) {
+      printf("ERROR: Invalid attribute '%s' received from remote host.\n", attribute.name.c_str());
+      return false;
+    }
+  }
+
+  return message.isValid();
+}
+
+// // MeshTransport
+
+MeshTransport::MeshTransport(OfxHost *host)
+{
+  ps = (const OfxPropertySuiteV1 *)host->fetchSuite(host->host, kOfxPropertySuite, 1);
+  mes = (const OfxMeshEffectSuiteV1 *)host->fetchSuite(host->host, kOfxMeshEffectSuite, 1);
+}
+
+OfxStatus MeshTransport::describe(OfxMeshHandle mesh, RemoteMesh *remoteMesh) const
+{
+  OfxPropertySetHandle meshProperties = &mesh->properties;
+
+  MFX_ENSURE(ps->propGetInt(meshProperties, kOfxMeshPropPointCount, 0, &remoteMesh->pointCount));
+  MFX_ENSURE(ps->propGetInt(meshProperties, kOfxMeshPropCornerCount, 0, &remoteMesh->cornerCount));
+  MFX_ENSURE(ps->propGetInt(meshProperties, kOfxMeshPropFaceCount, 0, &remoteMesh->faceCount));
+  MFX_ENSURE(ps->propGetInt(
+      meshProperties, kOfxMeshPropLooseEdgeCount, 0, &remoteMesh->looseEdgeCount));
+  MFX_ENSURE(ps->propGetInt(meshProperties, kOfxMeshPropNoLooseEdge, 0, &remoteMesh->noLooseEdge));
+  MFX_ENSURE(ps->propGetInt(
+      meshProperties, kOfxMeshPropConstantFaceSize, 0, &remoteMesh->constantFaceSize));
+
+  double *transform;
+  MFX_ENSURE(
+      ps->propGetPointer(meshProperties, kOfxMeshPropTransformMatrix, 0, (void **)&transform));
+  remoteMesh->hasTransform = NULL != transform;
+  if (remoteMesh->hasTransform) {
+    memcpy(remoteMesh->transform, transform, sizeof(remoteMesh->transform));
+  }
+
+  char *layout;
+  int alignment;
+  MFX_ENSURE(ps->propGetString(meshProperties, kOfxMeshPropAttributeLayout, 0, &layout));
+  MFX_ENSURE(ps->propGetInt(meshProperties, kOfxMeshPropAttributeAlignment, 0, &alignment));
+  bool is_planar = NULL != layout && 0 == strcmp(layout, kOfxMeshAttribLayoutPlanar);
+  size_t segment_alignment = alignment > (int)SEGMENT_ALIGNMENT ? (size_t)alignment :
+                                                                  SEGMENT_ALIGNMENT;
+
+  int element_count[5] = {remoteMesh->pointCount,
+                          remoteMesh->cornerCount,
+                          remoteMesh->faceCount,
+                          1,
+                          remoteMesh->looseEdgeCount};
+
+  size_t offset = 0;
+  remoteMesh->attributes.clear();
+  remoteMesh->attributes.reserve(mesh->attributes.num_attributes);
+  for (int i = 0; i < mesh->attributes.num_attributes; ++i) {
+    const OfxAttributeStruct *attribute = mesh->attributes.attributes[i];
+    OfxPropertySetHandle attributeProperties =
+        const_cast<OfxPropertySetHandle>(&attribute->properties);
+
+    char *type, *semantic;
+    void *data;
+    RemoteAttribute remoteAttribute;
+    remoteAttribute.attachment = attribute->attachment;
+    remoteAttribute.name = attribute->name;
+    MFX_ENSURE(ps->propGetString(attributeProperties, kOfxMeshAttribPropType, 0, &type));
+    MFX_ENSURE(ps->propGetString(attributeProperties, kOfxMeshAttribPropSemantic, 0, &semantic));
+    MFX_ENSURE(ps->propGetInt(
+        attributeProperties, kOfxMeshAttribPropComponentCount, 0, &remoteAttribute.componentCount));
+    MFX_ENSURE(ps->propGetPointer(attributeProperties, kOfxMeshAttribPropData, 0, &data));
+
+    size_t byte_size = 0;
+    remoteAttribute.type = remoteStaticAttributeType(type, &byte_size);
+    remoteAttribute.semantic = remoteStaticAttributeSemantic(semantic);
+    if (NULL == remoteAttribute.type || NULL == remoteAttachmentName(attribute->attachment)) {
+      return kOfxStatErrBadHandle;
+    }
+
+    // Same rule as meshAlloc, so that the receiving side sees the layout it asked for
+    size_t value_count = element_count[(int)attribute->attachment];
+    size_t buffer_size;
+    if (is_planar) {
+      size_t plane_alignment = alignment > 0 ? (size_t)alignment : byte_size;
+      size_t plane_size = alignUp(byte_size * value_count, plane_alignment);
+      remoteAttribute.stride = (int)byte_size;
+      remoteAttribute.componentStride = (int)plane_size;
+      buffer_size = plane_size * remoteAttribute.componentCount;
+    }
+    else {
+      remoteAttribute.stride = (int)byte_size * remoteAttribute.componentCount;
+      remoteAttribute.componentStride = (int)byte_size;
+      buffer_size = remoteAttribute.stride * value_count;
+    }
+
+    if (NULL == data || 0 == buffer_size) {
+      remoteAttribute.offset = -1;
+    }
+    else {
+      offset = alignUp(offset, segment_alignment);
+      remoteAttribute.offset = (int64_t)offset;
+      offset += buffer_size;
+    }
+
+    remoteMesh->attributes.push_back(remoteAttribute);
+  }
+
+  remoteMesh->dataSize = offset;
+  return kOfxStatOK;
+}
+
+OfxStatus MeshTransport::pack(OfxMeshHandle mesh, const RemoteMesh &remoteMesh, char *data) const
+{
+  int element_count[5] = {remoteMesh.pointCount,
+                          remoteMesh.cornerCount,
+                          remoteMesh.faceCount,
+                          1,
+                          remoteMesh.looseEdgeCount};
+
+  for (const RemoteAttribute &remoteAttribute : remoteMesh.attributes) {
+    if (remoteAttribute.offset < 0) {
+      continue;
+    }
+
+    OfxPropertySetHandle attributeProperties;
+    MFX_ENSURE(mes->meshGetAttribute(mesh,
+                                     remoteAttachmentName(remoteAttribute.attachment),
+                                     remoteAttribute.name.c_str(),
+                                     &attributeProperties));
+
+    char *src;
+    int src_stride, src_component_stride;
+    MFX_ENSURE(ps->propGetPointer(attributeProperties, kOfxMeshAttribPropData, 0, (void **)&src));
+    MFX_ENSURE(ps->propGetInt(attributeProperties, kOfxMeshAttribPropStride, 0, &src_stride));
+    MFX_ENSURE(ps->propGetInt(
+        attributeProperties, kOfxMeshAttribPropComponentStride, 0, &src_component_stride));
+
+    size_t byte_size;
+    remoteStaticAttributeType(remoteAttribute.type, &byte_size);
+    if (0 == src_component_stride) {
+      src_component_stride = (int)byte_size;
+    }
+
+    char *dst = data + remoteAttribute.offset;
+    int count = element_count[(int)remoteAttribute.attachment];
+    int component_count = remoteAttribute.componentCount;
+
+    if (src_stride == remoteAttribute.stride &&
+        src_component_stride == remoteAttribute.componentStride &&
+        remoteAttribute.componentStride == (int)byte_size) {
+      // Same dense interleaved layout on both sides
+      memcpy(dst, src, (size_t)remoteAttribute.stride * count);
+      continue;
+    }
+
+    for (int i = 0; i < count; ++i) {
+      const char *src_element = src + (size_t)src_stride * i;
+      char *dst_element = dst + (size_t)remoteAttribute.stride * i;
+      for (int k = 0; k < component_count; ++k) {
+        memcpy(dst_element + (size_t)remoteAttribute.componentStride * k,
+               src_element + (size_t)src_component_stride * k,
+               byte_size);
+      }
+    }
+  }
+
+  return kOfxStatOK;
+}
+
+OfxStatus MeshTransport::bind(OfxMeshHandle mesh, RemoteMesh &remoteMesh, char *data) const
+{
+  OfxPropertySetHandle meshProperties = &mesh->properties;
+
+  MFX_ENSURE(ps->propSetInt(meshProperties, kOfxMeshPropPointCount, 0, remoteMesh.pointCount));
+  MFX_ENSURE(ps->propSetInt(meshProperties, kOfxMeshPropCornerCount, 0, remoteMesh.cornerCount));
+  MFX_ENSURE(ps->propSetInt(meshProperties, kOfxMeshPropFaceCount, 0, remoteMesh.faceCount));
+  MFX_ENSURE(
+      ps->propSetInt(meshProperties, kOfxMeshPropLooseEdgeCount, 0, remoteMesh.looseEdgeCount));
+  MFX_ENSURE(ps->propSetInt(meshProperties, kOfxMeshPropNoLooseEdge, 0, remoteMesh.noLooseEdge));
+  MFX_ENSURE(ps->propSetInt(
+      meshProperties, kOfxMeshPropConstantFaceSize, 0, remoteMesh.constantFaceSize));
+  if (remoteMesh.hasTransform) {
+    MFX_ENSURE(ps->propSetPointer(
+        meshProperties, kOfxMeshPropTransformMatrix, 0, (void *)remoteMesh.transform));
+  }
+
+  for (const RemoteAttribute &remoteAttribute : remoteMesh.attributes) {
+    OfxPropertySetHandle attributeProperties;
+    MFX_ENSURE(mes->attributeDefine(mesh,
+                                    remoteAttachmentName(remoteAttribute.attachment),
+                                    remoteAttribute.name.c_str(),
+                                    remoteAttribute.componentCount,
+                                    remoteAttribute.type,
+                                    remoteAttribute.semantic,
+                                    &attributeProperties));
+
+    void *attribute_data = remoteAttribute.offset >= 0 ? data + remoteAttribute.offset : NULL;
+    MFX_ENSURE(ps->propSetInt(attributeProperties, kOfxMeshAttribPropIsOwner, 0, 0));
+    MFX_ENSURE(ps->propSetPointer(attributeProperties, kOfxMeshAttribPropData, 0, attribute_data));
+    MFX_ENSURE(
+        ps->propSetInt(attributeProperties, kOfxMeshAttribPropStride, 0, remoteAttribute.stride));
+    MFX_ENSURE(ps->propSetInt(attributeProperties,
+                              kOfxMeshAttribPropComponentStride,
+                              0,
+                              remoteAttribute.componentStride));
+  }
+
+  return kOfxStatOK;
+}
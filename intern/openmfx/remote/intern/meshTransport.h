@@ -0,0 +1,113 @@
+/*
+ * Copyright 2019-2021 Elie Michel
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** \file
+ * \ingroup openmesheffect
+ *
+ * Transport of mesh data across processes. The attribute buffers of a mesh
+ * are packed once into a shared memory segment, and the receiving side binds
+ * its attributes directly to the mapped segment, without copying.
+ */
+
+#ifndef __MFX_MESH_TRANSPORT_H__
+#define __MFX_MESH_TRANSPORT_H__
+
+#include "remoteProtocol.h"
+
+#include <mfxHost/mesh>
+
+#include "ofxCore.h"
+#include "ofxMeshEffect.h"
+#include "ofxProperty.h"
+
+#include <string>
+#include <vector>
+
+/**
+ * Strings of attribute properties are stored by pointer, so attachments, types
+ * and semantics received from the other process are mapped back to the static
+ * constants of the API. These return NULL for unknown values.
+ */
+const char *remoteAttachmentName(AttributeAttachment attachment);
+const char *remoteStaticAttributeType(const char *type, size_t *byteSize);
+const char *remoteStaticAttributeSemantic(const char *semantic);
+
+struct RemoteAttribute {
+  AttributeAttachment attachment;
+  std::string name;
+  const char *type;      // one of the static kOfxMeshAttribType* strings
+  const char *semantic;  // one of the static kOfxMeshAttribSemantic* strings, or NULL
+  int componentCount;
+  int64_t offset;  // from the start of the segment, -1 if the attribute has no data
+  int stride;
+  int componentStride;
+};
+
+/**
+ * Description of a mesh, sent alongside the shared memory segment holding its
+ * attribute data.
+ */
+struct RemoteMesh {
+ public:
+  RemoteMesh();
+
+  void write(RemoteMessage &message) const;
+  bool read(RemoteMessage &message);
+
+ public:
+  int pointCount;
+  int cornerCount;
+  int faceCount;
+  int looseEdgeCount;  // stored apart from faces, see kOfxInputPropLooseEdgeAttachment
+  int noLooseEdge;
+  int constantFaceSize;
+  bool hasTransform;
+  double transform[16];
+  size_t dataSize;  // size of the shared memory segment
+  std::vector<RemoteAttribute> attributes;
+};
+
+class MeshTransport {
+ public:
+  MeshTransport(OfxHost *host);
+
+  /**
+   * Fill a description of the mesh, choosing where each attribute will be
+   * located in the shared segment. The layout requested on the mesh (see
+   * kOfxMeshPropAttributeLayout) is preserved.
+   */
+  OfxStatus describe(OfxMeshHandle mesh, RemoteMesh *remoteMesh) const;
+
+  /**
+   * Copy the attribute data of the mesh into a segment of at least
+   * remoteMesh.dataSize bytes, at the locations chosen by describe().
+   */
+  OfxStatus pack(OfxMeshHandle mesh, const RemoteMesh &remoteMesh, char *data) const;
+
+  /**
+   * Define the attributes of the mesh and point them to the mapped segment.
+   * The mesh does not own the data, so the segment must outlive the mesh
+   * release. The transform matrix is only overridden when the remote mesh has
+   * one, in which case the remote mesh must outlive the release as well.
+   */
+  OfxStatus bind(OfxMeshHandle mesh, RemoteMesh &remoteMesh, char *data) const;
+
+ private:
+  const OfxPropertySuiteV1 *ps;
+  const OfxMeshEffectSuiteV1 *mes;
+};
+
+#endif // __MFX_MESH_TRANSPORT_H__
@@ -0,0 +1,420 @@
+/*
+ * Copyright 2019-2021 Elie Michel
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "remoteEffect.h"
+#include "meshTransport.h"
+
+#include "ofxParam.h"
+
+#include <cstring>
+
+// Parameter properties forwarded from the plugin's descriptor, interpreted
+// according to the parameter type
+static const char *VALUE_PROPERTIES[] = {
+    kOfxParamPropDefault,
+    kOfxParamPropMin,
+    kOfxParamPropMax,
+    kOfxParamPropDisplayMin,
+    kOfxParamPropDisplayMax,
+};
+
+static const char *STRING_PROPERTIES[] = {
+    kOfxPropLabel,
+    kOfxParamPropScriptName,
+    kOfxParamPropHint,
+};
+
+// // StringPool
+
+const char *StringPool::intern(const std::string &str)
+{
+  return m_strings.insert(str).first->c_str();
+}
+
+// // Utils
+
+OfxPropertyValueStruct *ensurePropertyValue(OfxPropertySetStruct &properties, const char *name)
+{
+  // Not inlined in an index expression, as it may reallocate the property array
+  int i = properties.ensure_property(name);
+  return properties.properties[i]->value;
+}
+
+static const char *staticLayout(const std::string &layout)
+{
+  if (layout == kOfxMeshAttribLayoutPlanar) {
+    return kOfxMeshAttribLayoutPlanar;
+  }
+  if (layout == kOfxMeshAttribLayoutInterleaved) {
+    return kOfxMeshAttribLayoutInterleaved;
+  }
+  return NULL;
+}
+
+static bool isIntegerParam(ParamType type)
+{
+  return PARAM_TYPE_INTEGER == type || PARAM_TYPE_INTEGER_2D == type ||
+         PARAM_TYPE_INTEGER_3D == type || PARAM_TYPE_CHOICE == type;
+}
+
+static bool isDoubleParam(ParamType type)
+{
+  return PARAM_TYPE_DOUBLE == type || PARAM_TYPE_DOUBLE_2D == type ||
+         PARAM_TYPE_DOUBLE_3D == type || PARAM_TYPE_RGB == type || PARAM_TYPE_RGBA == type;
+}
+
+/**
+ * Write a value of the given parameter type, stored either in a parameter or
+ * in one of its properties. Booleans are ints in properties but bools in
+ * parameters, so the caller reads and writes them.
+ */
+template<typename ValueStruct>
+static void writeValue(RemoteMessage &message, ParamType type, const ValueStruct value[4])
+{
+  size_t dimensions = parameter_type_dimensions(type);
+  for (size_t i = 0; i < dimensions; ++i) {
+    if (isIntegerParam(type)) {
+      message.writeInt(value[i].as_int);
+    }
+    else if (isDoubleParam(type)) {
+      message.writeDouble(value[i].as_double);
+    }
+  }
+  if (PARAM_TYPE_STRING == type) {
+    message.writeString(value[0].as_const_char);
+  }
+}
+
+template<typename ValueStruct>
+static bool readValue(RemoteMessage &message,
+                      ParamType type,
+                      ValueStruct value[4],
+                      std::string *string_value)
+{
+  size_t dimensions = parameter_type_dimensions(type);
+  for (size_t i = 0; i < dimensions; ++i) {
+    if (isIntegerParam(type)) {
+      message.readInt(&value[i].as_int);
+    }
+    else if (isDoubleParam(type)) {
+      message.readDouble(&value[i].as_double);
+    }
+  }
+  if (PARAM_TYPE_STRING == type) {
+    message.readString(string_value);
+  }
+  return message.isValid();
+}
+
+static const char *propertyString(const OfxPropertySetStruct &properties, const char *name)
+{
+  int i = properties.find_property(name);
+  return -1 != i ? properties.properties[i]->value[0].as_const_char : NULL;
+}
+
+static int propertyInt(const OfxPropertySetStruct &properties, const char *name, int fallback)
+{
+  int i = properties.find_property(name);
+  return -1 != i ? properties.properties[i]->value[0].as_int : fallback;
+}
+
+// // Effect description
+
+void writeEffectDescription(RemoteMessage &message, const OfxMeshEffectStruct &effect)
+{
+  message.writeInt(propertyInt(effect.properties, kOfxMeshEffectPropIsDeformation, 0));
+
+  message.writeInt(effect.inputs.num_inputs);
+  for (int i = 0; i < effect.inputs.num_inputs; ++i) {
+    const OfxMeshInputStruct *input = effect.inputs.inputs[i];
+    message.writeString(input->name);
+    message.writeString(propertyString(input->properties, kOfxPropLabel));
+    message.writeInt(propertyInt(input->properties, kOfxInputPropRequestGeometry, 1));
+    message.writeInt(propertyInt(input->properties, kOfxInputPropRequestTransform, 0));
+    message.writeInt(propertyInt(input->properties, kOfxInputPropIsOutput, 0));
+    message.writeInt(propertyInt(input->properties, kOfxInputPropLooseEdgeAttachment, 0));
+    message.writeString(propertyString(input->properties, kOfxMeshPropAttributeLayout));
+    message.writeInt(propertyInt(input->properties, kOfxMeshPropAttributeAlignment, 0));
+    message.writeInt(propertyInt(input->properties, kOfxMeshPropOutOfCore, 0));
+
+    const OfxAttributeSetStruct &requested = input->requested_attributes;
+    message.writeInt(requested.num_attributes);
+    for (int j = 0; j < requested.num_attributes; ++j) {
+      const OfxAttributeStruct *attribute = requested.attributes[j];
+      message.writeInt((int32_t)attribute->attachment);
+      message.writeString(attribute->name);
+      message.writeInt(propertyInt(attribute->properties, kOfxMeshAttribPropComponentCount, 1));
+      message.writeString(propertyString(attribute->properties, kOfxMeshAttribPropType));
+      message.writeString(propertyString(attribute->properties, kOfxMeshAttribPropSemantic));
+      message.writeInt(propertyInt(attribute->properties, kMeshAttribRequestPropMandatory, 0));
+    }
+  }
+
+  const OfxParamSetStruct &parameters = effect.parameters;
+  message.writeInt(parameters.num_parameters);
+  for (int i = 0; i < parameters.num_parameters; ++i) {
+    const OfxParamStruct *param = parameters.parameters[i];
+    message.writeString(param->name);
+    message.writeInt((int32_t)param->type);
+
+    for (const char *name : STRING_PROPERTIES) {
+      const char *value = propertyString(param->properties, name);
+      message.writeInt(NULL != value ? 1 : 0);
+      message.writeString(value);
+    }
+
+    for (const char *name : VALUE_PROPERTIES) {
+      int k = param->properties.find_property(name);
+      message.writeInt(-1 != k ? 1 : 0);
+      if (-1 == k) {
+        continue;
+      }
+      const OfxPropertyValueStruct *value = param->properties.properties[k]->value;
+      if (PARAM_TYPE_BOOLEAN == param->type) {
+        message.writeInt(value[0].as_int);
+      }
+      else {
+        writeValue(message, param->type, value);
+      }
+    }
+  }
+}
+
+bool readEffectDescription(RemoteMessage &message, OfxMeshEffectStruct *effect, StringPool &pool)
+{
+  int32_t is_deformation, input_count, param_count;
+  std::string name, label, type, semantic, layout;
+
+  message.readInt(&is_deformation);
+  ensurePropertyValue(effect->properties, kOfxMeshEffectPropIsDeformation)[0].as_int =
+      is_deformation;
+
+  if (!message.readInt(&input_count) || input_count < 0) {
+    return false;
+  }
+  for (int i = 0; i < input_count; ++i) {
+    int32_t request_geometry, request_transform, is_output, loose_edge_attachment, alignment,
+        out_of_core, attribute_count;
+    message.readString(&name);
+    message.readString(&label);
+    message.readInt(&request_geometry);
+    message.readInt(&request_transform);
+    message.readInt(&is_output);
+    message.readInt(&loose_edge_attachment);
+    message.readString(&layout);
+    message.readInt(&alignment);
+    message.readInt(&out_of_core);
+    if (!message.readInt(&attribute_count) || attribute_count < 0) {
+      return false;
+    }
+
+    // Same as the inputDefine suite function, but the name must be kept alive
+    int input_index = effect->inputs.ensure(pool.intern(name));
+    OfxMeshInputStruct *input = effect->inputs.inputs[input_index];
+    input->host = effect->host;
+    ensurePropertyValue(input->mesh.properties, kOfxMeshPropInternalData)[0]
+        .as_pointer = NULL;
+
+    OfxPropertySetStruct &props = input->properties;
+    if (!label.empty()) {
+      ensurePropertyValue(props, kOfxPropLabel)[0].as_const_char =
+          pool.intern(label);
+    }
+    ensurePropertyValue(props, kOfxInputPropRequestGeometry)[0].as_int =
+        request_geometry;
+    ensurePropertyValue(props, kOfxInputPropRequestTransform)[0].as_int =
+        request_transform;
+    ensurePropertyValue(props, kOfxInputPropIsOutput)[0].as_int =
+        is_output;
+    ensurePropertyValue(props, kOfxInputPropLooseEdgeAttachment)[0].as_int =
+        loose_edge_attachment;
+    ensurePropertyValue(props, kOfxMeshPropAttributeLayout)[0].as_const_char =
+        staticLayout(layout);
+    ensurePropertyValue(props, kOfxMeshPropAttributeAlignment)[0].as_int =
+        alignment;
+    ensurePropertyValue(props, kOfxMeshPropOutOfCore)[0].as_int =
+        out_of_core;
+
+    for (int j = 0; j < attribute_count; ++j) {
+      int32_t attachment, component_count, mandatory;
+      message.readInt(&attachment);
+      message.readString(&name);
+      message.readInt(&component_count);
+      message.readString(&type);
+      message.readString(&semantic);
+      message.readInt(&mandatory);
+
+      const char *static_type = remoteStaticAttributeType(type.c_str(), NULL);
+      if (!message.isValid() || NULL == static_type ||
+          NULL == remoteAttachmentName((AttributeAttachment)attachment)) {
+        return false;
+      }
+
+      int a = input->requested_attributes.ensure((AttributeAttachment)attachment, name.c_str());
+      OfxPropertySetStruct &attribute_props = input->requested_attributes.attributes[a]->properties;
+      ensurePropertyValue(attribute_props, kOfxMeshAttribPropComponentCount)[0]
+          .as_int = component_count;
+      ensurePropertyValue(attribute_props, kOfxMeshAttribPropType)[0]
+          .as_const_char = static_type;
+      ensurePropertyValue(attribute_props, kOfxMeshAttribPropSemantic)[0]
+          .as_const_char = remoteStaticAttributeSemantic(semantic.c_str());
+      ensurePropertyValue(attribute_props, kMeshAttribRequestPropMandatory)[0]
+          .as_int = mandatory;
+    }
+  }
+
+  if (!message.readInt(&param_count) || param_count < 0) {
+    return false;
+  }
+  for (int i = 0; i < param_count; ++i) {
+    int32_t param_type;
+    message.readString(&name);
+    message.readInt(&param_type);
+    if (!message.isValid()) {
+      return false;
+    }
+
+    int param_index = effect->parameters.ensure(name.c_str());
+    OfxParamStruct *param = effect->parameters.parameters[param_index];
+    param->set_type((ParamType)param_type);
+
+    for (const char *prop_name : STRING_PROPERTIES) {
+      int32_t is_set;
+      std::string value;
+      message.readInt(&is_set);
+      message.readString(&value);
+      if (is_set) {
+        ensurePropertyValue(param->properties, prop_name)[0]
+            .as_const_char = pool.intern(value);
+      }
+    }
+
+    for (const char *prop_name : VALUE_PROPERTIES) {
+      int32_t is_set;
+      if (!message.readInt(&is_set)) {
+        return false;
+      }
+      if (!is_set) {
+        continue;
+      }
+      OfxPropertyValueStruct *value =
+          ensurePropertyValue(param->properties, prop_name);
+      if (PARAM_TYPE_BOOLEAN == param->type) {
+        message.readInt(&value[0].as_int);
+      }
+      else {
+        std::string string_value;
+        readValue(message, param->type, value, &string_value);
+        if (PARAM_TYPE_STRING == param->type) {
+          value[0].as_const_char = pool.intern(string_value);
+        }
+      }
+    }
+  }
+
+  return message.isValid();
+}
+
+// // Parameter values
+
+void writeParameterValues(RemoteMessage &message, const OfxParamSetStruct &parameters)
+{
+  message.writeInt(parameters.num_parameters);
+  for (int i = 0; i < parameters.num_parameters; ++i) {
+    const OfxParamStruct *param = parameters.parameters[i];
+    message.writeString(param->name);
+    message.writeInt((int32_t)param->type);
+    if (PARAM_TYPE_BOOLEAN == param->type) {
+      message.writeInt(param->value[0].as_bool ? 1 : 0);
+    }
+    else {
+      writeValue(message, param->type, param->value);
+    }
+  }
+}
+
+bool readParameterValues(RemoteMessage &message, OfxParamSetStruct *parameters)
+{
+  int32_t param_count;
+  if (!message.readInt(&param_count) || param_count < 0) {
+    return false;
+  }
+
+  std::string name, string_value;
+  for (int i = 0; i < param_count; ++i) {
+    int32_t type;
+    message.readString(&name);
+    message.readInt(&type);
+
+    OfxParamValueStruct value[4];
+    memset(value, 0, sizeof(value));
+    if (PARAM_TYPE_BOOLEAN == (ParamType)type) {
+      int32_t as_int;
+      message.readInt(&as_int);
+      value[0].as_bool = 0 != as_int;
+    }
+    else {
+      readValue(message, (ParamType)type, value, &string_value);
+    }
+
+    if (!message.isValid()) {
+      return false;
+    }
+
+    int param_index = parameters->find(name.c_str());
+    if (-1 == param_index) {
+      printf("WARNING: Ignoring value of unknown parameter '%s'.\n", name.c_str());
+      continue;
+    }
+
+    OfxParamStruct *param = parameters->parameters[param_index];
+    if (param->type != (ParamType)type) {
+      printf("WARNING: Ignoring value of parameter '%s' with mismatching type.\n", name.c_str());
+      continue;
+    }
+
+    if (PARAM_TYPE_STRING == param->type) {
+      param->realloc_string((int)string_value.size());
+      strcpy(param->value[0].as_char, string_value.c_str());
+    }
+    else {
+      memcpy(param->value, value, sizeof(value));
+    }
+  }
+
+  return true;
+}
+
+// // Messages
+
+void writeEffectMessage(RemoteMessage &message, const OfxMeshEffectStruct &effect)
+{
+  message.writeInt((int32_t)effect.messageType);
+  message.writeString(effect.message);
+}
+
+bool readEffectMessage(RemoteMessage &message, OfxMeshEffectStruct *effect)
+{
+  int32_t type;
+  std::string text;
+  if (!message.readInt(&type) || !message.readString(&text)) {
+    return false;
+  }
+  effect->messageType = (OfxMessageType)type;
+  strncpy(effect->message, text.c_str(), sizeof(effect->message));
+  effect->message[sizeof(effect->message) - 1] = '\0';
+  return true;
+}
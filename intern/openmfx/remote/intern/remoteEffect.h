@@ -0,0 +1,80 @@
+/*
+ * Copyright 2019-2021 Elie Michel
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** \file
+ * \ingroup openmesheffect
+ *
+ * Serialization of effect descriptors, parameter values and messages, shared
+ * by the host and the helper process.
+ */
+
+#ifndef __MFX_REMOTE_EFFECT_H__
+#define __MFX_REMOTE_EFFECT_H__
+
+#include "remoteProtocol.h"
+
+#include <mfxHost/mesheffect>
+
+#include <set>
+#include <string>
+
+/**
+ * Properties store strings by pointer, so strings received from the other
+ * process are kept here for as long as the descriptors that use them.
+ */
+class StringPool {
+ public:
+  const char *intern(const std::string &str);
+
+ private:
+  std::set<std::string> m_strings;
+};
+
+/**
+ * Ensure a property exists and return its values. Used for properties that
+ * are set from the other process, bypassing the checks of the property suite.
+ */
+OfxPropertyValueStruct *ensurePropertyValue(OfxPropertySetStruct &properties, const char *name);
+
+/**
+ * Write the inputs, requested attributes and parameters defined by the
+ * describe action.
+ */
+void writeEffectDescription(RemoteMessage &message, const OfxMeshEffectStruct &effect);
+
+/**
+ * Rebuild a descriptor written by writeEffectDescription() into an effect
+ * freshly allocated by the host.
+ */
+bool readEffectDescription(RemoteMessage &message, OfxMeshEffectStruct *effect, StringPool &pool);
+
+/**
+ * Write the current value of all parameters.
+ */
+void writeParameterValues(RemoteMessage &message, const OfxParamSetStruct &parameters);
+
+/**
+ * Set parameter values written by writeParameterValues(), matching them by name.
+ */
+bool readParameterValues(RemoteMessage &message, OfxParamSetStruct *parameters);
+
+/**
+ * Forward the persistent message of an effect instance.
+ */
+void writeEffectMessage(RemoteMessage &message, const OfxMeshEffectStruct &effect);
+bool readEffectMessage(RemoteMessage &message, OfxMeshEffectStruct *effect);
+
+#endif // __MFX_REMOTE_EFFECT_H__
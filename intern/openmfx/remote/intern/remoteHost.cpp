@@ -0,0 +1,510 @@
+/*
+ * Copyright 2019-2021 Elie Michel
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "remoteHost.h"
+#include "meshTransport.h"
+#include "sharedMemory.h"
+
+#include "util/ofx_util.h"
+
+#include <mfxHost/mesheffect>
+#include <mfxHost/messages>
+
+#include "ofxProperty.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+// The host only hands OfxPlugin pointers back to the proxies
+static std::map<const OfxPlugin *, RemotePlugin *> gRemotePlugins;
+static std::mutex gRemotePluginsMutex;
+
+static RemotePlugin *findRemotePlugin(OfxMeshEffectHandle effect)
+{
+  int i = effect->properties.find_property(kOfxMeshEffectPropPluginHandle);
+  if (-1 == i) {
+    return nullptr;
+  }
+  const OfxPlugin *plugin = (const OfxPlugin *)effect->properties.properties[i]->value[0].as_pointer;
+
+  std::lock_guard<std::mutex> lock(gRemotePluginsMutex);
+  auto it = gRemotePlugins.find(plugin);
+  return it != gRemotePlugins.end() ? it->second : nullptr;
+}
+
+static void remoteSetHost(OfxHost *host)
+{
+  // Suites are fetched from the host the effects were created with
+  (void)host;
+}
+
+static OfxStatus remoteMainEntry(const char *action,
+                                 const void *handle,
+                                 OfxPropertySetHandle inArgs,
+                                 OfxPropertySetHandle outArgs)
+{
+  (void)outArgs;
+
+  // The helper process loads and unloads the actual plugins itself
+  if (0 == strcmp(action, kOfxActionLoad) || 0 == strcmp(action, kOfxActionUnload)) {
+    return kOfxStatOK;
+  }
+
+  OfxMeshEffectHandle effect = (OfxMeshEffectHandle)handle;
+  if (NULL == effect) {
+    return kOfxStatErrBadHandle;
+  }
+
+  RemotePlugin *plugin = findRemotePlugin(effect);
+  if (nullptr == plugin) {
+    printf("ERROR: Could not find the remote plugin of effect %p.\n", effect);
+    return kOfxStatErrBadHandle;
+  }
+  MfxRemoteHost *remote_host = plugin->remote_host;
+
+  if (0 == strcmp(action, kOfxActionDescribe)) {
+    return remote_host->describe(plugin, effect);
+  }
+  if (0 == strcmp(action, kOfxActionCreateInstance)) {
+    return remote_host->createInstance(plugin, effect);
+  }
+  if (0 == strcmp(action, kOfxActionDestroyInstance)) {
+    return remote_host->destroyInstance(plugin, effect);
+  }
+  if (0 == strcmp(action, kOfxMeshEffectActionIsIdentity)) {
+    return remote_host->isIdentity(plugin, effect, inArgs);
+  }
+  if (0 == strcmp(action, kOfxMeshEffectActionCook)) {
+    return remote_host->cook(plugin, effect, inArgs);
+  }
+  return kOfxStatReplyDefault;
+}
+
+static void setEffectError(OfxMeshEffectHandle effect, const char *message)
+{
+  if (NULL == effect) {
+    return;
+  }
+  effect->messageType = OfxMessageType::Error;
+  strncpy(effect->message, message, sizeof(effect->message));
+  effect->message[sizeof(effect->message) - 1] = '\0';
+}
+
+// // MfxRemoteHost
+
+MfxRemoteHost::MfxRemoteHost() : m_socket(-1), m_pid(-1), m_is_alive(false)
+{
+  memset(&m_registry, 0, sizeof(m_registry));
+}
+
+MfxRemoteHost::~MfxRemoteHost()
+{
+  stop();
+}
+
+bool MfxRemoteHost::start(const char *helper_path, const char *ofx_filepath)
+{
+  int sockets[2];
+  if (0 != socketpair(AF_UNIX, SOCK_STREAM, 0, sockets)) {
+    printf("ERROR: Could not create socket for the remote host.\n");
+    return false;
+  }
+  fcntl(sockets[0], F_SETFD, FD_CLOEXEC);
+#ifdef SO_NOSIGPIPE
+  int one = 1;
+  setsockopt(sockets[0], SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+
+  char fd_arg[16];
+  snprintf(fd_arg, sizeof(fd_arg), "%d", sockets[1]);
+  char *argv[] = {const_cast<char *>(helper_path),
+                  const_cast<char *>("--fd"),
+                  fd_arg,
+                  const_cast<char *>(ofx_filepath),
+                  nullptr};
+
+  int error = posix_spawn(&m_pid, helper_path, nullptr, nullptr, argv, environ);
+  close(sockets[1]);
+  if (0 != error) {
+    printf("ERROR: Could not start remote host '%s': %s\n", helper_path, strerror(error));
+    close(sockets[0]);
+    m_pid = -1;
+    return false;
+  }
+
+  m_socket = sockets[0];
+  m_is_alive = true;
+
+  if (!listPlugins()) {
+    printf("ERROR: Remote host could not load plugins from '%s'.\n", ofx_filepath);
+    stop();
+    return false;
+  }
+  return true;
+}
+
+void MfxRemoteHost::stop()
+{
+  if (m_socket >= 0) {
+    if (m_is_alive) {
+      remoteSend(m_socket, RemoteMessage(RemoteAction::Quit));
+    }
+    close(m_socket);
+    m_socket = -1;
+  }
+  m_is_alive = false;
+
+  if (m_pid > 0) {
+    int status;
+    while (waitpid(m_pid, &status, 0) < 0 && EINTR == errno) {
+    }
+    m_pid = -1;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(gRemotePluginsMutex);
+    for (const auto &plugin : m_plugins) {
+      gRemotePlugins.erase(&plugin->plugin);
+    }
+  }
+  m_plugins.clear();
+  m_plugin_pointers.clear();
+  m_plugin_status.clear();
+  m_plugin_load_counts.clear();
+  memset(&m_registry, 0, sizeof(m_registry));
+}
+
+bool MfxRemoteHost::isAlive() const
+{
+  return m_is_alive;
+}
+
+PluginRegistry *MfxRemoteHost::registry()
+{
+  return &m_registry;
+}
+
+bool MfxRemoteHost::transact(const RemoteMessage &request,
+                             RemoteMessage *reply,
+                             OfxMeshEffectHandle effect)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if (m_is_alive && remoteSend(m_socket, request) && remoteReceive(m_socket, reply) &&
+      RemoteAction::Reply == reply->action) {
+    return true;
+  }
+
+  if (m_is_alive) {
+    printf("ERROR: Lost connection with the remote host (pid %d).\n", (int)m_pid);
+    m_is_alive = false;
+  }
+  remoteCloseFds(reply);
+  setEffectError(effect, "The plugin process died, reload the plugin to restart it");
+  return false;
+}
+
+bool MfxRemoteHost::listPlugins()
+{
+  RemoteMessage reply;
+  if (!transact(RemoteMessage(RemoteAction::ListPlugins), &reply)) {
+    return false;
+  }
+
+  int32_t status, plugin_count;
+  reply.readInt(&status);
+  if (kOfxStatOK != status || !reply.readInt(&plugin_count) || plugin_count < 0) {
+    return false;
+  }
+
+  for (int i = 0; i < plugin_count; ++i) {
+    std::unique_ptr<RemotePlugin> plugin(new RemotePlugin);
+    int32_t major, minor;
+    reply.readString(&plugin->identifier);
+    reply.readInt(&major);
+    reply.readInt(&minor);
+    if (!reply.isValid()) {
+      return false;
+    }
+
+    plugin->remote_host = this;
+    plugin->index = i;
+    plugin->plugin.pluginApi = kOfxMeshEffectPluginApi;
+    plugin->plugin.apiVersion = kOfxMeshEffectPluginApiVersion;
+    plugin->plugin.pluginIdentifier = plugin->identifier.c_str();
+    plugin->plugin.pluginVersionMajor = (unsigned int)major;
+    plugin->plugin.pluginVersionMinor = (unsigned int)minor;
+    plugin->plugin.setHost = remoteSetHost;
+    plugin->plugin.mainEntry = remoteMainEntry;
+    m_plugins.push_back(std::move(plugin));
+  }
+
+  std::lock_guard<std::mutex> lock(gRemotePluginsMutex);
+  for (const auto &plugin : m_plugins) {
+    gRemotePlugins[&plugin->plugin] = plugin.get();
+    m_plugin_pointers.push_back(&plugin->plugin);
+    m_plugin_status.push_back(OfxPluginStatNotLoaded);
+    m_plugin_load_counts.push_back(0);
+  }
+
+  m_registry.num_plugins = (int)m_plugins.size();
+  m_registry.plugins = m_plugin_pointers.data();
+  m_registry.status = m_plugin_status.data();
+  m_registry.load_counts = m_plugin_load_counts.data();
+  return true;
+}
+
+OfxStatus MfxRemoteHost::describe(RemotePlugin *plugin, OfxMeshEffectHandle descriptor)
+{
+  RemoteMessage request(RemoteAction::Describe), reply;
+  request.writeInt(plugin->index);
+  if (!transact(request, &reply, descriptor)) {
+    return kOfxStatFailed;
+  }
+
+  int32_t status;
+  reply.readInt(&status);
+  readEffectMessage(reply, descriptor);
+  if (kOfxStatOK != status) {
+    return status;
+  }
+
+  if (!readEffectDescription(reply, descriptor, m_strings)) {
+    printf("ERROR: Invalid description of plugin '%s'.\n", plugin->identifier.c_str());
+    return kOfxStatFailed;
+  }
+  return kOfxStatOK;
+}
+
+OfxStatus MfxRemoteHost::createInstance(RemotePlugin *plugin, OfxMeshEffectHandle instance)
+{
+  RemoteMessage request(RemoteAction::CreateInstance), reply;
+  request.writeInt(plugin->index);
+  if (!transact(request, &reply, instance)) {
+    return kOfxStatFailed;
+  }
+
+  int32_t status, id;
+  reply.readInt(&status);
+  readEffectMessage(reply, instance);
+  if (kOfxStatOK != status) {
+    return status;
+  }
+  if (!reply.readInt(&id)) {
+    return kOfxStatFailed;
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  plugin->instances[instance] = id;
+  return kOfxStatOK;
+}
+
+OfxStatus MfxRemoteHost::destroyInstance(RemotePlugin *plugin, OfxMeshEffectHandle instance)
+{
+  int32_t id;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = plugin->instances.find(instance);
+    if (it == plugin->instances.end()) {
+      return kOfxStatErrBadHandle;
+    }
+    id = it->second;
+    plugin->instances.erase(it);
+  }
+
+  RemoteMessage request(RemoteAction::DestroyInstance), reply;
+  request.writeInt(id);
+  if (!transact(request, &reply)) {
+    // Nothing left to destroy if the process died
+    return kOfxStatOK;
+  }
+
+  int32_t status;
+  reply.readInt(&status);
+  return status;
+}
+
+void MfxRemoteHost::writeInstanceState(RemoteMessage &message,
+                                       RemotePlugin *plugin,
+                                       OfxMeshEffectHandle instance,
+                                       OfxPropertySetHandle inArgs)
+{
+  int32_t id = -1;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = plugin->instances.find(instance);
+    if (it != plugin->instances.end()) {
+      id = it->second;
+    }
+  }
+
+  int is_draft = 0;
+  int i = NULL != inArgs ? inArgs->find_property(kOfxMeshEffectPropRenderQualityDraft) : -1;
+  if (-1 != i) {
+    is_draft = inArgs->properties[i]->value[0].as_int;
+  }
+
+  message.writeInt(id);
+  message.writeInt(is_draft);
+  writeParameterValues(message, instance->parameters);
+}
+
+OfxStatus MfxRemoteHost::isIdentity(RemotePlugin *plugin,
+                                    OfxMeshEffectHandle instance,
+                                    OfxPropertySetHandle inArgs)
+{
+  RemoteMessage request(RemoteAction::IsIdentity), reply;
+  writeInstanceState(request, plugin, instance, inArgs);
+  if (!transact(request, &reply, instance)) {
+    return kOfxStatFailed;
+  }
+
+  int32_t status;
+  reply.readInt(&status);
+  readEffectMessage(reply, instance);
+  return status;
+}
+
+OfxStatus MfxRemoteHost::cook(RemotePlugin *plugin,
+                              OfxMeshEffectHandle instance,
+                              OfxPropertySetHandle inArgs)
+{
+  OfxHost *host = instance->host;
+  const OfxMeshEffectSuiteV1 *mes = (const OfxMeshEffectSuiteV1 *)host->fetchSuite(
+      host->host, kOfxMeshEffectSuite, 1);
+  MeshTransport transport(host);
+
+  RemoteMessage request(RemoteAction::Cook), reply;
+  writeInstanceState(request, plugin, instance, inArgs);
+
+  // Convert inputs on the host side and pack them in shared memory segments,
+  // that the helper maps without copying.
+  std::vector<std::unique_ptr<SharedMemory>> segments;
+  OfxMeshInputSetStruct &inputs = instance->inputs;
+  request.writeInt(inputs.num_inputs);
+  for (int i = 0; i < inputs.num_inputs; ++i) {
+    OfxMeshInputHandle input = inputs.inputs[i];
+    request.writeString(input->name);
+
+    OfxMeshHandle mesh = NULL;
+    // Only the main output is sent back, other outputs remain unused
+    if (input->is_output() || kOfxStatOK != mes->inputGetMesh(input, 0.0, &mesh, NULL)) {
+      request.writeInt(0);
+      continue;
+    }
+
+    RemoteMesh remote_mesh;
+    std::unique_ptr<SharedMemory> segment(new SharedMemory);
+    bool is_packed = kOfxStatOK == transport.describe(mesh, &remote_mesh) &&
+                     segment->create(remote_mesh.dataSize) &&
+                     kOfxStatOK == transport.pack(mesh, remote_mesh, segment->data());
+    mes->inputReleaseMesh(mesh);
+
+    if (!is_packed) {
+      printf("ERROR: Could not send input '%s' to the remote host.\n", input->name);
+      return kOfxStatErrMemory;
+    }
+
+    request.writeInt(1);
+    remote_mesh.write(request);
+    request.fds.push_back(segment->fd());
+    segments.push_back(std::move(segment));
+  }
+
+  if (!transact(request, &reply, instance)) {
+    return kOfxStatFailed;
+  }
+  segments.clear();
+
+  int32_t status, has_output;
+  reply.readInt(&status);
+  readEffectMessage(reply, instance);
+  if (kOfxStatOK != status) {
+    remoteCloseFds(&reply);
+    return status;
+  }
+
+  reply.readInt(&has_output);
+  if (!has_output) {
+    remoteCloseFds(&reply);
+    return kOfxStatOK;
+  }
+
+  RemoteMesh remote_output;
+  if (!remote_output.read(reply) || reply.fds.size() != 1) {
+    printf("ERROR: Invalid output received from the remote host.\n");
+    remoteCloseFds(&reply);
+    return kOfxStatFailed;
+  }
+
+  SharedMemory segment;
+  int fd = reply.fds[0];
+  reply.fds.clear();
+  if (!segment.open(fd, remote_output.dataSize)) {
+    return kOfxStatErrMemory;
+  }
+
+  // Expose the output segment through the regular output mesh, so that the
+  // usual release callback converts it into the host's representation.
+  OfxMeshInputHandle output;
+  OfxMeshHandle output_mesh;
+  if (kOfxStatOK != mes->inputGetHandle(instance, kOfxMeshMainOutput, &output, NULL) ||
+      kOfxStatOK != mes->inputGetMesh(output, 0.0, &output_mesh, NULL)) {
+    return kOfxStatFailed;
+  }
+
+  remote_output.hasTransform = false;  // owned by the host's callbacks
+  status = transport.bind(output_mesh, remote_output, segment.data());
+  mes->inputReleaseMesh(output_mesh);
+  return status;
+}
+
+// // C API
+
+MfxRemoteHost *remote_host_start(const char *helper_path, const char *ofx_filepath)
+{
+  MfxRemoteHost *remote_host = new MfxRemoteHost;
+  if (!remote_host->start(helper_path, ofx_filepath)) {
+    delete remote_host;
+    return NULL;
+  }
+  return remote_host;
+}
+
+PluginRegistry *remote_host_registry(MfxRemoteHost *remote_host)
+{
+  return remote_host->registry();
+}
+
+bool remote_host_is_alive(MfxRemoteHost *remote_host)
+{
+  return remote_host->isAlive();
+}
+
+void remote_host_stop(MfxRemoteHost *remote_host)
+{
+  delete remote_host;
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2019-2021 Elie Michel
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** \file
+ * \ingroup openmesheffect
+ *
+ * Host side of the out of process execution: proxy plugins forwarding their
+ * actions to the helper process.
+ */
+
+#ifndef __MFX_REMOTE_HOST_INTERN_H__
+#define __MFX_REMOTE_HOST_INTERN_H__
+
+#include "mfxRemoteHost.h"
+#include "remoteEffect.h"
+#include "remoteProtocol.h"
+
+#include "ofxCore.h"
+#include "ofxMeshEffect.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+struct RemotePlugin {
+  OfxPlugin plugin;
+  MfxRemoteHost *remote_host;
+  int index;  // index of the plugin in the helper's registry
+  std::string identifier;
+  std::map<OfxMeshEffectHandle, int32_t> instances;  // local instance -> remote id
+};
+
+struct MfxRemoteHost {
+ public:
+  MfxRemoteHost();
+  ~MfxRemoteHost();
+
+  // Disable copy, it owns a process
+  MfxRemoteHost(const MfxRemoteHost &) = delete;
+  MfxRemoteHost &operator=(const MfxRemoteHost &) = delete;
+
+  bool start(const char *helper_path, const char *ofx_filepath);
+  void stop();
+
+  bool isAlive() const;
+  PluginRegistry *registry();
+
+  // Actions of the proxy plugins
+  OfxStatus describe(RemotePlugin *plugin, OfxMeshEffectHandle descriptor);
+  OfxStatus createInstance(RemotePlugin *plugin, OfxMeshEffectHandle instance);
+  OfxStatus destroyInstance(RemotePlugin *plugin, OfxMeshEffectHandle instance);
+  OfxStatus isIdentity(RemotePlugin *plugin,
+                       OfxMeshEffectHandle instance,
+                       OfxPropertySetHandle inArgs);
+  OfxStatus cook(RemotePlugin *plugin, OfxMeshEffectHandle instance, OfxPropertySetHandle inArgs);
+
+ private:
+  /**
+   * Send a request and wait for its reply. On failure, the helper process is
+   * considered dead and the error is reported in the effect's message.
+   */
+  bool transact(const RemoteMessage &request,
+                RemoteMessage *reply,
+                OfxMeshEffectHandle effect = nullptr);
+
+  bool listPlugins();
+
+  /**
+   * Write what is needed by IsIdentity and Cook actions in the helper.
+   */
+  void writeInstanceState(RemoteMessage &message,
+                          RemotePlugin *plugin,
+                          OfxMeshEffectHandle instance,
+                          OfxPropertySetHandle inArgs);
+
+ private:
+  int m_socket;
+  pid_t m_pid;
+  bool m_is_alive;
+  std::mutex m_mutex;  // one request at a time on the socket
+
+  StringPool m_strings;
+  std::vector<std::unique_ptr<RemotePlugin>> m_plugins;
+  std::vector<OfxPlugin *> m_plugin_pointers;
+  std::vector<OfxPluginStatus> m_plugin_status;
+  std::vector<int> m_plugin_load_counts;
+  PluginRegistry m_registry;
+};
+
+#endif // __MFX_REMOTE_HOST_INTERN_H__
@@ -0,0 +1,283 @@
+/*
+ * Copyright 2019-2021 Elie Michel
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "remoteProtocol.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+#  define MSG_NOSIGNAL 0  // SIGPIPE is ignored by the helper process instead
+#endif
+
+constexpr uint32_t MESSAGE_MAGIC = 0x4d465852;  // "MFXR"
+constexpr int MAX_MESSAGE_FDS = 64;
+
+struct MessageHeader {
+  uint32_t magic;
+  int32_t action;
+  uint64_t payload_size;
+  int32_t fd_count;
+  int32_t _pad;
+};
+
+// // RemoteMessage
+
+RemoteMessage::RemoteMessage(RemoteAction action)
+{
+  clear(action);
+}
+
+void RemoteMessage::clear(RemoteAction action)
+{
+  this->action = action;
+  payload.clear();
+  fds.clear();
+  m_cursor = 0;
+  m_is_valid = true;
+}
+
+void RemoteMessage::writeInt(int32_t value)
+{
+  writeBytes(&value, sizeof(value));
+}
+
+void RemoteMessage::writeInt64(int64_t value)
+{
+  writeBytes(&value, sizeof(value));
+}
+
+void RemoteMessage::writeDouble(double value)
+{
+  writeBytes(&value, sizeof(value));
+}
+
+void RemoteMessage::writeString(const char *value)
+{
+  int32_t size = NULL != value ? (int32_t)strlen(value) : 0;
+  writeInt(size);
+  writeBytes(value, size);
+}
+
+void RemoteMessage::writeBytes(const void *data, size_t size)
+{
+  if (0 == size) {
+    return;
+  }
+  const char *bytes = static_cast<const char *>(data);
+  payload.insert(payload.end(), bytes, bytes + size);
+}
+
+bool RemoteMessage::readInt(int32_t *value)
+{
+  return readBytes(value, sizeof(*value));
+}
+
+bool RemoteMessage::readInt64(int64_t *value)
+{
+  return readBytes(value, sizeof(*value));
+}
+
+bool RemoteMessage::readDouble(double *value)
+{
+  return readBytes(value, sizeof(*value));
+}
+
+bool RemoteMessage::readString(std::string *value)
+{
+  int32_t size;
+  if (!readInt(&size) || size < 0 || m_cursor + size > payload.size()) {
+    m_is_valid = false;
+    return false;
+  }
+  value->assign(payload.data() + m_cursor, size);
+  m_cursor += size;
+  return true;
+}
+
+bool RemoteMessage::readBytes(void *data, size_t size)
+{
+  if (!m_is_valid || m_cursor + size > payload.size()) {
+    m_is_valid = false;
+    return false;
+  }
+  memcpy(data, payload.data() + m_cursor, size);
+  m_cursor += size;
+  return true;
+}
+
+bool RemoteMessage::isValid() const
+{
+  return m_is_valid;
+}
+
+// // Socket transport
+
+static bool writeAll(int socket, const char *data, size_t size)
+{
+  while (size > 0) {
+    ssize_t written = send(socket, data, size, MSG_NOSIGNAL);
+    if (written < 0) {
+      if (EINTR == errno) {
+        continue;
+      }
+      return false;
+    }
+    data += written;
+    size -= (size_t)written;
+  }
+  return true;
+}
+
+static bool readAll(int socket, char *data, size_t size)
+{
+  while (size > 0) {
+    ssize_t count = recv(socket, data, size, 0);
+    if (count < 0 && EINTR == errno) {
+      continue;
+    }
+    if (count <= 0) {
+      return false;
+    }
+    data += count;
+    size -= (size_t)count;
+  }
+  return true;
+}
+
+bool remoteSend(int socket, const RemoteMessage &message)
+{
+  if (message.fds.size() > MAX_MESSAGE_FDS) {
+    printf("ERROR: Too many shared memory segments in a single message.\n");
+    return false;
+  }
+
+  MessageHeader header;
+  header.magic = MESSAGE_MAGIC;
+  header.action = (int32_t)message.action;
+  header.payload_size = message.payload.size();
+  header.fd_count = (int32_t)message.fds.size();
+  header._pad = 0;
+
+  // The header carries the file descriptors as ancillary data
+  struct iovec iov;
+  iov.iov_base = &header;
+  iov.iov_len = sizeof(header);
+
+  char control[CMSG_SPACE(sizeof(int) * MAX_MESSAGE_FDS)];
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+
+  if (!message.fds.empty()) {
+    size_t fds_size = sizeof(int) * message.fds.size();
+    memset(control, 0, sizeof(control));
+    msg.msg_control = control;
+    msg.msg_controllen = CMSG_SPACE(fds_size);
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(fds_size);
+    memcpy(CMSG_DATA(cmsg), message.fds.data(), fds_size);
+  }
+
+  ssize_t sent;
+  do {
+    sent = sendmsg(socket, &msg, MSG_NOSIGNAL);
+  } while (sent < 0 && EINTR == errno);
+
+  if (sent < 0) {
+    return false;
+  }
+  if ((size_t)sent < sizeof(header) &&
+      !writeAll(socket, (const char *)&header + sent, sizeof(header) - sent)) {
+    return false;
+  }
+
+  return writeAll(socket, message.payload.data(), message.payload.size());
+}
+
+bool remoteReceive(int socket, RemoteMessage *message)
+{
+  message->clear(RemoteAction::Invalid);
+
+  MessageHeader header;
+  struct iovec iov;
+  iov.iov_base = &header;
+  iov.iov_len = sizeof(header);
+
+  char control[CMSG_SPACE(sizeof(int) * MAX_MESSAGE_FDS)];
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+
+  ssize_t received;
+  do {
+    received = recvmsg(socket, &msg, 0);
+  } while (received < 0 && EINTR == errno);
+
+  if (received <= 0) {
+    return false;
+  }
+
+  for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); NULL != cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if (SOL_SOCKET == cmsg->cmsg_level && SCM_RIGHTS == cmsg->cmsg_type) {
+      size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+      const int *fds = (const int *)CMSG_DATA(cmsg);
+      message->fds.insert(message->fds.end(), fds, fds + count);
+    }
+  }
+
+  if ((size_t)received < sizeof(header) &&
+      !readAll(socket, (char *)&header + received, sizeof(header) - received)) {
+    remoteCloseFds(message);
+    return false;
+  }
+
+  if (MESSAGE_MAGIC != header.magic || (size_t)header.fd_count != message->fds.size()) {
+    printf("ERROR: Corrupted message received from remote OpenMfx host.\n");
+    remoteCloseFds(message);
+    return false;
+  }
+
+  message->action = (RemoteAction)header.action;
+  message->payload.resize(header.payload_size);
+  if (!readAll(socket, message->payload.data(), header.payload_size)) {
+    remoteCloseFds(message);
+    return false;
+  }
+
+  return true;
+}
+
+void remoteCloseFds(RemoteMessage *message)
+{
+  for (int fd : message->fds) {
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+  message->fds.clear();
+}
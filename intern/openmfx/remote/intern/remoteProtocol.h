@@ -0,0 +1,102 @@
+/*
+ * Copyright 2019-2021 Elie Michel
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** \file
+ * \ingroup openmesheffect
+ *
+ * Messages exchanged between the host and the helper process running the
+ * plugins out of process. Messages are sent over a local socket, and may carry
+ * file descriptors of shared memory segments along with them.
+ */
+
+#ifndef __MFX_REMOTE_PROTOCOL_H__
+#define __MFX_REMOTE_PROTOCOL_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class RemoteAction : int32_t {
+  Invalid = 0,
+  // host -> helper
+  ListPlugins,
+  Describe,
+  CreateInstance,
+  DestroyInstance,
+  IsIdentity,
+  Cook,
+  Quit,
+  // helper -> host
+  Reply,
+};
+
+/**
+ * A message is a flat buffer of values, read back in the order they were written.
+ */
+class RemoteMessage {
+ public:
+  RemoteMessage(RemoteAction action = RemoteAction::Invalid);
+
+  void clear(RemoteAction action);
+
+  void writeInt(int32_t value);
+  void writeInt64(int64_t value);
+  void writeDouble(double value);
+  void writeString(const char *value);  // NULL is written as an empty string
+  void writeBytes(const void *data, size_t size);
+
+  /**
+   * Reading functions return false and leave the message in an invalid state
+   * once a read goes past the end of the message.
+   */
+  bool readInt(int32_t *value);
+  bool readInt64(int64_t *value);
+  bool readDouble(double *value);
+  bool readString(std::string *value);
+  bool readBytes(void *data, size_t size);
+
+  bool isValid() const;
+
+ public:
+  RemoteAction action;
+  std::vector<char> payload;
+  std::vector<int> fds;  // file descriptors attached to the message
+
+ private:
+  size_t m_cursor;
+  bool m_is_valid;
+};
+
+/**
+ * Send a message and its attached file descriptors. The descriptors remain
+ * owned by the caller.
+ */
+bool remoteSend(int socket, const RemoteMessage &message);
+
+/**
+ * Block until a message is received. Received file descriptors are owned by
+ * the caller, who must close them.
+ */
+bool remoteReceive(int socket, RemoteMessage *message);
+
+/**
+ * Close the file descriptors attached to a message. Descriptors that were
+ * taken over by the reader are expected to be set to -1.
+ */
+void remoteCloseFds(RemoteMessage *message);
+
+#endif // __MFX_REMOTE_PROTOCOL_H__
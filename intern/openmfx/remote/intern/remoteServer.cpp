@@ -0,0 +1,396 @@
+/*
+ * Copyright 2019-2021 Elie Michel
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "remoteServer.h"
+#include "remoteEffect.h"
+
+#include "mfxHost.h"
+#include "ofxExtras.h"
+
+#include "ofxProperty.h"
+
+#include <cstdio>
+#include <cstring>
+
+// // Host callbacks
+
+static RemoteMeshBinding *getBinding(OfxMeshHandle mesh)
+{
+  int i = mesh->properties.find_property(kOfxMeshPropInternalData);
+  if (-1 == i) {
+    return nullptr;
+  }
+  return (RemoteMeshBinding *)mesh->properties.properties[i]->value[0].as_pointer;
+}
+
+static OfxStatus before_mesh_get(OfxHost *host, OfxMeshHandle mesh)
+{
+  RemoteMeshBinding *binding = getBinding(mesh);
+  if (nullptr == binding) {
+    return kOfxStatErrBadHandle;
+  }
+
+  if (binding->is_input) {
+    if (!binding->is_present) {
+      return kOfxStatErrBadHandle;
+    }
+    return binding->transport->bind(mesh, binding->mesh, binding->memory.data());
+  }
+
+  // Output starts empty, like in the host
+  OfxPropertySuiteV1 *ps = (OfxPropertySuiteV1 *)host->fetchSuite(
+      host->host, kOfxPropertySuite, 1);
+  ps->propSetInt(&mesh->properties, kOfxMeshPropPointCount, 0, 0);
+  ps->propSetInt(&mesh->properties, kOfxMeshPropCornerCount, 0, 0);
+  ps->propSetInt(&mesh->properties, kOfxMeshPropFaceCount, 0, 0);
+  ps->propSetInt(&mesh->properties, kOfxMeshPropLooseEdgeCount, 0, 0);
+  ps->propSetInt(&mesh->properties, kOfxMeshPropNoLooseEdge, 0, 1);
+  ps->propSetInt(&mesh->properties, kOfxMeshPropConstantFaceSize, 0, -1);
+  ps->propSetPointer(&mesh->properties, kOfxMeshPropTransformMatrix, 0, NULL);
+  return kOfxStatOK;
+}
+
+static OfxStatus before_mesh_release(OfxHost *host, OfxMeshHandle mesh)
+{
+  (void)host;
+  RemoteMeshBinding *binding = getBinding(mesh);
+  if (nullptr == binding || binding->is_input) {
+    return kOfxStatOK;
+  }
+
+  // Pack the output before its buffers get freed
+  OfxStatus status = binding->transport->describe(mesh, &binding->mesh);
+  if (kOfxStatOK != status) {
+    return status;
+  }
+  if (!binding->memory.create(binding->mesh.dataSize)) {
+    return kOfxStatErrMemory;
+  }
+  status = binding->transport->pack(mesh, binding->mesh, binding->memory.data());
+  binding->is_present = kOfxStatOK == status;
+  return status;
+}
+
+static void setMeshBinding(OfxMeshInputHandle input, RemoteMeshBinding *binding)
+{
+  OfxPropertySetStruct &props = input->mesh.properties;
+  ensurePropertyValue(props, kOfxMeshPropInternalData)[0].as_pointer =
+      (void *)binding;
+}
+
+// // RemoteServer
+
+RemoteServer::RemoteServer() : m_host(nullptr), m_is_registry_loaded(false), m_next_instance_id(0)
+{
+  memset(&m_registry, 0, sizeof(m_registry));
+}
+
+RemoteServer::~RemoteServer()
+{
+  for (const auto &it : m_instances) {
+    ofxhost_destroy_instance(m_registry.plugins[it.second.plugin_index], it.second.handle);
+  }
+  m_instances.clear();
+
+  for (const auto &it : m_descriptors) {
+    ofxhost_release_descriptor(it.second);
+  }
+  m_descriptors.clear();
+
+  // Also unloads the plugins loaded by ensurePluginLoaded()
+  if (m_is_registry_loaded) {
+    free_registry(&m_registry);
+  }
+
+  if (nullptr != m_host) {
+    releaseGlobalHost();
+  }
+}
+
+bool RemoteServer::load(const char *ofx_filepath)
+{
+  m_host = getGlobalHost();
+  OfxPropertySuiteV1 *ps = (OfxPropertySuiteV1 *)m_host->fetchSuite(
+      m_host->host, kOfxPropertySuite, 1);
+  ps->propSetPointer(m_host->host, kOfxHostPropBeforeMeshGetCb, 0, (void *)before_mesh_get);
+  ps->propSetPointer(
+      m_host->host, kOfxHostPropBeforeMeshReleaseCb, 0, (void *)before_mesh_release);
+  m_transport.reset(new MeshTransport(m_host));
+
+  m_is_registry_loaded = load_registry(&m_registry, ofx_filepath);
+  return m_is_registry_loaded;
+}
+
+void RemoteServer::run(int socket)
+{
+  RemoteMessage request, reply;
+  while (remoteReceive(socket, &request)) {
+    if (RemoteAction::Quit == request.action) {
+      remoteCloseFds(&request);
+      break;
+    }
+
+    reply.clear(RemoteAction::Reply);
+    bool ok = handle(request, reply);
+    remoteCloseFds(&request);
+    if (!ok) {
+      printf("ERROR: Invalid request received by the remote host.\n");
+      break;
+    }
+
+    bool is_sent = remoteSend(socket, reply);
+    m_output.reset();  // the host received its own descriptor of the output segment
+    if (!is_sent) {
+      break;
+    }
+  }
+}
+
+bool RemoteServer::handle(RemoteMessage &request, RemoteMessage &reply)
+{
+  switch (request.action) {
+    case RemoteAction::ListPlugins:
+      listPlugins(reply);
+      break;
+    case RemoteAction::Describe:
+      describe(request, reply);
+      break;
+    case RemoteAction::CreateInstance:
+      createInstance(request, reply);
+      break;
+    case RemoteAction::DestroyInstance:
+      destroyInstance(request, reply);
+      break;
+    case RemoteAction::IsIdentity:
+      isIdentity(request, reply);
+      break;
+    case RemoteAction::Cook:
+      cook(request, reply);
+      break;
+    default:
+      return false;
+  }
+  return request.isValid();
+}
+
+void RemoteServer::listPlugins(RemoteMessage &reply)
+{
+  if (!m_is_registry_loaded) {
+    reply.writeInt(kOfxStatFailed);
+    return;
+  }
+
+  reply.writeInt(kOfxStatOK);
+  reply.writeInt(m_registry.num_plugins);
+  for (int i = 0; i < m_registry.num_plugins; ++i) {
+    const OfxPlugin *plugin = m_registry.plugins[i];
+    reply.writeString(plugin->pluginIdentifier);
+    reply.writeInt((int32_t)plugin->pluginVersionMajor);
+    reply.writeInt((int32_t)plugin->pluginVersionMinor);
+  }
+}
+
+bool RemoteServer::ensurePluginLoaded(int index)
+{
+  if (!m_is_registry_loaded || index < 0 || index >= m_registry.num_plugins) {
+    return false;
+  }
+
+  // The server is the only user of its registry, which holds each plugin once
+  if (OfxPluginStatOK == m_registry.status[index]) {
+    return true;
+  }
+  return registry_acquire_plugin(&m_registry, index, m_host);
+}
+
+void RemoteServer::describe(RemoteMessage &request, RemoteMessage &reply)
+{
+  int32_t index;
+  request.readInt(&index);
+
+  OfxMeshEffectStruct no_effect(m_host);
+  if (!ensurePluginLoaded(index)) {
+    reply.writeInt(kOfxStatFailed);
+    writeEffectMessage(reply, no_effect);
+    return;
+  }
+
+  if (m_descriptors.count(index)) {
+    ofxhost_release_descriptor(m_descriptors[index]);
+    m_descriptors.erase(index);
+  }
+
+  OfxMeshEffectHandle descriptor;
+  if (!ofxhost_get_descriptor(m_host, m_registry.plugins[index], &descriptor)) {
+    reply.writeInt(kOfxStatFailed);
+    writeEffectMessage(reply, no_effect);
+    return;
+  }
+  m_descriptors[index] = descriptor;
+
+  reply.writeInt(kOfxStatOK);
+  writeEffectMessage(reply, *descriptor);
+  writeEffectDescription(reply, *descriptor);
+}
+
+void RemoteServer::createInstance(RemoteMessage &request, RemoteMessage &reply)
+{
+  int32_t index;
+  request.readInt(&index);
+
+  OfxMeshEffectStruct no_effect(m_host);
+  OfxMeshEffectHandle instance;
+  if (0 == m_descriptors.count(index) ||
+      !ofxhost_create_instance(
+          m_registry.plugins[index], m_descriptors[index], &instance)) {
+    reply.writeInt(kOfxStatFailed);
+    writeEffectMessage(reply, no_effect);
+    return;
+  }
+
+  int32_t id = m_next_instance_id++;
+  m_instances[id] = {index, instance};
+
+  reply.writeInt(kOfxStatOK);
+  writeEffectMessage(reply, *instance);
+  reply.writeInt(id);
+}
+
+void RemoteServer::destroyInstance(RemoteMessage &request, RemoteMessage &reply)
+{
+  int32_t id;
+  request.readInt(&id);
+
+  auto it = m_instances.find(id);
+  if (it == m_instances.end()) {
+    reply.writeInt(kOfxStatErrBadHandle);
+    return;
+  }
+
+  ofxhost_destroy_instance(m_registry.plugins[it->second.plugin_index], it->second.handle);
+  m_instances.erase(it);
+  reply.writeInt(kOfxStatOK);
+}
+
+OfxMeshEffectHandle RemoteServer::readInstanceState(RemoteMessage &request, int32_t *plugin_index)
+{
+  int32_t id, is_draft;
+  request.readInt(&id);
+  request.readInt(&is_draft);
+
+  auto it = m_instances.find(id);
+  if (it == m_instances.end()) {
+    return nullptr;
+  }
+  OfxMeshEffectHandle instance = it->second.handle;
+  *plugin_index = it->second.plugin_index;
+
+  if (!readParameterValues(request, &instance->parameters)) {
+    return nullptr;
+  }
+
+  OfxPropertySetStruct &props = instance->properties;
+  ensurePropertyValue(props, kOfxMeshEffectPropRenderQualityDraft)[0]
+      .as_int = is_draft;
+  return instance;
+}
+
+void RemoteServer::isIdentity(RemoteMessage &request, RemoteMessage &reply)
+{
+  int32_t plugin_index;
+  OfxMeshEffectHandle instance = readInstanceState(request, &plugin_index);
+  if (nullptr == instance) {
+    OfxMeshEffectStruct no_effect(m_host);
+    reply.writeInt(kOfxStatErrBadHandle);
+    writeEffectMessage(reply, no_effect);
+    return;
+  }
+
+  bool should_cook = true;
+  bool ok = ofxhost_is_identity(m_registry.plugins[plugin_index], instance, &should_cook);
+  reply.writeInt(!ok ? kOfxStatFailed : should_cook ? kOfxStatReplyDefault : kOfxStatOK);
+  writeEffectMessage(reply, *instance);
+}
+
+void RemoteServer::cook(RemoteMessage &request, RemoteMessage &reply)
+{
+  int32_t plugin_index;
+  OfxMeshEffectHandle instance = readInstanceState(request, &plugin_index);
+  if (nullptr == instance) {
+    OfxMeshEffectStruct no_effect(m_host);
+    reply.writeInt(kOfxStatErrBadHandle);
+    writeEffectMessage(reply, no_effect);
+    return;
+  }
+
+  // Map the input segments sent by the host
+  int32_t input_count;
+  request.readInt(&input_count);
+  std::vector<std::unique_ptr<RemoteMeshBinding>> inputs;
+  size_t fd_index = 0;
+  std::string name;
+  for (int i = 0; i < input_count && request.isValid(); ++i) {
+    int32_t is_present;
+    request.readString(&name);
+    request.readInt(&is_present);
+
+    std::unique_ptr<RemoteMeshBinding> binding(new RemoteMeshBinding);
+    binding->is_input = true;
+    binding->is_present = false;
+    binding->transport = m_transport.get();
+
+    if (is_present) {
+      if (!binding->mesh.read(request) || fd_index >= request.fds.size()) {
+        break;
+      }
+      int fd = request.fds[fd_index];
+      request.fds[fd_index++] = -1;  // now owned by the segment
+      binding->is_present = binding->memory.open(fd, binding->mesh.dataSize);
+    }
+
+    int input_index = instance->inputs.find(name.c_str());
+    if (-1 != input_index) {
+      setMeshBinding(instance->inputs.inputs[input_index], binding.get());
+    }
+    inputs.push_back(std::move(binding));
+  }
+
+  m_output.reset(new RemoteMeshBinding);
+  m_output->is_input = false;
+  m_output->is_present = false;
+  m_output->transport = m_transport.get();
+
+  OfxMeshInputHandle output = nullptr;
+  int output_index = instance->inputs.find(kOfxMeshMainOutput);
+  if (-1 != output_index) {
+    output = instance->inputs.inputs[output_index];
+    setMeshBinding(output, m_output.get());
+  }
+
+  bool ok = request.isValid() && ofxhost_cook(m_registry.plugins[plugin_index], instance);
+
+  for (int i = 0; i < instance->inputs.num_inputs; ++i) {
+    setMeshBinding(instance->inputs.inputs[i], nullptr);
+  }
+
+  reply.writeInt(ok ? kOfxStatOK : kOfxStatFailed);
+  writeEffectMessage(reply, *instance);
+  reply.writeInt(ok && m_output->is_present ? 1 : 0);
+  if (ok && m_output->is_present) {
+    m_output->mesh.write(reply);
+    reply.fds.push_back(m_output->memory.fd());
+  }
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2019-2021 Elie Michel
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** \file
+ * \ingroup openmesheffect
+ *
+ * Helper process side of the out of process execution: runs the actual
+ * plugins on behalf of the host.
+ */
+
+#ifndef __MFX_REMOTE_SERVER_H__
+#define __MFX_REMOTE_SERVER_H__
+
+#include "meshTransport.h"
+#include "remoteProtocol.h"
+#include "sharedMemory.h"
+
+#include "mfxPluginRegistry.h"
+
+#include <mfxHost/mesheffect>
+
+#include <map>
+#include <memory>
+#include <vector>
+
+/**
+ * Data bound to a mesh through kOfxMeshPropInternalData for the duration of a cook
+ */
+struct RemoteMeshBinding {
+  bool is_input;
+  bool is_present;
+  RemoteMesh mesh;
+  SharedMemory memory;
+  MeshTransport *transport;
+};
+
+class RemoteServer {
+ public:
+  RemoteServer();
+  ~RemoteServer();
+
+  // Disable copy, it owns the plugin registry
+  RemoteServer(const RemoteServer &) = delete;
+  RemoteServer &operator=(const RemoteServer &) = delete;
+
+  bool load(const char *ofx_filepath);
+
+  /**
+   * Serve requests received on the socket until the host quits or the
+   * connection is lost.
+   */
+  void run(int socket);
+
+ private:
+  bool handle(RemoteMessage &request, RemoteMessage &reply);
+
+  void listPlugins(RemoteMessage &reply);
+  void describe(RemoteMessage &request, RemoteMessage &reply);
+  void createInstance(RemoteMessage &request, RemoteMessage &reply);
+  void destroyInstance(RemoteMessage &request, RemoteMessage &reply);
+  void isIdentity(RemoteMessage &request, RemoteMessage &reply);
+  void cook(RemoteMessage &request, RemoteMessage &reply);
+
+  bool ensurePluginLoaded(int index);
+
+  /**
+   * Read the state written by MfxRemoteHost::writeInstanceState() and apply it
+   * to the instance. Returns NULL if the instance is unknown.
+   */
+  OfxMeshEffectHandle readInstanceState(RemoteMessage &request, int32_t *plugin_index);
+
+ private:
+  OfxHost *m_host;
+  PluginRegistry m_registry;
+  bool m_is_registry_loaded;
+  std::unique_ptr<MeshTransport> m_transport;
+
+  std::map<int, OfxMeshEffectHandle> m_descriptors;  // per plugin index
+  struct Instance {
+    int plugin_index;
+    OfxMeshEffectHandle handle;
+  };
+  std::map<int32_t, Instance> m_instances;
+  int32_t m_next_instance_id;
+
+  // Segments of the output of the last cook, kept until the reply is sent
+  std::unique_ptr<RemoteMeshBinding> m_output;
+};
+
+#endif // __MFX_REMOTE_SERVER_H__
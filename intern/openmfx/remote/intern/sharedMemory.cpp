@@ -0,0 +1,129 @@
+/*
+ * Copyright 2019-2021 Elie Michel
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "sharedMemory.h"
+
+#include <atomic>
+#include <cstdio>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#  include <sys/syscall.h>
+#endif
+
+/**
+ * Get a file descriptor to a new anonymous shared memory object. On Linux
+ * this is a memfd, elsewhere a POSIX shared memory object that is unlinked
+ * right away so that it does not outlive the processes using it.
+ */
+static int createAnonymousSegment()
+{
+#if defined(__linux__) && defined(SYS_memfd_create)
+  int memfd = (int)syscall(SYS_memfd_create, "openmfx", 1 /* MFD_CLOEXEC */);
+  if (memfd >= 0) {
+    return memfd;
+  }
+#endif
+
+  static std::atomic<int> counter(0);
+  char name[64];
+  snprintf(name, sizeof(name), "/openmfx-%d-%d", (int)getpid(), counter++);
+  int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd >= 0) {
+    shm_unlink(name);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+  }
+  return fd;
+}
+
+SharedMemory::SharedMemory() : m_fd(-1), m_data(nullptr), m_size(0)
+{
+}
+
+SharedMemory::~SharedMemory()
+{
+  release();
+}
+
+bool SharedMemory::create(size_t size)
+{
+  release();
+
+  m_fd = createAnonymousSegment();
+  if (m_fd < 0) {
+    printf("ERROR: Could not create shared memory segment.\n");
+    return false;
+  }
+
+  if (0 != ftruncate(m_fd, (off_t)size)) {
+    printf("ERROR: Could not resize shared memory segment to %zu bytes.\n", size);
+    release();
+    return false;
+  }
+
+  m_size = size;
+  return map();
+}
+
+bool SharedMemory::open(int fd, size_t size)
+{
+  release();
+  m_fd = fd;
+  m_size = size;
+
+  struct stat st;
+  if (0 != fstat(m_fd, &st) || (size_t)st.st_size < size) {
+    printf("ERROR: Shared memory segment is smaller than announced.\n");
+    release();
+    return false;
+  }
+
+  return map();
+}
+
+void SharedMemory::release()
+{
+  if (nullptr != m_data) {
+    munmap(m_data, m_size);
+    m_data = nullptr;
+  }
+  if (m_fd >= 0) {
+    close(m_fd);
+    m_fd = -1;
+  }
+  m_size = 0;
+}
+
+bool SharedMemory::map()
+{
+  if (0 == m_size) {
+    return true;
+  }
+
+  void *data = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+  if (MAP_FAILED == data) {
+    printf("ERROR: Could not map shared memory segment.\n");
+    release();
+    return false;
+  }
+
+  m_data = static_cast<char *>(data);
+  return true;
+}
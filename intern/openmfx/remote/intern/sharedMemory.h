@@ -0,0 +1,75 @@
+/*
+ * Copyright 2019-2021 Elie Michel
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** \file
+ * \ingroup openmesheffect
+ *
+ * Anonymous shared memory segment, shared with another process by sending
+ * its file descriptor over a local socket.
+ */
+
+#ifndef __MFX_SHARED_MEMORY_H__
+#define __MFX_SHARED_MEMORY_H__
+
+#include <cstddef>
+
+class SharedMemory {
+ public:
+  SharedMemory();
+  ~SharedMemory();
+
+  // Disable copy, a segment is mapped once
+  SharedMemory(const SharedMemory &) = delete;
+  SharedMemory &operator=(const SharedMemory &) = delete;
+
+  /**
+   * Create and map a new segment of the given size.
+   */
+  bool create(size_t size);
+
+  /**
+   * Map a segment received from another process. Takes ownership of fd.
+   */
+  bool open(int fd, size_t size);
+
+  /**
+   * Unmap the segment and close its file descriptor.
+   */
+  void release();
+
+  char *data() const
+  {
+    return m_data;
+  }
+  size_t size() const
+  {
+    return m_size;
+  }
+  int fd() const
+  {
+    return m_fd;
+  }
+
+ private:
+  bool map();
+
+ private:
+  int m_fd;
+  char *m_data;
+  size_t m_size;
+};
+
+#endif // __MFX_SHARED_MEMORY_H__
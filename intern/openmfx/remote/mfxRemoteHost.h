@@ -0,0 +1,65 @@
+/*
+ * Copyright 2019-2021 Elie Michel
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** \file
+ * \ingroup openmesheffect
+ *
+ * Out of process execution of OpenMfx plugins. The .ofx binary is loaded by a
+ * helper process (mfx_remote_host) and the host only sees proxy plugins that
+ * forward actions to it. Meshes travel through shared memory, so a plugin
+ * crash only takes down the helper process.
+ */
+
+#ifndef __MFX_REMOTE_HOST_H__
+#define __MFX_REMOTE_HOST_H__
+
+#include "mfxPluginRegistry.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct MfxRemoteHost MfxRemoteHost;
+
+/**
+ * Spawn a helper process loading the plugins of ofx_filepath.
+ * Returns NULL if the helper could not be started or failed to load the file.
+ */
+MfxRemoteHost *remote_host_start(const char *helper_path, const char *ofx_filepath);
+
+/**
+ * Registry of proxy plugins, to be used like a regular registry with the
+ * functions of mfxHost.h. It remains owned by the remote host.
+ */
+PluginRegistry *remote_host_registry(MfxRemoteHost *remote_host);
+
+/**
+ * Whether the helper process is still running. Once it died, all actions of
+ * the proxy plugins fail until the remote host is restarted.
+ */
+bool remote_host_is_alive(MfxRemoteHost *remote_host);
+
+/**
+ * Stop the helper process. Descriptors and instances of the proxy plugins
+ * must have been released before.
+ */
+void remote_host_stop(MfxRemoteHost *remote_host);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __MFX_REMOTE_HOST_H__
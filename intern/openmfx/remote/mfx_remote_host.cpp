@@ -0,0 +1,57 @@
+/*
+ * Copyright 2019-2021 Elie Michel
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** \file
+ * \ingroup openmesheffect
+ *
+ * Helper process running OpenMfx plugins on behalf of a host.
+ * Usage: mfx_remote_host --fd <socket> <plugin.ofx>
+ * It is spawned by remote_host_start() and is not meant to be run by hand.
+ */
+
+#include "intern/remoteServer.h"
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <unistd.h>
+
+int main(int argc, char **argv)
+{
+  if (argc != 4 || 0 != strcmp(argv[1], "--fd")) {
+    fprintf(stderr, "Usage: %s --fd <socket> <plugin.ofx>\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  int socket = atoi(argv[2]);
+  const char *ofx_filepath = argv[3];
+
+  // A host that went away is detected by failed sends
+  signal(SIGPIPE, SIG_IGN);
+
+  int exit_code;
+  {
+    RemoteServer server;
+    // Failure is reported to the host when it lists plugins
+    exit_code = server.load(ofx_filepath) ? EXIT_SUCCESS : EXIT_FAILURE;
+    server.run(socket);
+  }
+
+  close(socket);
+  return exit_code;
+}
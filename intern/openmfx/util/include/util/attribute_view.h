@@ -0,0 +1,570 @@
+/*
+ * Copyright 2019 - 2021 Elie Michel
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/** \file
+ * \ingroup openmesheffect
+ *
+ * Attribute Views - header-only C++ companion of plugin_support.h
+ *
+ * Typed views on the strided buffers described by Attribute, and copy, cast
+ * and transform kernels that dispatch on attribute types once per buffer
+ * rather than once per element. Contiguous buffers take a memcpy or plain
+ * loop fast path that compilers vectorize.
+ *
+ * Kernels split their work with parallel_for(), which runs in the threads of
+ * the host's multithread suite when the host provides one, and serially
+ * otherwise. for_each_block() streams through out of core meshes.
+ */
+
+#ifndef __MFX_ATTRIBUTE_VIEW_H__
+#define __MFX_ATTRIBUTE_VIEW_H__
+
+#include "plugin_support.h"
+
+#include "ofxMultiThread.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#include <type_traits>
+
+namespace mfx {
+
+// ----------------------------------------------------------------------------
+// Types
+
+/**
+ * Storage of kOfxMeshAttribTypeHalf components, converted to float on access
+ */
+struct Half {
+  unsigned short bits;
+};
+
+/**
+ * Attribute type enum matching a C++ component type
+ */
+template <typename T> struct AttributeTypeOf;
+template <> struct AttributeTypeOf<unsigned char> {
+  static constexpr AttributeType value = MFX_UBYTE_ATTR;
+};
+template <> struct AttributeTypeOf<int> {
+  static constexpr AttributeType value = MFX_INT_ATTR;
+};
+template <> struct AttributeTypeOf<float> {
+  static constexpr AttributeType value = MFX_FLOAT_ATTR;
+};
+template <> struct AttributeTypeOf<Half> {
+  static constexpr AttributeType value = MFX_HALF_ATTR;
+};
+template <> struct AttributeTypeOf<short> {
+  static constexpr AttributeType value = MFX_SHORT_ATTR;
+};
+template <> struct AttributeTypeOf<unsigned short> {
+  static constexpr AttributeType value = MFX_USHORT_ATTR;
+};
+template <> struct AttributeTypeOf<double> {
+  static constexpr AttributeType value = MFX_DOUBLE_ATTR;
+};
+
+namespace detail {
+
+template <typename T> inline double load(T value)
+{
+  return (double)value;
+}
+template <> inline double load<Half>(Half value)
+{
+  return (double)halfToFloat(value.bits);
+}
+
+/**
+ * Clamp before casting to an integer type, NaN becoming 0
+ */
+inline double clamp(double value, double min, double max)
+{
+  if (value != value) {
+    return 0.0;
+  }
+  return value < min ? min : (value > max ? max : value);
+}
+
+template <typename T> inline T store(double value)
+{
+  return (T)value;
+}
+template <> inline unsigned char store<unsigned char>(double value)
+{
+  return (unsigned char)clamp(value, 0, 255);
+}
+template <> inline int store<int>(double value)
+{
+  return (int)clamp(value, INT_MIN, INT_MAX);
+}
+template <> inline short store<short>(double value)
+{
+  return (short)clamp(value, -32768, 32767);
+}
+template <> inline unsigned short store<unsigned short>(double value)
+{
+  return (unsigned short)clamp(value, 0, 65535);
+}
+template <> inline Half store<Half>(double value)
+{
+  return Half{floatToHalf((float)value)};
+}
+
+template <typename Dst, typename Src> struct CastScale {
+  static constexpr double value = 1.0;
+};
+template <> struct CastScale<float, unsigned char> {
+  static constexpr double value = 1.0 / 255.0;
+};
+
+}  // namespace detail
+
+/**
+ * Component conversion, with the same rules as copyAttribute(): values are
+ * clamped to the range of integer types and bytes are normalized when cast
+ * to floats (colors).
+ */
+template <typename Dst, typename Src> inline Dst component_cast(Src value)
+{
+  return detail::store<Dst>(detail::load(value) * detail::CastScale<Dst, Src>::value);
+}
+
+/**
+ * Same types are copied as is, which also keeps ints exact
+ */
+template <> inline float component_cast<float, float>(float value)
+{
+  return value;
+}
+template <> inline int component_cast<int, int>(int value)
+{
+  return value;
+}
+
+// ----------------------------------------------------------------------------
+// Parallel loops
+
+namespace detail {
+
+template <typename Fn> struct ParallelTask {
+  const Fn *fn;
+  int size;
+};
+
+template <typename Fn>
+void parallel_task(unsigned int threadIndex, unsigned int threadMax, void *customArg)
+{
+  const ParallelTask<Fn> *task = (const ParallelTask<Fn> *)customArg;
+  int begin = (int)((long long)task->size * threadIndex / threadMax);
+  int end = (int)((long long)task->size * (threadIndex + 1) / threadMax);
+  if (begin < end) {
+    (*task->fn)(begin, end);
+  }
+}
+
+}  // namespace detail
+
+/**
+ * Call fn(begin, end) on consecutive ranges covering [0, size), in the
+ * threads of the host's multithread suite when it is available and there are
+ * at least two ranges of grain_size elements. Ranges are run serially when
+ * called from a thread that the suite already spawned, since it cannot be
+ * called recursively.
+ */
+template <typename Fn>
+void parallel_for(int size, int grain_size, const Fn &fn, const PluginRuntime *runtime = &gRuntime)
+{
+  if (size <= 0) {
+    return;
+  }
+
+  const OfxMultiThreadSuiteV1 *multiThreadSuite = NULL;
+  if (NULL != runtime && NULL != runtime->host && size >= 2 * grain_size) {
+    multiThreadSuite = (const OfxMultiThreadSuiteV1 *)runtime->host->fetchSuite(
+        runtime->host->host, kOfxMultiThreadSuite, 1);
+  }
+
+  unsigned int cpu_count = 1;
+  if (NULL != multiThreadSuite && 0 == multiThreadSuite->multiThreadIsSpawnedThread()) {
+    multiThreadSuite->multiThreadNumCPUs(&cpu_count);
+  }
+  int range_count = std::min((int)cpu_count, size / std::max(grain_size, 1));
+
+  if (range_count > 1) {
+    detail::ParallelTask<Fn> task = {&fn, size};
+    if (kOfxStatOK == multiThreadSuite->multiThread(
+                          detail::parallel_task<Fn>, (unsigned int)range_count, &task)) {
+      return;
+    }
+  }
+  fn(0, size);
+}
+
+/**
+ * Default number of elements below which kernels do not split their work
+ */
+constexpr int kDefaultGrainSize = 4096;
+
+// ----------------------------------------------------------------------------
+// Blocks
+
+/**
+ * Default number of elements processed at once by for_each_block()
+ */
+constexpr int kDefaultBlockSize = 1 << 20;
+
+/**
+ * Call fn(begin, end) on consecutive blocks of at most block_size elements
+ * covering [0, size), in order, and release each block of the given attachment
+ * in the meshes once fn returned. Out of core meshes (see
+ * kOfxMeshPropOutOfCore) then only keep in memory the blocks being processed.
+ * Blocks are not released if the host does not provide the out of core suite.
+ * fn may itself split its block with parallel_for().
+ */
+template <typename Fn>
+OfxStatus for_each_block(int size,
+                         int block_size,
+                         const char *attachment,
+                         std::initializer_list<OfxMeshHandle> meshes,
+                         const Fn &fn,
+                         const PluginRuntime *runtime = &gRuntime)
+{
+  const OfxMeshOutOfCoreSuiteV1 *outOfCoreSuite = NULL;
+  if (NULL != runtime && NULL != runtime->host) {
+    outOfCoreSuite = (const OfxMeshOutOfCoreSuiteV1 *)runtime->host->fetchSuite(
+        runtime->host->host, kOfxMeshOutOfCoreSuite, 1);
+  }
+
+  block_size = std::max(block_size, 1);
+  for (int begin = 0; begin < size; begin += block_size) {
+    int end = begin + std::min(block_size, size - begin);
+    fn(begin, end);
+    if (NULL == outOfCoreSuite) {
+      continue;
+    }
+    for (OfxMeshHandle mesh : meshes) {
+      OfxStatus status = outOfCoreSuite->meshReleaseRange(
+          mesh, attachment, begin, end - begin);
+      if (kOfxStatOK != status) {
+        return status;
+      }
+    }
+  }
+  return kOfxStatOK;
+}
+
+// ----------------------------------------------------------------------------
+// Views
+
+/**
+ * View on the elements of an attribute buffer, each made of N components of
+ * type T. Elements are stride bytes apart and components component_stride
+ * bytes apart, which covers both interleaved and planar layouts (see
+ * kOfxMeshPropAttributeLayout).
+ */
+template <typename T, int N = 1> class AttributeView {
+ public:
+  AttributeView() = default;
+
+  AttributeView(char *data, int size, int stride, int component_stride)
+      : m_data(data), m_size(size), m_stride(stride), m_component_stride(component_stride)
+  {
+  }
+
+  /**
+   * View on the size first elements of an attribute. The view is invalid if
+   * the attribute is not of type T or has less than N components.
+   */
+  static AttributeView from(const Attribute &attribute, int size)
+  {
+    if (attribute.type != AttributeTypeOf<T>::value || attribute.componentCount < N ||
+        (NULL == attribute.data && size > 0)) {
+      return AttributeView();
+    }
+    int component_stride = 0 != attribute.componentStride ? attribute.componentStride :
+                                                            (int)sizeof(T);
+    AttributeView view(attribute.data, size, attribute.stride, component_stride);
+    view.m_is_valid = true;
+    return view;
+  }
+
+  bool is_valid() const
+  {
+    return m_is_valid;
+  }
+
+  int size() const
+  {
+    return m_size;
+  }
+
+  /**
+   * Elements are tightly packed and interleaved, so that the view can be
+   * used as a plain array of size() * N values.
+   */
+  bool is_contiguous() const
+  {
+    return m_stride == (int)(N * sizeof(T)) && (1 == N || m_component_stride == (int)sizeof(T));
+  }
+
+  /**
+   * Plain array of values, only meaningful when is_contiguous()
+   */
+  T *data() const
+  {
+    return (T *)m_data;
+  }
+
+  T &operator()(int index, int component = 0) const
+  {
+    return *(T *)(m_data + (ptrdiff_t)index * m_stride + (ptrdiff_t)component * m_component_stride);
+  }
+
+  AttributeView slice(int start, int count) const
+  {
+    AttributeView view(m_data + (ptrdiff_t)start * m_stride, count, m_stride, m_component_stride);
+    view.m_is_valid = m_is_valid;
+    return view;
+  }
+
+ private:
+  char *m_data = NULL;
+  int m_size = 0;
+  int m_stride = 0;
+  int m_component_stride = 0;
+  bool m_is_valid = false;
+};
+
+// ----------------------------------------------------------------------------
+// Kernels
+
+/**
+ * Copy min(dst.size(), src.size()) elements
+ */
+template <typename T, int N>
+void copy(const AttributeView<T, N> &dst,
+          const AttributeView<T, N> &src,
+          const PluginRuntime *runtime = &gRuntime)
+{
+  int size = std::min(dst.size(), src.size());
+  if (dst.is_contiguous() && src.is_contiguous()) {
+    parallel_for(
+        size,
+        kDefaultGrainSize,
+        [&](int begin, int end) {
+          memcpy(dst.data() + (ptrdiff_t)begin * N,
+                 src.data() + (ptrdiff_t)begin * N,
+                 (size_t)(end - begin) * N * sizeof(T));
+        },
+        runtime);
+    return;
+  }
+  parallel_for(
+      size,
+      kDefaultGrainSize,
+      [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+          for (int k = 0; k < N; ++k) {
+            dst(i, k) = src(i, k);
+          }
+        }
+      },
+      runtime);
+}
+
+/**
+ * Copy min(dst.size(), src.size()) elements, converting each component with
+ * component_cast()
+ */
+template <typename Dst, typename Src, int N>
+void cast(const AttributeView<Dst, N> &dst,
+          const AttributeView<Src, N> &src,
+          const PluginRuntime *runtime = &gRuntime)
+{
+  int size = std::min(dst.size(), src.size());
+  if (dst.is_contiguous() && src.is_contiguous()) {
+    parallel_for(
+        size * N,
+        kDefaultGrainSize,
+        [&](int begin, int end) {
+          Dst *d = dst.data();
+          const Src *s = src.data();
+          for (int i = begin; i < end; ++i) {
+            d[i] = component_cast<Dst>(s[i]);
+          }
+        },
+        runtime);
+    return;
+  }
+  parallel_for(
+      size,
+      kDefaultGrainSize,
+      [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+          for (int k = 0; k < N; ++k) {
+            dst(i, k) = component_cast<Dst>(src(i, k));
+          }
+        }
+      },
+      runtime);
+}
+
+/**
+ * Call fn(in, out) for min(dst.size(), src.size()) elements, where in points
+ * to the M components of a source element and out to the N components of the
+ * destination element. Strided or planar elements are gathered into and
+ * scattered from local arrays, contiguous ones are accessed in place.
+ * Elements are independent, so fn is called from several threads.
+ */
+template <typename Dst, int N, typename Src, int M, typename Fn>
+void transform(const AttributeView<Dst, N> &dst,
+               const AttributeView<Src, M> &src,
+               const Fn &fn,
+               const PluginRuntime *runtime = &gRuntime)
+{
+  int size = std::min(dst.size(), src.size());
+  if (dst.is_contiguous() && src.is_contiguous()) {
+    parallel_for(
+        size,
+        kDefaultGrainSize,
+        [&](int begin, int end) {
+          Dst *d = dst.data();
+          const Src *s = src.data();
+          for (int i = begin; i < end; ++i) {
+            fn(s + (ptrdiff_t)i * M, d + (ptrdiff_t)i * N);
+          }
+        },
+        runtime);
+    return;
+  }
+  parallel_for(
+      size,
+      kDefaultGrainSize,
+      [&](int begin, int end) {
+        Src in[M];
+        Dst out[N];
+        for (int i = begin; i < end; ++i) {
+          for (int k = 0; k < M; ++k) {
+            in[k] = src(i, k);
+          }
+          fn((const Src *)in, out);
+          for (int k = 0; k < N; ++k) {
+            dst(i, k) = out[k];
+          }
+        }
+      },
+      runtime);
+}
+
+// ----------------------------------------------------------------------------
+// Untyped attributes
+
+namespace detail {
+
+template <typename Dst, typename Src>
+void cast_components(
+    const Attribute &dst, const Attribute &src, int start, int count, int component_count,
+    const PluginRuntime *runtime)
+{
+  const int dst_component_stride = 0 != dst.componentStride ? dst.componentStride :
+                                                              (int)sizeof(Dst);
+  const int src_component_stride = 0 != src.componentStride ? src.componentStride :
+                                                              (int)sizeof(Src);
+  parallel_for(
+      count,
+      kDefaultGrainSize,
+      [&](int begin, int end) {
+        for (int i = start + begin; i < start + end; ++i) {
+          char *d = dst.data + (ptrdiff_t)i * dst.stride;
+          const char *s = src.data + (ptrdiff_t)i * src.stride;
+          for (int k = 0; k < component_count; ++k) {
+            *(Dst *)(d + k * dst_component_stride) = component_cast<Dst>(
+                *(const Src *)(s + k * src_component_stride));
+          }
+        }
+      },
+      runtime);
+}
+
+template <typename Fn> bool dispatch_type(AttributeType type, const Fn &fn)
+{
+  switch (type) {
+    case MFX_UBYTE_ATTR:
+      fn((unsigned char *)NULL);
+      return true;
+    case MFX_INT_ATTR:
+      fn((int *)NULL);
+      return true;
+    case MFX_FLOAT_ATTR:
+      fn((float *)NULL);
+      return true;
+    case MFX_HALF_ATTR:
+      fn((Half *)NULL);
+      return true;
+    case MFX_SHORT_ATTR:
+      fn((short *)NULL);
+      return true;
+    case MFX_USHORT_ATTR:
+      fn((unsigned short *)NULL);
+      return true;
+    case MFX_DOUBLE_ATTR:
+      fn((double *)NULL);
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace detail
+
+/**
+ * Parallel equivalent of copyAttribute(), where the conversion between types
+ * is chosen once for the whole range rather than for each component.
+ */
+inline OfxStatus copy_attribute(Attribute &destination,
+                                const Attribute &source,
+                                int start,
+                                int count,
+                                const PluginRuntime *runtime = &gRuntime)
+{
+  int component_count = std::min(source.componentCount, destination.componentCount);
+  bool is_supported = false;
+  detail::dispatch_type(destination.type, [&](auto *dst_tag) {
+    using Dst = typename std::remove_pointer<decltype(dst_tag)>::type;
+    is_supported = detail::dispatch_type(source.type, [&](auto *src_tag) {
+      using Src = typename std::remove_pointer<decltype(src_tag)>::type;
+      detail::cast_components<Dst, Src>(
+          destination, source, start, count, component_count, runtime);
+    });
+  });
+  if (!is_supported) {
+    printf("Warning: unsupported input/output type combinason in copy_attribute: %d -> %d\n",
+           source.type,
+           destination.type);
+    return kOfxStatErrUnsupported;
+  }
+  return kOfxStatOK;
+}
+
+}  // namespace mfx
+
+#endif // __MFX_ATTRIBUTE_VIEW_H__
@@ -23,8 +23,10 @@
 
 #ifdef _WIN32
 #  define PATH_DIR_SEP '\\'
+#  define PATH_LIST_SEP ';'
 #else // _WIN32
 #  define PATH_DIR_SEP '/'
+#  define PATH_LIST_SEP ':'
 #endif // _WIN32
 
 #endif // __MFX_PATH_UTIL_H__
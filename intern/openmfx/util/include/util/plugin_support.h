@@ -27,6 +27,12 @@
 #include "ofxCore.h"
 #include "ofxMeshEffect.h"
 
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 typedef struct PluginRuntime {
   OfxHost *host;
   const OfxPropertySuiteV1 *propertySuite;
@@ -39,11 +45,16 @@ enum AttributeType {
   MFX_UBYTE_ATTR,
   MFX_INT_ATTR,
   MFX_FLOAT_ATTR,
+  MFX_HALF_ATTR,
+  MFX_SHORT_ATTR,
+  MFX_USHORT_ATTR,
+  MFX_DOUBLE_ATTR,
 };
 
 typedef struct Attribute {
   enum AttributeType type;
   int stride;
+  int componentStride; // offset between components of an element, see kOfxMeshPropAttributeLayout
   int componentCount;
   char *data;
 } Attribute;
@@ -53,6 +64,18 @@ typedef struct Attribute {
  */
 enum AttributeType mfxAttrAsEnum(const char *attr_type);
 
+/**
+ * Size in bytes of a single component of the given type, or 0 if unknown
+ */
+size_t attributeComponentByteSize(enum AttributeType type);
+
+/**
+ * Conversions between 32 bit floats and the 16 bit half floats used by
+ * kOfxMeshAttribTypeHalf attributes
+ */
+float halfToFloat(unsigned short h);
+unsigned short floatToHalf(float f);
+
 /**
  * Get attribute info from low level open mesh effect API and store it in a struct Attribute
  */
@@ -62,14 +85,19 @@ OfxStatus getAttribute(OfxMeshHandle mesh, const char *attachment, const char *n
 OfxStatus getPointAttribute(OfxMeshHandle mesh, const char *name, Attribute *attr);
 OfxStatus getCornerAttribute(OfxMeshHandle mesh, const char *name, Attribute *attr);
 OfxStatus getFaceAttribute(OfxMeshHandle mesh, const char *name, Attribute *attr);
+OfxStatus getEdgeAttribute(OfxMeshHandle mesh, const char *name, Attribute *attr);
 
 /**
  * Copy attribute and try to cast. If number of component is different, copy the common components
- * only.
+ * only. UByte values are normalized to the (0,1) range when cast to Float.
  */
 OfxStatus copyAttribute(Attribute *destination, const Attribute *source, int start, int count);
 
 // !global!
 extern PluginRuntime gRuntime;
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif // __MFX_PLUGIN_SUPPORT_H__
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <limits.h>
 #include <string.h>
 #include <stdio.h>
 #include "plugin_support.h"
@@ -33,10 +34,165 @@ enum AttributeType mfxAttrAsEnum(const char *attr_type)
   if (0 == strcmp(attr_type, kOfxMeshAttribTypeFloat)) {
     return MFX_FLOAT_ATTR;
   }
+  if (0 == strcmp(attr_type, kOfxMeshAttribTypeHalf)) {
+    return MFX_HALF_ATTR;
+  }
+  if (0 == strcmp(attr_type, kOfxMeshAttribTypeShort)) {
+    return MFX_SHORT_ATTR;
+  }
+  if (0 == strcmp(attr_type, kOfxMeshAttribTypeUShort)) {
+    return MFX_USHORT_ATTR;
+  }
+  if (0 == strcmp(attr_type, kOfxMeshAttribTypeDouble)) {
+    return MFX_DOUBLE_ATTR;
+  }
   printf("Warning: inknown attribute type: %s\n", attr_type);
   return MFX_UNKNOWN_ATTR;
 }
 
+size_t attributeComponentByteSize(enum AttributeType type)
+{
+  switch (type) {
+  case MFX_UBYTE_ATTR:
+    return sizeof(unsigned char);
+  case MFX_INT_ATTR:
+    return sizeof(int);
+  case MFX_FLOAT_ATTR:
+    return sizeof(float);
+  case MFX_HALF_ATTR:
+    return sizeof(unsigned short);
+  case MFX_SHORT_ATTR:
+    return sizeof(short);
+  case MFX_USHORT_ATTR:
+    return sizeof(unsigned short);
+  case MFX_DOUBLE_ATTR:
+    return sizeof(double);
+  default:
+    return 0;
+  }
+}
+
+float halfToFloat(unsigned short h)
+{
+  unsigned int sign = (unsigned int)(h & 0x8000) << 16;
+  unsigned int exponent = (h >> 10) & 0x1f;
+  unsigned int mantissa = h & 0x3ff;
+  unsigned int bits;
+  float f;
+
+  if (0 == exponent) {
+    // zero or subnormal, which are normal floats
+    f = (float)mantissa / 16777216.0f; // 2^-24
+    return sign ? -f : f;
+  }
+  else if (31 == exponent) {
+    // inf or nan
+    bits = sign | 0x7f800000 | (mantissa << 13);
+  }
+  else {
+    bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+  }
+  memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+unsigned short floatToHalf(float f)
+{
+  unsigned int bits;
+  memcpy(&bits, &f, sizeof(bits));
+  unsigned short sign = (unsigned short)((bits >> 16) & 0x8000);
+  int exponent = (int)((bits >> 23) & 0xff) - 127 + 15;
+  unsigned int mantissa = bits & 0x7fffff;
+
+  if ((bits & 0x7fffffff) > 0x7f800000) {
+    return sign | 0x7e00; // nan
+  }
+  if (exponent >= 31) {
+    return sign | 0x7c00; // overflow to inf
+  }
+  if (exponent <= 0) {
+    // subnormal half, or underflow to zero
+    if (exponent < -10) {
+      return sign;
+    }
+    mantissa |= 0x800000;
+    int shift = 14 - exponent;
+    unsigned short h = (unsigned short)(mantissa >> shift);
+    unsigned int remainder = mantissa & ((1u << shift) - 1);
+    unsigned int half = 1u << (shift - 1);
+    if (remainder > half || (remainder == half && (h & 1))) {
+      ++h; // round to nearest even
+    }
+    return sign | h;
+  }
+  unsigned short h = sign | (unsigned short)(exponent << 10) | (unsigned short)(mantissa >> 13);
+  unsigned int remainder = mantissa & 0x1fff;
+  if (remainder > 0x1000 || (remainder == 0x1000 && (h & 1))) {
+    ++h; // round to nearest even, carrying into exponent if needed
+  }
+  return h;
+}
+
+static double loadComponent(enum AttributeType type, const char *data, int k)
+{
+  switch (type) {
+  case MFX_UBYTE_ATTR:
+    return (double)((const unsigned char*)data)[k];
+  case MFX_INT_ATTR:
+    return (double)((const int*)data)[k];
+  case MFX_FLOAT_ATTR:
+    return (double)((const float*)data)[k];
+  case MFX_HALF_ATTR:
+    return (double)halfToFloat(((const unsigned short*)data)[k]);
+  case MFX_SHORT_ATTR:
+    return (double)((const short*)data)[k];
+  case MFX_USHORT_ATTR:
+    return (double)((const unsigned short*)data)[k];
+  case MFX_DOUBLE_ATTR:
+    return ((const double*)data)[k];
+  default:
+    return 0.0;
+  }
+}
+
+// Clamp before casting to an integer type, NaN becoming 0
+static double clampComponent(double value, double min, double max)
+{
+  if (value != value) {
+    return 0.0;
+  }
+  return value < min ? min : (value > max ? max : value);
+}
+
+static void storeComponent(enum AttributeType type, char *data, int k, double value)
+{
+  switch (type) {
+  case MFX_UBYTE_ATTR:
+    ((unsigned char*)data)[k] = (unsigned char)clampComponent(value, 0, 255);
+    break;
+  case MFX_INT_ATTR:
+    ((int*)data)[k] = (int)clampComponent(value, INT_MIN, INT_MAX);
+    break;
+  case MFX_FLOAT_ATTR:
+    ((float*)data)[k] = (float)value;
+    break;
+  case MFX_HALF_ATTR:
+    ((unsigned short*)data)[k] = floatToHalf((float)value);
+    break;
+  case MFX_SHORT_ATTR:
+    ((short*)data)[k] = (short)clampComponent(value, -32768, 32767);
+    break;
+  case MFX_USHORT_ATTR:
+    ((unsigned short*)data)[k] = (unsigned short)clampComponent(value, 0, 65535);
+    break;
+  case MFX_DOUBLE_ATTR:
+    ((double*)data)[k] = value;
+    break;
+  default:
+    break;
+  }
+}
+
 OfxStatus getAttribute(OfxMeshHandle mesh, const char *attachment, const char *name, Attribute *attr)
 {
   const OfxMeshEffectSuiteV1 *meshEffectSuite = gRuntime.meshEffectSuite;
@@ -48,9 +204,13 @@ OfxStatus getAttribute(OfxMeshHandle mesh, const char *attachment, const char *n
   MFX_ENSURE(meshEffectSuite->meshGetAttribute(mesh, attachment, name, &attr_props));
   MFX_ENSURE(propertySuite->propGetString(attr_props, kOfxMeshAttribPropType, 0, &type));
   MFX_ENSURE(propertySuite->propGetInt(attr_props, kOfxMeshAttribPropStride, 0, &attr->stride));
+  MFX_ENSURE(propertySuite->propGetInt(attr_props, kOfxMeshAttribPropComponentStride, 0, &attr->componentStride));
   MFX_ENSURE(propertySuite->propGetInt(attr_props, kOfxMeshAttribPropComponentCount, 0, &attr->componentCount));
   MFX_ENSURE(propertySuite->propGetPointer(attr_props, kOfxMeshAttribPropData, 0, (void**)&attr->data));
   attr->type = mfxAttrAsEnum(type);
+  if (0 == attr->componentStride) {
+    attr->componentStride = (int)attributeComponentByteSize(attr->type);
+  }
 
   return kOfxStatOK;
 }
@@ -70,25 +230,21 @@ OfxStatus getFaceAttribute(OfxMeshHandle mesh, const char *name, Attribute *attr
   return getAttribute(mesh, kOfxMeshAttribFace, name, attr);
 }
 
+OfxStatus getEdgeAttribute(OfxMeshHandle mesh, const char *name, Attribute *attr)
+{
+  return getAttribute(mesh, kOfxMeshAttribEdge, name, attr);
+}
+
 OfxStatus copyAttribute(Attribute *destination, const Attribute *source, int start, int count)
 {
   int componentCount = source->componentCount < destination->componentCount ? source->componentCount : destination->componentCount;
 
-  if (source->type == destination->type)
+  if (source->type == destination->type &&
+      source->componentStride == destination->componentStride &&
+      source->componentStride == (int)attributeComponentByteSize(source->type))
   {
-    size_t componentByteSize = 0;
-    switch (source->type)
-    {
-    case MFX_UBYTE_ATTR:
-      componentByteSize = sizeof(unsigned char);
-      break;
-    case MFX_INT_ATTR:
-      componentByteSize = sizeof(int);
-      break;
-    case MFX_FLOAT_ATTR:
-      componentByteSize = sizeof(float);
-      break;
-    default:
+    size_t componentByteSize = attributeComponentByteSize(source->type);
+    if (0 == componentByteSize) {
       printf("Error: unsupported attribute type: %d\n", source->type);
       return kOfxStatErrFatal;
     }
@@ -101,23 +257,23 @@ OfxStatus copyAttribute(Attribute *destination, const Attribute *source, int sta
     return kOfxStatOK;
   }
 
-  switch (destination->type) {
-  case MFX_FLOAT_ATTR:
-    switch (source->type) {
-    case MFX_UBYTE_ATTR:
-      for (int i = 0; i < count; ++i) {
-        const unsigned char *src = (unsigned char *)&source->data[(start + i) * source->stride];
-        float *dst = (float*)&destination->data[(start + i) * destination->stride];
-        for (int k = 0; k < componentCount; ++k)
-        {
-          dst[k] = (float)src[k] / 255.0f;
-        }
+  if (MFX_UNKNOWN_ATTR != source->type && MFX_UNKNOWN_ATTR != destination->type) {
+    // Colors stored as bytes are normalized when cast to floats
+    double scale = MFX_UBYTE_ATTR == source->type && MFX_FLOAT_ATTR == destination->type
+      ? 1.0 / 255.0
+      : 1.0;
+    for (int i = 0; i < count; ++i) {
+      const char *src = &source->data[(start + i) * source->stride];
+      char *dst = &destination->data[(start + i) * destination->stride];
+      for (int k = 0; k < componentCount; ++k)
+      {
+        storeComponent(destination->type, dst + k * destination->componentStride, 0,
+                       loadComponent(source->type, src + k * source->componentStride, 0) * scale);
       }
-      return kOfxStatOK;
-      break;
     }
-    break;
+    return kOfxStatOK;
   }
+
   printf("Warning: unsupported input/output type combinason in copyAttribute: %d -> %d\n", source->type, destination->type);
   return kOfxStatErrUnsupported;
 }
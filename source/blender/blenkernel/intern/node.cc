@@ -4973,6 +4973,7 @@ static void registerGeometryNodes()
   register_node_type_geo_mesh_primitive_line();
   register_node_type_geo_mesh_primitive_uv_sphere();
   register_node_type_geo_object_info();
+  register_node_type_geo_openmfx();
   register_node_type_geo_point_distribute();
   register_node_type_geo_point_instance();
   register_node_type_geo_point_rotate();
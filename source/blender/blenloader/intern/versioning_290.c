@@ -2098,5 +2098,18 @@ void blo_do_versions_290(FileData *fd, Library *UNUSED(lib), Main *bmain)
    */
   {
     /* Keep this block, even when empty. */
+
+    /* OpenMfx viewport proxies used to be set up in initData only. */
+    if (!DNA_struct_elem_find(
+            fd->filesdna, "OpenMfxModifierData", "float", "viewport_proxy_ratio")) {
+      LISTBASE_FOREACH (Object *, ob, &bmain->objects) {
+        LISTBASE_FOREACH (ModifierData *, md, &ob->modifiers) {
+          if (md->type == eModifierType_OpenMfx) {
+            OpenMfxModifierData *fxmd = (OpenMfxModifierData *)md;
+            fxmd->viewport_proxy_ratio = 0.25f;
+          }
+        }
+      }
+    }
   }
 }
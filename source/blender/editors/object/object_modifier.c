@@ -48,6 +48,8 @@
 #include "BLI_string_utf8.h"
 #include "BLI_utildefines.h"
 
+#include "PIL_time.h"
+
 #include "BKE_DerivedMesh.h"
 #include "BKE_animsys.h"
 #include "BKE_armature.h"
@@ -95,6 +97,8 @@
 
 #include "MOD_nodes.h"
 
+#include "mfxModifier.h"
+
 #include "UI_interface.h"
 
 #include "WM_api.h"
@@ -3096,6 +3100,289 @@ void OBJECT_OT_ocean_bake(wmOperatorType *ot)
 
 /** \} */
 
+/* ------------------------------------------------------------------- */
+/** \name OpenMfx Bake Operator
+ * \{ */
+
+static bool openmfx_bake_poll(bContext *C)
+{
+  return edit_modifier_poll_generic(C, &RNA_OpenMfxModifier, 0, true, false);
+}
+
+typedef struct OpenMfxBakeJob {
+  /* from wmJob */
+  wmWindowManager *wm;
+  short *stop, *do_update;
+  float *progress;
+
+  Scene *scene;
+  Depsgraph *depsgraph;
+  Object *ob;
+  OpenMfxModifierData *fxmd;
+
+  bool success;
+  double start;
+} OpenMfxBakeJob;
+
+static void openmfx_bake_free(void *customdata)
+{
+  OpenMfxBakeJob *job = customdata;
+  MEM_freeN(job);
+}
+
+static void openmfx_bake_startjob(void *customdata, short *stop, short *do_update, float *progress)
+{
+  OpenMfxBakeJob *job = customdata;
+  OpenMfxModifierData *fxmd = job->fxmd;
+  Scene *scene = job->scene;
+  const int orig_frame = scene->r.cfra;
+  const int frames = fxmd->bake_frame_end - fxmd->bake_frame_start + 1;
+
+  job->stop = stop;
+  job->do_update = do_update;
+  job->progress = progress;
+  job->start = PIL_check_seconds_timer();
+  job->success = true;
+
+  G.is_break = false; /* reset BKE_blender_test_break*/
+
+  /* XXX annoying hack: needed to prevent data corruption when changing
+   * scene frame in separate threads
+   */
+  WM_set_locked_interface(job->wm, true);
+
+  /* The evaluated modifier writes each frame it cooks to the cache while the baking flag is
+   * set, so baking only consists in stepping the job's depsgraph through frames, as the point
+   * cache bake does. */
+  for (int frame = fxmd->bake_frame_start; frame <= fxmd->bake_frame_end; frame++) {
+    if (G.is_break || *stop) {
+      job->success = false;
+      break;
+    }
+
+    *do_update = true;
+    *progress = (frame - fxmd->bake_frame_start) / (float)frames;
+
+    scene->r.cfra = frame;
+    BKE_scene_graph_update_for_newframe(job->depsgraph);
+  }
+
+  scene->r.cfra = orig_frame;
+  BKE_scene_graph_update_for_newframe(job->depsgraph);
+
+  *do_update = true;
+  *stop = 0;
+}
+
+static void openmfx_bake_endjob(void *customdata)
+{
+  OpenMfxBakeJob *job = customdata;
+  OpenMfxModifierData *fxmd = job->fxmd;
+
+  fxmd->flag &= ~MOD_OPENMFX_FLAG_BAKING;
+  if (job->success) {
+    fxmd->flag |= MOD_OPENMFX_FLAG_BAKED;
+  }
+  else {
+    mfx_Modifier_free_bake(fxmd, job->ob);
+  }
+
+  WM_set_locked_interface(job->wm, false);
+
+  DEG_id_tag_update(&job->ob->id, ID_RECALC_GEOMETRY);
+  WM_main_add_notifier(NC_SCENE | ND_FRAME, job->scene);
+
+  if (job->success) {
+    WM_reportf(
+        RPT_INFO, "OpenMfx: Bake complete! (%.2f)", PIL_check_seconds_timer() - job->start);
+  }
+  else {
+    WM_report(RPT_WARNING, "Baking canceled!");
+  }
+}
+
+static int openmfx_bake_exec(bContext *C, wmOperator *op)
+{
+  Object *ob = ED_object_active_context(C);
+  OpenMfxModifierData *fxmd = (OpenMfxModifierData *)edit_modifier_property_get(
+      op, ob, eModifierType_OpenMfx);
+  const bool free = RNA_boolean_get(op->ptr, "free");
+
+  if (!fxmd) {
+    return OPERATOR_CANCELLED;
+  }
+
+  /* Frames of a previous bake would be read rather than cooked again. */
+  mfx_Modifier_free_bake(fxmd, ob);
+
+  if (free) {
+    DEG_id_tag_update(&ob->id, ID_RECALC_GEOMETRY);
+    WM_event_add_notifier(C, NC_OBJECT | ND_MODIFIER, ob);
+    return OPERATOR_FINISHED;
+  }
+
+  if (fxmd->bake_frame_end < fxmd->bake_frame_start) {
+    BKE_report(op->reports, RPT_ERROR, "No frames to bake");
+    return OPERATOR_CANCELLED;
+  }
+
+  fxmd->flag |= MOD_OPENMFX_FLAG_BAKING;
+  DEG_id_tag_update(&ob->id, ID_RECALC_GEOMETRY);
+
+  OpenMfxBakeJob *job = MEM_callocN(sizeof(OpenMfxBakeJob), "OpenMfxBakeJob");
+  job->wm = CTX_wm_manager(C);
+  job->scene = CTX_data_scene(C);
+  /* Depsgraph is used to sweep the frame range and evaluate scene at different times. */
+  job->depsgraph = CTX_data_depsgraph_pointer(C);
+  job->ob = ob;
+  job->fxmd = fxmd;
+
+  wmJob *wm_job = WM_jobs_get(CTX_wm_manager(C),
+                              CTX_wm_window(C),
+                              CTX_data_scene(C),
+                              "OpenMfx Bake",
+                              WM_JOB_PROGRESS,
+                              WM_JOB_TYPE_OPENMFX_BAKE);
+
+  WM_jobs_customdata_set(wm_job, job, openmfx_bake_free);
+  WM_jobs_timer(wm_job, 0.1, NC_OBJECT | ND_MODIFIER, NC_OBJECT | ND_MODIFIER);
+  WM_jobs_callbacks(wm_job, openmfx_bake_startjob, NULL, NULL, openmfx_bake_endjob);
+
+  WM_jobs_start(CTX_wm_manager(C), wm_job);
+
+  return OPERATOR_FINISHED;
+}
+
+static int openmfx_bake_invoke(bContext *C, wmOperator *op, const wmEvent *UNUSED(event))
+{
+  if (edit_modifier_invoke_properties(C, op)) {
+    return openmfx_bake_exec(C, op);
+  }
+  return OPERATOR_CANCELLED;
+}
+
+void OBJECT_OT_openmfx_bake(wmOperatorType *ot)
+{
+  ot->name = "Bake OpenMfx";
+  ot->description = "Cook an OpenMfx effect over a frame range and cache its results on disk";
+  ot->idname = "OBJECT_OT_openmfx_bake";
+
+  ot->poll = openmfx_bake_poll;
+  ot->invoke = openmfx_bake_invoke;
+  ot->exec = openmfx_bake_exec;
+
+  /* flags */
+  ot->flag = OPTYPE_REGISTER | OPTYPE_UNDO | OPTYPE_INTERNAL;
+  edit_modifier_properties(ot);
+
+  RNA_def_boolean(ot->srna, "free", false, "Free", "Free the bake, rather than generating it");
+}
+
+/** \} */
+
+/* ------------------------------------------------------------------- */
+/** \name OpenMfx Batch Cook Operator
+ * \{ */
+
+static bool openmfx_batch_cook_poll(bContext *C)
+{
+  return edit_modifier_poll_generic(C, &RNA_OpenMfxModifier, 0, true, false);
+}
+
+static int openmfx_batch_cook_exec(bContext *C, wmOperator *op)
+{
+  Main *bmain = CTX_data_main(C);
+  Scene *scene = CTX_data_scene(C);
+  Object *ob = ED_object_active_context(C);
+  OpenMfxModifierData *fxmd = (OpenMfxModifierData *)edit_modifier_property_get(
+      op, ob, eModifierType_OpenMfx);
+  const bool use_render_quality = RNA_boolean_get(op->ptr, "use_render_quality");
+
+  if (!fxmd) {
+    return OPERATOR_CANCELLED;
+  }
+
+  /* Meshes shared by several selected objects are only cooked once. */
+  BKE_main_id_tag_listbase(&bmain->meshes, LIB_TAG_DOIT, false);
+
+  Object **targets = MEM_malloc_arrayN(
+      CTX_DATA_COUNT(C, selected_editable_objects), sizeof(Object *), __func__);
+  int target_count = 0;
+  CTX_DATA_BEGIN (C, Object *, selob, selected_editable_objects) {
+    if (selob == ob || selob->type != OB_MESH || BKE_object_is_in_editmode(selob)) {
+      continue;
+    }
+    Mesh *me = selob->data;
+    if (ID_IS_LINKED(me) || (me->id.tag & LIB_TAG_DOIT)) {
+      continue;
+    }
+    me->id.tag |= LIB_TAG_DOIT;
+    targets[target_count++] = selob;
+  }
+  CTX_DATA_END;
+
+  if (target_count == 0) {
+    MEM_freeN(targets);
+    BKE_report(op->reports, RPT_ERROR, "Other selected mesh objects required to cook");
+    return OPERATOR_CANCELLED;
+  }
+
+  const int written_count = mfx_Modifier_cook_batch(
+      fxmd, ob, targets, target_count, use_render_quality, BKE_scene_frame_get(scene));
+
+  for (int i = 0; i < target_count; i++) {
+    DEG_id_tag_update(targets[i]->data, ID_RECALC_GEOMETRY);
+    WM_event_add_notifier(C, NC_GEOM | ND_DATA, targets[i]->data);
+  }
+  MEM_freeN(targets);
+
+  if (written_count < target_count) {
+    BKE_reportf(op->reports,
+                RPT_WARNING,
+                "OpenMfx: %d of %d meshes could not be cooked",
+                target_count - written_count,
+                target_count);
+  }
+  else {
+    BKE_reportf(op->reports, RPT_INFO, "OpenMfx: %d meshes cooked", written_count);
+  }
+
+  return OPERATOR_FINISHED;
+}
+
+static int openmfx_batch_cook_invoke(bContext *C, wmOperator *op, const wmEvent *UNUSED(event))
+{
+  if (edit_modifier_invoke_properties(C, op)) {
+    return openmfx_batch_cook_exec(C, op);
+  }
+  return OPERATOR_CANCELLED;
+}
+
+void OBJECT_OT_openmfx_batch_cook(wmOperatorType *ot)
+{
+  ot->name = "Batch Cook OpenMfx";
+  ot->description =
+      "Apply the effect of an OpenMfx modifier of the active object to the meshes of all other "
+      "selected objects, replacing their geometry";
+  ot->idname = "OBJECT_OT_openmfx_batch_cook";
+
+  ot->poll = openmfx_batch_cook_poll;
+  ot->invoke = openmfx_batch_cook_invoke;
+  ot->exec = openmfx_batch_cook_exec;
+
+  /* flags */
+  ot->flag = OPTYPE_REGISTER | OPTYPE_UNDO;
+  edit_modifier_properties(ot);
+
+  RNA_def_boolean(ot->srna,
+                  "use_render_quality",
+                  true,
+                  "Render Quality",
+                  "Cook at render quality rather than as a viewport draft");
+}
+
+/** \} */
+
 /* ------------------------------------------------------------------- */
 /** \name Laplaciandeform Bind Operator
  * \{ */
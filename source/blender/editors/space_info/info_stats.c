@@ -67,6 +67,8 @@
 
 #include "GPU_capabilities.h"
 
+#include "mfxModifier.h"
+
 #define MAX_INFO_NUM_LEN 16
 
 typedef struct SceneStats {
@@ -618,6 +620,13 @@ static const char *info_statusbar_string(Main *bmain,
     uintptr_t mem_in_use = MEM_get_memory_in_use();
     BLI_str_format_byte_unit(formatted_mem, mem_in_use, false);
     ofs += BLI_snprintf(info + ofs, len, TIP_("Memory: %s"), formatted_mem);
+
+    /* Part of it held by OpenMfx effects. */
+    size_t mfx_mem_in_use = mfx_Modifier_memory_in_use();
+    if (mfx_mem_in_use > 0) {
+      BLI_str_format_byte_unit(formatted_mem, mfx_mem_in_use, false);
+      ofs += BLI_snprintf(info + ofs, len - ofs, TIP_(" (OpenMfx: %s)"), formatted_mem);
+    }
   }
 
   /* GPU VRAM status. */
@@ -2352,26 +2352,55 @@ typedef struct OpenMfxEffect {
 
 #define MOD_OPENMFX_MAX_EFFECT_NAME 256
 
-/** OpenMfxModifierData->parameters */
+/** OpenMfxParameterInfoTable->infos */
+typedef struct OpenMfxParameterInfo {
+  /** System name, used to match parameters across effect reloads */
+  char *name;
+  /** Display label */
+  char *label;
+  /** Used for Double, Double2D, Double3D, RGB, RGBA */
+  float float_min;
+  float float_softmin;
+  float float_max;
+  float float_softmax;
+  /** Used for Integer, Integer2D, Integer3D, Boolean, Choice index */
+  int int_min;
+  int int_softmin;
+  int int_max;
+  int int_softmax;
+} OpenMfxParameterInfo;
+
+/**
+ * OpenMfxModifierData->parameter_info
+ * Description of the parameters of an effect, which does not depend on their values and is
+ * hence shared among the copies of a modifier rather than duplicated with each of them.
+ */
+typedef struct OpenMfxParameterInfoTable {
+  /** Number of modifiers using this table, see mfxParameters.h */
+  int users;
+  int num_parameters;
+  OpenMfxParameterInfo *infos;
+} OpenMfxParameterInfoTable;
+
+/**
+ * OpenMfxModifierData->parameters
+ * Layout of the parameters in files saved before their description moved to
+ * OpenMfxParameterInfo. Only read to convert them, see blendRead() in MOD_openmfx.c.
+ */
 typedef struct OpenMfxParameter {
   /** MOD_OPENMFX_MAX_PARAMETER_NAME */
   char name[256];
   /** MOD_OPENMFX_MAX_PARAMETER_LABEL */
   char label[256];
-  /** OpenMfx parameter type */
   int type, _pad0;
-  /** Used for Double, Double2D, Double3D, RGB, RGBA */
   float float_vec_value[4];
-  /** Used for Integer, Integer2D, Integer3D, Boolean, Choice index */
   int integer_vec_value[4];
   /** MOD_OPENMFX_MAX_STRING_VALUE */
   char string_value[1024];
-  /** Used for Double, Double2D, Double3D, RGB, RGBA */
   float float_min;
   float float_softmin;
   float float_max;
   float float_softmax;
-  /** Used for Integer, Integer2D, Integer3D, Boolean, Choice index */
   int int_min;
   int int_softmin;
   int int_max;
@@ -2382,6 +2411,20 @@ typedef struct OpenMfxParameter {
 #define MOD_OPENMFX_MAX_PARAMETER_LABEL 256
 #define MOD_OPENMFX_MAX_STRING_VALUE 1024
 
+/** OpenMfxModifierData->parameter_values */
+typedef struct OpenMfxParameterValue {
+  /** Entry of OpenMfxModifierData->parameter_info, NULL if unknown */
+  OpenMfxParameterInfo *info;
+  /** Used for String, NULL when empty */
+  char *string_value;
+  /** OpenMfx parameter type */
+  int type, _pad0;
+  /** Used for Double, Double2D, Double3D, RGB, RGBA */
+  float float_vec_value[4];
+  /** Used for Integer, Integer2D, Integer3D, Boolean, Choice index */
+  int integer_vec_value[4];
+} OpenMfxParameterValue;
+
 /** OpenMfxModifierData->extra_inputs */
 typedef struct OpenMfxInput {
   /** MOD_OPENMFX_MAX_INPUT_NAME */
@@ -2405,14 +2448,27 @@ typedef struct OpenMfxModifierData {
 
   /** 1024 = FILE_MAX. */
   char plugin_path[1024];
-  int active_effect_index, _pad0;
+  int active_effect_index;
+  /** MOD_OPENMFX_FLAG_* */
+  short flag;
+  char _pad0[2];
+  /** Ratio of the input faces kept when cooking a viewport proxy */
+  float viewport_proxy_ratio;
+  /** Frame range written by the bake operator */
+  int bake_frame_start, bake_frame_end;
+  char _pad2[4];
+  /** Directory of the bake cache files, 1024 = FILE_MAX. */
+  char bake_directory[1024];
 
   /* Runtime. */
   int num_effects, _pad1;
   int num_parameters, num_extra_inputs;
   OpenMfxEffect *effects;
-  OpenMfxParameter *parameters;
+  /** Legacy parameters, converted to parameter_values at read time */
+  OpenMfxParameter *parameters DNA_DEPRECATED;
+  OpenMfxParameterValue *parameter_values;
   OpenMfxInput *extra_inputs;
+  OpenMfxParameterInfoTable *parameter_info;
 
   /** MOD_OPENMFX_MAX_MESSAGE */
   char message[1024];
@@ -2420,6 +2476,18 @@ typedef struct OpenMfxModifierData {
 
 #define MOD_OPENMFX_MAX_MESSAGE 1024
 
+/** OpenMfxModifierData->flag */
+enum {
+  /** Cook a decimated copy of the input in the viewport */
+  MOD_OPENMFX_FLAG_VIEWPORT_PROXY = (1 << 0),
+  /** Run the plugin in a separate process, so that it cannot crash Blender */
+  MOD_OPENMFX_FLAG_OUT_OF_PROCESS = (1 << 1),
+  /** Frames of the bake range are read from the bake cache instead of being cooked */
+  MOD_OPENMFX_FLAG_BAKED = (1 << 2),
+  /** Set while baking, cooked frames are written to the bake cache */
+  MOD_OPENMFX_FLAG_BAKING = (1 << 3),
+};
+
 #ifdef __cplusplus
 }
 #endif
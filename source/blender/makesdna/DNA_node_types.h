@@ -1308,6 +1308,14 @@ typedef struct NodeGeometryMeshLine {
   uint8_t count_mode;
 } NodeGeometryMeshLine;
 
+typedef struct NodeGeometryOpenMfx {
+  /** 1024 = FILE_MAX. */
+  char plugin_path[1024];
+  /** Index of the effect within the plugin. */
+  int effect_index;
+  char _pad[4];
+} NodeGeometryOpenMfx;
+
 /* script node mode */
 #define NODE_SCRIPT_INTERNAL 0
 #define NODE_SCRIPT_EXTERNAL 1
@@ -628,6 +628,7 @@ const EnumPropertyItem rna_enum_openmfx_effect_items[] = {
 #  endif
 
 #  include "mfxModifier.h"
+#  include "mfxParameters.h"
 
 static void rna_UVProject_projectors_begin(CollectionPropertyIterator *iter, PointerRNA *ptr)
 {
@@ -1626,8 +1627,8 @@ static void rna_OpenMfx_parameters_begin(CollectionPropertyIterator *iter, Point
 {
   OpenMfxModifierData *fxmd = (OpenMfxModifierData *)ptr->data;
   rna_iterator_array_begin(iter,
-                           (void *)fxmd->parameters,
-                           sizeof(OpenMfxParameter),
+                           (void *)fxmd->parameter_values,
+                           sizeof(OpenMfxParameterValue),
                            fxmd->num_parameters,
                            0,
                            NULL);
@@ -1663,6 +1664,13 @@ static void rna_OpenMfxModifier_plugin_path_set(PointerRNA *ptr, const char *val
   mfx_Modifier_on_plugin_changed(fxmd);
 }
 
+static void rna_OpenMfxModifier_use_out_of_process_set(PointerRNA *ptr, bool value)
+{
+  OpenMfxModifierData *fxmd = (OpenMfxModifierData *)ptr->data;
+  SET_FLAG_FROM_TEST(fxmd->flag, value, MOD_OPENMFX_FLAG_OUT_OF_PROCESS);
+  mfx_Modifier_on_plugin_changed(fxmd);
+}
+
 static void rna_OpenMfxModifier_active_effect_index_set(PointerRNA *ptr, int value)
 {
   OpenMfxModifierData *fxmd = (OpenMfxModifierData *)ptr->data;
@@ -1703,7 +1711,7 @@ static const EnumPropertyItem *rna_OpenMfxModifier_effect_enum_item(struct bCont
 
 static char *rna_OpenMfxParameter_path(PointerRNA *ptr)
 {
-  OpenMfxParameter *parm = (OpenMfxParameter *)ptr->data;
+  OpenMfxParameterValue *parm = (OpenMfxParameterValue *)ptr->data;
   Object *ob = (Object *)ptr->owner_id;
 
   // Locate the OpenMfx modifier that owns this parameter
@@ -1716,7 +1724,7 @@ static char *rna_OpenMfxParameter_path(PointerRNA *ptr)
     if (eModifierType_OpenMfx == md->type) {
       OpenMfxModifierData *fxmd = (OpenMfxModifierData *)md;
       for (int i = 0; i < fxmd->num_parameters; ++i) {
-        if ((fxmd->parameters + i) == parm) {
+        if ((fxmd->parameter_values + i) == parm) {
           owner_md = md;
           param_index = i;
           break;
@@ -1742,112 +1750,136 @@ static char *rna_OpenMfxParameter_path(PointerRNA *ptr)
   return BLI_sprintfN("modifiers[\"%s\"].parameters[%d]", mod_name_esc, param_index);
 }
 
+static void rna_OpenMfxParameter_name_get(PointerRNA *ptr, char *value)
+{
+  OpenMfxParameterValue *parm = (OpenMfxParameterValue *)ptr->data;
+  strcpy(value, mfx_Parameter_info(parm)->name);
+}
+
+static int rna_OpenMfxParameter_name_length(PointerRNA *ptr)
+{
+  OpenMfxParameterValue *parm = (OpenMfxParameterValue *)ptr->data;
+  return strlen(mfx_Parameter_info(parm)->name);
+}
+
+static void rna_OpenMfxParameter_label_get(PointerRNA *ptr, char *value)
+{
+  OpenMfxParameterValue *parm = (OpenMfxParameterValue *)ptr->data;
+  strcpy(value, mfx_Parameter_info(parm)->label);
+}
+
+static int rna_OpenMfxParameter_label_length(PointerRNA *ptr)
+{
+  OpenMfxParameterValue *parm = (OpenMfxParameterValue *)ptr->data;
+  return strlen(mfx_Parameter_info(parm)->label);
+}
+
 static void rna_OpenMfxParameter_integer_value_get(PointerRNA *ptr, int *value)
 {
-  OpenMfxParameter *parm = (OpenMfxParameter *)ptr->data;
+  OpenMfxParameterValue *parm = (OpenMfxParameterValue *)ptr->data;
   value[0] = parm->integer_vec_value[0];
 }
 
 static void rna_OpenMfxParameter_integer_value_set(PointerRNA *ptr, const int *value)
 {
-  OpenMfxParameter *parm = (OpenMfxParameter *)ptr->data;
+  OpenMfxParameterValue *parm = (OpenMfxParameterValue *)ptr->data;
   parm->integer_vec_value[0] = value[0];
 }
 
 static void rna_OpenMfxParameter_integer_value_range(
     PointerRNA *ptr, int *min, int *max, int *softmin, int *softmax)
 {
-  OpenMfxParameter *parm = (OpenMfxParameter *)ptr->data;
-  *min = parm->int_min;
-  *softmin = parm->int_softmin;
-  *max = parm->int_max;
-  *softmax = parm->int_softmax;
+  const OpenMfxParameterInfo *info = mfx_Parameter_info((OpenMfxParameterValue *)ptr->data);
+  *min = info->int_min;
+  *softmin = info->int_softmin;
+  *max = info->int_max;
+  *softmax = info->int_softmax;
 }
 
 static void rna_OpenMfxParameter_integer2d_value_get(PointerRNA *ptr, int *value)
 {
-  OpenMfxParameter *parm = (OpenMfxParameter *)ptr->data;
+  OpenMfxParameterValue *parm = (OpenMfxParameterValue *)ptr->data;
   copy_v2_v2_int(value, parm->integer_vec_value);
 }
 
 static void rna_OpenMfxParameter_integer2d_value_set(PointerRNA *ptr, const int *value)
 {
-  OpenMfxParameter *parm = (OpenMfxParameter *)ptr->data;
+  OpenMfxParameterValue *parm = (OpenMfxParameterValue *)ptr->data;
   copy_v2_v2_int(parm->integer_vec_value, value);
 }
 
 static void rna_OpenMfxParameter_integer3d_value_get(PointerRNA *ptr, int *value)
 {
-  OpenMfxParameter *parm = (OpenMfxParameter *)ptr->data;
+  OpenMfxParameterValue *parm = (OpenMfxParameterValue *)ptr->data;
   copy_v3_v3_int(value, parm->integer_vec_value);
 }
 
 static void rna_OpenMfxParameter_integer3d_value_set(PointerRNA *ptr, const int *value)
 {
-  OpenMfxParameter *parm = (OpenMfxParameter *)ptr->data;
+  OpenMfxParameterValue *parm = (OpenMfxParameterValue *)ptr->data;
   copy_v3_v3_int(parm->integer_vec_value, value);
 }
 
 static void rna_OpenMfxParameter_float_value_get(PointerRNA *ptr, float *value)
 {
-  OpenMfxParameter *parm = (OpenMfxParameter *)ptr->data;
+  OpenMfxParameterValue *parm = (OpenMfxParameterValue *)ptr->data;
   value[0] = parm->float_vec_value[0];
 }
 
 static void rna_OpenMfxParameter_float_value_set(PointerRNA *ptr, const float *value)
 {
-  OpenMfxParameter *parm = (OpenMfxParameter *)ptr->data;
+  OpenMfxParameterValue *parm = (OpenMfxParameterValue *)ptr->data;
   parm->float_vec_value[0] = value[0];
 }
 
 static void rna_OpenMfxParameter_float_value_range(
     PointerRNA *ptr, float *min, float *max, float *softmin, float *softmax)
 {
-  OpenMfxParameter *parm = (OpenMfxParameter *)ptr->data;
-  *min = parm->float_min;
-  *softmin = parm->float_softmin;
-  *max = parm->float_max;
-  *softmax = parm->float_softmax;
+  const OpenMfxParameterInfo *info = mfx_Parameter_info((OpenMfxParameterValue *)ptr->data);
+  *min = info->float_min;
+  *softmin = info->float_softmin;
+  *max = info->float_max;
+  *softmax = info->float_softmax;
 }
 static void rna_OpenMfxParameter_float2d_value_get(PointerRNA *ptr, float *value)
 {
-  OpenMfxParameter *parm = (OpenMfxParameter *)ptr->data;
+  OpenMfxParameterValue *parm = (OpenMfxParameterValue *)ptr->data;
   copy_v2_v2(value, parm->float_vec_value);
 }
 
 static void rna_OpenMfxParameter_float2d_value_set(PointerRNA *ptr, const float *value)
 {
-  OpenMfxParameter *parm = (OpenMfxParameter *)ptr->data;
+  OpenMfxParameterValue *parm = (OpenMfxParameterValue *)ptr->data;
   copy_v2_v2(parm->float_vec_value, value);
 }
 
 static void rna_OpenMfxParameter_float3d_value_get(PointerRNA *ptr, float *value)
 {
-  OpenMfxParameter *parm = (OpenMfxParameter *)ptr->data;
+  OpenMfxParameterValue *parm = (OpenMfxParameterValue *)ptr->data;
   copy_v3_v3(value, parm->float_vec_value);
 }
 
 static void rna_OpenMfxParameter_float3d_value_set(PointerRNA *ptr, const float *value)
 {
-  OpenMfxParameter *parm = (OpenMfxParameter *)ptr->data;
+  OpenMfxParameterValue *parm = (OpenMfxParameterValue *)ptr->data;
   copy_v3_v3(parm->float_vec_value, value);
 }
 
 static void rna_OpenMfxParameter_float4d_value_get(PointerRNA *ptr, float *value)
 {
-  OpenMfxParameter *parm = (OpenMfxParameter *)ptr->data;
+  OpenMfxParameterValue *parm = (OpenMfxParameterValue *)ptr->data;
   copy_v4_v4(value, parm->float_vec_value);
 }
 
 static void rna_OpenMfxParameter_float4d_value_set(PointerRNA *ptr, const float *value)
 {
-  OpenMfxParameter *parm = (OpenMfxParameter *)ptr->data;
+  OpenMfxParameterValue *parm = (OpenMfxParameterValue *)ptr->data;
   copy_v4_v4(parm->float_vec_value, value);
 }
 
 static void rna_OpenMfxParameter_boolean_value_get(PointerRNA *ptr, bool *value)
 {
-  OpenMfxParameter *parm = (OpenMfxParameter *)ptr->data;
+  OpenMfxParameterValue *parm = (OpenMfxParameterValue *)ptr->data;
   value[0] = parm->integer_vec_value[0] != 0;
   value[1] = false;
   value[2] = false;
@@ -1856,7 +1888,7 @@ static void rna_OpenMfxParameter_boolean_value_get(PointerRNA *ptr, bool *value)
 
 static void rna_OpenMfxParameter_boolean_value_set(PointerRNA *ptr, const bool *value)
 {
-  OpenMfxParameter *parm = (OpenMfxParameter *)ptr->data;
+  OpenMfxParameterValue *parm = (OpenMfxParameterValue *)ptr->data;
   parm->integer_vec_value[0] = value[0] ? 1 : 0;
   parm->integer_vec_value[1] = false;
   parm->integer_vec_value[2] = false;
@@ -1865,20 +1897,20 @@ static void rna_OpenMfxParameter_boolean_value_set(PointerRNA *ptr, const bool *
 
 static void rna_OpenMfxParameter_string_value_get(PointerRNA *ptr, char *value)
 {
-  OpenMfxParameter *parm = (OpenMfxParameter *)ptr->data;
-  BLI_strncpy(value, parm->string_value, sizeof(parm->string_value));
+  OpenMfxParameterValue *parm = (OpenMfxParameterValue *)ptr->data;
+  strcpy(value, mfx_Parameter_string_value(parm));
 }
 
 static int rna_OpenMfxParameter_string_value_length(PointerRNA *ptr)
 {
-  OpenMfxParameter *parm = (OpenMfxParameter *)ptr->data;
-  return strlen(parm->string_value);
+  OpenMfxParameterValue *parm = (OpenMfxParameterValue *)ptr->data;
+  return strlen(mfx_Parameter_string_value(parm));
 }
 
 static void rna_OpenMfxParameter_string_value_set(PointerRNA *ptr, const char *value)
 {
-  OpenMfxParameter *parm = (OpenMfxParameter *)ptr->data;
-  BLI_strncpy(parm->string_value, value, sizeof(parm->string_value));
+  OpenMfxParameterValue *parm = (OpenMfxParameterValue *)ptr->data;
+  mfx_Parameter_set_string_value(parm, value);
 }
 
 static bool rna_NodesModifier_node_group_poll(PointerRNA *UNUSED(ptr), PointerRNA value)
@@ -7519,16 +7551,21 @@ static void rna_def_modifier_openmfx_parameter(BlenderRNA *brna)
   PropertyRNA *prop;
 
   srna = RNA_def_struct(brna, "OpenMfxParameter", NULL);
+  RNA_def_struct_sdna(srna, "OpenMfxParameterValue");
   RNA_def_struct_ui_text(
       srna, "OpenMfxParameter", "An exposed parameter of the active effect");
   RNA_def_struct_path_func(srna, "rna_OpenMfxParameter_path");
 
   prop = RNA_def_property(srna, "name", PROP_STRING, PROP_NONE);
+  RNA_def_property_string_funcs(
+      prop, "rna_OpenMfxParameter_name_get", "rna_OpenMfxParameter_name_length", NULL);
   RNA_def_property_ui_text(prop, "Name", "System name of the effect");
   RNA_def_property_clear_flag(prop, PROP_EDITABLE);
   RNA_def_property_update(prop, 0, "rna_Modifier_update");
 
   prop = RNA_def_property(srna, "label", PROP_STRING, PROP_NONE);
+  RNA_def_property_string_funcs(
+      prop, "rna_OpenMfxParameter_label_get", "rna_OpenMfxParameter_label_length", NULL);
   RNA_def_property_ui_text(prop, "Label", "Display label of the effect");
   RNA_def_property_clear_flag(prop, PROP_EDITABLE);
   RNA_def_property_update(prop, 0, "rna_Modifier_update");
@@ -7689,6 +7726,48 @@ static void rna_def_modifier_openmfx(BlenderRNA *brna)
                              "rna_OpenMfxModifier_active_effect_index_range");
   RNA_def_property_update(prop, 0, "rna_Modifier_dependency_update");
 
+  prop = RNA_def_property(srna, "use_viewport_proxy", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "flag", MOD_OPENMFX_FLAG_VIEWPORT_PROXY);
+  RNA_def_property_ui_text(
+      prop,
+      "Viewport Proxy",
+      "Feed the effect with a decimated copy of its input when evaluating for the viewport");
+  RNA_def_property_update(prop, 0, "rna_Modifier_update");
+
+  prop = RNA_def_property(srna, "use_out_of_process", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "flag", MOD_OPENMFX_FLAG_OUT_OF_PROCESS);
+  RNA_def_property_boolean_funcs(prop, NULL, "rna_OpenMfxModifier_use_out_of_process_set");
+  RNA_def_property_ui_text(prop,
+                           "Out of Process",
+                           "Run the plugin in a separate process, so that a crashing plugin "
+                           "does not take Blender down with it");
+  RNA_def_property_update(prop, 0, "rna_Modifier_dependency_update");
+
+  prop = RNA_def_property(srna, "viewport_proxy_ratio", PROP_FLOAT, PROP_FACTOR);
+  RNA_def_property_range(prop, 0.01f, 1.0f);
+  RNA_def_property_ui_range(prop, 0.01f, 1.0f, 1, 4);
+  RNA_def_property_ui_text(
+      prop, "Proxy Ratio", "Ratio of the input faces kept in the viewport proxy");
+  RNA_def_property_update(prop, 0, "rna_Modifier_update");
+
+  prop = RNA_def_property(srna, "is_baked", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "flag", MOD_OPENMFX_FLAG_BAKED);
+  RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+  RNA_def_property_ui_text(
+      prop, "Is Baked", "Whether frames of the bake range are read from the bake cache");
+
+  prop = RNA_def_property(srna, "bake_directory", PROP_STRING, PROP_DIRPATH);
+  RNA_def_property_ui_text(
+      prop, "Bake Directory", "Path to a folder to store the results of the effect when baking");
+
+  prop = RNA_def_property(srna, "bake_frame_start", PROP_INT, PROP_TIME);
+  RNA_def_property_range(prop, MINAFRAME, MAXFRAME);
+  RNA_def_property_ui_text(prop, "Bake Start", "Start frame of the bake");
+
+  prop = RNA_def_property(srna, "bake_frame_end", PROP_INT, PROP_TIME);
+  RNA_def_property_range(prop, MINAFRAME, MAXFRAME);
+  RNA_def_property_ui_text(prop, "Bake End", "End frame of the bake");
+
   RNA_define_lib_overridable(false);
 
   prop = RNA_def_enum(srna,
@@ -9631,6 +9631,24 @@ static void def_geo_mesh_line(StructRNA *srna)
   RNA_def_property_update(prop, NC_NODE | NA_EDITED, "rna_Node_socket_update");
 }
 
+static void def_geo_openmfx(StructRNA *srna)
+{
+  PropertyRNA *prop;
+
+  RNA_def_struct_sdna_from(srna, "NodeGeometryOpenMfx", "storage");
+
+  prop = RNA_def_property(srna, "plugin_path", PROP_STRING, PROP_FILEPATH);
+  RNA_def_property_ui_text(
+      prop, "Plugin Path", "Path to the OpenFX Mesh Effect plugin to use (.ofx)");
+  RNA_def_property_update(prop, NC_NODE | NA_EDITED, "rna_Node_socket_update");
+
+  prop = RNA_def_property(srna, "effect_index", PROP_INT, PROP_NONE);
+  RNA_def_property_range(prop, 0, INT_MAX);
+  RNA_def_property_ui_text(
+      prop, "Effect", "Index of the effect to use within the current OFX plug-in bundle");
+  RNA_def_property_update(prop, NC_NODE | NA_EDITED, "rna_Node_socket_update");
+}
+
 /* -------------------------------------------------------------------------- */
 
 static void rna_def_shader_node(BlenderRNA *brna)
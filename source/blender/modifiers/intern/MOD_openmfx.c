@@ -21,10 +21,16 @@
  * \ingroup modifiers
  */
 
+/* Allow using deprecated functionality for .blend file I/O. */
+#define DNA_DEPRECATED_ALLOW
+
 #include "MEM_guardedalloc.h"
 
+#include "BLI_string.h"
 #include "BLI_utildefines.h"
 
+#include "BLT_translation.h"
+
 #include "BKE_context.h"
 #include "BKE_screen.h"
 #include "BKE_modifier.h"
@@ -38,6 +44,7 @@
 
 #include "DNA_mesh_types.h"
 #include "DNA_meshdata_types.h"
+#include "DNA_scene_types.h"
 #include "DNA_screen_types.h"
 
 #include "MOD_modifiertypes.h"
@@ -46,7 +53,12 @@
 
 #include "BLO_read_write.h"
 
+#include "WM_types.h" /* For UI bake operator. */
+
+#include "DEG_depsgraph_query.h"
+
 #include "mfxModifier.h"
+#include "mfxParameters.h"
 
 #include <stdio.h>
 
@@ -57,17 +69,30 @@ static Mesh *modifyMesh(ModifierData *md,
                            Mesh *mesh)
 {
   OpenMfxModifierData *fxmd = (OpenMfxModifierData *)md;
-  return mfx_Modifier_do(fxmd, mesh, ctx->object);
+  const bool use_render_quality = (ctx->flag & MOD_APPLY_RENDER) != 0;
+  const float ctime = DEG_get_ctime(ctx->depsgraph);
+  const Scene *scene = DEG_get_evaluated_scene(ctx->depsgraph);
+  const float motion_blur_shutter = (use_render_quality && (scene->r.mode & R_MBLUR)) ?
+                                        scene->r.blurfac :
+                                        0.0f;
+  return mfx_Modifier_do(
+      fxmd, mesh, ctx->object, use_render_quality, ctime, motion_blur_shutter);
 }
 
 static void initData(struct ModifierData *md)
 {
   OpenMfxModifierData *fxmd = (OpenMfxModifierData *)md;
   fxmd->active_effect_index = -1;
+  fxmd->flag = 0;
+  fxmd->viewport_proxy_ratio = 0.25f;
+  fxmd->bake_frame_start = 1;
+  fxmd->bake_frame_end = 250;
+  STRNCPY(fxmd->bake_directory, "//openmfx_cache/");
   fxmd->num_effects = 0;
   fxmd->effects = NULL;
   fxmd->num_parameters = 0;
-  fxmd->parameters = NULL;
+  fxmd->parameter_values = NULL;
+  fxmd->parameter_info = NULL;
   fxmd->num_extra_inputs = 0;
   fxmd->extra_inputs = NULL;
   fxmd->message[0] = '\0';
@@ -95,8 +120,13 @@ static void requiredDataMask(Object *UNUSED(ob),
      maybe there could be a mechanism in OpenMfx to have a plugin explicitely
      ask for input attributes, so that we can avoid feeding all of them to addons
      that are not using it. */
-  r_cddata_masks->lmask |= CD_MLOOPUV;
-  r_cddata_masks->lmask |= CD_MLOOPCOL;
+  r_cddata_masks->lmask |= CD_MASK_MLOOPUV | CD_MASK_MLOOPCOL;
+
+  /* Generic attributes and vertex groups are forwarded as well. */
+  r_cddata_masks->vmask |= CD_MASK_PROP_ALL | CD_MASK_MDEFORMVERT;
+  r_cddata_masks->emask |= CD_MASK_PROP_ALL;
+  r_cddata_masks->lmask |= CD_MASK_PROP_ALL;
+  r_cddata_masks->pmask |= CD_MASK_PROP_ALL;
 }
 
 static void updateDepsgraph(ModifierData *md, const ModifierUpdateDepsgraphContext *ctx)
@@ -166,10 +196,7 @@ static void freeData(struct ModifierData *md)
   freeRuntimeData(md->runtime);
   md->runtime = NULL;
 
-  if (fxmd->parameters) {
-    MEM_freeN(fxmd->parameters);
-    fxmd->parameters = NULL;
-  }
+  mfx_Modifier_free_parameters(fxmd);
 
   if (fxmd->extra_inputs) {
     MEM_freeN(fxmd->extra_inputs);
@@ -191,11 +218,19 @@ static void panel_draw(const bContext *C, Panel *panel)
   PointerRNA *ptr = modifier_panel_get_property_pointers(panel, &ob_ptr);
 
   uiItemR(layout, ptr, "plugin_path", UI_ITEM_R_EXPAND, NULL, ICON_NONE);
+  uiItemR(layout, ptr, "use_out_of_process", 0, NULL, ICON_NONE);
   uiItemS(layout);
 
   uiItemR(layout, ptr, "effect_enum", 0, NULL, ICON_NONE);
   uiItemS(layout);
 
+  row = uiLayoutRowWithHeading(layout, true, IFACE_("Viewport Proxy"));
+  uiItemR(row, ptr, "use_viewport_proxy", 0, "", ICON_NONE);
+  uiLayout *sub = uiLayoutRow(row, true);
+  uiLayoutSetActive(sub, RNA_boolean_get(ptr, "use_viewport_proxy"));
+  uiItemR(sub, ptr, "viewport_proxy_ratio", 0, "", ICON_NONE);
+  uiItemS(layout);
+
   char *label;
   CollectionPropertyIterator iter;
   for (RNA_collection_begin(ptr, "extra_inputs", &iter); iter.valid;
@@ -251,12 +286,86 @@ static void panel_draw(const bContext *C, Panel *panel)
     }
   }
 
+  /* Memory is used by the evaluated modifier, which is the one cooking. */
+  Depsgraph *depsgraph = CTX_data_depsgraph_pointer(C);
+  ModifierData *md_eval = NULL;
+  if (depsgraph != NULL) {
+    md_eval = BKE_modifier_get_evaluated(depsgraph, ob_ptr.data, ptr->data);
+  }
+  if (md_eval != NULL) {
+    OpenMfxMemoryUsage usage;
+    mfx_Modifier_memory_usage((OpenMfxModifierData *)md_eval, &usage);
+    const size_t peak_bytes = usage.attribute_peak_bytes + usage.plugin_peak_bytes;
+    if (peak_bytes > 0) {
+      char formatted_bytes[15], formatted_peak[15], text[64];
+      BLI_str_format_byte_unit(
+          formatted_bytes, usage.attribute_bytes + usage.plugin_bytes, false);
+      BLI_str_format_byte_unit(formatted_peak, peak_bytes, false);
+      BLI_snprintf(
+          text, sizeof(text), TIP_("Memory: %s, Peak: %s"), formatted_bytes, formatted_peak);
+      uiItemS(layout);
+      uiItemL(layout, text, ICON_NONE);
+    }
+  }
+
   modifier_panel_end(layout, ptr);
 }
 
+static void bake_panel_draw(const bContext *UNUSED(C), Panel *panel)
+{
+  uiLayout *col;
+  uiLayout *layout = panel->layout;
+
+  PointerRNA *ptr = modifier_panel_get_property_pointers(panel, NULL);
+
+  uiLayoutSetPropSep(layout, true);
+
+  bool is_baked = RNA_boolean_get(ptr, "is_baked");
+
+  if (is_baked) {
+    PointerRNA op_ptr;
+    uiItemFullO(layout,
+                "OBJECT_OT_openmfx_bake",
+                IFACE_("Delete Bake"),
+                ICON_NONE,
+                NULL,
+                WM_OP_EXEC_DEFAULT,
+                0,
+                &op_ptr);
+    RNA_boolean_set(&op_ptr, "free", true);
+  }
+  else {
+    uiItemO(layout, NULL, ICON_NONE, "OBJECT_OT_openmfx_bake");
+  }
+
+  col = uiLayoutColumn(layout, true);
+  uiLayoutSetEnabled(col, !is_baked);
+  uiItemR(col, ptr, "bake_directory", 0, NULL, ICON_NONE);
+  uiItemR(col, ptr, "bake_frame_start", 0, IFACE_("Frame Start"), ICON_NONE);
+  uiItemR(col, ptr, "bake_frame_end", 0, IFACE_("End"), ICON_NONE);
+}
+
 static void panelRegister(ARegionType *region_type)
 {
   PanelType *panel_type = modifier_panel_register(region_type, eModifierType_OpenMfx, panel_draw);
+  modifier_subpanel_register(region_type, "bake", "Bake", NULL, bake_panel_draw, panel_type);
+}
+
+/**
+ * Whether an earlier OpenMfx modifier of the same stack shares the parameter info table of md,
+ * in which case the table has already been written. Writing it again at the same address would
+ * leak the first copy at read time.
+ */
+static bool parameter_info_written_before(const ModifierData *md)
+{
+  const OpenMfxParameterInfoTable *table = ((const OpenMfxModifierData *)md)->parameter_info;
+  for (const ModifierData *prev = md->prev; prev; prev = prev->prev) {
+    if (prev->type == eModifierType_OpenMfx &&
+        ((const OpenMfxModifierData *)prev)->parameter_info == table) {
+      return true;
+    }
+  }
+  return false;
 }
 
 static void blendWrite(BlendWriter *writer, const ModifierData *md)
@@ -269,20 +378,74 @@ static void blendWrite(BlendWriter *writer, const ModifierData *md)
   }
 
   BLO_write_struct_array(writer,
-                         OpenMfxParameter,
+                         OpenMfxParameterValue,
                          fxmd->num_parameters,
-                         fxmd->parameters);
+                         fxmd->parameter_values);
+  for (int i = 0; i < fxmd->num_parameters; ++i) {
+    BLO_write_string(writer, fxmd->parameter_values[i].string_value);
+  }
+
+  const OpenMfxParameterInfoTable *table = fxmd->parameter_info;
+  if (table && !parameter_info_written_before(md)) {
+    // Written once per object, users are counted again at read time.
+    OpenMfxParameterInfoTable table_copy = *table;
+    table_copy.users = 0;
+    BLO_write_struct_at_address(writer, OpenMfxParameterInfoTable, table, &table_copy);
+    BLO_write_struct_array(writer, OpenMfxParameterInfo, table->num_parameters, table->infos);
+    for (int i = 0; i < table->num_parameters; ++i) {
+      BLO_write_string(writer, table->infos[i].name);
+      BLO_write_string(writer, table->infos[i].label);
+    }
+  }
   BLO_write_struct_array(writer,
                          OpenMfxInput,
                          fxmd->num_extra_inputs,
                          fxmd->extra_inputs);
 }
 
+static void read_parameters(BlendDataReader *reader, OpenMfxModifierData *fxmd)
+{
+  fxmd->parameter_values = BLO_read_data_address(reader, &fxmd->parameter_values);
+  for (int i = 0; i < fxmd->num_parameters; ++i) {
+    BLO_read_data_address(reader, &fxmd->parameter_values[i].string_value);
+    fxmd->parameter_values[i].info = NULL;
+  }
+
+  // A missing table is rebuilt from the plugin, see mfx_Modifier_reload_effect_info()
+  BLO_read_data_address(reader, &fxmd->parameter_info);
+  OpenMfxParameterInfoTable *table = fxmd->parameter_info;
+  if (table) {
+    // Modifiers of the same object sharing the table get the same pointer
+    if (table->users == 0) {
+      BLO_read_data_address(reader, &table->infos);
+      for (int i = 0; i < table->num_parameters; ++i) {
+        BLO_read_data_address(reader, &table->infos[i].name);
+        BLO_read_data_address(reader, &table->infos[i].label);
+      }
+    }
+    table->users++;
+    for (int i = 0; i < MIN2(fxmd->num_parameters, table->num_parameters); ++i) {
+      fxmd->parameter_values[i].info = &table->infos[i];
+    }
+  }
+}
+
 static void blendRead(BlendDataReader *reader, ModifierData *md)
 {
   OpenMfxModifierData *fxmd = (OpenMfxModifierData *)md;
 
-  fxmd->parameters = BLO_read_data_address(reader, &fxmd->parameters);
+  // Files saved before descriptions were split from values only have the legacy parameters
+  BLO_read_data_address(reader, &fxmd->parameters);
+  if (fxmd->parameters) {
+    fxmd->parameter_values = mfx_Parameters_from_legacy(
+        fxmd->parameters, fxmd->num_parameters, &fxmd->parameter_info);
+    MEM_freeN(fxmd->parameters);
+    fxmd->parameters = NULL;
+  }
+  else {
+    read_parameters(reader, fxmd);
+  }
+
   fxmd->extra_inputs = BLO_read_data_address(reader, &fxmd->extra_inputs);
 
   printf("At read, before remap, extra inputs are:\n");
@@ -314,7 +477,8 @@ ModifierTypeInfo modifierType_OpenMfx = {
     /* srna */ &RNA_OpenMfxModifier,
     /* type */ eModifierTypeType_Constructive,
     /* flags */ eModifierTypeFlag_AcceptsMesh | eModifierTypeFlag_SupportsMapping |
-        eModifierTypeFlag_SupportsEditmode | eModifierTypeFlag_EnableInEditmode,
+        eModifierTypeFlag_SupportsEditmode | eModifierTypeFlag_EnableInEditmode |
+        eModifierTypeFlag_AcceptsBMesh,
     /* icon */ ICON_MOD_ARRAY,
     /* copyData */ copyData,
     /* deformVerts */ NULL,
@@ -0,0 +1,345 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "BLI_listbase.h"
+#include "BLI_math_vector.h"
+#include "BLI_string.h"
+
+#include "DEG_depsgraph_query.h"
+
+#include "UI_interface.h"
+#include "UI_resources.h"
+
+#include "mfxGeometryNode.h"
+#include "mfxParameters.h"
+
+#include "node_geometry_util.hh"
+
+/* Sockets depend on the parameters of the effect, so there are no templates. Parameter sockets
+ * use the name of the parameter as identifier and come after the geometry socket. Inputs of the
+ * effect other than the main one are object sockets, identified by the name of the input, and
+ * its outputs other than the main one are geometry sockets that come after the main output. */
+
+static int geo_node_openmfx_socket_type(int parameter_type)
+{
+  switch (parameter_type) {
+    case PARAM_TYPE_INTEGER:
+      return SOCK_INT;
+    case PARAM_TYPE_INTEGER_2D:
+    case PARAM_TYPE_INTEGER_3D:
+    case PARAM_TYPE_DOUBLE_2D:
+    case PARAM_TYPE_DOUBLE_3D:
+      return SOCK_VECTOR;
+    case PARAM_TYPE_DOUBLE:
+      return SOCK_FLOAT;
+    case PARAM_TYPE_RGB:
+    case PARAM_TYPE_RGBA:
+      return SOCK_RGBA;
+    case PARAM_TYPE_BOOLEAN:
+      return SOCK_BOOLEAN;
+    case PARAM_TYPE_STRING:
+      return SOCK_STRING;
+    default:
+      return -1;
+  }
+}
+
+static bool geo_node_openmfx_is_parameter_socket(const bNodeSocket *sock,
+                                                 const OpenMfxParameterValue &parameter)
+{
+  return STREQ(sock->identifier, mfx_Parameter_info(&parameter)->name) &&
+         sock->type == geo_node_openmfx_socket_type(parameter.type);
+}
+
+static void geo_node_openmfx_set_socket_default(bNodeSocket *sock,
+                                                const OpenMfxParameterValue &parameter)
+{
+  const OpenMfxParameterInfo *info = mfx_Parameter_info(&parameter);
+  const bool is_integer = ELEM(parameter.type, PARAM_TYPE_INTEGER_2D, PARAM_TYPE_INTEGER_3D);
+  switch (sock->type) {
+    case SOCK_INT: {
+      bNodeSocketValueInt *value = (bNodeSocketValueInt *)sock->default_value;
+      value->value = parameter.integer_vec_value[0];
+      value->min = info->int_min;
+      value->max = info->int_max;
+      break;
+    }
+    case SOCK_FLOAT: {
+      bNodeSocketValueFloat *value = (bNodeSocketValueFloat *)sock->default_value;
+      value->value = parameter.float_vec_value[0];
+      value->min = info->float_min;
+      value->max = info->float_max;
+      break;
+    }
+    case SOCK_VECTOR: {
+      bNodeSocketValueVector *value = (bNodeSocketValueVector *)sock->default_value;
+      for (int c = 0; c < 3; c++) {
+        value->value[c] = is_integer ? (float)parameter.integer_vec_value[c] :
+                                       parameter.float_vec_value[c];
+      }
+      break;
+    }
+    case SOCK_RGBA: {
+      bNodeSocketValueRGBA *value = (bNodeSocketValueRGBA *)sock->default_value;
+      copy_v3_v3(value->value, parameter.float_vec_value);
+      value->value[3] = parameter.type == PARAM_TYPE_RGBA ? parameter.float_vec_value[3] : 1.0f;
+      break;
+    }
+    case SOCK_BOOLEAN: {
+      bNodeSocketValueBoolean *value = (bNodeSocketValueBoolean *)sock->default_value;
+      value->value = parameter.integer_vec_value[0] != 0;
+      break;
+    }
+    case SOCK_STRING: {
+      bNodeSocketValueString *value = (bNodeSocketValueString *)sock->default_value;
+      BLI_strncpy(value->value, mfx_Parameter_string_value(&parameter), sizeof(value->value));
+      break;
+    }
+  }
+}
+
+static void geo_node_openmfx_layout(uiLayout *layout, bContext *UNUSED(C), PointerRNA *ptr)
+{
+  uiItemR(layout, ptr, "plugin_path", 0, "", ICON_NONE);
+  uiItemR(layout, ptr, "effect_index", 0, NULL, ICON_NONE);
+
+  const bNode *node = (const bNode *)ptr->data;
+  const NodeGeometryOpenMfx &storage = *(const NodeGeometryOpenMfx *)node->storage;
+  blender::Vector<std::string> effects = mfx_GeometryNode_list_effects(storage.plugin_path);
+  if (storage.effect_index >= 0 && storage.effect_index < effects.size()) {
+    uiItemL(layout, effects[storage.effect_index].c_str(), ICON_NONE);
+  }
+  else if (storage.plugin_path[0] != '\0') {
+    uiItemL(layout, IFACE_("No such effect"), ICON_ERROR);
+  }
+}
+
+static void geo_node_openmfx_init(bNodeTree *ntree, bNode *node)
+{
+  NodeGeometryOpenMfx *data = (NodeGeometryOpenMfx *)MEM_callocN(sizeof(NodeGeometryOpenMfx),
+                                                                 __func__);
+  node->storage = data;
+
+  nodeAddStaticSocket(ntree, node, SOCK_IN, SOCK_GEOMETRY, PROP_NONE, "Geometry", "Geometry");
+  nodeAddStaticSocket(ntree, node, SOCK_OUT, SOCK_GEOMETRY, PROP_NONE, "Geometry", "Geometry");
+}
+
+/**
+ * Make parameter sockets match the parameters of the current effect, keeping the sockets (and
+ * hence links and values) of parameters that did not change.
+ */
+static void geo_node_openmfx_update(bNodeTree *ntree, bNode *node)
+{
+  const NodeGeometryOpenMfx &storage = *(const NodeGeometryOpenMfx *)node->storage;
+
+  blender::Vector<OpenMfxParameterValue> parameters;
+  mfx_GeometryNode_get_parameters(storage.plugin_path, storage.effect_index, parameters);
+  blender::Vector<OpenMfxInput> inputs;
+  mfx_GeometryNode_get_inputs(storage.plugin_path, storage.effect_index, inputs);
+
+  bNodeSocket *geometry_socket = (bNodeSocket *)node->inputs.first;
+  LISTBASE_FOREACH_MUTABLE (bNodeSocket *, sock, &node->inputs) {
+    if (sock == geometry_socket) {
+      continue;
+    }
+    bool is_used = false;
+    for (const OpenMfxParameterValue &parameter : parameters) {
+      is_used = is_used || geo_node_openmfx_is_parameter_socket(sock, parameter);
+    }
+    for (const OpenMfxInput &input : inputs) {
+      is_used = is_used || (STREQ(sock->identifier, input.name) && sock->type == SOCK_OBJECT);
+    }
+    if (!is_used) {
+      nodeRemoveSocket(ntree, node, sock);
+    }
+  }
+
+  blender::Vector<OpenMfxInput> outputs;
+  mfx_GeometryNode_get_outputs(storage.plugin_path, storage.effect_index, outputs);
+
+  bNodeSocket *geometry_output_socket = (bNodeSocket *)node->outputs.first;
+  LISTBASE_FOREACH_MUTABLE (bNodeSocket *, sock, &node->outputs) {
+    if (sock == geometry_output_socket) {
+      continue;
+    }
+    bool is_used = false;
+    for (const OpenMfxInput &output : outputs) {
+      is_used = is_used || (STREQ(sock->identifier, output.name) && sock->type == SOCK_GEOMETRY);
+    }
+    if (!is_used) {
+      nodeRemoveSocket(ntree, node, sock);
+    }
+  }
+  for (const OpenMfxInput &output : outputs) {
+    if (nodeFindSocket(node, SOCK_OUT, output.name) == nullptr) {
+      nodeAddStaticSocket(
+          ntree, node, SOCK_OUT, SOCK_GEOMETRY, PROP_NONE, output.name, output.label);
+    }
+  }
+
+  for (const OpenMfxParameterValue &parameter : parameters) {
+    const OpenMfxParameterInfo *info = mfx_Parameter_info(&parameter);
+    const int socket_type = geo_node_openmfx_socket_type(parameter.type);
+    if (socket_type == -1 || STREQ(info->name, "Geometry") ||
+        nodeFindSocket(node, SOCK_IN, info->name) != nullptr) {
+      continue;
+    }
+    bNodeSocket *sock = nodeAddStaticSocket(
+        ntree, node, SOCK_IN, socket_type, PROP_NONE, info->name, info->label);
+    geo_node_openmfx_set_socket_default(sock, parameter);
+  }
+  mfx_GeometryNode_free_parameters(parameters);
+
+  for (const OpenMfxInput &input : inputs) {
+    if (nodeFindSocket(node, SOCK_IN, input.name) == nullptr) {
+      nodeAddStaticSocket(ntree, node, SOCK_IN, SOCK_OBJECT, PROP_NONE, input.name, input.label);
+    }
+  }
+}
+
+namespace blender::nodes {
+
+/**
+ * Read the value of a parameter from its socket, in the layout used by the modifier.
+ */
+static void geo_node_openmfx_read_parameter(GeoNodeExecParams &params,
+                                            const bNodeSocket &sock,
+                                            OpenMfxParameterValue &parameter)
+{
+  switch (sock.type) {
+    case SOCK_INT:
+      parameter.integer_vec_value[0] = params.extract_input<int>(sock.identifier);
+      break;
+    case SOCK_FLOAT:
+      parameter.float_vec_value[0] = params.extract_input<float>(sock.identifier);
+      break;
+    case SOCK_VECTOR: {
+      const float3 value = params.extract_input<float3>(sock.identifier);
+      const bool is_integer = ELEM(parameter.type, PARAM_TYPE_INTEGER_2D, PARAM_TYPE_INTEGER_3D);
+      for (int c = 0; c < 3; c++) {
+        if (is_integer) {
+          parameter.integer_vec_value[c] = (int)roundf(value[c]);
+        }
+        else {
+          parameter.float_vec_value[c] = value[c];
+        }
+      }
+      break;
+    }
+    case SOCK_RGBA: {
+      const Color4f value = params.extract_input<Color4f>(sock.identifier);
+      parameter.float_vec_value[0] = value.r;
+      parameter.float_vec_value[1] = value.g;
+      parameter.float_vec_value[2] = value.b;
+      parameter.float_vec_value[3] = value.a;
+      break;
+    }
+    case SOCK_BOOLEAN:
+      parameter.integer_vec_value[0] = params.extract_input<bool>(sock.identifier) ? 1 : 0;
+      break;
+    case SOCK_STRING: {
+      const std::string value = params.extract_input<std::string>(sock.identifier);
+      mfx_Parameter_set_string_value(&parameter, value.c_str());
+      break;
+    }
+  }
+}
+
+static void geo_node_openmfx_exec(GeoNodeExecParams params)
+{
+  GeometrySet geometry_set = params.extract_input<GeometrySet>("Geometry");
+  const bNode &node = params.node();
+  const NodeGeometryOpenMfx &storage = *(const NodeGeometryOpenMfx *)node.storage;
+
+  if (storage.plugin_path[0] == '\0') {
+    params.set_output("Geometry", std::move(geometry_set));
+    return;
+  }
+
+  /* Start from the default values, overridden by the sockets that match a parameter. */
+  Vector<OpenMfxParameterValue> parameters;
+  mfx_GeometryNode_get_parameters(storage.plugin_path, storage.effect_index, parameters);
+  for (OpenMfxParameterValue &parameter : parameters) {
+    const char *name = mfx_Parameter_info(&parameter)->name;
+    const bNodeSocket *sock = nodeFindSocket(&node, SOCK_IN, name);
+    if (sock != nullptr && !(sock->flag & SOCK_UNAVAIL) &&
+        geo_node_openmfx_is_parameter_socket(sock, parameter)) {
+      geo_node_openmfx_read_parameter(params, *sock, parameter);
+    }
+  }
+
+  /* Objects connected to the other inputs of the effect, which its output may instance. */
+  Vector<OpenMfxInput> inputs;
+  mfx_GeometryNode_get_inputs(storage.plugin_path, storage.effect_index, inputs);
+  Vector<Object *> input_objects;
+  for (const OpenMfxInput &input : inputs) {
+    const bNodeSocket *sock = nodeFindSocket(&node, SOCK_IN, input.name);
+    Object *object = nullptr;
+    if (sock != nullptr && sock->type == SOCK_OBJECT) {
+      bke::PersistentObjectHandle object_handle =
+          params.extract_input<bke::PersistentObjectHandle>(input.name);
+      object = params.handle_map().lookup(object_handle);
+    }
+    input_objects.append(object);
+  }
+
+  /* All the outputs of the effect are produced by the same cook. */
+  Vector<OpenMfxInput> outputs;
+  mfx_GeometryNode_get_outputs(storage.plugin_path, storage.effect_index, outputs);
+  Vector<GeometrySet> extra_outputs(outputs.size());
+
+  geometry_set = geometry_set_realize_instances(geometry_set);
+
+  const bool use_render_quality = DEG_get_mode(params.depsgraph()) == DAG_EVAL_RENDER;
+  std::string message;
+  if (!mfx_GeometryNode_cook(storage.plugin_path,
+                             storage.effect_index,
+                             parameters,
+                             input_objects,
+                             params.self_object(),
+                             use_render_quality,
+                             geometry_set,
+                             extra_outputs,
+                             message)) {
+    params.error_message_add(NodeWarningType::Error, message);
+  }
+  mfx_GeometryNode_free_parameters(parameters);
+
+  for (int i = 0; i < outputs.size(); i++) {
+    const bNodeSocket *sock = nodeFindSocket(&node, SOCK_OUT, outputs[i].name);
+    if (sock != nullptr && sock->type == SOCK_GEOMETRY) {
+      params.set_output(outputs[i].name, std::move(extra_outputs[i]));
+    }
+  }
+  params.set_output("Geometry", std::move(geometry_set));
+}
+
+}  // namespace blender::nodes
+
+void register_node_type_geo_openmfx()
+{
+  static bNodeType ntype;
+
+  geo_node_type_base(&ntype, GEO_NODE_OPENMFX, "OpenMfx", NODE_CLASS_GEOMETRY, 0);
+  node_type_init(&ntype, geo_node_openmfx_init);
+  node_type_update(&ntype, geo_node_openmfx_update);
+  node_type_size_preset(&ntype, NODE_SIZE_LARGE);
+  node_type_storage(
+      &ntype, "NodeGeometryOpenMfx", node_free_standard_storage, node_copy_standard_storage);
+  ntype.geometry_node_execute = blender::nodes::geo_node_openmfx_exec;
+  ntype.draw_buttons = geo_node_openmfx_layout;
+  nodeRegisterType(&ntype);
+}
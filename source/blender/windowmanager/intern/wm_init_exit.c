@@ -138,6 +138,8 @@
 
 #include "DRW_engine.h"
 
+#include "mfxModifier.h"
+
 CLG_LOGREF_DECLARE_GLOBAL(WM_LOG_OPERATORS, "wm.operator");
 CLG_LOGREF_DECLARE_GLOBAL(WM_LOG_HANDLERS, "wm.handler");
 CLG_LOGREF_DECLARE_GLOBAL(WM_LOG_EVENTS, "wm.event");
@@ -260,6 +262,12 @@ void WM_init(bContext *C, int argc, const char **argv)
 
   ED_node_init_butfuncs();
 
+  /* Loads OpenMfx plugins in a background thread while the UI starts. */
+  mfx_Modifier_init_allocator();
+  mfx_Modifier_init_thread_pool();
+  mfx_Modifier_preload_plugins();
+  mfx_Modifier_init_cook_cache();
+
   BLF_init();
 
   BLT_lang_init();
@@ -565,6 +573,9 @@ void WM_exit_ex(bContext *C, const bool do_python)
   RE_FreeAllRender();
   RE_engines_exit();
 
+  mfx_Modifier_free_cook_cache();
+  mfx_Modifier_free_preloaded_plugins();
+
   ED_preview_free_dbase(); /* frees a Main dbase, before BKE_blender_free! */
 
   if (wm) {
@@ -597,6 +608,9 @@ void WM_exit_ex(bContext *C, const bool do_python)
   ED_gpencil_anim_copybuf_free();
   ED_gpencil_strokes_copybuf_free();
 
+  /* After the OpenMfx modifiers have released their meshes. */
+  mfx_Modifier_free_memory();
+
   /* free gizmo-maps after freeing blender,
    * so no deleted data get accessed during cleaning up of areas. */
   wm_gizmomaptypes_free();